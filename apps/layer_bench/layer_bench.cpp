@@ -0,0 +1,41 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <iostream>
+
+#include <nnforge/plain/plain.h>
+#include "layer_bench_toolset.h"
+
+// Kernels are benchmarked in plain backend only
+int main(int argc, char* argv[])
+{
+	try
+	{
+		nnforge::plain::plain::init();
+
+		layer_bench_toolset bench(nnforge::factory_generator::ptr(new nnforge::plain::factory_generator_plain()));
+
+		if (bench.parse(argc, argv))
+			bench.do_action();
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "Exception caught: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
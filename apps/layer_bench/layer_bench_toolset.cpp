@@ -0,0 +1,627 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "layer_bench_toolset.h"
+
+#include <nnforge/layer_factory.h>
+#include <nnforge/neural_network_exception.h>
+#include <nnforge/rnd.h>
+#include <nnforge/accuracy_layer.h>
+#include <nnforge/add_layer.h>
+#include <nnforge/average_subsampling_layer.h>
+#include <nnforge/batch_norm_layer.h>
+#include <nnforge/concat_layer.h>
+#include <nnforge/convolution_layer.h>
+#include <nnforge/cross_entropy_layer.h>
+#include <nnforge/data_layer.h>
+#include <nnforge/lerror_layer.h>
+#include <nnforge/linear_sampler_layer.h>
+#include <nnforge/local_contrast_subtractive_layer.h>
+#include <nnforge/max_subsampling_layer.h>
+#include <nnforge/negative_log_likelihood_layer.h>
+#include <nnforge/parametric_rectified_linear_layer.h>
+#include <nnforge/sparse_convolution_layer.h>
+#include <nnforge/plain/factory_generator_plain.h>
+#include <nnforge/plain/layer_tester_plain_factory.h>
+#include <nnforge/plain/layer_updater_plain_factory.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <set>
+
+layer_bench_toolset::layer_bench_toolset(nnforge::factory_generator::ptr factory)
+	: nnforge::toolset(factory)
+{
+}
+
+std::string layer_bench_toolset::get_default_action() const
+{
+	return "layer_bench";
+}
+
+void layer_bench_toolset::do_custom_action()
+{
+	if (action == "layer_bench")
+	{
+		run_layer_bench();
+	}
+	else
+		toolset::do_custom_action();
+}
+
+std::vector<nnforge::string_option> layer_bench_toolset::get_string_options()
+{
+	std::vector<nnforge::string_option> res = toolset::get_string_options();
+
+	res.push_back(nnforge::string_option("layer_bench_entry_counts", &layer_bench_entry_counts, "64", "Comma separated list of entry counts to benchmark layers with"));
+	res.push_back(nnforge::string_option("layer_bench_feature_map_counts", &layer_bench_feature_map_counts, "16,64", "Comma separated list of input feature map counts to benchmark layers with"));
+	res.push_back(nnforge::string_option("layer_bench_spatial_sizes", &layer_bench_spatial_sizes, "32", "Comma separated list of 2D input sizes to benchmark layers with"));
+	res.push_back(nnforge::string_option("layer_bench_window_sizes", &layer_bench_window_sizes, "3", "Comma separated list of window sizes for convolution and subsampling layers"));
+	res.push_back(nnforge::string_option("layer_bench_output_filename", &layer_bench_output_filename, "layer_bench.json", "Name of the JSON file the results are written to, in working data folder"));
+
+	return res;
+}
+
+std::vector<nnforge::multi_string_option> layer_bench_toolset::get_multi_string_options()
+{
+	std::vector<nnforge::multi_string_option> res = toolset::get_multi_string_options();
+
+	res.push_back(nnforge::multi_string_option("layer_bench_layer_type", &layer_bench_layer_types, "Types of the layers to benchmark, all the layers registered in plain backend are benchmarked if none specified"));
+
+	return res;
+}
+
+std::vector<nnforge::int_option> layer_bench_toolset::get_int_options()
+{
+	std::vector<nnforge::int_option> res = toolset::get_int_options();
+
+	res.push_back(nnforge::int_option("layer_bench_warmup_iteration_count", &layer_bench_warmup_iteration_count, 2, "Number of untimed runs of each action before measuring"));
+	res.push_back(nnforge::int_option("layer_bench_iteration_count", &layer_bench_iteration_count, 10, "Number of timed runs of each action"));
+
+	return res;
+}
+
+void layer_bench_toolset::run_layer_bench()
+{
+	std::shared_ptr<nnforge::plain::factory_generator_plain> plain_factory = std::dynamic_pointer_cast<nnforge::plain::factory_generator_plain>(master_factory);
+	if (!plain_factory)
+		throw nnforge::neural_network_exception("layer_bench is able to run with plain backend only");
+	nnforge::plain::plain_running_configuration::const_ptr plain_config = plain_factory->get_plain_running_configuration();
+
+	if (layer_bench_iteration_count <= 0)
+		throw nnforge::neural_network_exception((boost::format("Invalid layer_bench_iteration_count: %1%") % layer_bench_iteration_count).str());
+
+	std::vector<unsigned int> entry_count_list = parse_shape_list(layer_bench_entry_counts, "layer_bench_entry_counts");
+	std::vector<unsigned int> feature_map_count_list = parse_shape_list(layer_bench_feature_map_counts, "layer_bench_feature_map_counts");
+	std::vector<unsigned int> spatial_size_list = parse_shape_list(layer_bench_spatial_sizes, "layer_bench_spatial_sizes");
+	std::vector<unsigned int> window_size_list = parse_shape_list(layer_bench_window_sizes, "layer_bench_window_sizes");
+
+	std::vector<std::string> tester_type_name_list = nnforge::plain::layer_tester_plain_factory::get_singleton().get_layer_type_name_list();
+	std::vector<std::string> updater_type_name_list = nnforge::plain::layer_updater_plain_factory::get_singleton().get_layer_type_name_list();
+	std::set<std::string> tester_type_name_set(tester_type_name_list.begin(), tester_type_name_list.end());
+	std::set<std::string> updater_type_name_set(updater_type_name_list.begin(), updater_type_name_list.end());
+
+	std::set<std::string> layer_type_name_set(layer_bench_layer_types.begin(), layer_bench_layer_types.end());
+	if (layer_type_name_set.empty())
+	{
+		layer_type_name_set.insert(tester_type_name_set.begin(), tester_type_name_set.end());
+		layer_type_name_set.insert(updater_type_name_set.begin(), updater_type_name_set.end());
+	}
+
+	boost::filesystem::create_directories(get_working_data_folder());
+	boost::filesystem::path output_filepath = get_working_data_folder() / layer_bench_output_filename;
+	boost::filesystem::ofstream out(output_filepath, std::ios_base::out | std::ios_base::trunc);
+	if (!out)
+		throw nnforge::neural_network_exception((boost::format("Unable to open %1% for writing") % output_filepath.string()).str());
+
+	out << "{" << std::endl;
+	out << "\t\"thread_count\": " << plain_config->openmp_thread_count << "," << std::endl;
+	out << "\t\"peak_gflops\": " << plain_config->get_flops() * 1.0e-9 << "," << std::endl;
+	out << "\t\"warmup_iteration_count\": " << layer_bench_warmup_iteration_count << "," << std::endl;
+	out << "\t\"iteration_count\": " << layer_bench_iteration_count << "," << std::endl;
+	out << "\t\"results\": [";
+
+	bool first_result = true;
+	for(std::set<std::string>::const_iterator it = layer_type_name_set.begin(); it != layer_type_name_set.end(); ++it)
+	{
+		const std::string& layer_type_name = *it;
+		bool has_tester = (tester_type_name_set.find(layer_type_name) != tester_type_name_set.end());
+		bool has_updater = (updater_type_name_set.find(layer_type_name) != updater_type_name_set.end());
+		if ((!has_tester) && (!has_updater))
+			throw nnforge::neural_network_exception((boost::format("Neither plain tester nor plain updater is registered for layer type %1%") % layer_type_name).str());
+
+		for(std::vector<unsigned int>::const_iterator fm_it = feature_map_count_list.begin(); fm_it != feature_map_count_list.end(); ++fm_it)
+		for(std::vector<unsigned int>::const_iterator window_it = window_size_list.begin(); window_it != window_size_list.end(); ++window_it)
+		for(std::vector<unsigned int>::const_iterator spatial_it = spatial_size_list.begin(); spatial_it != spatial_size_list.end(); ++spatial_it)
+		for(std::vector<unsigned int>::const_iterator entry_it = entry_count_list.begin(); entry_it != entry_count_list.end(); ++entry_it)
+		{
+			std::string skip_reason;
+			std::vector<nnforge::layer_configuration_specific> input_configuration_specific_list;
+			nnforge::layer_configuration_specific output_configuration_specific;
+			nnforge::layer::ptr layer_schema;
+			try
+			{
+				layer_schema = create_bench_layer(layer_type_name, *fm_it, *window_it);
+				if (!layer_schema)
+					throw nnforge::neural_network_exception("the layer type is not supported by layer_bench");
+				if (layer_schema->get_tiling_factor() != nnforge::tiling_factor(1))
+					throw nnforge::neural_network_exception("tiling layers are not supported by layer_bench");
+				input_configuration_specific_list = get_bench_input_configuration_specific_list(layer_schema, *fm_it, *spatial_it);
+				for(unsigned int i = 0; i < static_cast<unsigned int>(input_configuration_specific_list.size()); ++i)
+					layer_schema->input_layer_instance_names.push_back((boost::format("input_%1%") % i).str());
+				layer_schema->instance_name = "bench";
+				output_configuration_specific = layer_schema->get_output_layer_configuration_specific(input_configuration_specific_list);
+			}
+			catch (const std::exception& e)
+			{
+				skip_reason = e.what();
+			}
+
+			std::vector<action_timing> tester_timings;
+			std::vector<action_timing> updater_timings;
+			if (skip_reason.empty())
+			{
+				if (has_tester)
+					tester_timings = bench_tester(plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific, *entry_it);
+				if (has_updater)
+					updater_timings = bench_updater(plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific, *entry_it);
+			}
+
+			out << (first_result ? "" : ",") << std::endl;
+			first_result = false;
+			out << "\t\t{" << std::endl;
+			out << "\t\t\t\"layer_type\": \"" << escape_json(layer_type_name) << "\"," << std::endl;
+			out << "\t\t\t\"entry_count\": " << *entry_it << "," << std::endl;
+			out << "\t\t\t\"feature_map_count\": " << *fm_it << "," << std::endl;
+			out << "\t\t\t\"spatial_size\": " << *spatial_it << "," << std::endl;
+			out << "\t\t\t\"window_size\": " << *window_it;
+			if (!skip_reason.empty())
+			{
+				out << "," << std::endl << "\t\t\t\"skipped\": \"" << escape_json(skip_reason) << "\"";
+				std::cout << layer_type_name << " fm=" << *fm_it << " window=" << *window_it << " size=" << *spatial_it << " entries=" << *entry_it << ": skipped, " << skip_reason << std::endl;
+			}
+			else
+			{
+				if (has_tester)
+				{
+					out << "," << std::endl << "\t\t\t\"tester\": ";
+					write_timings(out, tester_timings);
+				}
+				if (has_updater)
+				{
+					out << "," << std::endl << "\t\t\t\"updater\": ";
+					write_timings(out, updater_timings);
+				}
+
+				std::cout << layer_type_name << " fm=" << *fm_it << " window=" << *window_it << " size=" << *spatial_it << " entries=" << *entry_it << ":";
+				for(std::vector<action_timing>::const_iterator timing_it = tester_timings.begin(); timing_it != tester_timings.end(); ++timing_it)
+					if (timing_it->error.empty())
+						std::cout << " inference " << timing_it->action_name << " " << (boost::format("%|1$.3f| ms, %|2$.1f| GFLOPS") % (timing_it->average_seconds * 1000.0) % (timing_it->flops / timing_it->average_seconds * 1.0e-9)).str() << ";";
+				for(std::vector<action_timing>::const_iterator timing_it = updater_timings.begin(); timing_it != updater_timings.end(); ++timing_it)
+					if (timing_it->error.empty())
+						std::cout << " training " << timing_it->action_name << " " << (boost::format("%|1$.3f| ms, %|2$.1f| GFLOPS") % (timing_it->average_seconds * 1000.0) % (timing_it->flops / timing_it->average_seconds * 1.0e-9)).str() << ";";
+				std::cout << std::endl;
+			}
+			out << std::endl << "\t\t}";
+		}
+	}
+
+	out << std::endl << "\t]" << std::endl;
+	out << "}" << std::endl;
+
+	std::cout << "Layer benchmark results written to " << output_filepath.string() << std::endl;
+}
+
+nnforge::layer::ptr layer_bench_toolset::create_bench_layer(
+	const std::string& layer_type_name,
+	unsigned int feature_map_count,
+	unsigned int window_size) const
+{
+	std::vector<unsigned int> window_sizes(2, window_size);
+	std::vector<unsigned int> left_zero_padding(2, (window_size - 1) / 2);
+	std::vector<unsigned int> right_zero_padding(2, window_size / 2);
+
+	if (layer_type_name == nnforge::convolution_layer::layer_type_name)
+		return nnforge::layer::ptr(new nnforge::convolution_layer(window_sizes, feature_map_count, feature_map_count, left_zero_padding, right_zero_padding));
+	else if (layer_type_name == nnforge::sparse_convolution_layer::layer_type_name)
+		return nnforge::layer::ptr(new nnforge::sparse_convolution_layer(window_sizes, feature_map_count, feature_map_count, 0.25F, left_zero_padding, right_zero_padding));
+	else if (layer_type_name == nnforge::max_subsampling_layer::layer_type_name)
+		return nnforge::layer::ptr(new nnforge::max_subsampling_layer(window_sizes));
+	else if (layer_type_name == nnforge::average_subsampling_layer::layer_type_name)
+		return nnforge::layer::ptr(new nnforge::average_subsampling_layer(std::vector<nnforge::average_subsampling_factor>(2, window_size)));
+	else if (layer_type_name == nnforge::local_contrast_subtractive_layer::layer_type_name)
+	{
+		std::vector<unsigned int> feature_maps_affected;
+		for(unsigned int i = 0; i < feature_map_count; ++i)
+			feature_maps_affected.push_back(i);
+		return nnforge::layer::ptr(new nnforge::local_contrast_subtractive_layer(window_sizes, feature_maps_affected, feature_map_count));
+	}
+	else if (layer_type_name == nnforge::parametric_rectified_linear_layer::layer_type_name)
+		return nnforge::layer::ptr(new nnforge::parametric_rectified_linear_layer(feature_map_count));
+	else if (layer_type_name == nnforge::batch_norm_layer::layer_type_name)
+		return nnforge::layer::ptr(new nnforge::batch_norm_layer(feature_map_count));
+	else if (layer_type_name == nnforge::data_layer::layer_type_name)
+		return nnforge::layer::ptr();
+
+	return nnforge::layer_factory::get_singleton().create_layer(layer_type_name);
+}
+
+std::vector<nnforge::layer_configuration_specific> layer_bench_toolset::get_bench_input_configuration_specific_list(
+	nnforge::layer::const_ptr layer_schema,
+	unsigned int feature_map_count,
+	unsigned int spatial_size) const
+{
+	std::vector<unsigned int> dimension_sizes(2, spatial_size);
+	std::vector<nnforge::layer_configuration_specific> res(1, nnforge::layer_configuration_specific(feature_map_count, dimension_sizes));
+
+	const std::string layer_type_name = layer_schema->get_type_name();
+	if ((layer_type_name == nnforge::add_layer::layer_type_name)
+		|| (layer_type_name == nnforge::concat_layer::layer_type_name)
+		|| (layer_type_name == nnforge::lerror_layer::layer_type_name)
+		|| (layer_type_name == nnforge::cross_entropy_layer::layer_type_name)
+		|| (layer_type_name == nnforge::negative_log_likelihood_layer::layer_type_name)
+		|| (layer_type_name == nnforge::accuracy_layer::layer_type_name))
+	{
+		res.push_back(res.front());
+	}
+	else if (layer_type_name == nnforge::linear_sampler_layer::layer_type_name)
+	{
+		// The grid goes first
+		res.insert(res.begin(), nnforge::layer_configuration_specific(2, dimension_sizes));
+	}
+
+	return res;
+}
+
+std::vector<layer_bench_toolset::action_timing> layer_bench_toolset::bench_tester(
+	nnforge::plain::plain_running_configuration::const_ptr plain_config,
+	nnforge::layer::const_ptr layer_schema,
+	const std::vector<nnforge::layer_configuration_specific>& input_configuration_specific_list,
+	const nnforge::layer_configuration_specific& output_configuration_specific,
+	unsigned int entry_count) const
+{
+	nnforge::plain::layer_tester_plain::const_ptr tester = nnforge::plain::layer_tester_plain_factory::get_singleton().get_tester_plain_layer(layer_schema->get_type_name());
+
+	nnforge::random_generator generator = nnforge::rnd::get_random_generator(48576);
+
+	nnforge::layer_data::ptr data;
+	nnforge::layer_data_custom::ptr data_custom;
+	if (!layer_schema->is_empty_data() || !layer_schema->is_empty_data_custom())
+	{
+		data = layer_schema->create_layer_data();
+		data_custom = layer_schema->create_layer_data_custom();
+		layer_schema->randomize_data(data, data_custom, generator);
+	}
+
+	std::vector<nnforge::plain::plain_buffer::const_ptr> input_buffers;
+	for(std::vector<nnforge::layer_configuration_specific>::const_iterator it = input_configuration_specific_list.begin(); it != input_configuration_specific_list.end(); ++it)
+		input_buffers.push_back(create_random_buffer(static_cast<size_t>(it->get_neuron_count()) * entry_count, generator));
+	nnforge::plain::plain_buffer::ptr output_buffer = create_buffer(static_cast<size_t>(output_configuration_specific.get_neuron_count()) * entry_count * sizeof(float));
+
+	std::vector<action_timing> res;
+	nnforge::layer_action action(nnforge::layer_action::forward);
+	try
+	{
+		nnforge::plain::plain_buffer::ptr temporary_working_fixed_buffer = create_buffer(tester->get_temporary_working_fixed_buffer_size(plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific));
+		nnforge::plain::plain_buffer::ptr temporary_working_per_entry_buffer = create_buffer(tester->get_temporary_working_per_entry_buffer_size(plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific) * entry_count);
+		double flops = static_cast<double>(layer_schema->get_flops_per_entry(input_configuration_specific_list, action)) * entry_count;
+
+		res.push_back(time_action(
+			action.str(),
+			flops,
+			[&] ()
+			{
+				tester->run_forward_propagation(
+					output_buffer,
+					input_buffers,
+					temporary_working_fixed_buffer,
+					temporary_working_per_entry_buffer,
+					plain_config,
+					layer_schema,
+					data,
+					data_custom,
+					input_configuration_specific_list,
+					output_configuration_specific,
+					entry_count);
+			}));
+	}
+	catch (const std::exception& e)
+	{
+		action_timing timing;
+		timing.action_name = action.str();
+		timing.error = e.what();
+		res.push_back(timing);
+	}
+
+	return res;
+}
+
+std::vector<layer_bench_toolset::action_timing> layer_bench_toolset::bench_updater(
+	nnforge::plain::plain_running_configuration::const_ptr plain_config,
+	nnforge::layer::const_ptr layer_schema,
+	const std::vector<nnforge::layer_configuration_specific>& input_configuration_specific_list,
+	const nnforge::layer_configuration_specific& output_configuration_specific,
+	unsigned int entry_count) const
+{
+	nnforge::plain::layer_updater_plain::const_ptr updater = nnforge::plain::layer_updater_plain_factory::get_singleton().get_updater_plain_layer(layer_schema->get_type_name());
+
+	nnforge::random_generator generator = nnforge::rnd::get_random_generator(48576);
+
+	nnforge::layer_data::ptr data;
+	nnforge::layer_data_custom::ptr data_custom;
+	nnforge::layer_data::ptr gradient;
+	if (!layer_schema->is_empty_data() || !layer_schema->is_empty_data_custom())
+	{
+		data = layer_schema->create_layer_data();
+		data_custom = layer_schema->create_layer_data_custom();
+		layer_schema->randomize_data(data, data_custom, generator);
+		gradient = layer_schema->create_layer_data();
+	}
+
+	// The same action set backward_propagation builds for a trainable layer in the middle of the network
+	std::set<nnforge::layer_action> actions;
+	actions.insert(nnforge::layer_action(nnforge::layer_action::forward));
+	for(int backprop_index = 0; backprop_index < static_cast<int>(input_configuration_specific_list.size()); ++backprop_index)
+		actions.insert(nnforge::layer_action(nnforge::layer_action::backward_data, backprop_index));
+	if (!layer_schema->is_empty_data())
+		actions.insert(nnforge::layer_action(nnforge::layer_action::backward_weights));
+
+	std::vector<nnforge::plain::plain_buffer::const_ptr> input_buffers;
+	std::vector<nnforge::plain::plain_buffer::ptr> input_errors_buffers;
+	for(std::vector<nnforge::layer_configuration_specific>::const_iterator it = input_configuration_specific_list.begin(); it != input_configuration_specific_list.end(); ++it)
+	{
+		input_buffers.push_back(create_random_buffer(static_cast<size_t>(it->get_neuron_count()) * entry_count, generator));
+		input_errors_buffers.push_back(create_buffer(static_cast<size_t>(it->get_neuron_count()) * entry_count * sizeof(float)));
+	}
+	nnforge::plain::plain_buffer::ptr output_buffer = create_buffer(static_cast<size_t>(output_configuration_specific.get_neuron_count()) * entry_count * sizeof(float));
+	nnforge::plain::plain_buffer::ptr output_errors_buffer = create_random_buffer(static_cast<size_t>(output_configuration_specific.get_neuron_count()) * entry_count, generator);
+
+	nnforge::plain::plain_buffer::ptr temporary_per_entry_buffer;
+	std::vector<action_timing> res;
+	for(std::set<nnforge::layer_action>::const_iterator it = actions.begin(); it != actions.end(); ++it)
+	{
+		const nnforge::layer_action& action = *it;
+		try
+		{
+			if (action.get_action_type() == nnforge::layer_action::forward)
+				temporary_per_entry_buffer = create_buffer(updater->get_temporary_per_entry_buffer_size(actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific) * entry_count);
+			nnforge::plain::plain_buffer::ptr temporary_working_fixed_buffer = create_buffer(updater->get_temporary_working_fixed_buffer_size(action, actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific));
+			nnforge::plain::plain_buffer::ptr temporary_working_per_entry_buffer = create_buffer(updater->get_temporary_working_per_entry_buffer_size(action, actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific) * entry_count);
+			double flops = static_cast<double>(layer_schema->get_flops_per_entry(input_configuration_specific_list, action)) * entry_count;
+
+			std::function<void()> func;
+			switch (action.get_action_type())
+			{
+			case nnforge::layer_action::forward:
+				func = [&] ()
+				{
+					updater->run_forward_propagation(
+						output_buffer,
+						input_buffers,
+						temporary_working_fixed_buffer,
+						temporary_working_per_entry_buffer,
+						temporary_per_entry_buffer,
+						plain_config,
+						layer_schema,
+						data,
+						data_custom,
+						input_configuration_specific_list,
+						output_configuration_specific,
+						actions,
+						entry_count);
+				};
+				break;
+			case nnforge::layer_action::backward_data:
+				func = [&] ()
+				{
+					updater->run_backward_data_propagation(
+						action.get_backprop_index(),
+						input_errors_buffers[action.get_backprop_index()],
+						output_errors_buffer,
+						input_buffers,
+						output_buffer,
+						temporary_working_fixed_buffer,
+						temporary_working_per_entry_buffer,
+						temporary_per_entry_buffer,
+						plain_config,
+						layer_schema,
+						data,
+						data_custom,
+						input_configuration_specific_list,
+						output_configuration_specific,
+						false,
+						actions,
+						entry_count);
+				};
+				break;
+			case nnforge::layer_action::backward_weights:
+				func = [&] ()
+				{
+					updater->run_backward_weights_propagation(
+						input_buffers,
+						output_errors_buffer,
+						temporary_working_fixed_buffer,
+						temporary_working_per_entry_buffer,
+						temporary_per_entry_buffer,
+						plain_config,
+						layer_schema,
+						gradient,
+						data_custom,
+						input_configuration_specific_list,
+						output_configuration_specific,
+						actions,
+						entry_count);
+				};
+				break;
+			default:
+				throw nnforge::neural_network_exception((boost::format("Unexpected action %1% in layer_bench") % action.str()).str());
+			}
+
+			res.push_back(time_action(action.str(), flops, func));
+		}
+		catch (const std::exception& e)
+		{
+			action_timing timing;
+			timing.action_name = action.str();
+			timing.error = e.what();
+			res.push_back(timing);
+		}
+	}
+
+	return res;
+}
+
+layer_bench_toolset::action_timing layer_bench_toolset::time_action(
+	const std::string& action_name,
+	double flops,
+	const std::function<void()>& func) const
+{
+	for(int i = 0; i < layer_bench_warmup_iteration_count; ++i)
+		func();
+
+	action_timing res;
+	res.action_name = action_name;
+	res.flops = flops;
+	res.min_seconds = std::numeric_limits<double>::max();
+	double total_seconds = 0.0;
+	for(int i = 0; i < layer_bench_iteration_count; ++i)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		func();
+		std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+		total_seconds += sec.count();
+		res.min_seconds = std::min(res.min_seconds, sec.count());
+	}
+	res.average_seconds = total_seconds / static_cast<double>(layer_bench_iteration_count);
+
+	return res;
+}
+
+nnforge::plain::plain_buffer::ptr layer_bench_toolset::create_buffer(size_t size)
+{
+	if (size == 0)
+		return nnforge::plain::plain_buffer::ptr();
+
+	return nnforge::plain::plain_buffer::ptr(new nnforge::plain::plain_buffer(size));
+}
+
+nnforge::plain::plain_buffer::ptr layer_bench_toolset::create_random_buffer(
+	size_t float_count,
+	nnforge::random_generator& generator)
+{
+	nnforge::plain::plain_buffer::ptr res = create_buffer(float_count * sizeof(float));
+	if (res)
+	{
+		std::uniform_real_distribution<float> dist(0.0F, 1.0F);
+		float * dst = *res;
+		for(size_t i = 0; i < float_count; ++i)
+			dst[i] = dist(generator);
+	}
+
+	return res;
+}
+
+std::vector<unsigned int> layer_bench_toolset::parse_shape_list(
+	const std::string& str,
+	const char * option_name)
+{
+	std::vector<std::string> strs;
+	boost::split(strs, str, boost::is_any_of(","));
+
+	std::vector<unsigned int> res;
+	for(std::vector<std::string>::iterator it = strs.begin(); it != strs.end(); ++it)
+	{
+		boost::trim(*it);
+		if (it->empty())
+			continue;
+
+		unsigned int val;
+		try
+		{
+			val = boost::lexical_cast<unsigned int>(*it);
+		}
+		catch (const boost::bad_lexical_cast&)
+		{
+			throw nnforge::neural_network_exception((boost::format("Invalid value %1% in %2%") % *it % option_name).str());
+		}
+		if (val == 0)
+			throw nnforge::neural_network_exception((boost::format("Zero value in %1%") % option_name).str());
+		res.push_back(val);
+	}
+
+	if (res.empty())
+		throw nnforge::neural_network_exception((boost::format("No values specified in %1%") % option_name).str());
+
+	return res;
+}
+
+void layer_bench_toolset::write_timings(
+	std::ostream& out,
+	const std::vector<action_timing>& timings)
+{
+	out << "{";
+	for(std::vector<action_timing>::const_iterator it = timings.begin(); it != timings.end(); ++it)
+	{
+		out << ((it == timings.begin()) ? "" : ",") << std::endl;
+		out << "\t\t\t\t\"" << escape_json(it->action_name) << "\": { ";
+		if (it->error.empty())
+		{
+			out << "\"average_ms\": " << it->average_seconds * 1000.0;
+			out << ", \"min_ms\": " << it->min_seconds * 1000.0;
+			out << ", \"gflop\": " << it->flops * 1.0e-9;
+			out << ", \"gflops\": " << ((it->average_seconds > 0.0) ? (it->flops / it->average_seconds * 1.0e-9) : 0.0);
+		}
+		else
+		{
+			out << "\"error\": \"" << escape_json(it->error) << "\"";
+		}
+		out << " }";
+	}
+	out << std::endl << "\t\t\t}";
+}
+
+std::string layer_bench_toolset::escape_json(const std::string& str)
+{
+	std::string res;
+	for(std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+	{
+		switch (*it)
+		{
+		case '"':
+			res += "\\\"";
+			break;
+		case '\\':
+			res += "\\\\";
+			break;
+		case '\n':
+			res += "\\n";
+			break;
+		case '\t':
+			res += "\\t";
+			break;
+		default:
+			res += *it;
+		}
+	}
+	return res;
+}
@@ -0,0 +1,114 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <nnforge/toolset.h>
+#include <nnforge/plain/plain_running_configuration.h>
+#include <nnforge/plain/plain_buffer.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <ostream>
+
+class layer_bench_toolset : public nnforge::toolset
+{
+public:
+	layer_bench_toolset(nnforge::factory_generator::ptr factory);
+
+	virtual ~layer_bench_toolset() = default;
+
+protected:
+	virtual std::string get_default_action() const;
+
+	virtual void do_custom_action();
+
+	virtual std::vector<nnforge::string_option> get_string_options();
+
+	virtual std::vector<nnforge::multi_string_option> get_multi_string_options();
+
+	virtual std::vector<nnforge::int_option> get_int_options();
+
+	void run_layer_bench();
+
+	// The layer is built for the shape specified, returns empty smart pointer if the layer type is not supported
+	virtual nnforge::layer::ptr create_bench_layer(
+		const std::string& layer_type_name,
+		unsigned int feature_map_count,
+		unsigned int window_size) const;
+
+	virtual std::vector<nnforge::layer_configuration_specific> get_bench_input_configuration_specific_list(
+		nnforge::layer::const_ptr layer_schema,
+		unsigned int feature_map_count,
+		unsigned int spatial_size) const;
+
+private:
+	struct action_timing
+	{
+		std::string action_name;
+		double average_seconds;
+		double min_seconds;
+		double flops;
+		std::string error;
+	};
+
+	std::vector<action_timing> bench_tester(
+		nnforge::plain::plain_running_configuration::const_ptr plain_config,
+		nnforge::layer::const_ptr layer_schema,
+		const std::vector<nnforge::layer_configuration_specific>& input_configuration_specific_list,
+		const nnforge::layer_configuration_specific& output_configuration_specific,
+		unsigned int entry_count) const;
+
+	std::vector<action_timing> bench_updater(
+		nnforge::plain::plain_running_configuration::const_ptr plain_config,
+		nnforge::layer::const_ptr layer_schema,
+		const std::vector<nnforge::layer_configuration_specific>& input_configuration_specific_list,
+		const nnforge::layer_configuration_specific& output_configuration_specific,
+		unsigned int entry_count) const;
+
+	action_timing time_action(
+		const std::string& action_name,
+		double flops,
+		const std::function<void()>& func) const;
+
+	// Returns empty smart pointer for zero size
+	static nnforge::plain::plain_buffer::ptr create_buffer(size_t size);
+
+	static nnforge::plain::plain_buffer::ptr create_random_buffer(
+		size_t float_count,
+		nnforge::random_generator& generator);
+
+	static std::vector<unsigned int> parse_shape_list(
+		const std::string& str,
+		const char * option_name);
+
+	static void write_timings(
+		std::ostream& out,
+		const std::vector<action_timing>& timings);
+
+	static std::string escape_json(const std::string& str);
+
+private:
+	std::vector<std::string> layer_bench_layer_types;
+	std::string layer_bench_entry_counts;
+	std::string layer_bench_feature_map_counts;
+	std::string layer_bench_spatial_sizes;
+	std::string layer_bench_window_sizes;
+	std::string layer_bench_output_filename;
+	int layer_bench_warmup_iteration_count;
+	int layer_bench_iteration_count;
+};
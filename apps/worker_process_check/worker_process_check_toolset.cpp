@@ -0,0 +1,439 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "worker_process_check_toolset.h"
+
+#include <nnforge/neural_network_exception.h>
+#include <nnforge/rnd.h>
+#include <nnforge/convolution_layer.h>
+#include <nnforge/data_layer.h>
+#include <nnforge/lerror_layer.h>
+#include <nnforge/rectified_linear_layer.h>
+#include <nnforge/network_data_initializer.h>
+#include <nnforge/neuron_value_set_data_bunch_reader.h>
+#include <nnforge/plain/factory_generator_plain.h>
+#include <nnforge/plain/plain_reduce_all_queue.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/process.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+
+worker_process_check_toolset::worker_process_check_toolset(nnforge::factory_generator::ptr factory)
+	: nnforge::toolset(factory)
+{
+}
+
+std::string worker_process_check_toolset::get_default_action() const
+{
+	return "worker_process_check";
+}
+
+void worker_process_check_toolset::do_custom_action()
+{
+	if (action == "worker_process_check")
+	{
+		run_worker_process_check();
+	}
+	else if (action == "worker_process_check_communicator")
+	{
+		run_communicator_check();
+	}
+	else
+		toolset::do_custom_action();
+}
+
+std::vector<nnforge::string_option> worker_process_check_toolset::get_string_options()
+{
+	std::vector<nnforge::string_option> res = toolset::get_string_options();
+
+	res.push_back(nnforge::string_option("worker_process_check_process_counts", &worker_process_check_process_counts, "2,3,4", "Comma separated list of worker process counts to compare with single process training"));
+	res.push_back(nnforge::string_option("worker_process_check_run", &worker_process_check_run, "", "Subfolder of trained data the run is saved to, set by the checking process"));
+
+	return res;
+}
+
+std::vector<nnforge::float_option> worker_process_check_toolset::get_float_options()
+{
+	std::vector<nnforge::float_option> res = toolset::get_float_options();
+
+	res.push_back(nnforge::float_option("worker_process_check_max_difference", &worker_process_check_max_difference, 1.0e-5F, "Maximum absolute difference between the weights trained by single and multiple processes"));
+
+	return res;
+}
+
+std::vector<nnforge::int_option> worker_process_check_toolset::get_int_options()
+{
+	std::vector<nnforge::int_option> res = toolset::get_int_options();
+
+	res.push_back(nnforge::int_option("worker_process_check_entry_count", &worker_process_check_entry_count, 103, "Number of synthetic training entries"));
+	res.push_back(nnforge::int_option("worker_process_check_seed", &worker_process_check_seed, 1, "Seed for the synthetic training entries and initial weights"));
+	res.push_back(nnforge::int_option("worker_process_check_tcp_port", &worker_process_check_tcp_port, 0, "Worker processes use tcp communicator listening on 127.0.0.1 at this port plus rank, 0 indicates plain_communicator is used as is"));
+	res.push_back(nnforge::int_option("worker_process_check_communicator_elem_count", &worker_process_check_communicator_elem_count, 2500003, "Number of values reduced and broadcast by the communicator check, spanning several buckets"));
+
+	return res;
+}
+
+nnforge::network_schema::ptr worker_process_check_toolset::load_schema() const
+{
+	std::vector<nnforge::layer::const_ptr> layer_list;
+
+	{
+		nnforge::layer::ptr l(new nnforge::data_layer());
+		l->instance_name = "input";
+		layer_list.push_back(l);
+	}
+	{
+		nnforge::layer::ptr l(new nnforge::data_layer());
+		l->instance_name = "target";
+		layer_list.push_back(l);
+	}
+	{
+		nnforge::layer::ptr l(new nnforge::convolution_layer(std::vector<unsigned int>(2, 3), 2, 4));
+		l->instance_name = "conv1";
+		l->input_layer_instance_names.push_back("input");
+		layer_list.push_back(l);
+	}
+	{
+		nnforge::layer::ptr l(new nnforge::rectified_linear_layer());
+		l->instance_name = "relu1";
+		l->input_layer_instance_names.push_back("conv1");
+		layer_list.push_back(l);
+	}
+	{
+		nnforge::layer::ptr l(new nnforge::convolution_layer(std::vector<unsigned int>(2, 3), 4, 1));
+		l->instance_name = "conv2";
+		l->input_layer_instance_names.push_back("relu1");
+		layer_list.push_back(l);
+	}
+	{
+		nnforge::layer::ptr l(new nnforge::lerror_layer());
+		l->instance_name = "error";
+		l->input_layer_instance_names.push_back("conv2");
+		l->input_layer_instance_names.push_back("target");
+		layer_list.push_back(l);
+	}
+
+	return nnforge::network_schema::ptr(new nnforge::network_schema(layer_list));
+}
+
+boost::filesystem::path worker_process_check_toolset::get_ann_subfolder_name() const
+{
+	boost::filesystem::path res = toolset::get_ann_subfolder_name();
+	if (!worker_process_check_run.empty())
+		res /= worker_process_check_run;
+	return res;
+}
+
+bool worker_process_check_toolset::is_training_with_validation() const
+{
+	return false;
+}
+
+nnforge::structured_data_bunch_reader::ptr worker_process_check_toolset::get_structured_data_bunch_reader(
+	const std::string& dataset_name,
+	dataset_usage usage,
+	unsigned int multiple_epoch_count,
+	unsigned int shuffle_block_size) const
+{
+	if (worker_process_check_entry_count <= 0)
+		throw nnforge::neural_network_exception((boost::format("Invalid worker_process_check_entry_count: %1%") % worker_process_check_entry_count).str());
+
+	nnforge::layer_configuration_specific input_config(2, std::vector<unsigned int>(2, 8));
+	nnforge::layer_configuration_specific target_config(1, std::vector<unsigned int>(2, 4));
+	nnforge::neuron_value_set::ptr input_data(new nnforge::neuron_value_set(input_config.get_neuron_count(), worker_process_check_entry_count));
+	nnforge::neuron_value_set::ptr target_data(new nnforge::neuron_value_set(target_config.get_neuron_count(), worker_process_check_entry_count));
+
+	nnforge::random_generator gen = nnforge::rnd::get_random_generator(worker_process_check_seed);
+	std::normal_distribution<float> dist(0.0F, 1.0F);
+	for(std::vector<std::shared_ptr<std::vector<float> > >::iterator it = input_data->neuron_value_list.begin(); it != input_data->neuron_value_list.end(); ++it)
+		for(std::vector<float>::iterator it2 = (*it)->begin(); it2 != (*it)->end(); ++it2)
+			*it2 = dist(gen);
+	for(std::vector<std::shared_ptr<std::vector<float> > >::iterator it = target_data->neuron_value_list.begin(); it != target_data->neuron_value_list.end(); ++it)
+		for(std::vector<float>::iterator it2 = (*it)->begin(); it2 != (*it)->end(); ++it2)
+			*it2 = dist(gen);
+
+	std::map<std::string, std::pair<nnforge::layer_configuration_specific, nnforge::neuron_value_set::ptr> > layer_name_to_config_and_value_set_map;
+	layer_name_to_config_and_value_set_map.insert(std::make_pair("input", std::make_pair(input_config, input_data)));
+	layer_name_to_config_and_value_set_map.insert(std::make_pair("target", std::make_pair(target_config, target_data)));
+
+	return nnforge::structured_data_bunch_reader::ptr(new nnforge::neuron_value_set_data_bunch_reader(layer_name_to_config_and_value_set_map));
+}
+
+void worker_process_check_toolset::run_worker_process_check()
+{
+	std::vector<unsigned int> process_count_list = parse_count_list(worker_process_check_process_counts, "worker_process_check_process_counts");
+
+	nnforge::network_schema::ptr schema = get_schema(schema_usage_train);
+	nnforge::network_data initial_data(schema->get_layers());
+	{
+		nnforge::random_generator gen = nnforge::rnd::get_random_generator(worker_process_check_seed);
+		initial_data.randomize(schema->get_layers(), gen);
+		nnforge::network_data_initializer init;
+		init.initialize(initial_data.data_list, *schema);
+	}
+
+	nnforge::network_data::ptr reference_data = train_with_worker_processes(initial_data, 1);
+
+	unsigned int failed_count = 0;
+	for(std::vector<unsigned int>::const_iterator it = process_count_list.begin(); it != process_count_list.end(); ++it)
+	{
+		check_communicator(*it);
+		std::cout << (boost::format("%1% worker processes: reduce_all and broadcast passed") % *it).str() << std::endl;
+
+		nnforge::network_data::ptr data = train_with_worker_processes(initial_data, *it);
+		float max_difference = get_max_difference(*reference_data, *data);
+		bool passed = (max_difference <= worker_process_check_max_difference);
+		std::cout << (boost::format("%1% worker processes: max weight difference from single process %2%, %3%") % *it % max_difference % (passed ? "passed" : "FAILED")).str() << std::endl;
+		if (!passed)
+			++failed_count;
+	}
+
+	if (failed_count > 0)
+		throw nnforge::neural_network_exception((boost::format("Weights trained with %1% of %2% worker process counts differ from single process training") % failed_count % process_count_list.size()).str());
+}
+
+nnforge::network_data::ptr worker_process_check_toolset::train_with_worker_processes(
+	const nnforge::network_data& initial_data,
+	unsigned int process_count) const
+{
+	std::string run_name = (boost::format("worker_process_%1%") % process_count).str();
+	boost::filesystem::path run_folder = get_working_data_folder() / toolset::get_ann_subfolder_name() / run_name;
+	boost::filesystem::remove_all(run_folder);
+
+	// Every run resumes from the same snapshot
+	initial_data.write(run_folder / ann_snapshot_subfolder_name / "ann_trained_000_epoch_00000");
+
+	std::vector<std::string> args = get_child_args("train", process_count);
+	args.push_back("--ann_count=1");
+	args.push_back("--resume_from_snapshot=true");
+	args.push_back((boost::format("--worker_process_check_run=%1%") % run_name).str());
+
+	std::cout << "Training with " << process_count << " worker processes" << std::endl;
+	boost::process::child training_process(command_line_args.front(), boost::process::args(args), boost::process::std_out > boost::process::null);
+	training_process.wait();
+	if (training_process.exit_code() != 0)
+		throw nnforge::neural_network_exception((boost::format("Training with %1% worker processes exited with code %2%, see log.txt in %3%") % process_count % training_process.exit_code() % get_working_data_folder().string()).str());
+
+	nnforge::network_data::ptr res(new nnforge::network_data());
+	res->read(run_folder / "ann_trained_000");
+	return res;
+}
+
+void worker_process_check_toolset::check_communicator(unsigned int process_count) const
+{
+	std::vector<std::string> args = get_child_args("worker_process_check_communicator", process_count);
+	args.push_back((boost::format("--worker_process_group=nnforge_check_%1%_%2%_%|3$08x|") % boost::this_process::get_id() % process_count % std::random_device()()).str());
+
+	// Running worker processes are terminated when their handles are destroyed, so that the rest don't wait for the failed one
+	std::vector<std::shared_ptr<boost::process::child> > worker_processes;
+	for(unsigned int rank = 0; rank < process_count; ++rank)
+	{
+		std::vector<std::string> worker_args(args);
+		worker_args.push_back((boost::format("--worker_process_rank=%1%") % rank).str());
+		worker_processes.push_back(std::shared_ptr<boost::process::child>(new boost::process::child(command_line_args.front(), boost::process::args(worker_args), boost::process::std_out > boost::process::null)));
+	}
+
+	while (true)
+	{
+		bool running = false;
+		for(std::vector<std::shared_ptr<boost::process::child> >::const_iterator it = worker_processes.begin(); it != worker_processes.end(); ++it)
+		{
+			if ((*it)->running())
+				running = true;
+			else if ((*it)->exit_code() != 0)
+				throw nnforge::neural_network_exception((boost::format("Communicator check worker process %1% of %2% exited with code %3%, see its log in %4%") % (it - worker_processes.begin()) % process_count % (*it)->exit_code() % get_working_data_folder().string()).str());
+		}
+		if (!running)
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
+void worker_process_check_toolset::run_communicator_check()
+{
+	std::shared_ptr<nnforge::plain::factory_generator_plain> plain_factory = std::dynamic_pointer_cast<nnforge::plain::factory_generator_plain>(master_factory);
+	if (!plain_factory)
+		throw nnforge::neural_network_exception("worker_process_check is able to run with plain backend only");
+	if (worker_process_count < 2)
+		throw nnforge::neural_network_exception((boost::format("Invalid worker_process_count for communicator check: %1%") % worker_process_count).str());
+	if (worker_process_check_communicator_elem_count <= 0)
+		throw nnforge::neural_network_exception((boost::format("Invalid worker_process_check_communicator_elem_count: %1%") % worker_process_check_communicator_elem_count).str());
+
+	plain_factory->set_worker_process(worker_process_rank, worker_process_count, worker_process_group);
+	nnforge::plain::plain_communicator::ptr communicator = plain_factory->get_plain_running_configuration()->communicator;
+
+	size_t elem_count = static_cast<size_t>(worker_process_check_communicator_elem_count);
+	float rank_factor = static_cast<float>(worker_process_rank + 1);
+	float rank_factor_sum = static_cast<float>(worker_process_count * (worker_process_count + 1) / 2);
+	size_t mismatch_count = 0;
+
+	// Small integers are summed exactly in any order
+	{
+		std::vector<float> data(elem_count);
+		for(size_t i = 0; i < elem_count; ++i)
+			data[i] = static_cast<float>(i % 97) * rank_factor;
+		communicator->reduce_all(&data[0], elem_count);
+		for(size_t i = 0; i < elem_count; ++i)
+			if (data[i] != static_cast<float>(i % 97) * rank_factor_sum)
+				++mismatch_count;
+	}
+
+	{
+		std::vector<float> data(elem_count);
+		for(size_t i = 0; i < elem_count; ++i)
+			data[i] = static_cast<float>(i % 89 + worker_process_rank * 100);
+		communicator->broadcast(&data[0], elem_count);
+		for(size_t i = 0; i < elem_count; ++i)
+			if (data[i] != static_cast<float>(i % 89))
+				++mismatch_count;
+	}
+
+	// Buffers of different sizes are enqueued one after another, the way gradients of the layers are, twice to reuse the queue
+	{
+		std::vector<size_t> buffer_elem_count_list;
+		buffer_elem_count_list.push_back(1);
+		buffer_elem_count_list.push_back(elem_count / 3 + 1);
+		buffer_elem_count_list.push_back(17);
+		buffer_elem_count_list.push_back(elem_count);
+		std::vector<std::vector<float> > buffer_list(buffer_elem_count_list.size());
+
+		nnforge::plain::plain_reduce_all_queue queue(communicator);
+		for(unsigned int pass = 0; pass < 2; ++pass)
+		{
+			for(unsigned int buffer_id = 0; buffer_id < buffer_list.size(); ++buffer_id)
+			{
+				std::vector<float>& data = buffer_list[buffer_id];
+				data.resize(buffer_elem_count_list[buffer_id]);
+				for(size_t i = 0; i < data.size(); ++i)
+					data[i] = static_cast<float>(i % 13 + buffer_id + pass) * rank_factor;
+				queue.enqueue(&data[0], data.size());
+			}
+
+			queue.wait();
+
+			for(unsigned int buffer_id = 0; buffer_id < buffer_list.size(); ++buffer_id)
+			{
+				const std::vector<float>& data = buffer_list[buffer_id];
+				for(size_t i = 0; i < data.size(); ++i)
+					if (data[i] != static_cast<float>(i % 13 + buffer_id + pass) * rank_factor_sum)
+						++mismatch_count;
+			}
+		}
+	}
+
+	if (mismatch_count > 0)
+		throw nnforge::neural_network_exception((boost::format("%1% values differ from expected after reduce_all and broadcast with %2% communicator") % mismatch_count % communicator->get_type_name()).str());
+
+	std::cout << "reduce_all and broadcast with " << communicator->get_type_name() << " communicator passed" << std::endl;
+}
+
+std::vector<std::string> worker_process_check_toolset::get_child_args(
+	const std::string& child_action,
+	unsigned int process_count) const
+{
+	std::vector<std::string> res;
+	res.push_back(child_action);
+	for(std::vector<std::string>::const_iterator it = command_line_args.begin() + 1; it != command_line_args.end(); ++it)
+	{
+		if ((*it == action) || (it->find("--action") == 0) || (it->find("--ann_count") == 0) || (it->find("--resume_from_snapshot") == 0)
+			|| (it->find("--worker_process_count") == 0) || (it->find("--worker_process_rank") == 0) || (it->find("--worker_process_group") == 0) || (it->find("--worker_process_check_run") == 0))
+			continue;
+		if ((worker_process_check_tcp_port > 0) && ((it->find("--plain_communicator") == 0) || (it->find("--plain_tcp_peer") == 0)))
+			continue;
+		res.push_back(*it);
+	}
+
+	res.push_back((boost::format("--worker_process_count=%1%") % process_count).str());
+	if (worker_process_check_tcp_port > 0)
+	{
+		res.push_back("--plain_communicator=tcp");
+		for(unsigned int rank = 0; rank < process_count; ++rank)
+			res.push_back((boost::format("--plain_tcp_peer=127.0.0.1:%1%") % (worker_process_check_tcp_port + rank)).str());
+	}
+
+	return res;
+}
+
+float worker_process_check_toolset::get_max_difference(
+	const nnforge::network_data& data1,
+	const nnforge::network_data& data2)
+{
+	float res = 0.0F;
+
+	std::vector<std::string> layer_name_list = data1.data_list.get_data_layer_name_list();
+	for(std::vector<std::string>::const_iterator it = layer_name_list.begin(); it != layer_name_list.end(); ++it)
+	{
+		nnforge::layer_data::ptr layer_data1 = data1.data_list.get(*it);
+		nnforge::layer_data::ptr layer_data2 = data2.data_list.find(*it);
+		if ((!layer_data2) || (layer_data2->size() != layer_data1->size()))
+			throw nnforge::neural_network_exception((boost::format("Trained weights of layer %1% differ in shape") % *it).str());
+
+		for(unsigned int part_id = 0; part_id < layer_data1->size(); ++part_id)
+		{
+			const std::vector<float>& part1 = layer_data1->at(part_id);
+			const std::vector<float>& part2 = layer_data2->at(part_id);
+			if (part1.size() != part2.size())
+				throw nnforge::neural_network_exception((boost::format("Trained weights of layer %1% differ in shape") % *it).str());
+
+			for(unsigned int i = 0; i < part1.size(); ++i)
+				res = std::max(res, fabsf(part1[i] - part2[i]));
+		}
+	}
+
+	return res;
+}
+
+std::vector<unsigned int> worker_process_check_toolset::parse_count_list(
+	const std::string& str,
+	const char * option_name)
+{
+	std::vector<std::string> strs;
+	boost::split(strs, str, boost::is_any_of(","));
+
+	std::vector<unsigned int> res;
+	for(std::vector<std::string>::iterator it = strs.begin(); it != strs.end(); ++it)
+	{
+		boost::trim(*it);
+		if (it->empty())
+			continue;
+
+		unsigned int val;
+		try
+		{
+			val = boost::lexical_cast<unsigned int>(*it);
+		}
+		catch (const boost::bad_lexical_cast&)
+		{
+			throw nnforge::neural_network_exception((boost::format("Invalid value %1% in %2%") % *it % option_name).str());
+		}
+		if (val < 2)
+			throw nnforge::neural_network_exception((boost::format("Worker process count %1% in %2% is less than 2") % val % option_name).str());
+		res.push_back(val);
+	}
+
+	if (res.empty())
+		throw nnforge::neural_network_exception((boost::format("No values specified in %1%") % option_name).str());
+
+	return res;
+}
@@ -0,0 +1,93 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <nnforge/toolset.h>
+#include <nnforge/network_data.h>
+
+#include <string>
+#include <vector>
+
+// Checks reduce_all and broadcast of the communicator with several worker processes on this host,
+// then trains the same network with 1 and with several worker processes and compares the weights
+class worker_process_check_toolset : public nnforge::toolset
+{
+public:
+	worker_process_check_toolset(nnforge::factory_generator::ptr factory);
+
+	virtual ~worker_process_check_toolset() = default;
+
+protected:
+	virtual std::string get_default_action() const;
+
+	virtual void do_custom_action();
+
+	virtual std::vector<nnforge::string_option> get_string_options();
+
+	virtual std::vector<nnforge::float_option> get_float_options();
+
+	virtual std::vector<nnforge::int_option> get_int_options();
+
+	virtual nnforge::network_schema::ptr load_schema() const;
+
+	virtual boost::filesystem::path get_ann_subfolder_name() const;
+
+	virtual bool is_training_with_validation() const;
+
+	// Synthetic entries, the same in every process
+	virtual nnforge::structured_data_bunch_reader::ptr get_structured_data_bunch_reader(
+		const std::string& dataset_name,
+		dataset_usage usage,
+		unsigned int multiple_epoch_count,
+		unsigned int shuffle_block_size) const;
+
+	void run_worker_process_check();
+
+	// Runs in each of the worker processes launched by check_communicator
+	void run_communicator_check();
+
+	// Launches process_count worker processes running reduce_all and broadcast directly and through plain_reduce_all_queue
+	void check_communicator(unsigned int process_count) const;
+
+	// Runs train action in a child process, which launches the rest of worker processes, and returns the trained weights
+	nnforge::network_data::ptr train_with_worker_processes(
+		const nnforge::network_data& initial_data,
+		unsigned int process_count) const;
+
+	// Arguments of this process with the action and worker process options replaced
+	std::vector<std::string> get_child_args(
+		const std::string& child_action,
+		unsigned int process_count) const;
+
+private:
+	static float get_max_difference(
+		const nnforge::network_data& data1,
+		const nnforge::network_data& data2);
+
+	static std::vector<unsigned int> parse_count_list(
+		const std::string& str,
+		const char * option_name);
+
+private:
+	std::string worker_process_check_process_counts;
+	std::string worker_process_check_run;
+	float worker_process_check_max_difference;
+	int worker_process_check_entry_count;
+	int worker_process_check_seed;
+	int worker_process_check_tcp_port;
+	int worker_process_check_communicator_elem_count;
+};
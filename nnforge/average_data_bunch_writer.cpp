@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "average_data_bunch_writer.h"
+
+namespace nnforge
+{
+	void average_data_bunch_writer::set_config_map(const std::map<std::string, layer_configuration_specific> config_map)
+	{
+		std::lock_guard<std::mutex> lock(thread_id_to_partial_sum_map_mutex);
+
+		this->config_map = config_map;
+		thread_id_to_partial_sum_map.clear();
+	}
+
+	void average_data_bunch_writer::write(
+		unsigned int entry_id,
+		const std::map<std::string, const float *>& data_map)
+	{
+		partial_sum& sum = get_partial_sum();
+
+		for(std::map<std::string, const float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+		{
+			std::vector<double>& layer_sum = sum.layer_name_to_sum_map[it->first];
+			if (layer_sum.empty())
+				layer_sum.resize(config_map.find(it->first)->second.get_neuron_count(), 0.0);
+
+			const float * src = it->second;
+			for(std::vector<double>::iterator dst_it = layer_sum.begin(); dst_it != layer_sum.end(); ++dst_it, ++src)
+				*dst_it += static_cast<double>(*src);
+		}
+
+		++sum.entry_count;
+	}
+
+	average_data_bunch_writer::partial_sum& average_data_bunch_writer::get_partial_sum()
+	{
+		std::lock_guard<std::mutex> lock(thread_id_to_partial_sum_map_mutex);
+
+		std::shared_ptr<partial_sum>& res = thread_id_to_partial_sum_map[std::this_thread::get_id()];
+		if (!res)
+			res = std::shared_ptr<partial_sum>(new partial_sum());
+
+		return *res;
+	}
+
+	std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > average_data_bunch_writer::get_average() const
+	{
+		std::lock_guard<std::mutex> lock(thread_id_to_partial_sum_map_mutex);
+
+		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > res;
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+			res.insert(std::make_pair(it->first, std::make_pair(it->second, std::shared_ptr<std::vector<double> >(new std::vector<double>(it->second.get_neuron_count(), 0.0)))));
+
+		unsigned int entry_count = 0;
+		for(std::map<std::thread::id, std::shared_ptr<partial_sum> >::const_iterator it = thread_id_to_partial_sum_map.begin(); it != thread_id_to_partial_sum_map.end(); ++it)
+		{
+			const partial_sum& sum = *it->second;
+			for(std::map<std::string, std::vector<double> >::const_iterator it2 = sum.layer_name_to_sum_map.begin(); it2 != sum.layer_name_to_sum_map.end(); ++it2)
+			{
+				std::vector<double>& dst = *res[it2->first].second;
+				for(unsigned int i = 0; i < static_cast<unsigned int>(it2->second.size()); ++i)
+					dst[i] += it2->second[i];
+			}
+			entry_count += sum.entry_count;
+		}
+
+		if (entry_count > 0)
+		{
+			double mult = 1.0 / static_cast<double>(entry_count);
+			for(std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > >::iterator it = res.begin(); it != res.end(); ++it)
+				for(std::vector<double>::iterator it2 = it->second.second->begin(); it2 != it->second.second->end(); ++it2)
+					*it2 *= mult;
+		}
+
+		return res;
+	}
+
+	unsigned int average_data_bunch_writer::get_entry_count() const
+	{
+		std::lock_guard<std::mutex> lock(thread_id_to_partial_sum_map_mutex);
+
+		unsigned int res = 0;
+		for(std::map<std::thread::id, std::shared_ptr<partial_sum> >::const_iterator it = thread_id_to_partial_sum_map.begin(); it != thread_id_to_partial_sum_map.end(); ++it)
+			res += it->second->entry_count;
+
+		return res;
+	}
+}
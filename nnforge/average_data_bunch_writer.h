@@ -0,0 +1,71 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_bunch_writer.h"
+
+#include <map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+
+namespace nnforge
+{
+	// Keeps running sums of the entries written instead of entries themselves, memory used doesn't depend on entry count.
+	// Each writing thread accumulates its own sums, they are merged when averages are requested
+	class average_data_bunch_writer : public structured_data_bunch_writer
+	{
+	public:
+		typedef std::shared_ptr<average_data_bunch_writer> ptr;
+
+		average_data_bunch_writer() = default;
+
+		virtual ~average_data_bunch_writer() = default;
+
+		virtual void set_config_map(const std::map<std::string, layer_configuration_specific> config_map);
+
+		virtual void write(
+			unsigned int entry_id,
+			const std::map<std::string, const float *>& data_map);
+
+		// Per neuron averages across all the entries written
+		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > get_average() const;
+
+		unsigned int get_entry_count() const;
+
+	private:
+		struct partial_sum
+		{
+			partial_sum()
+				: entry_count(0)
+			{
+			}
+
+			std::map<std::string, std::vector<double> > layer_name_to_sum_map;
+			unsigned int entry_count;
+		};
+
+		partial_sum& get_partial_sum();
+
+	private:
+		std::map<std::string, layer_configuration_specific> config_map;
+
+		mutable std::mutex thread_id_to_partial_sum_map_mutex;
+		std::map<std::thread::id, std::shared_ptr<partial_sum> > thread_id_to_partial_sum_map;
+	};
+}
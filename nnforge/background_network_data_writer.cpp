@@ -0,0 +1,252 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "background_network_data_writer.h"
+
+#include "neural_network_exception.h"
+
+#include <iostream>
+#include <boost/format.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace nnforge
+{
+	background_network_data_writer::background_network_data_writer(bool sync_to_disk)
+		: sync_to_disk(sync_to_disk)
+		, next_buffer_set_id(0)
+		, job_pending(false)
+		, stop_requested(false)
+	{
+		writer_thread = std::thread([this] () { run(); });
+	}
+
+	background_network_data_writer::~background_network_data_writer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(job_mutex);
+			stop_requested = true;
+		}
+		job_condition.notify_all();
+		writer_thread.join();
+
+		if (write_error)
+		{
+			try
+			{
+				std::rethrow_exception(write_error);
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "Writing network data failed: " << e.what() << std::endl;
+			}
+			catch (...)
+			{
+				std::cerr << "Writing network data failed" << std::endl;
+			}
+		}
+	}
+
+	void background_network_data_writer::write(const std::vector<std::pair<network_data::const_ptr, boost::filesystem::path> >& data_folder_list)
+	{
+		// The write in progress uses the other buffer set, so copying overlaps with it
+		std::vector<network_data::ptr>& buffer_set = buffer_sets[next_buffer_set_id];
+		buffer_set.resize(std::max(buffer_set.size(), data_folder_list.size()));
+		std::vector<std::pair<network_data::ptr, boost::filesystem::path> > new_job;
+		for(unsigned int i = 0; i < data_folder_list.size(); ++i)
+		{
+			network_data::ptr buffer;
+			if (data_folder_list[i].first)
+			{
+				if (!buffer_set[i])
+					buffer_set[i] = network_data::ptr(new network_data());
+				copy_data(*data_folder_list[i].first, *buffer_set[i]);
+				buffer = buffer_set[i];
+			}
+			new_job.push_back(std::make_pair(buffer, data_folder_list[i].second));
+		}
+
+		wait();
+
+		{
+			std::lock_guard<std::mutex> lock(job_mutex);
+			job = new_job;
+			job_pending = true;
+		}
+		job_condition.notify_all();
+		next_buffer_set_id = 1 - next_buffer_set_id;
+	}
+
+	void background_network_data_writer::wait()
+	{
+		std::unique_lock<std::mutex> lock(job_mutex);
+		job_condition.wait(lock, [this] () { return !job_pending; });
+		if (write_error)
+		{
+			std::exception_ptr error = write_error;
+			write_error = std::exception_ptr();
+			std::rethrow_exception(error);
+		}
+	}
+
+	void background_network_data_writer::run()
+	{
+		while (true)
+		{
+			std::vector<std::pair<network_data::ptr, boost::filesystem::path> > current_job;
+			{
+				std::unique_lock<std::mutex> lock(job_mutex);
+				job_condition.wait(lock, [this] () { return job_pending || stop_requested; });
+				if (!job_pending)
+					return;
+				current_job = job;
+			}
+
+			std::exception_ptr error;
+			try
+			{
+				for(std::vector<std::pair<network_data::ptr, boost::filesystem::path> >::const_iterator it = current_job.begin(); it != current_job.end(); ++it)
+				{
+					if (it->first)
+						write_folder(*it->first, it->second);
+					else
+						boost::filesystem::remove_all(it->second);
+				}
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(job_mutex);
+				write_error = error;
+				job_pending = false;
+			}
+			job_condition.notify_all();
+		}
+	}
+
+	void background_network_data_writer::write_folder(
+		const network_data& data,
+		const boost::filesystem::path& folder_path) const
+	{
+		boost::filesystem::path temp_folder_path = folder_path;
+		temp_folder_path += ".temp";
+		if (boost::filesystem::exists(temp_folder_path))
+			boost::filesystem::remove_all(temp_folder_path);
+
+		data.write(temp_folder_path);
+
+		// All the files of the folder are flushed at once, after they are written
+		if (sync_to_disk)
+		{
+			for(boost::filesystem::recursive_directory_iterator it(temp_folder_path); it != boost::filesystem::recursive_directory_iterator(); ++it)
+				sync_path(it->path());
+			sync_path(temp_folder_path);
+		}
+
+		// The previous folder is moved aside and removed only when the new one is in place,
+		// so that one of them is always complete, either under its own name or with .old suffix, which recover_folders brings back
+		boost::filesystem::path old_folder_path = folder_path;
+		old_folder_path += ".old";
+		if (boost::filesystem::exists(folder_path))
+		{
+			if (boost::filesystem::exists(old_folder_path))
+				boost::filesystem::remove_all(old_folder_path);
+			boost::filesystem::rename(folder_path, old_folder_path);
+		}
+		boost::filesystem::rename(temp_folder_path, folder_path);
+
+		if (sync_to_disk)
+			sync_path(folder_path.parent_path());
+
+		if (boost::filesystem::exists(old_folder_path))
+			boost::filesystem::remove_all(old_folder_path);
+	}
+
+	void background_network_data_writer::copy_data(
+		const network_data& src,
+		network_data& dst)
+	{
+		// Assigning to the existing layer data reuses its memory, the destination is cleared when it has layers missing from the source
+		std::vector<std::string> data_layer_name_list = src.data_list.get_data_layer_name_list();
+		if (dst.data_list.get_data_layer_name_list() != data_layer_name_list)
+			dst.data_list = layer_data_list();
+		for(std::vector<std::string>::const_iterator it = data_layer_name_list.begin(); it != data_layer_name_list.end(); ++it)
+		{
+			layer_data::ptr d = dst.data_list.find(*it);
+			if (d)
+				*d = *src.data_list.get(*it);
+			else
+				dst.data_list.add(*it, layer_data::ptr(new layer_data(*src.data_list.get(*it))));
+		}
+
+		std::vector<std::string> data_custom_layer_name_list = src.data_custom_list.get_data_custom_layer_name_list();
+		if (dst.data_custom_list.get_data_custom_layer_name_list() != data_custom_layer_name_list)
+			dst.data_custom_list = layer_data_custom_list();
+		for(std::vector<std::string>::const_iterator it = data_custom_layer_name_list.begin(); it != data_custom_layer_name_list.end(); ++it)
+		{
+			layer_data_custom::ptr d = dst.data_custom_list.find(*it);
+			if (d)
+				*d = *src.data_custom_list.get(*it);
+			else
+				dst.data_custom_list.add(*it, layer_data_custom::ptr(new layer_data_custom(*src.data_custom_list.get(*it))));
+		}
+	}
+
+	void background_network_data_writer::recover_folders(const boost::filesystem::path& parent_folder_path)
+	{
+		if (!boost::filesystem::is_directory(parent_folder_path))
+			return;
+
+		std::vector<boost::filesystem::path> old_folder_path_list;
+		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(parent_folder_path); it != boost::filesystem::directory_iterator(); ++it)
+			if ((it->status().type() == boost::filesystem::directory_file) && (it->path().extension().string() == ".old"))
+				old_folder_path_list.push_back(it->path());
+
+		for(std::vector<boost::filesystem::path>::const_iterator it = old_folder_path_list.begin(); it != old_folder_path_list.end(); ++it)
+		{
+			boost::filesystem::path folder_path = *it;
+			folder_path.replace_extension();
+			if (boost::filesystem::exists(folder_path))
+			{
+				boost::filesystem::remove_all(*it);
+			}
+			else
+			{
+				std::cout << "Recovering " << folder_path.string() << " from the interrupted write" << std::endl;
+				boost::filesystem::rename(*it, folder_path);
+			}
+		}
+	}
+
+	void background_network_data_writer::sync_path(const boost::filesystem::path& path)
+	{
+		#ifndef _WIN32
+		int fd = ::open(path.string().c_str(), O_RDONLY);
+		if (fd < 0)
+			throw neural_network_exception((boost::format("Unable to open %1% to flush it to the disk") % path.string()).str());
+		int res = ::fsync(fd);
+		::close(fd);
+		if (res != 0)
+			throw neural_network_exception((boost::format("Unable to flush %1% to the disk") % path.string()).str());
+		#endif
+	}
+}
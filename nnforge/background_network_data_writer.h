@@ -0,0 +1,87 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "network_data.h"
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <boost/filesystem.hpp>
+
+namespace nnforge
+{
+	// Writes network data to folders on a background I/O thread.
+	// The data is copied to one of the two buffer sets first, which are reused from one write to another,
+	// so the caller is blocked only when the previous write is not complete yet
+	class background_network_data_writer
+	{
+	public:
+		typedef std::shared_ptr<background_network_data_writer> ptr;
+
+		// Each folder is flushed to the disk before it is renamed when sync_to_disk is set
+		background_network_data_writer(bool sync_to_disk = false);
+
+		// Waits for the write in progress to complete, the error it fails with is only reported to stderr, call wait to get it
+		~background_network_data_writer();
+
+		// Each data is written to a temporary folder, which replaces the destination one when complete.
+		// Empty data means the destination folder or file should be removed
+		void write(const std::vector<std::pair<network_data::const_ptr, boost::filesystem::path> >& data_folder_list);
+
+		// Waits for the write in progress to complete, rethrows the exception it failed with
+		void wait();
+
+		// Moves the folders an interrupted write left with .old suffix back to their names when those are free, removes the rest of .old folders
+		static void recover_folders(const boost::filesystem::path& parent_folder_path);
+
+		// Flushes the file or the folder entry to the disk, does nothing on Windows
+		static void sync_path(const boost::filesystem::path& path);
+
+	private:
+		void run();
+
+		void write_folder(
+			const network_data& data,
+			const boost::filesystem::path& folder_path) const;
+
+		static void copy_data(
+			const network_data& src,
+			network_data& dst);
+
+	private:
+		bool sync_to_disk;
+
+		std::vector<network_data::ptr> buffer_sets[2];
+		unsigned int next_buffer_set_id;
+
+		std::thread writer_thread;
+		std::mutex job_mutex;
+		std::condition_variable job_condition;
+		std::vector<std::pair<network_data::ptr, boost::filesystem::path> > job;
+		bool job_pending;
+		bool stop_requested;
+		std::exception_ptr write_error;
+
+	private:
+		background_network_data_writer(const background_network_data_writer&) = delete;
+		background_network_data_writer& operator =(const background_network_data_writer&) = delete;
+	};
+}
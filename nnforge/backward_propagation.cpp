@@ -21,6 +21,7 @@
 
 #include <boost/format.hpp>
 #include <chrono>
+#include <algorithm>
 #include <boost/filesystem/fstream.hpp>
 
 namespace nnforge
@@ -37,6 +38,10 @@ namespace nnforge
 		, exclude_data_update_layer_names(exclude_data_update_layer_names)
 		, debug(debug)
 		, profile(profile)
+		, skipped_flops(0.0F)
+		, forward_flops(0.0F)
+		, backward_entry_ratio(1.0F)
+		, chunk_size(0)
 	{
 		if (error_source_layer_names.empty())
 			throw neural_network_exception("No error source layers specified for backward_propagation");
@@ -59,6 +64,17 @@ namespace nnforge
 			exclude_data_update_layer_names,
 			same_output_action_sets,
 			gradient_to_producing_actions_map);
+		if (!exclude_data_update_layer_names.empty())
+		{
+			std::vector<std::vector<layer_name_with_action> > unfrozen_same_output_action_sets;
+			std::map<std::string, std::vector<layer_name_with_action> > unfrozen_gradient_to_producing_actions_map;
+			unfrozen_action_schema = this->schema->get_actions_for_backward_propagation(
+				output_layer_names,
+				error_source_layer_names,
+				std::vector<std::string>(),
+				unfrozen_same_output_action_sets,
+				unfrozen_gradient_to_producing_actions_map);
+		}
 		for(std::vector<std::vector<layer_name_with_action> >::const_iterator it = same_output_action_sets.begin(); it != same_output_action_sets.end(); ++it)
 		{
 			const std::vector<layer_name_with_action>& same_output_actions = *it;
@@ -161,9 +177,16 @@ namespace nnforge
 
 	void backward_propagation::update_flops()
 	{
+		std::map<layer_name_with_action, float> flops_per_action = action_schema->get_flops_per_action(layer_config_map, cumulative_tiling_factor_map);
 		if (profile->is_profile())
-			action_flops_per_entry = action_schema->get_flops_per_action(layer_config_map, cumulative_tiling_factor_map);
+			action_flops_per_entry = flops_per_action;
 		flops = action_schema->get_flops(layer_config_map, cumulative_tiling_factor_map);
+		forward_flops = 0.0F;
+		for(std::map<layer_name_with_action, float>::const_iterator it = flops_per_action.begin(); it != flops_per_action.end(); ++it)
+			if (it->first.get_action().get_action_type() == layer_action::forward)
+				forward_flops += it->second;
+		if (unfrozen_action_schema)
+			skipped_flops = std::max(unfrozen_action_schema->get_flops(layer_config_map, cumulative_tiling_factor_map) - flops, 0.0F);
 	}
 
 	backward_propagation::stat backward_propagation::run(
@@ -188,6 +211,7 @@ namespace nnforge
 		set_input_configuration_specific(reader.get_config_map());
 		structured_data_bunch_reader::ptr narrow_reader = reader.get_narrow_reader(data_layer_names);
 		res.flops_per_entry = flops;
+		res.skipped_flops_per_entry = skipped_flops;
 		std::vector<std::string> data_layer_name_list(data_layer_names.begin(), data_layer_names.end());
 		std::map<std::string, layer_configuration_specific> output_config_map;
 		for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
@@ -195,6 +219,9 @@ namespace nnforge
 		writer.set_config_map(output_config_map);
 		std::map<layer_name_with_action, float> action_seconds;
 		float idle_seconds;
+		chunk_size = 0;
+		skipped_gradient_size = 0;
+		backward_entry_ratio = 1.0F;
 		actual_run(
 			narrow_reader ? *narrow_reader : reader,
 			writer,
@@ -214,6 +241,15 @@ namespace nnforge
 		std::chrono::duration<float> sec = std::chrono::high_resolution_clock::now() - start;
 		res.total_seconds = sec.count();
 		res.idle_seconds = idle_seconds;
+		res.chunk_size = chunk_size;
+		res.skipped_gradient_size = skipped_gradient_size;
+		res.backward_entry_ratio = backward_entry_ratio;
+		res.selectively_skipped_flops_per_entry = 0.0F;
+		if (backward_entry_ratio < 1.0F)
+		{
+			res.selectively_skipped_flops_per_entry = (1.0F - backward_entry_ratio) * (flops - forward_flops);
+			res.flops_per_entry = flops - res.selectively_skipped_flops_per_entry;
+		}
 
 		if (profile->is_profile() && !action_seconds.empty())
 		{
@@ -245,6 +281,14 @@ namespace nnforge
 		float idle_overhead = val.idle_seconds / val.total_seconds;
 		float gflops = val.flops_per_entry * static_cast<float>(val.entry_processed_count) / val.total_seconds * 1.0e-9F;
 		out << (boost::format("%|1$.2f| seconds, idle %|2$.1f|%%, %3% entries, %|4$.2e| flops per entry, %|5$.1f| GFLOPS") % val.total_seconds % (idle_overhead * 100.0F) % val.entry_processed_count % val.flops_per_entry % gflops).str();
+		if (val.chunk_size > 0)
+			out << ", chunk " << val.chunk_size;
+		if (val.skipped_flops_per_entry > 0.0F)
+			out << (boost::format(", %|1$.2e| flops per entry skipped on frozen layers") % val.skipped_flops_per_entry).str();
+		if (val.skipped_gradient_size > 0)
+			out << ", " << ((val.skipped_gradient_size + 1024 - 1) / 1024) << " KB of gradients saved on frozen layers";
+		if (val.backward_entry_ratio < 1.0F)
+			out << (boost::format(", backward pass for %|1$.1f|%% of entries, %|2$.2e| flops per entry saved") % (val.backward_entry_ratio * 100.0F) % val.selectively_skipped_flops_per_entry).str();
 		return out;
 	}
 }
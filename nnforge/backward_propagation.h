@@ -46,6 +46,15 @@ namespace nnforge
 			float flops_per_entry;
 			float total_seconds;
 			float idle_seconds;
+			// The largest number of entries processed at once, 0 when not reported
+			unsigned int chunk_size;
+			// Backward flops per entry not spent on the layers excluded from training, 0 when none are excluded
+			float skipped_flops_per_entry;
+			// Bytes of gradients not allocated for the layers excluded from training, 0 when none are excluded or it is not reported
+			size_t skipped_gradient_size;
+			// Fraction of entries backward pass was run for, and the flops per entry saved by skipping it for the rest, net of repeating forward pass
+			float backward_entry_ratio;
+			float selectively_skipped_flops_per_entry;
 			std::map<std::string, std::vector<float> > average_absolute_updates;
 		};
 
@@ -119,6 +128,16 @@ namespace nnforge
 		unsigned int output_layers_tiling_factor;
 		std::map<layer_name_with_action, float> action_flops_per_entry;
 		float flops;
+		// Built when some layers are excluded from training, it has all the layers of the schema trained and is used to report the flops saved
+		network_action_schema::const_ptr unfrozen_action_schema;
+		float skipped_flops;
+		float forward_flops;
+		// actual_run sets it when backward pass is run for a part of the entries only, it is 1 otherwise
+		float backward_entry_ratio;
+		// actual_run sets it to the largest number of entries processed at once
+		unsigned int chunk_size;
+		// actual_run sets it to the size of gradients and the related buffers not allocated for the layers excluded from training
+		size_t skipped_gradient_size;
 		std::set<std::string> data_layer_names;
 		std::map<std::string, std::vector<layer_name_with_action>> gradient_to_producing_actions_map;
 
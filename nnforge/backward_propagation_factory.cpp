@@ -18,4 +18,24 @@
 
 namespace nnforge
 {
+	std::vector<backward_propagation::ptr> backward_propagation_factory::create_concurrent(
+		const network_schema& schema,
+		const std::vector<std::string>& output_layer_names,
+		const std::vector<std::string>& error_source_layer_names,
+		const std::vector<std::string>& exclude_data_update_layer_names,
+		unsigned int count,
+		debug_state::ptr debug,
+		profile_state::ptr profile) const
+	{
+		std::vector<backward_propagation::ptr> res;
+		for(unsigned int i = 0; i < count; ++i)
+			res.push_back(create(
+				schema,
+				output_layer_names,
+				error_source_layer_names,
+				exclude_data_update_layer_names,
+				debug,
+				profile));
+		return res;
+	}
 }
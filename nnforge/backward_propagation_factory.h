@@ -42,6 +42,17 @@ namespace nnforge
 			debug_state::ptr debug,
 			profile_state::ptr profile) const = 0;
 
+		// Creates count backward propagations running at the same time, each of them gets its share of the backend resources
+		// The default implementation creates count independent ones
+		virtual std::vector<backward_propagation::ptr> create_concurrent(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			const std::vector<std::string>& error_source_layer_names,
+			const std::vector<std::string>& exclude_data_update_layer_names,
+			unsigned int count,
+			debug_state::ptr debug,
+			profile_state::ptr profile) const;
+
 	protected:
 		backward_propagation_factory() = default;
 	};
@@ -32,6 +32,7 @@ namespace nnforge
 		float epsilon)
 		: feature_map_count(feature_map_count)
 		, epsilon(epsilon)
+		, use_batch_statistics(false)
 	{
 		check();
 	}
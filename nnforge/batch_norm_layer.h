@@ -66,6 +66,9 @@ namespace nnforge
 	public:
 		unsigned int feature_map_count;
 		float epsilon;
+		// Normalize with statistics of the entries processed at once instead of stored mean and inverse std_dev,
+		// it is used when recalibrating the statistics and is not serialized
+		bool use_batch_statistics;
 
 		static const float default_batch_normalization_epsilon;
 	};
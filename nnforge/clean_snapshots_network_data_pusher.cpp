@@ -17,13 +17,14 @@
 #include "clean_snapshots_network_data_pusher.h"
 
 #include "neural_network_exception.h"
+#include "network_data_checkpoint.h"
 
 #include <boost/filesystem/fstream.hpp>
 #include <boost/format.hpp>
 
 namespace nnforge
 {
-	const char * clean_snapshots_network_data_pusher::snapshot_ann_index_extractor_pattern = "^ann_trained_(\\d+)_epoch_(\\d+)$";
+	const char * clean_snapshots_network_data_pusher::snapshot_ann_index_extractor_pattern = "^ann_trained_(\\d+)_epoch_(\\d+)(\\.nnc)?$";
 	
 	clean_snapshots_network_data_pusher::clean_snapshots_network_data_pusher(
 		const boost::filesystem::path& folder_path,
@@ -43,9 +44,13 @@ namespace nnforge
 		{
 			unsigned int current_index = task_state.index_peeked;
 			std::string snapshot_folder_name = (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % current_index % previous_epoch).str();
+			// The snapshot might be either a folder or a checkpoint file
 			boost::filesystem::path folder_path_to_clean = folder_path / snapshot_folder_name;
+			boost::filesystem::path file_path_to_clean = folder_path / (snapshot_folder_name + network_data_checkpoint::file_extension);
 			if (boost::filesystem::exists(folder_path_to_clean))
 				boost::filesystem::remove_all(folder_path_to_clean);
+			if (boost::filesystem::exists(file_path_to_clean))
+				boost::filesystem::remove(file_path_to_clean);
 		}
 	}
 }
@@ -27,4 +27,12 @@ namespace nnforge
 			(*it)->push(task_state, schema);
 		}
 	}
+
+	void complex_network_data_pusher::flush()
+	{
+		for(complex_network_data_pusher::iterator it = begin(); it != end(); it++)
+		{
+			(*it)->flush();
+		}
+	}
 }
@@ -32,5 +32,7 @@ namespace nnforge
 		virtual void push(
 			const training_task_state& task_state,
 			const network_schema& schema);
+
+		virtual void flush();
 	};
 }
@@ -0,0 +1,39 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "composite_data_bunch_writer.h"
+
+namespace nnforge
+{
+	composite_data_bunch_writer::composite_data_bunch_writer(const std::vector<structured_data_bunch_writer::ptr>& writers)
+		: writers(writers)
+	{
+	}
+
+	void composite_data_bunch_writer::set_config_map(const std::map<std::string, layer_configuration_specific> config_map)
+	{
+		for(std::vector<structured_data_bunch_writer::ptr>::const_iterator it = writers.begin(); it != writers.end(); ++it)
+			(*it)->set_config_map(config_map);
+	}
+
+	void composite_data_bunch_writer::write(
+		unsigned int entry_id,
+		const std::map<std::string, const float *>& data_map)
+	{
+		for(std::vector<structured_data_bunch_writer::ptr>::const_iterator it = writers.begin(); it != writers.end(); ++it)
+			(*it)->write(entry_id, data_map);
+	}
+}
@@ -18,6 +18,7 @@
 
 #include "neural_network_cudnn_exception.h"
 #include "util_cuda.h"
+#include "cudnn_util.h"
 
 #include "../batch_norm_layer.h"
 
@@ -59,6 +60,18 @@ namespace nnforge
 			}
 		}
 
+		batch_norm_layer_tester_cuda::batch_norm_layer_tester_cuda()
+		{
+			cudnn_safe_call(cudnnCreateTensorDescriptor(&weights_desc));
+			cudnn_safe_call(cudnnCreateTensorDescriptor(&data_desc));
+		}
+
+		batch_norm_layer_tester_cuda::~batch_norm_layer_tester_cuda()
+		{
+			cudnnDestroyTensorDescriptor(weights_desc);
+			cudnnDestroyTensorDescriptor(data_desc);
+		}
+
 		void batch_norm_layer_tester_cuda::enqueue_forward_propagation(
 			cudaStream_t stream_id,
 			cuda_linear_buffer_device::ptr output_buffer,
@@ -71,6 +84,38 @@ namespace nnforge
 			cuda_linear_buffer_device::ptr temporary_working_per_entry_buffer,
 			unsigned int entry_count)
 		{
+			if (use_batch_statistics)
+			{
+				cudnn_safe_call(cudnnSetStream(cuda_config->get_cudnn_handle(), stream_id));
+
+				cudnn_util::set_tensor_descriptor(
+					data_desc,
+					output_configuration_specific,
+					entry_count);
+
+				float alpha = 1.0F;
+				float beta = 0.0F;
+				cudnn_safe_call(cudnnBatchNormalizationForwardTraining(
+					cuda_config->get_cudnn_handle(),
+					CUDNN_BATCHNORM_SPATIAL,
+					&alpha,
+					&beta,
+					data_desc,
+					*input_buffers[0],
+					data_desc,
+					*output_buffer,
+					weights_desc,
+					*data[0],
+					*data[1],
+					1.0,
+					0,
+					0,
+					epsilon,
+					0,
+					0));
+				return;
+			}
+
 			std::pair<dim3, dim3> kernel_dims = cuda_util::get_grid_and_threadblock_sizes_sequential_access(
 				*cuda_config,
 				output_elem_count_per_feature_map,
@@ -96,11 +141,19 @@ namespace nnforge
 			epsilon = layer_derived->epsilon;
 			if (epsilon < CUDNN_BN_MIN_EPSILON)
 				throw neural_network_exception((boost::format("Too small epsilon specified: %1%, cuDNN requires at least %2%") % epsilon % CUDNN_BN_MIN_EPSILON).str());
+
+			use_batch_statistics = layer_derived->use_batch_statistics;
+			if (use_batch_statistics)
+				cudnn_util::set_tensor_bn_weights_descriptor(
+					weights_desc,
+					output_configuration_specific.feature_map_count,
+					static_cast<unsigned int>(output_configuration_specific.dimension_sizes.size()));
 		}
 
 		int batch_norm_layer_tester_cuda::get_input_index_layer_can_write() const
 		{
-			return 0;
+			// cuDNN batch statistics are computed out of place
+			return use_batch_statistics ? -1 : 0;
 		}
 	}
 }
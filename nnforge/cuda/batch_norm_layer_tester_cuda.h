@@ -25,9 +25,9 @@ namespace nnforge
 		class batch_norm_layer_tester_cuda : public layer_tester_cuda
 		{
 		public:
-			batch_norm_layer_tester_cuda() = default;
+			batch_norm_layer_tester_cuda();
 
-			virtual ~batch_norm_layer_tester_cuda() = default;
+			virtual ~batch_norm_layer_tester_cuda();
 
 			virtual void enqueue_forward_propagation(
 				cudaStream_t stream_id,
@@ -48,6 +48,10 @@ namespace nnforge
 
 		private:
 			float epsilon;
+			bool use_batch_statistics;
+
+			cudnnTensorDescriptor_t weights_desc;
+			cudnnTensorDescriptor_t data_desc;
 		};
 	}
 }
@@ -27,4 +27,9 @@ namespace nnforge
 	{
 		return 1;
 	}
+
+	bool data_transformer::is_deterministic() const
+	{
+		return true;
+	}
 }
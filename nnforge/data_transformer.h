@@ -39,6 +39,9 @@ namespace nnforge
 
 		virtual unsigned int get_sample_count() const;
 
+		// False for the transformers producing different results for the same entry from one read to another, random augmentations
+		virtual bool is_deterministic() const;
+
 	protected:
 		data_transformer() = default;
 
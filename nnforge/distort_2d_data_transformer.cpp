@@ -144,4 +144,9 @@ namespace nnforge
 			}
 		}
 	}
+
+	bool distort_2d_data_transformer::is_deterministic() const
+	{
+		return false;
+	}
 }
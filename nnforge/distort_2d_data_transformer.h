@@ -47,6 +47,8 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual bool is_deterministic() const;
 			
 	protected:
 		float border_value;
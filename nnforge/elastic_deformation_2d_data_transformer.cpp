@@ -132,4 +132,9 @@ namespace nnforge
 			}
 		}
 	}
+
+	bool elastic_deformation_2d_data_transformer::is_deterministic() const
+	{
+		return false;
+	}
 }
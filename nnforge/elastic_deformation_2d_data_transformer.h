@@ -40,6 +40,8 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual bool is_deterministic() const;
 			
 		static void smooth(
 			cv::Mat1f disp,
@@ -18,6 +18,19 @@
 
 namespace nnforge
 {
+	bool factory_generator::set_thread_count(int thread_count)
+	{
+		return false;
+	}
+
+	bool factory_generator::set_worker_process(
+		unsigned int rank,
+		unsigned int worker_count,
+		const std::string& group_name)
+	{
+		return false;
+	}
+
 	std::vector<string_option> factory_generator::get_string_options()
 	{
 		return std::vector<string_option>();
@@ -21,6 +21,7 @@
 #include "config_options.h"
 
 #include <memory>
+#include <string>
 
 namespace nnforge
 {
@@ -39,6 +40,16 @@ namespace nnforge
 
 		virtual void info() const = 0;
 
+		// Changes the number of threads used by the backend and reinitializes it, returns false if the backend doesn't support it
+		virtual bool set_thread_count(int thread_count);
+
+		// Makes the backend train as one of worker_count processes sharing gradients, the processes with the same group_name form a group.
+		// Reinitializes the backend, returns false if the backend doesn't support it
+		virtual bool set_worker_process(
+			unsigned int rank,
+			unsigned int worker_count,
+			const std::string& group_name);
+
 		virtual std::vector<string_option> get_string_options();
 
 		virtual std::vector<multi_string_option> get_multi_string_options();
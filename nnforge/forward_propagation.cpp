@@ -33,6 +33,7 @@ namespace nnforge
 		: output_layer_names(output_layer_names)
 		, debug(debug)
 		, profile(profile)
+		, chunk_size(0)
 	{
 		if (output_layer_names.empty())
 			throw neural_network_exception("No output layers specified for forward_propagation");
@@ -81,6 +82,11 @@ namespace nnforge
 		return res;
 	}
 
+	const std::set<std::string>& forward_propagation::get_data_layer_names() const
+	{
+		return data_layer_names;
+	}
+
 	void forward_propagation::clear_data()
 	{
 		actual_clear_data();
@@ -151,10 +157,12 @@ namespace nnforge
 		writer.set_config_map(output_config_map);
 		std::map<layer_name_with_action, float> action_seconds;
 		float idle_seconds;
+		chunk_size = 0;
 		actual_run(narrow_reader ? *narrow_reader : reader, writer, res.entry_processed_count, action_seconds, idle_seconds);
 		std::chrono::duration<float> sec = std::chrono::high_resolution_clock::now() - start;
 		res.total_seconds = sec.count();
 		res.idle_seconds = idle_seconds;
+		res.chunk_size = chunk_size;
 
 		if (profile->is_profile() && !action_seconds.empty())
 		{
@@ -186,6 +194,8 @@ namespace nnforge
 		float idle_overhead = val.idle_seconds / val.total_seconds;
 		float gflops = val.flops_per_entry * static_cast<float>(val.entry_processed_count) / val.total_seconds * 1.0e-9F;
 		out << (boost::format("%|1$.2f| seconds, idle %|2$.1f|%%, %3% entries, %|4$.2e| flops per entry, %|5$.1f| GFLOPS") % val.total_seconds % (idle_overhead * 100.0F) % val.entry_processed_count % val.flops_per_entry % gflops).str();
+		if (val.chunk_size > 0)
+			out << ", chunk " << val.chunk_size;
 		return out;
 	}
 }
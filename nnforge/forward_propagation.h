@@ -46,6 +46,8 @@ namespace nnforge
 			float flops_per_entry;
 			float total_seconds;
 			float idle_seconds;
+			// The largest number of entries processed at once, 0 when not reported
+			unsigned int chunk_size;
 		};
 
 	public:
@@ -66,6 +68,8 @@ namespace nnforge
 
 		bool is_schema_with_weights() const;
 
+		const std::set<std::string>& get_data_layer_names() const;
+
 	protected:
 		forward_propagation(
 			const network_schema& schema,
@@ -104,6 +108,8 @@ namespace nnforge
 		unsigned int output_layers_tiling_factor;
 		std::map<layer_name_with_action, float> action_flops_per_entry;
 		float flops;
+		// actual_run sets it to the largest number of entries processed at once
+		unsigned int chunk_size;
 		std::set<std::string> data_layer_names;
 
 	private:
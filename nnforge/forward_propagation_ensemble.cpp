@@ -0,0 +1,332 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "forward_propagation_ensemble.h"
+
+#include "neural_network_exception.h"
+#include "neuron_value_set_data_bunch_reader.h"
+
+#include <boost/format.hpp>
+#include <algorithm>
+#include <chrono>
+
+namespace nnforge
+{
+	forward_propagation_ensemble::forward_propagation_ensemble(
+		const std::vector<forward_propagation::ptr>& forward_props,
+		unsigned int chunk_entry_count,
+		unsigned int thread_group_count,
+		unsigned int reader_thread_count)
+		: forward_props(forward_props)
+		, chunk_entry_count(chunk_entry_count)
+		, thread_group_count(std::max(std::min(thread_group_count, static_cast<unsigned int>(forward_props.size())), 1U))
+		, reader_thread_count(std::max(reader_thread_count, 1U))
+	{
+		if (forward_props.empty())
+			throw neural_network_exception("No networks specified for forward_propagation_ensemble");
+		if (chunk_entry_count == 0)
+			throw neural_network_exception("Chunk entry count for forward_propagation_ensemble should be positive");
+
+		// The thread calling run runs the first group
+		job_runner = threadpool_job_runner::ptr(new threadpool_job_runner(this->reader_thread_count + this->thread_group_count - 1));
+	}
+
+	forward_propagation_ensemble::stat forward_propagation_ensemble::run(
+		structured_data_bunch_reader& reader,
+		structured_data_bunch_writer::ptr writer,
+		const std::vector<structured_data_bunch_writer::ptr>& network_writers)
+	{
+		if ((!network_writers.empty()) && (network_writers.size() != forward_props.size()))
+			throw neural_network_exception((boost::format("forward_propagation_ensemble got %1% network writers for %2% networks") % network_writers.size() % forward_props.size()).str());
+
+		// All the networks share schema, hence data layers
+		const std::set<std::string>& data_layer_names = forward_props.front()->get_data_layer_names();
+		structured_data_bunch_reader::ptr narrow_reader = reader.get_narrow_reader(data_layer_names);
+		structured_data_bunch_reader& input_reader = narrow_reader ? *narrow_reader : reader;
+		std::map<std::string, layer_configuration_specific> input_config_map = input_reader.get_config_map();
+
+		stat res;
+		res.network_stats.resize(forward_props.size());
+		for(std::vector<forward_propagation::stat>::iterator it = res.network_stats.begin(); it != res.network_stats.end(); ++it)
+		{
+			it->entry_processed_count = 0;
+			it->flops_per_entry = 0.0F;
+			it->total_seconds = 0.0F;
+			it->idle_seconds = 0.0F;
+			it->chunk_size = 0;
+		}
+		res.entry_read_count = 0;
+		res.read_seconds = 0.0F;
+
+		// Chunks are read to the buffers in turn
+		chunk_buffer buffers[2];
+		for(int buffer_id = 0; buffer_id < 2; ++buffer_id)
+		{
+			for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+			{
+				std::map<std::string, layer_configuration_specific>::const_iterator config_it = input_config_map.find(*it);
+				if (config_it == input_config_map.end())
+					throw neural_network_exception((boost::format("Data layer %1% is not available in the reader for forward_propagation_ensemble") % *it).str());
+				buffers[buffer_id].chunk_map.insert(std::make_pair(*it, std::make_pair(config_it->second, neuron_value_set::ptr(new neuron_value_set(config_it->second.get_neuron_count(), chunk_entry_count)))));
+			}
+		}
+
+		std::vector<std::shared_ptr<chunk_sum_writer> > group_writers;
+		for(unsigned int group_id = 0; group_id < thread_group_count; ++group_id)
+			group_writers.push_back(std::shared_ptr<chunk_sum_writer>(new chunk_sum_writer()));
+
+		// Declared after the buffers, so that the jobs are waited for before the buffers are destroyed
+		job_set read_jobs(*job_runner);
+		job_set group_jobs(*job_runner);
+		unsigned int output_entry_count = 0;
+		bool first_chunk = true;
+		int current_buffer_id = 0;
+		start_chunk_read(input_reader, buffers[current_buffer_id], 0, read_jobs);
+		while(true)
+		{
+			std::chrono::high_resolution_clock::time_point read_start = std::chrono::high_resolution_clock::now();
+			read_jobs.wait();
+			std::chrono::duration<float> read_sec = std::chrono::high_resolution_clock::now() - read_start;
+			res.read_seconds += read_sec.count();
+
+			const chunk_buffer& current_buffer = buffers[current_buffer_id];
+			unsigned int entry_count = current_buffer.read_entry_count;
+			if (entry_count == 0)
+				break;
+
+			// Entries are decoded and transformed once for all the networks, the next chunk is read while the networks run
+			if (entry_count == chunk_entry_count)
+				start_chunk_read(input_reader, buffers[1 - current_buffer_id], res.entry_read_count + entry_count, read_jobs);
+
+			// The chunk reader exposes the entries read only
+			std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > current_chunk_map;
+			for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = current_buffer.chunk_map.begin(); it != current_buffer.chunk_map.end(); ++it)
+			{
+				neuron_value_set::ptr current_set(new neuron_value_set(it->second.second->neuron_count));
+				current_set->neuron_value_list.assign(it->second.second->neuron_value_list.begin(), it->second.second->neuron_value_list.begin() + entry_count);
+				current_chunk_map.insert(std::make_pair(it->first, std::make_pair(it->second.first, current_set)));
+			}
+
+			auto run_group = [&] (unsigned int group_id)
+			{
+				neuron_value_set_data_bunch_reader chunk_reader(current_chunk_map);
+				chunk_sum_writer& group_writer = *group_writers[group_id];
+				for(unsigned int network_id = group_id; network_id < forward_props.size(); network_id += thread_group_count)
+				{
+					group_writer.set_network_writer(network_writers.empty() ? structured_data_bunch_writer::ptr() : network_writers[network_id], output_entry_count, first_chunk);
+					forward_propagation::stat st = forward_props[network_id]->run(chunk_reader, group_writer);
+
+					forward_propagation::stat& acc = res.network_stats[network_id];
+					acc.entry_processed_count += st.entry_processed_count;
+					acc.flops_per_entry = st.flops_per_entry;
+					acc.total_seconds += st.total_seconds;
+					acc.idle_seconds += st.idle_seconds;
+					acc.chunk_size = std::max(acc.chunk_size, st.chunk_size);
+				}
+			};
+			for(std::vector<std::shared_ptr<chunk_sum_writer> >::const_iterator it = group_writers.begin(); it != group_writers.end(); ++it)
+				(*it)->reset_sums();
+			for(unsigned int group_id = 1; group_id < thread_group_count; ++group_id)
+				group_jobs.post(std::bind(run_group, group_id));
+			run_group(0);
+			group_jobs.wait();
+
+			// Merge sums of the groups into the first one and pass averages to the writer
+			chunk_sum_writer& sum_writer = *group_writers.front();
+			for(std::vector<std::shared_ptr<chunk_sum_writer> >::const_iterator it = group_writers.begin() + 1; it != group_writers.end(); ++it)
+			{
+				for(std::map<std::string, std::vector<float> >::iterator sum_it = sum_writer.layer_name_to_sum_map.begin(); sum_it != sum_writer.layer_name_to_sum_map.end(); ++sum_it)
+				{
+					const std::vector<float>& src = (*it)->layer_name_to_sum_map[sum_it->first];
+					std::transform(sum_it->second.begin(), sum_it->second.end(), src.begin(), sum_it->second.begin(), [] (float x, float y) { return x + y; });
+				}
+			}
+			if (writer)
+			{
+				if (first_chunk)
+					writer->set_config_map(sum_writer.config_map);
+				float mult = 1.0F / static_cast<float>(forward_props.size());
+				for(std::map<std::string, std::vector<float> >::iterator it = sum_writer.layer_name_to_sum_map.begin(); it != sum_writer.layer_name_to_sum_map.end(); ++it)
+					std::transform(it->second.begin(), it->second.end(), it->second.begin(), [mult] (float x) { return x * mult; });
+				for(unsigned int entry_id = 0; entry_id < sum_writer.entry_count; ++entry_id)
+				{
+					std::map<std::string, const float *> data_map;
+					for(std::map<std::string, std::vector<float> >::const_iterator it = sum_writer.layer_name_to_sum_map.begin(); it != sum_writer.layer_name_to_sum_map.end(); ++it)
+						data_map.insert(std::make_pair(it->first, &it->second[0] + static_cast<size_t>(entry_id) * sum_writer.config_map[it->first].get_neuron_count()));
+					writer->write(output_entry_count + entry_id, data_map);
+				}
+			}
+
+			output_entry_count += sum_writer.entry_count;
+			res.entry_read_count += entry_count;
+			first_chunk = false;
+
+			if (entry_count < chunk_entry_count)
+				break;
+			current_buffer_id = 1 - current_buffer_id;
+		}
+
+		return res;
+	}
+
+	void forward_propagation_ensemble::start_chunk_read(
+		structured_data_bunch_reader& reader,
+		chunk_buffer& buffer,
+		unsigned int first_entry_id,
+		job_set& read_jobs) const
+	{
+		buffer.read_entry_count = chunk_entry_count;
+		for(unsigned int reader_id = 0; reader_id < reader_thread_count; ++reader_id)
+		{
+			read_jobs.post([this, &reader, &buffer, first_entry_id, reader_id] ()
+			{
+				for(unsigned int entry_id = reader_id; entry_id < buffer.read_entry_count; entry_id += reader_thread_count)
+				{
+					std::map<std::string, float *> data_map;
+					for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = buffer.chunk_map.begin(); it != buffer.chunk_map.end(); ++it)
+						data_map.insert(std::make_pair(it->first, &it->second.second->neuron_value_list[entry_id]->at(0)));
+					if (!reader.read(first_entry_id + entry_id, data_map))
+					{
+						unsigned int current = buffer.read_entry_count;
+						while ((entry_id < current) && (!buffer.read_entry_count.compare_exchange_weak(current, entry_id)));
+						break;
+					}
+				}
+			});
+		}
+	}
+
+	forward_propagation_ensemble::job_set::job_set(threadpool_job_runner& job_runner)
+		: job_runner(job_runner)
+		, running_job_count(0)
+	{
+	}
+
+	forward_propagation_ensemble::job_set::~job_set()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		done_condition.wait(lock, [this] () { return running_job_count == 0; });
+	}
+
+	void forward_propagation_ensemble::job_set::post(const std::function<void()>& func)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m);
+			++running_job_count;
+		}
+		job_runner.service.post(std::bind(&job_set::run_job, this, func));
+	}
+
+	void forward_propagation_ensemble::job_set::wait()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		done_condition.wait(lock, [this] () { return running_job_count == 0; });
+		std::exception_ptr current_error = error;
+		error = std::exception_ptr();
+		if (current_error)
+			std::rethrow_exception(current_error);
+	}
+
+	void forward_propagation_ensemble::job_set::run_job(const std::function<void()>& func)
+	{
+		std::exception_ptr current_error;
+		try
+		{
+			func();
+		}
+		catch (...)
+		{
+			current_error = std::current_exception();
+		}
+
+		// The set might be destroyed as soon as the lock is released after the last job
+		std::lock_guard<std::mutex> lock(m);
+		if (current_error && !error)
+			error = current_error;
+		if (--running_job_count == 0)
+			done_condition.notify_all();
+	}
+
+	forward_propagation_ensemble::chunk_sum_writer::chunk_sum_writer()
+		: entry_count(0)
+		, entry_offset(0)
+		, first_chunk(true)
+	{
+	}
+
+	void forward_propagation_ensemble::chunk_sum_writer::reset_sums()
+	{
+		for(std::map<std::string, std::vector<float> >::iterator it = layer_name_to_sum_map.begin(); it != layer_name_to_sum_map.end(); ++it)
+			std::fill(it->second.begin(), it->second.end(), 0.0F);
+		entry_count = 0;
+	}
+
+	void forward_propagation_ensemble::chunk_sum_writer::set_network_writer(
+		structured_data_bunch_writer::ptr network_writer,
+		unsigned int entry_offset,
+		bool first_chunk)
+	{
+		this->network_writer = network_writer;
+		this->entry_offset = entry_offset;
+		this->first_chunk = first_chunk;
+	}
+
+	void forward_propagation_ensemble::chunk_sum_writer::set_config_map(const std::map<std::string, layer_configuration_specific> config_map)
+	{
+		if (this->config_map != config_map)
+		{
+			this->config_map = config_map;
+			layer_name_to_sum_map.clear();
+			for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+				layer_name_to_sum_map.insert(std::make_pair(it->first, std::vector<float>()));
+		}
+
+		// Network writers are configured once, they get entries of all the chunks
+		if (network_writer && first_chunk)
+			network_writer->set_config_map(config_map);
+	}
+
+	void forward_propagation_ensemble::chunk_sum_writer::write(
+		unsigned int entry_id,
+		const std::map<std::string, const float *>& data_map)
+	{
+		{
+			std::lock_guard<std::mutex> lock(write_mutex);
+
+			entry_count = std::max(entry_count, entry_id + 1);
+			for(std::map<std::string, const float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+			{
+				unsigned int neuron_count = config_map[it->first].get_neuron_count();
+				std::vector<float>& sum = layer_name_to_sum_map[it->first];
+				if (sum.size() < static_cast<size_t>(entry_count) * neuron_count)
+					sum.resize(static_cast<size_t>(entry_count) * neuron_count, 0.0F);
+				float * dst = &sum[0] + static_cast<size_t>(entry_id) * neuron_count;
+				const float * src = it->second;
+				for(unsigned int i = 0; i < neuron_count; ++i)
+					dst[i] += src[i];
+			}
+		}
+
+		if (network_writer)
+			network_writer->write(entry_offset + entry_id, data_map);
+	}
+
+	std::ostream& operator<< (std::ostream& out, const forward_propagation_ensemble::stat& val)
+	{
+		out << (boost::format("%1% entries read once, %|2$.1f| seconds waiting for reads") % val.entry_read_count % val.read_seconds).str();
+		return out;
+	}
+}
@@ -0,0 +1,163 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "forward_propagation.h"
+#include "structured_data_bunch_reader.h"
+#include "structured_data_bunch_writer.h"
+#include "threadpool_job_runner.h"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <ostream>
+#include <functional>
+#include <condition_variable>
+
+namespace nnforge
+{
+	// Runs several networks of the same schema over the dataset reading each chunk of the input data once.
+	// The chunk read is kept in memory and shared by all the networks, outputs are averaged across networks on the fly.
+	// The next chunk is read by reader_thread_count threads while the networks run on the current one.
+	// Networks may be spread across thread groups, each group runs its networks one after another.
+	// Network i runs in group i % thread_group_count, it should be created by forward_propagation_factory::create_in_group for this group
+	class forward_propagation_ensemble
+	{
+	public:
+		class stat
+		{
+		public:
+			std::vector<forward_propagation::stat> network_stats;
+			unsigned int entry_read_count;
+			// Time the networks waited for chunks to be read
+			float read_seconds;
+		};
+
+	public:
+		typedef std::shared_ptr<forward_propagation_ensemble> ptr;
+
+		// Each of forward_props should have its network data set already, all of them should have the same output layers
+		forward_propagation_ensemble(
+			const std::vector<forward_propagation::ptr>& forward_props,
+			unsigned int chunk_entry_count,
+			unsigned int thread_group_count = 1,
+			unsigned int reader_thread_count = 1);
+
+		~forward_propagation_ensemble() = default;
+
+		// writer receives outputs averaged across the networks, it might be empty.
+		// network_writers is either empty or has one element per network, it receives the outputs of each network, elements might be empty.
+		// writer gets entries in order, network writers get them the way networks write them
+		stat run(
+			structured_data_bunch_reader& reader,
+			structured_data_bunch_writer::ptr writer,
+			const std::vector<structured_data_bunch_writer::ptr>& network_writers);
+
+	private:
+		// Jobs posted to the job runner which the caller waits for, the destructor waits for them too
+		class job_set
+		{
+		public:
+			job_set(threadpool_job_runner& job_runner);
+
+			~job_set();
+
+			void post(const std::function<void()>& func);
+
+			// The first exception thrown by the jobs is rethrown
+			void wait();
+
+		private:
+			void run_job(const std::function<void()>& func);
+
+		private:
+			threadpool_job_runner& job_runner;
+			std::mutex m;
+			std::condition_variable done_condition;
+			unsigned int running_job_count;
+			std::exception_ptr error;
+
+		private:
+			job_set(const job_set&) = delete;
+			job_set& operator =(const job_set&) = delete;
+		};
+
+		// One of the two buffers the chunks are read to in turn
+		struct chunk_buffer
+		{
+			std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > chunk_map;
+			// Entries after the end of the dataset are not counted
+			std::atomic<unsigned int> read_entry_count;
+		};
+
+		void start_chunk_read(
+			structured_data_bunch_reader& reader,
+			chunk_buffer& buffer,
+			unsigned int first_entry_id,
+			job_set& read_jobs) const;
+
+		// Accumulates outputs of the networks of a single thread group for the current chunk
+		class chunk_sum_writer : public structured_data_bunch_writer
+		{
+		public:
+			chunk_sum_writer();
+
+			virtual ~chunk_sum_writer() = default;
+
+			virtual void set_config_map(const std::map<std::string, layer_configuration_specific> config_map);
+
+			virtual void write(
+				unsigned int entry_id,
+				const std::map<std::string, const float *>& data_map);
+
+			void reset_sums();
+
+			// Entries of the network run next are passed to network_writer shifted by entry_offset
+			void set_network_writer(
+				structured_data_bunch_writer::ptr network_writer,
+				unsigned int entry_offset,
+				bool first_chunk);
+
+		public:
+			std::map<std::string, layer_configuration_specific> config_map;
+			std::map<std::string, std::vector<float> > layer_name_to_sum_map;
+			unsigned int entry_count;
+
+		private:
+			structured_data_bunch_writer::ptr network_writer;
+			unsigned int entry_offset;
+			bool first_chunk;
+			std::mutex write_mutex;
+		};
+
+	private:
+		std::vector<forward_propagation::ptr> forward_props;
+		unsigned int chunk_entry_count;
+		unsigned int thread_group_count;
+		unsigned int reader_thread_count;
+		threadpool_job_runner::ptr job_runner;
+
+	private:
+		forward_propagation_ensemble(const forward_propagation_ensemble&) = delete;
+		forward_propagation_ensemble& operator =(const forward_propagation_ensemble&) = delete;
+	};
+
+	std::ostream& operator<< (std::ostream& out, const forward_propagation_ensemble::stat& val);
+}
@@ -18,4 +18,14 @@
 
 namespace nnforge
 {
+	forward_propagation::ptr forward_propagation_factory::create_in_group(
+		const network_schema& schema,
+		const std::vector<std::string>& output_layer_names,
+		unsigned int group_id,
+		unsigned int group_count,
+		debug_state::ptr debug,
+		profile_state::ptr profile) const
+	{
+		return create(schema, output_layer_names, debug, profile);
+	}
 }
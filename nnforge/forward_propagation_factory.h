@@ -41,6 +41,16 @@ namespace nnforge
 			debug_state::ptr debug,
 			profile_state::ptr profile) const = 0;
 
+		// Creates forward propagation for the group_id-th of group_count groups running at the same time,
+		// each group gets its share of the backend resources. The default implementation ignores groups
+		virtual forward_propagation::ptr create_in_group(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			unsigned int group_id,
+			unsigned int group_count,
+			debug_state::ptr debug,
+			profile_state::ptr profile) const;
+
 	protected:
 		forward_propagation_factory() = default;
 	};
@@ -0,0 +1,296 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "frozen_prefix_feature_cache.h"
+
+#include "neural_network_exception.h"
+#include "data_layer.h"
+#include "dropout_layer.h"
+#include "batch_norm_layer.h"
+#include "structured_data_stream_reader.h"
+#include "structured_data_bunch_stream_reader.h"
+#include "structured_data_bunch_stream_writer.h"
+
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <typeinfo>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	// 64-bit FNV-1a
+	static unsigned long long hash_bytes(
+		unsigned long long hash,
+		const void * data,
+		size_t size)
+	{
+		const unsigned char * bytes = static_cast<const unsigned char *>(data);
+		for(size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	frozen_prefix_feature_cache::frozen_prefix_feature_cache(
+		network_schema::const_ptr schema,
+		const std::vector<std::string>& output_layer_names,
+		const std::vector<std::string>& error_source_layer_names,
+		const std::vector<std::string>& exclude_data_update_layer_names,
+		const std::map<std::string, structured_data_reader::ptr>& data_reader_map,
+		const std::map<std::string, std::vector<data_transformer::ptr> >& data_transformer_map,
+		const std::vector<boost::filesystem::path>& data_file_paths,
+		unsigned int multiple_epoch_count,
+		unsigned int shuffle_block_size,
+		const boost::filesystem::path& cache_folder_path,
+		forward_propagation_factory::const_ptr forward_prop_factory,
+		debug_state::ptr debug,
+		profile_state::ptr profile)
+		: data_reader_map(data_reader_map)
+		, multiple_epoch_count(multiple_epoch_count)
+		, shuffle_block_size(shuffle_block_size)
+		, cache_folder_path(cache_folder_path)
+		, forward_prop_factory(forward_prop_factory)
+		, debug(debug)
+		, profile(profile)
+	{
+		std::set<std::string> exclude_data_update_layer_name_set(exclude_data_update_layer_names.begin(), exclude_data_update_layer_names.end());
+		std::set<std::string> not_frozen_layer_name_set(output_layer_names.begin(), output_layer_names.end());
+		not_frozen_layer_name_set.insert(error_source_layer_names.begin(), error_source_layer_names.end());
+
+		// Dropout and batch normalization behave differently in training and inference, they are not frozen
+		std::set<std::string> data_layer_name_set;
+		std::set<std::string> frozen_layer_name_set;
+		std::vector<layer::const_ptr> layer_list = schema->get_layers_in_forward_propagation_order();
+		for(std::vector<layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+		{
+			const layer& l = **it;
+			if (l.get_type_name() == data_layer::layer_type_name)
+			{
+				data_layer_name_set.insert(l.instance_name);
+				continue;
+			}
+
+			bool frozen = (not_frozen_layer_name_set.find(l.instance_name) == not_frozen_layer_name_set.end())
+				&& ((l.is_empty_data() && l.is_empty_data_custom()) || (exclude_data_update_layer_name_set.find(l.instance_name) != exclude_data_update_layer_name_set.end()))
+				&& (l.get_type_name() != dropout_layer::layer_type_name)
+				&& (l.get_type_name() != batch_norm_layer::layer_type_name);
+			for(std::vector<std::string>::const_iterator it2 = l.input_layer_instance_names.begin(); frozen && (it2 != l.input_layer_instance_names.end()); ++it2)
+				frozen = (data_layer_name_set.find(*it2) != data_layer_name_set.end()) || (frozen_layer_name_set.find(*it2) != frozen_layer_name_set.end());
+
+			if (frozen)
+				frozen_layer_name_set.insert(l.instance_name);
+		}
+
+		std::set<std::string> boundary_layer_name_set;
+		std::vector<layer::const_ptr> suffix_layer_list;
+		for(std::vector<layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+		{
+			const layer& l = **it;
+			if ((data_layer_name_set.find(l.instance_name) != data_layer_name_set.end()) || (frozen_layer_name_set.find(l.instance_name) != frozen_layer_name_set.end()))
+				continue;
+
+			suffix_layer_list.push_back(*it);
+			for(std::vector<std::string>::const_iterator it2 = l.input_layer_instance_names.begin(); it2 != l.input_layer_instance_names.end(); ++it2)
+			{
+				if (frozen_layer_name_set.find(*it2) != frozen_layer_name_set.end())
+					boundary_layer_name_set.insert(*it2);
+				else if (data_layer_name_set.find(*it2) != data_layer_name_set.end())
+					suffix_data_layer_names.insert(*it2);
+			}
+		}
+		boundary_layer_names.assign(boundary_layer_name_set.begin(), boundary_layer_name_set.end());
+
+		if (boundary_layer_names.empty())
+			return;
+
+		for(std::set<std::string>::const_iterator it = suffix_data_layer_names.begin(); it != suffix_data_layer_names.end(); ++it)
+			suffix_layer_list.push_back(schema->get_layer(*it));
+		for(std::vector<std::string>::const_iterator it = boundary_layer_names.begin(); it != boundary_layer_names.end(); ++it)
+		{
+			layer::ptr boundary_data_layer(new data_layer());
+			boundary_data_layer->instance_name = *it;
+			suffix_layer_list.push_back(boundary_data_layer);
+		}
+		suffix_schema = network_schema::ptr(new network_schema(suffix_layer_list));
+		suffix_schema->name = schema->name;
+
+		prefix_schema = network_schema::ptr(new network_schema(schema->get_required_layers(boundary_layer_names)));
+
+		std::map<std::string, layer_configuration_specific> input_config_map;
+		for(std::map<std::string, structured_data_reader::ptr>::const_iterator it = data_reader_map.begin(); it != data_reader_map.end(); ++it)
+			input_config_map.insert(std::make_pair(it->first, it->second->get_configuration()));
+		std::map<std::string, layer_configuration_specific> layer_config_map = schema->get_layer_configuration_specific_map(input_config_map);
+		for(std::set<std::string>::const_iterator it = suffix_data_layer_names.begin(); it != suffix_data_layer_names.end(); ++it)
+			suffix_config_map.insert(std::make_pair(*it, layer_config_map[*it]));
+		for(std::vector<std::string>::const_iterator it = boundary_layer_names.begin(); it != boundary_layer_names.end(); ++it)
+			suffix_config_map.insert(std::make_pair(*it, layer_config_map[*it]));
+
+		std::ostringstream description;
+		prefix_schema->write_proto(description);
+		for(std::vector<std::string>::const_iterator it = boundary_layer_names.begin(); it != boundary_layer_names.end(); ++it)
+			description << "output " << *it << "\n";
+		for(std::vector<boost::filesystem::path>::const_iterator it = data_file_paths.begin(); it != data_file_paths.end(); ++it)
+			description << "data " << it->filename().string() << " " << boost::filesystem::file_size(*it) << " " << boost::filesystem::last_write_time(*it) << "\n";
+		for(std::map<std::string, std::vector<data_transformer::ptr> >::const_iterator it = data_transformer_map.begin(); it != data_transformer_map.end(); ++it)
+		{
+			for(std::vector<data_transformer::ptr>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+			{
+				if (!(*it2)->is_deterministic())
+					throw neural_network_exception((boost::format("Outputs of the frozen prefix cannot be cached: data transformer %1% applied to %2% is not deterministic") % typeid(**it2).name() % it->first).str());
+				description << "transformer " << it->first << " " << typeid(**it2).name() << "\n";
+			}
+		}
+		// Settings of the transformers and normalizers are not available, the data they produce for the first entries reflects them
+		const unsigned int fingerprint_entry_count = 64;
+		for(std::map<std::string, structured_data_reader::ptr>::const_iterator it = data_reader_map.begin(); it != data_reader_map.end(); ++it)
+		{
+			layer_configuration_specific config = it->second->get_configuration();
+			std::vector<float> entry(config.get_neuron_count());
+			unsigned long long fingerprint = 14695981039346656037ULL;
+			for(unsigned int entry_id = 0; (entry_id < fingerprint_entry_count) && (!entry.empty()); ++entry_id)
+			{
+				if (!it->second->read(entry_id, &entry[0]))
+					break;
+				fingerprint = hash_bytes(fingerprint, &entry[0], entry.size() * sizeof(float));
+			}
+			description << "input " << it->first << " " << config.get_neuron_count() << " " << fingerprint << "\n";
+		}
+		schema_and_data_description = description.str();
+
+		std::cout << "Frozen prefix: " << frozen_layer_name_set.size() << " layers, caching outputs of";
+		for(std::vector<std::string>::const_iterator it = boundary_layer_names.begin(); it != boundary_layer_names.end(); ++it)
+			std::cout << " " << *it << " " << suffix_config_map[*it].get_neuron_count() << " neurons";
+		std::cout << std::endl;
+	}
+
+	bool frozen_prefix_feature_cache::is_applicable() const
+	{
+		return !boundary_layer_names.empty();
+	}
+
+	network_schema::ptr frozen_prefix_feature_cache::get_suffix_schema() const
+	{
+		return suffix_schema;
+	}
+
+	std::map<std::string, layer_configuration_specific> frozen_prefix_feature_cache::get_suffix_config_map() const
+	{
+		return suffix_config_map;
+	}
+
+	std::string frozen_prefix_feature_cache::get_key(const network_data& data) const
+	{
+		unsigned long long hash = 14695981039346656037ULL;
+		hash = hash_bytes(hash, schema_and_data_description.data(), schema_and_data_description.size());
+
+		std::vector<layer::const_ptr> prefix_layer_list = prefix_schema->get_layers();
+		for(std::vector<layer::const_ptr>::const_iterator it = prefix_layer_list.begin(); it != prefix_layer_list.end(); ++it)
+		{
+			const std::string& layer_name = (*it)->instance_name;
+			hash = hash_bytes(hash, layer_name.data(), layer_name.size());
+
+			layer_data::ptr weights = data.data_list.find(layer_name);
+			if (weights)
+				for(layer_data::const_iterator it2 = weights->begin(); it2 != weights->end(); ++it2)
+					if (!it2->empty())
+						hash = hash_bytes(hash, &(*it2)[0], it2->size() * sizeof(float));
+
+			layer_data_custom::ptr weights_custom = data.data_custom_list.find(layer_name);
+			if (weights_custom)
+				for(layer_data_custom::const_iterator it2 = weights_custom->begin(); it2 != weights_custom->end(); ++it2)
+					if (!it2->empty())
+						hash = hash_bytes(hash, &(*it2)[0], it2->size() * sizeof(int));
+		}
+
+		return (boost::format("%|1$016x|") % hash).str();
+	}
+
+	std::map<std::string, boost::filesystem::path> frozen_prefix_feature_cache::get_cache_file_paths(const std::string& key) const
+	{
+		std::map<std::string, boost::filesystem::path> res;
+		for(std::vector<std::string>::const_iterator it = boundary_layer_names.begin(); it != boundary_layer_names.end(); ++it)
+			res.insert(std::make_pair(*it, cache_folder_path / (boost::format("%1%_%2%.dt") % key % *it).str()));
+		return res;
+	}
+
+	structured_data_bunch_reader::ptr frozen_prefix_feature_cache::get_reader(const network_data& data)
+	{
+		std::string key = get_key(data);
+		std::map<std::string, boost::filesystem::path> cache_file_paths = get_cache_file_paths(key);
+
+		bool cache_exists = true;
+		for(std::map<std::string, boost::filesystem::path>::const_iterator it = cache_file_paths.begin(); it != cache_file_paths.end(); ++it)
+			cache_exists = cache_exists && boost::filesystem::exists(it->second);
+
+		if (cache_exists)
+			std::cout << "Using cached outputs of the frozen prefix " << key << std::endl;
+		else
+			build(data, cache_file_paths);
+
+		std::map<std::string, structured_data_reader::ptr> suffix_data_reader_map;
+		for(std::map<std::string, boost::filesystem::path>::const_iterator it = cache_file_paths.begin(); it != cache_file_paths.end(); ++it)
+		{
+			std::shared_ptr<std::istream> in(new boost::filesystem::ifstream(it->second, std::ios_base::in | std::ios_base::binary));
+			suffix_data_reader_map.insert(std::make_pair(it->first, structured_data_reader::ptr(new structured_data_stream_reader(in))));
+		}
+		for(std::set<std::string>::const_iterator it = suffix_data_layer_names.begin(); it != suffix_data_layer_names.end(); ++it)
+		{
+			std::map<std::string, structured_data_reader::ptr>::const_iterator reader_it = data_reader_map.find(*it);
+			if (reader_it == data_reader_map.end())
+				throw neural_network_exception((boost::format("No input data for layer %1%") % *it).str());
+			suffix_data_reader_map.insert(*reader_it);
+		}
+
+		return structured_data_bunch_reader::ptr(new structured_data_bunch_stream_reader(suffix_data_reader_map, multiple_epoch_count, shuffle_block_size));
+	}
+
+	void frozen_prefix_feature_cache::build(
+		const network_data& data,
+		const std::map<std::string, boost::filesystem::path>& cache_file_paths) const
+	{
+		// Only the latest outputs are kept
+		boost::filesystem::create_directories(cache_folder_path);
+		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(cache_folder_path); it != boost::filesystem::directory_iterator(); ++it)
+			if ((it->status().type() == boost::filesystem::regular_file) && ((it->path().extension() == ".dt") || (it->path().extension() == ".temp")))
+				boost::filesystem::remove(it->path());
+
+		std::map<std::string, boost::filesystem::path> temp_file_paths;
+		for(std::map<std::string, boost::filesystem::path>::const_iterator it = cache_file_paths.begin(); it != cache_file_paths.end(); ++it)
+			temp_file_paths.insert(std::make_pair(it->first, boost::filesystem::path(it->second.string() + ".temp")));
+
+		std::cout << "Caching outputs of the frozen prefix to " << cache_folder_path.string() << "..." << std::endl;
+
+		forward_propagation::ptr forward_prop = forward_prop_factory->create(*prefix_schema, boundary_layer_names, debug, profile);
+		forward_prop->set_data(data);
+		forward_propagation::stat st;
+		{
+			structured_data_bunch_stream_reader reader(data_reader_map, 1, 0);
+			structured_data_bunch_stream_writer writer(temp_file_paths);
+			st = forward_prop->run(reader, writer);
+			writer.close();
+		}
+		forward_prop.reset();
+
+		for(std::map<std::string, boost::filesystem::path>::const_iterator it = temp_file_paths.begin(); it != temp_file_paths.end(); ++it)
+			boost::filesystem::rename(it->second, cache_file_paths.find(it->first)->second);
+
+		std::cout << (boost::format("%1% entries cached in %|2$.1f| seconds, %|3$.3e| FLOPs per entry won't be recomputed in each epoch") % st.entry_processed_count % st.total_seconds % st.flops_per_entry).str() << std::endl;
+	}
+}
@@ -0,0 +1,111 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "network_schema.h"
+#include "network_data.h"
+#include "structured_data_reader.h"
+#include "structured_data_bunch_reader.h"
+#include "data_transformer.h"
+#include "forward_propagation_factory.h"
+#include "debug_state.h"
+#include "profile_state.h"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <memory>
+#include <boost/filesystem.hpp>
+
+namespace nnforge
+{
+	// The frozen prefix consists of the layers which are not trained and depend on the input data through frozen layers only.
+	// Their outputs don't change from epoch to epoch when the input data is deterministic,
+	// so the class runs the prefix once for the whole dataset and keeps the outputs consumed by the rest of the network
+	// in structured data files. The trainable suffix of the schema is trained on these files then.
+	// The files are rebuilt when the prefix schema, its weights, the input data files, or the data transformers change.
+	// Data transformers are applied once, when building the files, so all of them should be deterministic
+	class frozen_prefix_feature_cache
+	{
+	public:
+		typedef std::shared_ptr<frozen_prefix_feature_cache> ptr;
+
+		// data_reader_map should read the whole dataset, data_file_paths are used to detect it is modified.
+		// data_transformer_map has the transformers applied by data_reader_map, the constructor throws if any of them is not deterministic
+		frozen_prefix_feature_cache(
+			network_schema::const_ptr schema,
+			const std::vector<std::string>& output_layer_names,
+			const std::vector<std::string>& error_source_layer_names,
+			const std::vector<std::string>& exclude_data_update_layer_names,
+			const std::map<std::string, structured_data_reader::ptr>& data_reader_map,
+			const std::map<std::string, std::vector<data_transformer::ptr> >& data_transformer_map,
+			const std::vector<boost::filesystem::path>& data_file_paths,
+			unsigned int multiple_epoch_count,
+			unsigned int shuffle_block_size,
+			const boost::filesystem::path& cache_folder_path,
+			forward_propagation_factory::const_ptr forward_prop_factory,
+			debug_state::ptr debug,
+			profile_state::ptr profile);
+
+		~frozen_prefix_feature_cache() = default;
+
+		// False when there are no frozen layers with outputs to cache
+		bool is_applicable() const;
+
+		// Outputs of the frozen prefix consumed by the suffix are data layers in it
+		network_schema::ptr get_suffix_schema() const;
+
+		std::map<std::string, layer_configuration_specific> get_suffix_config_map() const;
+
+		// Builds the files unless they exist for the frozen weights in data already.
+		// The reader returned provides input data for the suffix schema
+		structured_data_bunch_reader::ptr get_reader(const network_data& data);
+
+	private:
+		// Identifies the prefix schema, its weights and the input data
+		std::string get_key(const network_data& data) const;
+
+		std::map<std::string, boost::filesystem::path> get_cache_file_paths(const std::string& key) const;
+
+		void build(
+			const network_data& data,
+			const std::map<std::string, boost::filesystem::path>& cache_file_paths) const;
+
+	private:
+		std::map<std::string, structured_data_reader::ptr> data_reader_map;
+		unsigned int multiple_epoch_count;
+		unsigned int shuffle_block_size;
+		boost::filesystem::path cache_folder_path;
+		forward_propagation_factory::const_ptr forward_prop_factory;
+		debug_state::ptr debug;
+		profile_state::ptr profile;
+
+		network_schema::ptr prefix_schema;
+		network_schema::ptr suffix_schema;
+		// Frozen layers the suffix uses the outputs of
+		std::vector<std::string> boundary_layer_names;
+		// Input data layers the suffix uses directly
+		std::set<std::string> suffix_data_layer_names;
+		std::map<std::string, layer_configuration_specific> suffix_config_map;
+		std::string schema_and_data_description;
+
+	private:
+		frozen_prefix_feature_cache(const frozen_prefix_feature_cache&) = delete;
+		frozen_prefix_feature_cache& operator =(const frozen_prefix_feature_cache&) = delete;
+	};
+}
@@ -188,4 +188,9 @@ namespace nnforge
 		if (src_data != dst_data)
 			memcpy(dst_data, src_data, original_config.get_neuron_count() * sizeof(float));
 	}
+
+	bool natural_image_data_transformer::is_deterministic() const
+	{
+		return false;
+	}
 }
@@ -17,6 +17,7 @@
 #include "network_data.h"
 
 #include "neural_network_exception.h"
+#include "network_data_checkpoint.h"
 
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/format.hpp>
@@ -48,6 +49,21 @@ namespace nnforge
 	{
 	}
 
+	network_data::ptr network_data::clone() const
+	{
+		network_data::ptr res(new network_data());
+
+		std::vector<std::string> data_layer_name_list = data_list.get_data_layer_name_list();
+		for(std::vector<std::string>::const_iterator it = data_layer_name_list.begin(); it != data_layer_name_list.end(); ++it)
+			res->data_list.add(*it, layer_data::ptr(new layer_data(*data_list.get(*it))));
+
+		std::vector<std::string> data_custom_layer_name_list = data_custom_list.get_data_custom_layer_name_list();
+		for(std::vector<std::string>::const_iterator it = data_custom_layer_name_list.begin(); it != data_custom_layer_name_list.end(); ++it)
+			res->data_custom_list.add(*it, layer_data_custom::ptr(new layer_data_custom(*data_custom_list.get(*it))));
+
+		return res;
+	}
+
 	void network_data::check_network_data_consistency(const std::vector<layer::const_ptr>& layer_list) const
 	{
 		data_list.check_consistency(layer_list);
@@ -61,12 +77,29 @@ namespace nnforge
 
 	void network_data::write(const boost::filesystem::path& folder_path) const
 	{
+		if (folder_path.extension().string() == network_data_checkpoint::file_extension)
+		{
+			network_data_checkpoint checkpoint;
+			checkpoint.data = network_data::ptr(new network_data(*this));
+			checkpoint.write(folder_path);
+			return;
+		}
+
 		data_list.write(folder_path);
 		data_custom_list.write(folder_path);
 	}
 
 	void network_data::read(const boost::filesystem::path& folder_path)
 	{
+		if (network_data_checkpoint::is_checkpoint_file(folder_path))
+		{
+			network_data_checkpoint checkpoint;
+			checkpoint.read(folder_path, false);
+			data_list = checkpoint.data->data_list;
+			data_custom_list = checkpoint.data->data_custom_list;
+			return;
+		}
+
 		data_list.read(folder_path);
 		data_custom_list.read(folder_path);
 	}
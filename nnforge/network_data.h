@@ -50,8 +50,13 @@ namespace nnforge
 
 		const boost::uuids::uuid& get_uuid() const;
 
+		// Copies the data itself, copy constructor shares layer data with the original
+		network_data::ptr clone() const;
+
+		// Single-file checkpoint is written when folder_path has checkpoint file extension
 		void write(const boost::filesystem::path& folder_path) const;
 
+		// Single-file checkpoint is read when folder_path is a checkpoint file
 		void read(const boost::filesystem::path& folder_path);
 
 		// The method throws exception in case the data is not suitable for the layers
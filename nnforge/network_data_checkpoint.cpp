@@ -0,0 +1,341 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "network_data_checkpoint.h"
+
+#include "neural_network_exception.h"
+#include "background_network_data_writer.h"
+
+#include <sstream>
+#include <cstring>
+#include <boost/format.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace nnforge
+{
+	// {6C0E9A5E-27D4-4F4B-9B5B-3E1D0A8C2F71}
+	const boost::uuids::uuid network_data_checkpoint::checkpoint_guid =
+		{ 0x6c, 0x0e, 0x9a, 0x5e
+		, 0x27, 0xd4
+		, 0x4f, 0x4b
+		, 0x9b, 0x5b
+		, 0x3e, 0x1d, 0x0a, 0x8c, 0x2f, 0x71 };
+
+	const unsigned int network_data_checkpoint::format_version = 1;
+
+	const size_t network_data_checkpoint::payload_alignment = 64;
+
+	const char * network_data_checkpoint::file_extension = ".nnc";
+
+	namespace
+	{
+		struct part_entry
+		{
+			const void * src;
+			unsigned long long element_count;
+			unsigned int element_size;
+			unsigned long long offset;
+		};
+
+		void write_uint32(std::ostream& out, unsigned int val)
+		{
+			out.write(reinterpret_cast<const char *>(&val), sizeof(val));
+		}
+
+		void write_uint64(std::ostream& out, unsigned long long val)
+		{
+			out.write(reinterpret_cast<const char *>(&val), sizeof(val));
+		}
+
+		void write_string(std::ostream& out, const std::string& val)
+		{
+			write_uint32(out, static_cast<unsigned int>(val.size()));
+			out.write(val.data(), val.size());
+		}
+
+		// Reads the header of the mapped file checking it doesn't go beyond the end of the file
+		class header_reader
+		{
+		public:
+			header_reader(
+				const unsigned char * buf,
+				size_t size,
+				const boost::filesystem::path& file_path)
+				: buf(buf)
+				, size(size)
+				, pos(0)
+				, file_path(file_path)
+			{
+			}
+
+			const unsigned char * read_bytes(size_t count)
+			{
+				if (size - pos < count)
+					throw neural_network_exception((boost::format("Checkpoint file %1% is truncated") % file_path.string()).str());
+				const unsigned char * res = buf + pos;
+				pos += count;
+				return res;
+			}
+
+			unsigned int read_uint32()
+			{
+				unsigned int res;
+				memcpy(&res, read_bytes(sizeof(res)), sizeof(res));
+				return res;
+			}
+
+			unsigned long long read_uint64()
+			{
+				unsigned long long res;
+				memcpy(&res, read_bytes(sizeof(res)), sizeof(res));
+				return res;
+			}
+
+			std::string read_string()
+			{
+				unsigned int len = read_uint32();
+				const unsigned char * str = read_bytes(len);
+				return std::string(reinterpret_cast<const char *>(str), len);
+			}
+
+			// Returns pointer to the payload of the part
+			const unsigned char * get_payload(
+				unsigned long long offset,
+				unsigned long long element_count,
+				unsigned int element_size) const
+			{
+				if ((offset > size) || (element_count > (size - offset) / element_size))
+					throw neural_network_exception((boost::format("Part payload is out of checkpoint file %1%") % file_path.string()).str());
+				return buf + offset;
+			}
+
+		private:
+			const unsigned char * buf;
+			size_t size;
+			size_t pos;
+			boost::filesystem::path file_path;
+		};
+	}
+
+	void network_data_checkpoint::write(
+		const boost::filesystem::path& file_path,
+		bool sync_to_disk) const
+	{
+		if (!data)
+			throw neural_network_exception("No network data to write to checkpoint");
+
+		std::vector<std::pair<std::string, network_data::const_ptr> > blobs;
+		blobs.push_back(std::make_pair(std::string("data"), data));
+		if (momentum_data)
+			blobs.push_back(std::make_pair(std::string("momentum"), momentum_data));
+		if (momentum_data2)
+			blobs.push_back(std::make_pair(std::string("momentum2"), momentum_data2));
+
+		std::vector<part_entry> parts;
+		for(std::vector<std::pair<std::string, network_data::const_ptr> >::const_iterator it = blobs.begin(); it != blobs.end(); ++it)
+		{
+			std::vector<std::string> data_layer_name_list = it->second->data_list.get_data_layer_name_list();
+			for(std::vector<std::string>::const_iterator it2 = data_layer_name_list.begin(); it2 != data_layer_name_list.end(); ++it2)
+			{
+				layer_data::ptr d = it->second->data_list.get(*it2);
+				for(layer_data::const_iterator it3 = d->begin(); it3 != d->end(); ++it3)
+				{
+					part_entry part = { it3->empty() ? 0 : &(*it3)[0], it3->size(), static_cast<unsigned int>(sizeof(float)), 0 };
+					parts.push_back(part);
+				}
+			}
+			std::vector<std::string> data_custom_layer_name_list = it->second->data_custom_list.get_data_custom_layer_name_list();
+			for(std::vector<std::string>::const_iterator it2 = data_custom_layer_name_list.begin(); it2 != data_custom_layer_name_list.end(); ++it2)
+			{
+				layer_data_custom::ptr d = it->second->data_custom_list.get(*it2);
+				for(layer_data_custom::const_iterator it3 = d->begin(); it3 != d->end(); ++it3)
+				{
+					part_entry part = { it3->empty() ? 0 : &(*it3)[0], it3->size(), static_cast<unsigned int>(sizeof(int)), 0 };
+					parts.push_back(part);
+				}
+			}
+		}
+
+		// The header is built twice, its size doesn't depend on the offsets which are known once the size is
+		std::string header;
+		for(int pass = 0; pass < 2; ++pass)
+		{
+			if (pass == 1)
+			{
+				unsigned long long offset = (header.size() + payload_alignment - 1) / payload_alignment * payload_alignment;
+				for(std::vector<part_entry>::iterator it = parts.begin(); it != parts.end(); ++it)
+				{
+					it->offset = offset;
+					offset += (it->element_count * it->element_size + payload_alignment - 1) / payload_alignment * payload_alignment;
+				}
+			}
+
+			std::ostringstream out(std::ios_base::out | std::ios_base::binary);
+			out.write(reinterpret_cast<const char *>(checkpoint_guid.data), sizeof(checkpoint_guid.data));
+			write_uint32(out, format_version);
+			write_uint32(out, static_cast<unsigned int>(blobs.size()));
+			std::vector<part_entry>::const_iterator part_it = parts.begin();
+			for(std::vector<std::pair<std::string, network_data::const_ptr> >::const_iterator it = blobs.begin(); it != blobs.end(); ++it)
+			{
+				write_string(out, it->first);
+
+				std::vector<std::string> data_layer_name_list = it->second->data_list.get_data_layer_name_list();
+				write_uint32(out, static_cast<unsigned int>(data_layer_name_list.size()));
+				for(std::vector<std::string>::const_iterator it2 = data_layer_name_list.begin(); it2 != data_layer_name_list.end(); ++it2)
+				{
+					write_string(out, *it2);
+					layer_data::ptr d = it->second->data_list.get(*it2);
+					write_uint32(out, static_cast<unsigned int>(d->size()));
+					for(unsigned int part_id = 0; part_id < d->size(); ++part_id, ++part_it)
+					{
+						write_uint64(out, part_it->offset);
+						write_uint64(out, part_it->element_count);
+					}
+				}
+
+				std::vector<std::string> data_custom_layer_name_list = it->second->data_custom_list.get_data_custom_layer_name_list();
+				write_uint32(out, static_cast<unsigned int>(data_custom_layer_name_list.size()));
+				for(std::vector<std::string>::const_iterator it2 = data_custom_layer_name_list.begin(); it2 != data_custom_layer_name_list.end(); ++it2)
+				{
+					write_string(out, *it2);
+					layer_data_custom::ptr d = it->second->data_custom_list.get(*it2);
+					write_uint32(out, static_cast<unsigned int>(d->size()));
+					for(unsigned int part_id = 0; part_id < d->size(); ++part_id, ++part_it)
+					{
+						write_uint64(out, part_it->offset);
+						write_uint64(out, part_it->element_count);
+					}
+				}
+			}
+			header = out.str();
+		}
+
+		boost::filesystem::path temp_file_path = file_path;
+		temp_file_path += ".temp";
+		{
+			boost::filesystem::ofstream out(temp_file_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			out.exceptions(std::ostream::eofbit | std::ostream::failbit | std::ostream::badbit);
+			out.write(header.data(), header.size());
+			unsigned long long pos = header.size();
+			const std::vector<char> padding(payload_alignment, 0);
+			for(std::vector<part_entry>::const_iterator it = parts.begin(); it != parts.end(); ++it)
+			{
+				out.write(&padding[0], static_cast<std::streamsize>(it->offset - pos));
+				out.write(static_cast<const char *>(it->src), static_cast<std::streamsize>(it->element_count * it->element_size));
+				pos = it->offset + it->element_count * it->element_size;
+			}
+			out.write(&padding[0], static_cast<std::streamsize>((pos + payload_alignment - 1) / payload_alignment * payload_alignment - pos));
+		}
+		if (sync_to_disk)
+			background_network_data_writer::sync_path(temp_file_path);
+		boost::filesystem::rename(temp_file_path, file_path);
+		if (sync_to_disk)
+			background_network_data_writer::sync_path(file_path.parent_path());
+	}
+
+	void network_data_checkpoint::read(
+		const boost::filesystem::path& file_path,
+		bool read_momentum)
+	{
+		data.reset();
+		momentum_data.reset();
+		momentum_data2.reset();
+
+		if (!boost::filesystem::is_regular_file(file_path))
+			throw neural_network_exception((boost::format("Checkpoint file %1% doesn't exist") % file_path.string()).str());
+
+		boost::interprocess::file_mapping mapping(file_path.string().c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+		header_reader reader(static_cast<const unsigned char *>(region.get_address()), region.get_size(), file_path);
+
+		boost::uuids::uuid checkpoint_guid_read;
+		memcpy(checkpoint_guid_read.data, reader.read_bytes(sizeof(checkpoint_guid_read.data)), sizeof(checkpoint_guid_read.data));
+		if (checkpoint_guid_read != checkpoint_guid)
+			throw neural_network_exception((boost::format("Unknown checkpoint GUID encountered in %1%: %2%") % file_path.string() % checkpoint_guid_read).str());
+		unsigned int format_version_read = reader.read_uint32();
+		if (format_version_read != format_version)
+			throw neural_network_exception((boost::format("Unsupported checkpoint format version %1% in %2%") % format_version_read % file_path.string()).str());
+
+		unsigned int blob_count = reader.read_uint32();
+		for(unsigned int blob_id = 0; blob_id < blob_count; ++blob_id)
+		{
+			std::string blob_name = reader.read_string();
+			network_data::ptr blob(new network_data());
+			// The index has to be walked through anyway, payloads of skipped blobs are not touched
+			bool skip = (blob_name != "data") && !read_momentum;
+
+			unsigned int layer_count = reader.read_uint32();
+			for(unsigned int layer_id = 0; layer_id < layer_count; ++layer_id)
+			{
+				std::string layer_name = reader.read_string();
+				layer_data::ptr d(new layer_data());
+				d->resize(reader.read_uint32());
+				for(layer_data::iterator it = d->begin(); it != d->end(); ++it)
+				{
+					unsigned long long offset = reader.read_uint64();
+					unsigned long long element_count = reader.read_uint64();
+					if (skip)
+						continue;
+					const float * src = reinterpret_cast<const float *>(reader.get_payload(offset, element_count, sizeof(float)));
+					it->assign(src, src + element_count);
+				}
+				if (!skip)
+					blob->data_list.add(layer_name, d);
+			}
+
+			unsigned int custom_layer_count = reader.read_uint32();
+			for(unsigned int layer_id = 0; layer_id < custom_layer_count; ++layer_id)
+			{
+				std::string layer_name = reader.read_string();
+				layer_data_custom::ptr d(new layer_data_custom());
+				d->resize(reader.read_uint32());
+				for(layer_data_custom::iterator it = d->begin(); it != d->end(); ++it)
+				{
+					unsigned long long offset = reader.read_uint64();
+					unsigned long long element_count = reader.read_uint64();
+					if (skip)
+						continue;
+					const int * src = reinterpret_cast<const int *>(reader.get_payload(offset, element_count, sizeof(int)));
+					it->assign(src, src + element_count);
+				}
+				if (!skip)
+					blob->data_custom_list.add(layer_name, d);
+			}
+
+			if (skip)
+				continue;
+			if (blob_name == "data")
+				data = blob;
+			else if (blob_name == "momentum")
+				momentum_data = blob;
+			else if (blob_name == "momentum2")
+				momentum_data2 = blob;
+			else
+				throw neural_network_exception((boost::format("Unknown blob %1% encountered in checkpoint %2%") % blob_name % file_path.string()).str());
+		}
+
+		if (!data)
+			throw neural_network_exception((boost::format("No network data in checkpoint %1%") % file_path.string()).str());
+	}
+
+	bool network_data_checkpoint::is_checkpoint_file(const boost::filesystem::path& file_path)
+	{
+		return boost::filesystem::is_regular_file(file_path) && (file_path.extension().string() == file_extension);
+	}
+}
@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "network_data.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/uuid/uuid.hpp>
+
+namespace nnforge
+{
+	// Network data and optionally its momentums in a single file.
+	// The header indexes all the layers and their parts, payloads follow it aligned,
+	// so reading maps the file into memory and copies each part at once without parsing
+	class network_data_checkpoint
+	{
+	public:
+		network_data_checkpoint() = default;
+
+		// The file is written to a temporary one first, which then replaces file_path.
+		// The temporary file is flushed to the disk before it is renamed, and the folder after that, when sync_to_disk is set
+		void write(
+			const boost::filesystem::path& file_path,
+			bool sync_to_disk = false) const;
+
+		// Momentums are left empty when read_momentum is not set or the file has no momentums
+		void read(
+			const boost::filesystem::path& file_path,
+			bool read_momentum = true);
+
+		static bool is_checkpoint_file(const boost::filesystem::path& file_path);
+
+	public:
+		network_data::ptr data;
+		network_data::ptr momentum_data;
+		network_data::ptr momentum_data2;
+
+		static const char * file_extension;
+
+	private:
+		static const boost::uuids::uuid checkpoint_guid;
+		static const unsigned int format_version;
+		static const size_t payload_alignment;
+	};
+}
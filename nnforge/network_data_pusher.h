@@ -35,6 +35,10 @@ namespace nnforge
 			const training_task_state& task_state,
 			const network_schema& schema) = 0;
 
+		// Waits for the work started by previous pushes to complete, rethrows the exception it failed with.
+		// Pushers doing nothing in background don't need to override it
+		virtual void flush();
+
 	protected:
 		network_data_pusher() = default;
 
@@ -519,6 +519,8 @@ namespace nnforge
 			}
 		}
 
+		// Backward data actions are required only through the weight updates depending on them, so nothing is propagated below the lowest trainable layer
+		// and outputs of the frozen layers are used by forward actions only, just like in inference
 		res->drop_actions_not_required_to_do(target_action_set);
 
 		for(std::set<std::string>::const_iterator it = layer_weights_to_update.begin(); it != layer_weights_to_update.end(); ++it)
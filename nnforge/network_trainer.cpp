@@ -18,9 +18,14 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <exception>
 
 #include "neural_network_exception.h"
 #include "exponential_learning_rate_decay_policy.h"
+#include "structured_data_bunch_shared_reader.h"
 
 namespace nnforge
 {
@@ -38,6 +43,8 @@ namespace nnforge
 		, lr_policy(new exponential_learning_rate_decay_policy())
 		, batch_size(1)
 		, max_chunk_size(0)
+		, concurrent_task_count(1)
+		, concurrent_max_kept_entry_count(8192)
 	{
 	}
 
@@ -47,15 +54,155 @@ namespace nnforge
 		network_data_pusher& progress_pusher,
 		network_data_pusher& pusher)
 	{
-		initialize_train(reader);
+		initialize_train(prefix_cache ? prefix_cache->get_suffix_config_map() : reader.get_config_map());
 
+		if (concurrent_task_count > 1)
+		{
+			if (prefix_cache)
+				throw neural_network_exception("Networks cannot be trained concurrently on the cached outputs of the frozen prefix");
+
+			train_concurrently(reader, peeker, progress_pusher, pusher);
+		}
+		else
+		{
+			train_sequentially(reader, peeker, progress_pusher, pusher);
+		}
+
+		// Pushers might still be writing the data of the last epoch in background
+		progress_pusher.flush();
+		pusher.flush();
+	}
+
+	void network_trainer::train_sequentially(
+		structured_data_bunch_reader& reader,
+		network_data_peeker& peeker,
+		network_data_pusher& progress_pusher,
+		network_data_pusher& pusher)
+	{
+		while(true)
+		{
+			training_task_state new_task;
+			if (!allocate_task(peeker, new_task))
+				break;
+
+			structured_data_bunch_reader::ptr cached_reader;
+			if (prefix_cache)
+				cached_reader = prefix_cache->get_reader(*new_task.data);
+			structured_data_bunch_reader& task_reader = cached_reader ? *cached_reader : reader;
+
+			unsigned int reader_epoch_id = new_task.initial_epoch;
+
+			while(true)
+			{
+				std::cout << "---------- NN # " << new_task.index_peeked << ", Epoch " << new_task.get_current_epoch() + 1 << " ----------" << std::endl;
+
+				task_reader.set_epoch(reader_epoch_id);
+
+				train_step(
+					task_reader,
+					new_task,
+					0);
+
+				++reader_epoch_id;
+
+				if (complete_epoch(new_task, progress_pusher, pusher))
+					break;
+			}
+		}
+	}
+
+	void network_trainer::train_concurrently(
+		structured_data_bunch_reader& reader,
+		network_data_peeker& peeker,
+		network_data_pusher& progress_pusher,
+		network_data_pusher& pusher)
+	{
+		std::vector<std::shared_ptr<training_task_state> > tasks(concurrent_task_count);
+		bool peeker_exhausted = false;
+
+		while(true)
+		{
+			for(std::vector<std::shared_ptr<training_task_state> >::iterator it = tasks.begin(); (it != tasks.end()) && (!peeker_exhausted); ++it)
+			{
+				if (*it)
+					continue;
+
+				std::shared_ptr<training_task_state> new_task(new training_task_state());
+				if (allocate_task(peeker, *new_task))
+					*it = new_task;
+				else
+					peeker_exhausted = true;
+			}
+
+			// Tasks at the same epoch see the same data, they are trained together reading the data once
+			unsigned int reader_epoch_id = std::numeric_limits<unsigned int>::max();
+			for(std::vector<std::shared_ptr<training_task_state> >::const_iterator it = tasks.begin(); it != tasks.end(); ++it)
+				if (*it)
+					reader_epoch_id = std::min(reader_epoch_id, (*it)->get_current_epoch());
+			if (reader_epoch_id == std::numeric_limits<unsigned int>::max())
+				break;
+
+			std::vector<unsigned int> slot_ids;
+			for(unsigned int slot_id = 0; slot_id < static_cast<unsigned int>(tasks.size()); ++slot_id)
+			{
+				if (tasks[slot_id] && (tasks[slot_id]->get_current_epoch() == reader_epoch_id))
+				{
+					slot_ids.push_back(slot_id);
+					std::cout << "---------- NN # " << tasks[slot_id]->index_peeked << ", Epoch " << reader_epoch_id + 1 << " ----------" << std::endl;
+				}
+			}
+
+			if (slot_ids.size() == 1)
+			{
+				reader.set_epoch(reader_epoch_id);
+				train_step(reader, *tasks[slot_ids.front()], slot_ids.front());
+			}
+			else
+			{
+				structured_data_bunch_shared_reader shared_reader(reader, static_cast<unsigned int>(slot_ids.size()), concurrent_max_kept_entry_count);
+				shared_reader.set_epoch(reader_epoch_id);
+
+				std::vector<std::exception_ptr> errors(slot_ids.size());
+				std::vector<std::thread> threads;
+				for(unsigned int consumer_id = 0; consumer_id < static_cast<unsigned int>(slot_ids.size()); ++consumer_id)
+				{
+					threads.push_back(std::thread([&, consumer_id] ()
+						{
+							try
+							{
+								structured_data_bunch_reader::ptr consumer_reader = shared_reader.get_consumer_reader(consumer_id);
+								train_step(*consumer_reader, *tasks[slot_ids[consumer_id]], slot_ids[consumer_id]);
+							}
+							catch (...)
+							{
+								errors[consumer_id] = std::current_exception();
+							}
+							shared_reader.finish(consumer_id);
+						}));
+				}
+				for(std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+					it->join();
+				for(std::vector<std::exception_ptr>::const_iterator it = errors.begin(); it != errors.end(); ++it)
+					if (*it)
+						std::rethrow_exception(*it);
+			}
+
+			for(std::vector<unsigned int>::const_iterator it = slot_ids.begin(); it != slot_ids.end(); ++it)
+				if (complete_epoch(*tasks[*it], progress_pusher, pusher))
+					tasks[*it].reset();
+		}
+	}
+
+	bool network_trainer::allocate_task(
+		network_data_peeker& peeker,
+		training_task_state& new_task)
+	{
 		while(true)
 		{
 			network_data_peek_entry entry_peeked = peeker.peek(schema);
 			if (entry_peeked.data == 0)
-				break;
+				return false;
 
-			training_task_state new_task;
 			new_task.index_peeked = entry_peeked.index;
 			new_task.data = entry_peeked.data;
 			new_task.initial_epoch = entry_peeked.start_epoch;
@@ -104,35 +251,30 @@ namespace nnforge
 				std::cout << ", Starting with the 2nd empty momentum";
 			std::cout << std::endl;
 
-			unsigned int reader_epoch_id = new_task.initial_epoch;
-
-			while(true)
-			{
-				std::cout << "---------- NN # " << new_task.index_peeked << ", Epoch " << new_task.get_current_epoch() + 1 << " ----------" << std::endl;
-
-				reader.set_epoch(reader_epoch_id);
-
-				train_step(
-					reader,
-					new_task);
-
-				++reader_epoch_id;
+			return true;
+		}
+	}
 
-				progress_pusher.push(new_task, *schema);
+	bool network_trainer::complete_epoch(
+		training_task_state& task,
+		network_data_pusher& progress_pusher,
+		network_data_pusher& pusher)
+	{
+		progress_pusher.push(task, *schema);
 
-				if (is_broken(new_task))
-				{
-					std::cout << "# " << new_task.index_peeked << " - broken weights while training, discarding it." << std::endl;
-					break;
-				}
+		if (is_broken(task))
+		{
+			std::cout << "# " << task.index_peeked << " - broken weights while training, discarding it." << std::endl;
+			return true;
+		}
 
-				if (is_last_epoch(new_task))
-				{
-					pusher.push(new_task, *schema);
-					break;
-				}
-			}
+		if (is_last_epoch(task))
+		{
+			pusher.push(task, *schema);
+			return true;
 		}
+
+		return false;
 	}
 
 	bool network_trainer::is_last_epoch(const training_task_state& state) const
@@ -23,6 +23,7 @@
 #include "structured_data_bunch_reader.h"
 #include "training_momentum.h"
 #include "learning_rate_decay_policy.h"
+#include "frozen_prefix_feature_cache.h"
 
 #include <map>
 #include <memory>
@@ -49,6 +50,12 @@ namespace nnforge
 		learning_rate_decay_policy::const_ptr lr_policy;
 		float weight_decay;
 		training_momentum momentum;
+		// Number of networks trained at the same time, the networks at the same epoch share reading the data
+		unsigned int concurrent_task_count;
+		// Number of entries kept in memory for the networks trained together, the rest is read again by the networks lagging behind
+		unsigned int concurrent_max_kept_entry_count;
+		// When set, each task is trained on the cached outputs of the frozen prefix instead of the reader passed to train
+		frozen_prefix_feature_cache::ptr prefix_cache;
 
 	protected:
 		network_trainer(
@@ -59,12 +66,14 @@ namespace nnforge
 
 		float get_global_learning_rate(unsigned int epoch) const;
 
-		virtual void initialize_train(structured_data_bunch_reader& reader) = 0;
+		virtual void initialize_train(const std::map<std::string, layer_configuration_specific>& input_config_map) = 0;
 
 		// The method should add testing result to the training history of each element
+		// slot_id is less than concurrent_task_count, the calls with different slot_id might run concurrently
 		virtual void train_step(
 			structured_data_bunch_reader& reader,
-			training_task_state& task) = 0;
+			training_task_state& task,
+			unsigned int slot_id) = 0;
 
 		network_schema::ptr schema;
 		std::vector<std::string> output_layer_names;
@@ -72,6 +81,29 @@ namespace nnforge
 		std::vector<std::string> exclude_data_update_layer_names;
 
 	private:
+		void train_sequentially(
+			structured_data_bunch_reader& reader,
+			network_data_peeker& peeker,
+			network_data_pusher& progress_pusher,
+			network_data_pusher& pusher);
+
+		void train_concurrently(
+			structured_data_bunch_reader& reader,
+			network_data_peeker& peeker,
+			network_data_pusher& progress_pusher,
+			network_data_pusher& pusher);
+
+		// Returns false when the peeker has no more tasks
+		bool allocate_task(
+			network_data_peeker& peeker,
+			training_task_state& new_task);
+
+		// Pushes the results of the epoch, returns true when training the task is over
+		bool complete_epoch(
+			training_task_state& task,
+			network_data_pusher& progress_pusher,
+			network_data_pusher& pusher);
+
 		bool is_last_epoch(const training_task_state& state) const;
 
 		bool is_broken(const training_task_state& state) const;
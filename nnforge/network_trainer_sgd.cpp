@@ -21,7 +21,7 @@
 #include <limits>
 
 #include "neural_network_exception.h"
-#include "neuron_value_set_data_bunch_writer.h"
+#include "average_data_bunch_writer.h"
 
 namespace nnforge
 {
@@ -32,33 +32,58 @@ namespace nnforge
 		const std::vector<std::string>& exclude_data_update_layer_names,
 		backward_propagation::ptr backprop)
 		: network_trainer(schema, output_layer_names, error_source_layer_names, exclude_data_update_layer_names)
-		, backprop(backprop)
+		, backprops(1, backprop)
 	{
 	}
 
+	network_trainer_sgd::network_trainer_sgd(
+		network_schema::ptr schema,
+		const std::vector<std::string>& output_layer_names,
+		const std::vector<std::string>& error_source_layer_names,
+		const std::vector<std::string>& exclude_data_update_layer_names,
+		const std::vector<backward_propagation::ptr>& backprops)
+		: network_trainer(schema, output_layer_names, error_source_layer_names, exclude_data_update_layer_names)
+		, backprops(backprops)
+	{
+		concurrent_task_count = static_cast<unsigned int>(backprops.size());
+	}
+
 	void network_trainer_sgd::train_step(
 		structured_data_bunch_reader& reader,
-		training_task_state& task)
+		training_task_state& task,
+		unsigned int slot_id)
 	{
-		std::pair<std::map<std::string, std::vector<float> >, std::string> lr_and_comment = prepare_learning_rates(task.get_current_epoch(), task.data);
+		// Only the weights of the suffix are passed when training on the cached outputs of the frozen prefix, they share the storage with the task's ones
+		network_data::ptr data = task.data;
+		network_data::ptr momentum_data = task.momentum_data;
+		network_data::ptr momentum_data2 = task.momentum_data2;
+		if (prefix_cache)
+		{
+			std::vector<layer::const_ptr> suffix_layers = prefix_cache->get_suffix_schema()->get_layers();
+			data = network_data::ptr(new network_data(suffix_layers, *task.data));
+			if (momentum_data)
+				momentum_data = network_data::ptr(new network_data(suffix_layers, *task.momentum_data));
+			if (momentum_data2)
+				momentum_data2 = network_data::ptr(new network_data(suffix_layers, *task.momentum_data2));
+		}
+
+		std::pair<std::map<std::string, std::vector<float> >, std::string> lr_and_comment = prepare_learning_rates(task.get_current_epoch(), data);
 		task.comments.push_back(lr_and_comment.second);
 
-		neuron_value_set_data_bunch_writer writer;
-		backward_propagation::stat training_stat = backprop->run(
+		average_data_bunch_writer writer;
+		backward_propagation::stat training_stat = backprops[slot_id]->run(
 			reader,
 			writer,
-			*task.data,
-			task.momentum_data,
-			task.momentum_data2,
+			*data,
+			momentum_data,
+			momentum_data2,
 			lr_and_comment.first,
 			batch_size,
 			max_chunk_size,
 			weight_decay,
 			momentum,
 			task.get_current_epoch());
-		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > output_data_average_results;
-		for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = writer.layer_name_to_config_and_value_set_map.begin(); it != writer.layer_name_to_config_and_value_set_map.end(); ++it)
-			output_data_average_results.insert(std::make_pair(it->first, std::make_pair(it->second.first, it->second.second->get_average())));
+		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > output_data_average_results = writer.get_average();
 
 		task.history.push_back(std::make_pair(training_stat, output_data_average_results));
 	}
@@ -84,8 +109,12 @@ namespace nnforge
 		return std::make_pair(res, comment);
 	}
 
-	void network_trainer_sgd::initialize_train(structured_data_bunch_reader& reader)
+	void network_trainer_sgd::initialize_train(const std::map<std::string, layer_configuration_specific>& input_config_map)
 	{
-		backprop->set_input_configuration_specific(reader.get_config_map());
+		if (backprops.size() < concurrent_task_count)
+			throw neural_network_exception((boost::format("%1% networks cannot be trained concurrently with %2% backward propagations") % concurrent_task_count % backprops.size()).str());
+
+		for(std::vector<backward_propagation::ptr>::const_iterator it = backprops.begin(); it != backprops.end(); ++it)
+			(*it)->set_input_configuration_specific(input_config_map);
 	}
 }
@@ -36,15 +36,24 @@ namespace nnforge
 			const std::vector<std::string>& exclude_data_update_layer_names,
 			backward_propagation::ptr backprop);
 
+		// One backward propagation per each of the networks trained concurrently
+		network_trainer_sgd(
+			network_schema::ptr schema,
+			const std::vector<std::string>& output_layer_names,
+			const std::vector<std::string>& error_source_layer_names,
+			const std::vector<std::string>& exclude_data_update_layer_names,
+			const std::vector<backward_propagation::ptr>& backprops);
+
 		virtual ~network_trainer_sgd() = default;
 
 	protected:
 		// The method should add testing result to the training history of each element
 		virtual void train_step(
 			structured_data_bunch_reader& reader,
-			training_task_state& task);
+			training_task_state& task,
+			unsigned int slot_id);
 
-		virtual void initialize_train(structured_data_bunch_reader& reader);
+		virtual void initialize_train(const std::map<std::string, layer_configuration_specific>& input_config_map);
 
 	private:
 		std::pair<std::map<std::string, std::vector<float> >, std::string> prepare_learning_rates(
@@ -52,6 +61,6 @@ namespace nnforge
 			network_data::const_ptr data);
 
 	private:
-		backward_propagation::ptr backprop;
+		std::vector<backward_propagation::ptr> backprops;
 	};
 }
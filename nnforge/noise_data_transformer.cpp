@@ -50,4 +50,9 @@ namespace nnforge
 			}
 		}
 	}
+
+	bool noise_data_transformer::is_deterministic() const
+	{
+		return false;
+	}
 }
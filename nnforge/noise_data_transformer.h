@@ -36,6 +36,8 @@ namespace nnforge
 			float * data_transformed,
 			const layer_configuration_specific& original_config,
 			unsigned int sample_id);
+
+		virtual bool is_deterministic() const;
 			
 	protected:
 		random_generator generator;
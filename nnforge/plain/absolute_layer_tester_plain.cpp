@@ -44,9 +44,11 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-				*(out_it + i) = fabs(*(in_it + i));
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
+			{
+				for(int i = begin; i < end; ++i)
+					*(out_it + i) = fabs(*(in_it + i));
+			});
 		}
 
 		int absolute_layer_tester_plain::get_input_index_layer_can_write(
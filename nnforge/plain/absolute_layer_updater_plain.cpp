@@ -46,9 +46,11 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
-				*(out_it + i) = fabs(*(in_it + i));
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
+			{
+				for(int i = begin; i < end; ++i)
+					*(out_it + i) = fabs(*(in_it + i));
+			});
 		}
 
 		void absolute_layer_updater_plain::run_backward_data_propagation(
@@ -77,23 +79,27 @@ namespace nnforge
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					float input_val = *(in_it + i);
-					float out_err = *(out_err_it+ i);
-					*(in_err_it + i) += (input_val < 0.0F) ? -out_err : out_err;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						float input_val = *(in_it + i);
+						float out_err = *(out_err_it+ i);
+						*(in_err_it + i) += (input_val < 0.0F) ? -out_err : out_err;
+					}
+				});
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					float input_val = *(in_it + i);
-					float out_err = *(out_err_it+ i);
-					*(in_err_it + i) = (input_val < 0.0F) ? -out_err : out_err;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						float input_val = *(in_it + i);
+						float out_err = *(out_err_it+ i);
+						*(in_err_it + i) = (input_val < 0.0F) ? -out_err : out_err;
+					}
+				});
 			}
 		}
 
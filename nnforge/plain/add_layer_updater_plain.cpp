@@ -53,14 +53,16 @@ namespace nnforge
 			const float alpha = layer_derived->alpha;
 			const int src_ptr_count = static_cast<int>(in_list.size());
 			const int elem_count = static_cast<int>(entry_count * output_configuration_specific.get_neuron_count());
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
 			{
-				float sum = 0.0F;
-				for(int j = 0; j < src_ptr_count; ++j)
-					sum += in_ptr_list[j][i];
-				out[i] = sum * alpha;
-			}
+				for(int i = begin; i < end; ++i)
+				{
+					float sum = 0.0F;
+					for(int j = 0; j < src_ptr_count; ++j)
+						sum += in_ptr_list[j][i];
+					out[i] = sum * alpha;
+				}
+			});
 		}
 
 		void add_layer_updater_plain::run_backward_data_propagation(
@@ -89,21 +91,25 @@ namespace nnforge
 			const int elem_count = static_cast<int>(entry_count * output_configuration_specific.get_neuron_count());
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					in_errors[i] += out_errors[i] * alpha;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						in_errors[i] += out_errors[i] * alpha;
+					}
+				});
 			}
 			else
 			{
 				if ((in_errors != out_errors) || (alpha != 1.0F))
 				{
-					#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-					for(int i = 0; i < elem_count; ++i)
+					plain_config->parallel_for(elem_count, [&] (int begin, int end)
 					{
-						in_errors[i] = out_errors[i] * alpha;
-					}
+						for(int i = begin; i < end; ++i)
+						{
+							in_errors[i] = out_errors[i] * alpha;
+						}
+					});
 				}
 			}
 		}
@@ -56,10 +56,9 @@ namespace nnforge
 			const float weight_scale = layer_derived->get_weight_scale(output_configuration_specific);
 			const int total_workload = entry_count * output_height;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_height;
 					int y = workload_id - (entry_id * output_height);
@@ -92,7 +91,7 @@ namespace nnforge
 						out_it_base_y[x] = y_out_pos;
 					}
 				}
-			}
+			});
 		}
 	}
 }
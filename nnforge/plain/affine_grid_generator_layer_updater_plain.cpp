@@ -58,10 +58,9 @@ namespace nnforge
 			const float weight_scale = layer_derived->get_weight_scale(output_configuration_specific);
 			const int total_workload = entry_count * output_height;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_height;
 					int y = workload_id - (entry_id * output_height);
@@ -94,7 +93,7 @@ namespace nnforge
 						out_it_base_y[x] = y_out_pos;
 					}
 				}
-			}
+			});
 		}
 
 		void affine_grid_generator_layer_updater_plain::run_backward_data_propagation(
@@ -130,10 +129,9 @@ namespace nnforge
 			const float weight_scale = layer_derived->get_weight_scale(output_configuration_specific);
 			const int total_workload = entry_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id;
 
@@ -178,7 +176,7 @@ namespace nnforge
 							in_it_base[i] = input_errors[i] * weight_scale;
 					}
 				}
-			}
+			});
 		}
 
 		bool affine_grid_generator_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
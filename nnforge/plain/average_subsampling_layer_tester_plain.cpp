@@ -106,12 +106,11 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
@@ -144,7 +143,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 	}
 }
@@ -108,12 +108,11 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
@@ -145,7 +144,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		void average_subsampling_layer_updater_plain::run_backward_data_propagation(
@@ -237,11 +236,13 @@ namespace nnforge
 				if (!exact_subsampling)
 				{
 					const int total_clean_workload = entry_count * entry_subsampling_size * input_neuron_count;
-					#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-					for(int workload_id = 0; workload_id < total_clean_workload; ++workload_id)
+					plain_config->parallel_for(total_clean_workload, [&] (int begin, int end)
 					{
-						*(in_err_it_global + workload_id) = 0.0F;
-					}
+						for(int workload_id = begin; workload_id < end; ++workload_id)
+						{
+							*(in_err_it_global + workload_id) = 0.0F;
+						}
+					});
 				}
 			}
 
@@ -251,12 +252,11 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
@@ -293,7 +293,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		bool average_subsampling_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
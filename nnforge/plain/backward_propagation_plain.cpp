@@ -17,11 +17,20 @@
 #include "backward_propagation_plain.h"
 
 #include "layer_updater_plain_factory.h"
+#include "plain_reduce_all_queue.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <numeric>
+#include <string.h>
+#include <math.h>
 
 #include "../neural_network_exception.h"
 
@@ -40,29 +49,50 @@ namespace nnforge
 			: backward_propagation(schema, output_layer_names, error_source_layer_names, exclude_data_update_layer_names, debug, profile)
 			, plain_config(plain_config)
 			, temporary_working_fixed_size(0)
+			, cache_aware_entry_count(0)
 		{
 			actions_in_execution_order = action_schema->get_actions_in_execution_order();
 
-			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
-			network_action_schema::ptr sequential_action_schema(new network_action_schema());
+			if (plain_config->inter_op_parallelism)
 			{
-				std::vector<layer_name_with_action> dependencies;
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				// Independent branches run concurrently, buffers are planned on the original action graph so that concurrent actions never share them
+				inter_op_action_stream_runner = plain_action_stream_runner::const_ptr(new plain_action_stream_runner(*action_schema, plain_config));
+
+				if (debug->is_debug())
 				{
-					sequential_action_schema->add_action(
-						this->schema->get_layer(it->get_name()),
-						it->get_action(),
-						dependencies);
-					dependencies.clear();
-					dependencies.push_back(*it);
+					std::map<layer_name_with_action, unsigned int> action_to_worker_map;
+					const std::vector<std::vector<layer_name_with_action> >& worker_action_list = inter_op_action_stream_runner->get_worker_action_list();
+					for(unsigned int worker_id = 0; worker_id < static_cast<unsigned int>(worker_action_list.size()); ++worker_id)
+						for(std::vector<layer_name_with_action>::const_iterator it = worker_action_list[worker_id].begin(); it != worker_action_list[worker_id].end(); ++it)
+							action_to_worker_map.insert(std::make_pair(*it, worker_id));
+					debug->output_message((boost::format("backward prop plain concurrent workers: %1%") % inter_op_action_stream_runner->get_worker_count()).str().c_str());
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_action_schema_workers", "gv"), std::ios_base::out | std::ios_base::trunc);
+					action_schema->write_gv(out, action_to_worker_map);
 				}
 			}
-			action_schema = sequential_action_schema;
-
-			if (debug->is_debug())
+			else
 			{
-				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
-				action_schema->write_gv(out);
+				// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
+				network_action_schema::ptr sequential_action_schema(new network_action_schema());
+				{
+					std::vector<layer_name_with_action> dependencies;
+					for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					{
+						sequential_action_schema->add_action(
+							this->schema->get_layer(it->get_name()),
+							it->get_action(),
+							dependencies);
+						dependencies.clear();
+						dependencies.push_back(*it);
+					}
+				}
+				action_schema = sequential_action_schema;
+
+				if (debug->is_debug())
+				{
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
+					action_schema->write_gv(out);
+				}
 			}
 
 			std::set<std::string> action_layer_names;
@@ -70,12 +100,57 @@ namespace nnforge
 			{
 				action_layer_names.insert(it->get_name());
 				layer_name_to_action_set_map.insert(std::make_pair(it->get_name(), std::set<layer_action>())).first->second.insert(it->get_action());
+				if (it->get_action().get_action_type() == layer_action::update_weights)
+					updated_layer_names.insert(it->get_name());
 			}
 			for(std::set<std::string> ::const_iterator it = action_layer_names.begin(); it != action_layer_names.end(); ++it)
 				updaters.insert(
 					std::make_pair(
 						*it,
 						layer_updater_plain_factory::get_singleton().get_updater_plain_layer(this->schema->get_layer(*it)->get_type_name())));
+
+			if (plain_config->activation_checkpointing)
+				setup_non_checkpoint_layer_names();
+		}
+
+		void backward_propagation_plain::setup_non_checkpoint_layer_names()
+		{
+			std::set<std::string> dedicated_output_buffers(output_layer_names.begin(), output_layer_names.end());
+			std::vector<std::string> candidate_layer_names;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				if (it->get_action().get_action_type() != layer_action::forward)
+					continue;
+				if (dedicated_output_buffers.find(it->get_name()) != dedicated_output_buffers.end())
+					continue;
+				if (!updaters[it->get_name()]->is_forward_deterministic())
+					continue;
+				candidate_layer_names.push_back(it->get_name());
+			}
+			if (candidate_layer_names.empty())
+				return;
+
+			std::set<std::string> checkpoint_layer_names;
+			if (plain_config->activation_checkpoint_layer_names.empty())
+			{
+				// Keep each sqrt(N)-th output, this results in O(sqrt(N)) activations stored at the cost of one extra forward pass
+				unsigned int stride = static_cast<unsigned int>(ceilf(sqrtf(static_cast<float>(candidate_layer_names.size()))));
+				for(unsigned int i = stride - 1; i < static_cast<unsigned int>(candidate_layer_names.size()); i += stride)
+					checkpoint_layer_names.insert(candidate_layer_names[i]);
+			}
+			else
+			{
+				for(std::vector<std::string>::const_iterator it = plain_config->activation_checkpoint_layer_names.begin(); it != plain_config->activation_checkpoint_layer_names.end(); ++it)
+				{
+					if (!schema->find_layer(*it))
+						throw neural_network_exception((boost::format("Activation checkpoint layer %1% not found in the schema") % *it).str());
+					checkpoint_layer_names.insert(*it);
+				}
+			}
+
+			for(std::vector<std::string>::const_iterator it = candidate_layer_names.begin(); it != candidate_layer_names.end(); ++it)
+				if (checkpoint_layer_names.find(*it) == checkpoint_layer_names.end())
+					non_checkpoint_layer_names.insert(*it);
 		}
 
 		void backward_propagation_plain::actual_run(
@@ -96,7 +171,22 @@ namespace nnforge
 			float& idle_seconds)
 		{
 			std::map<std::string, std::vector<double> > updates_accumulated;
-			std::vector<std::string> data_layer_list = data.data_list.get_data_layer_name_list();
+			std::vector<std::string> all_data_layer_list = data.data_list.get_data_layer_name_list();
+			std::vector<std::string> data_layer_list;
+			size_t frozen_weight_count = 0;
+			unsigned int frozen_layer_count = 0;
+			for(std::vector<std::string>::const_iterator it = all_data_layer_list.begin(); it != all_data_layer_list.end(); ++it)
+			{
+				if (updated_layer_names.find(*it) != updated_layer_names.end())
+				{
+					data_layer_list.push_back(*it);
+					continue;
+				}
+				layer_data::ptr d = data.data_list.get(*it);
+				for(layer_data::const_iterator it2 = d->begin(); it2 != d->end(); ++it2)
+					frozen_weight_count += it2->size();
+				++frozen_layer_count;
+			}
 			for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
 			{
 				const std::string& layer_name = *it;
@@ -109,16 +199,88 @@ namespace nnforge
 				layer_list.push_back(schema->get_layer(*it));
 			layer_data_list::ptr gradient(new layer_data_list(layer_list, 0.0F));
 
+			// Each worker process gets its own shard of every chunk and the gradients are reduced across them before being applied
+			plain_communicator::ptr communicator = plain_config->communicator;
+			unsigned int worker_process_count = communicator ? communicator->get_worker_count() : 1;
+			unsigned int worker_process_rank = communicator ? communicator->get_rank() : 0;
+			if (communicator)
+				broadcast_data(*communicator, data, momentum_data, momentum_data2);
+			// Gradients are reduced as soon as update_weights action of the layer is reached, the order should be the same in all the worker processes,
+			// so it is not done when actions are run concurrently
+			plain_reduce_all_queue::ptr reduce_queue;
+			if (communicator && (worker_process_count > 1) && (!action_stream_runner))
+				reduce_queue = plain_reduce_all_queue::ptr(new plain_reduce_all_queue(communicator));
+			std::set<std::string> enqueued_gradient_layer_names;
+
+			unsigned int async_worker_count = static_cast<unsigned int>(std::max(plain_config->async_sgd_worker_count, 1));
+			if ((async_worker_count > 1) && communicator)
+				throw neural_network_exception("Asynchronous SGD cannot be combined with multiple worker processes");
+
+			bool selective_backprop = (plain_config->selective_backprop_rate < 1.0F);
+			std::map<unsigned int, size_t> selective_layer_buffer_set_to_per_entry_size_map;
+			if (selective_backprop)
+			{
+				if (plain_config->selective_backprop_rate <= 0.0F)
+					throw neural_network_exception((boost::format("Invalid selective backprop rate: %1%") % plain_config->selective_backprop_rate).str());
+				if ((async_worker_count > 1) || communicator)
+					throw neural_network_exception("Selective backprop cannot be combined with asynchronous SGD or multiple worker processes");
+				// Errors are read from dedicated buffers, outputs of other layers might be overwritten before the end of forward pass
+				for(std::vector<std::string>::const_iterator it = error_source_layer_names.begin(); it != error_source_layer_names.end(); ++it)
+					if (std::find(output_layer_names.begin(), output_layer_names.end(), *it) == output_layer_names.end())
+						throw neural_network_exception((boost::format("Selective backprop requires error source layer %1% to be an output layer") % *it).str());
+				// Activations of the selected entries are compacted in place, which relies on each entry occupying the same slot in all the buffers
+				for(std::map<std::string, unsigned int>::const_iterator it = cumulative_tiling_factor_map.begin(); it != cumulative_tiling_factor_map.end(); ++it)
+					if (it->second != 1)
+						throw neural_network_exception((boost::format("Selective backprop is not supported for layer %1% with tiling factor %2%") % it->first % it->second).str());
+
+				// Find which layer buffers hold per-entry data at the end of forward pass, the last action writing to the buffer set wins
+				for(std::vector<std::pair<layer_name_with_action, bool> >::const_iterator action_it = action_run_list.begin(); action_it != action_run_list.end(); ++action_it)
+				{
+					const layer_name_with_action& current_layer_name_with_action = action_it->first;
+					if ((current_layer_name_with_action.get_action().get_action_type() != layer_action::forward) || !(recomputed_layer_names.empty() || action_it->second))
+						continue;
+					const std::string& layer_name = current_layer_name_with_action.get_name();
+					if (recomputed_layer_names.find(layer_name) != recomputed_layer_names.end())
+						continue;
+
+					std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_working_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
+					if (it != temporary_working_per_entry_data_action_to_set_map.end())
+						selective_layer_buffer_set_to_per_entry_size_map.erase(it->second);
+
+					layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+					it = temporary_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
+					if (it != temporary_per_entry_data_action_to_set_map.end())
+					{
+						layer::const_ptr l = schema->get_layer(layer_name);
+						std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+							input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+						selective_layer_buffer_set_to_per_entry_size_map[it->second] = updaters[layer_name]->get_temporary_per_entry_buffer_size(
+							layer_name_to_action_set_map[layer_name],
+							plain_config,
+							l,
+							input_layer_configuration_specific_list,
+							output_layer_configuration_specific);
+					}
+
+					it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
+					if (it != layer_buffer_action_to_set_map.end())
+						selective_layer_buffer_set_to_per_entry_size_map[it->second] = output_layer_configuration_specific.get_neuron_count() * sizeof(float);
+				}
+			}
+
 			buffer_plain_size_configuration buffer_configuration = buffer_config_without_data_and_momentum;
 			{
-				for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
+				for(std::vector<std::string>::const_iterator it = all_data_layer_list.begin(); it != all_data_layer_list.end(); ++it)
 				{
 					const std::string& layer_name = *it;
+					bool is_updated = (updated_layer_names.find(layer_name) != updated_layer_names.end());
 					layer_data::ptr d = data.data_list.get(layer_name);
 					for(layer_data::const_iterator it2 = d->begin(); it2 != d->end(); ++it2)
 					{
 						buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // data
-						buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // gradient
+						if (is_updated)
+							buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // gradient
 						if (momentum.is_momentum_data())
 							buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // momentum
 						if (momentum.is_momentum_data2())
@@ -135,11 +297,53 @@ namespace nnforge
 				}
 				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
 					buffer_configuration.add_constant_buffer(it->second.size() * sizeof(double));
+				// Each asynchronous SGD worker has its own gradient and momentums
+				if (async_worker_count > 1)
+				{
+					for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
+					{
+						layer_data::ptr d = data.data_list.get(*it);
+						for(layer_data::const_iterator it2 = d->begin(); it2 != d->end(); ++it2)
+						{
+							for(unsigned int i = 0; i < async_worker_count; ++i)
+							{
+								buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // gradient
+								if (momentum.is_momentum_data())
+									buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // momentum
+								if (momentum.is_momentum_data2())
+									buffer_configuration.add_constant_buffer(it2->size() * sizeof(float)); // 2nd momentum
+							}
+						}
+					}
+				}
+			}
+
+			if (frozen_layer_count > 0)
+			{
+				skipped_gradient_size = frozen_weight_count * sizeof(float);
+				// Asynchronous SGD workers would have their own gradients and momentums as well
+				if (async_worker_count > 1)
+					skipped_gradient_size *= 1 + async_worker_count * (1 + (momentum.is_momentum_data() ? 1 : 0) + (momentum.is_momentum_data2() ? 1 : 0));
+				if (debug->is_debug())
+				{
+					std::stringstream debug_str;
+					debug_str << "backward prop plain gradients skipped for " << frozen_layer_count << " frozen layers: "
+						<< ((skipped_gradient_size + 1024 - 1) / 1024) << " KB saved";
+					debug->output_message(debug_str.str().c_str());
+				}
 			}
 
 			unsigned int max_entry_count = plain_config->get_max_entry_count(buffer_configuration);
 
-			if (debug->is_debug())
+			if (max_entry_count == 0)
+				throw neural_network_exception("Insufficient memory to do forward-backward prop for even one sample");
+
+			// Chunks are split between worker processes, so they process worker_process_count times more entries at once
+			max_entry_count *= worker_process_count;
+			if ((communicator) && (max_chunk_size > 0))
+				max_chunk_size *= worker_process_count;
+			unsigned int current_cache_aware_entry_count = cache_aware_entry_count * worker_process_count;
+
 			{
 				std::stringstream debug_str;
 				debug_str << "backward prop plain max packet size: " << max_entry_count;
@@ -148,12 +352,15 @@ namespace nnforge
 					max_entry_count = max_chunk_size;
 					debug_str << " (clamped to " << max_chunk_size << ")";
 				}
-				debug->output_message(debug_str.str().c_str());
+				if ((current_cache_aware_entry_count > 0) && (max_entry_count > current_cache_aware_entry_count))
+				{
+					max_entry_count = current_cache_aware_entry_count;
+					debug_str << " (clamped to cache-aware " << current_cache_aware_entry_count << ")";
+				}
+				if (debug->is_debug())
+					debug->output_message(debug_str.str().c_str());
 			}
 
-			if (max_entry_count == 0)
-				throw neural_network_exception("Insufficient memory to do forward-backward prop for even one sample");
-
 			std::vector<unsigned int> entry_read_count_list;
 			if (batch_size <= max_entry_count)
 				entry_read_count_list.push_back(batch_size);
@@ -179,19 +386,67 @@ namespace nnforge
 					debug->output_message(debug_str.str().c_str());
 				}
 			}
-			unsigned int current_max_chunk_size = *std::max_element(entry_read_count_list.begin(), entry_read_count_list.end());
+			chunk_size = *std::max_element(entry_read_count_list.begin(), entry_read_count_list.end());
+			unsigned int current_max_chunk_size = (chunk_size + worker_process_count - 1) / worker_process_count;
+
+			// Asynchronous SGD workers split memory, each of them accumulates the gradient over async_chunk_count_per_batch chunks before applying it,
+			// so that the batch is the same as in synchronous mode, it is rounded up to a multiple of the chunk size
+			unsigned int async_max_chunk_size = std::max(max_entry_count / async_worker_count, 1U);
+			unsigned int async_chunk_count_per_batch = (batch_size + async_max_chunk_size - 1) / async_max_chunk_size;
+			unsigned int async_chunk_size = (batch_size + async_chunk_count_per_batch - 1) / async_chunk_count_per_batch;
+			if (async_worker_count > 1)
+			{
+				chunk_size = async_chunk_size;
+				if (debug->is_debug())
+				{
+					std::stringstream debug_str;
+					debug_str << "Asynchronous SGD: " << async_worker_count << " workers, " << async_chunk_count_per_batch << " chunks of " << async_chunk_size << " entries per update";
+					debug->output_message(debug_str.str().c_str());
+				}
+			}
 
-			std::map<std::string, plain_buffer::ptr> dedicated_buffers;
-			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
-				dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * current_max_chunk_size))));
+			// Buffers and the state of the chunk being processed, each asynchronous SGD worker has its own one
+			struct chunk_state
+			{
+				std::map<std::string, plain_buffer::ptr> dedicated_buffers;
+				// Each of the concurrently running actions needs its own fixed working buffer
+				std::vector<plain_buffer::ptr> temporary_working_fixed_buffers;
+				std::vector<plain_buffer::ptr> layer_buffers;
+				std::vector<plain_buffer::ptr> scratch_buffers;
+				layer_data_list::ptr gradient;
+				layer_data_list::ptr momentum_list;
+				layer_data_list::ptr momentum2_list;
+				std::map<std::string, std::vector<double> > * updates_accumulated;
+				int entry_read_count;
+				bool is_apply_gradient;
+				float gradient_normalizer;
+				unsigned int iteration_id;
+			};
 
-			plain_buffer::ptr temporary_working_fixed_buffer;
-			if (temporary_working_fixed_size > 0)
-				temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
+			auto allocate_buffers = [&] (chunk_state& state, unsigned int entry_count, unsigned int fixed_buffer_count, plain_running_configuration::const_ptr state_plain_config)
+			{
+				for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
+					state.dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * entry_count))));
 
-			std::vector<plain_buffer::ptr> layer_buffers;
-			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-				layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * current_max_chunk_size)));
+				state.temporary_working_fixed_buffers.resize(fixed_buffer_count);
+				if (temporary_working_fixed_size > 0)
+					for(std::vector<plain_buffer::ptr>::iterator it = state.temporary_working_fixed_buffers.begin(); it != state.temporary_working_fixed_buffers.end(); ++it)
+						*it = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
+
+				for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
+					state.layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * entry_count)));
+
+				for(std::vector<size_t>::const_iterator it = scratch_buffer_set_per_entry_size_list.begin(); it != scratch_buffer_set_per_entry_size_list.end(); ++it)
+					state.scratch_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * entry_count)));
+
+				// Per-entry buffers are processed in ranges of entries, each range is placed on the NUMA node of the thread it is dealt to
+				for(std::map<std::string, plain_buffer::ptr>::const_iterator it = state.dedicated_buffers.begin(); it != state.dedicated_buffers.end(); ++it)
+					state_plain_config->first_touch(*it->second, entry_count);
+				for(std::vector<plain_buffer::ptr>::const_iterator it = state.layer_buffers.begin(); it != state.layer_buffers.end(); ++it)
+					state_plain_config->first_touch(**it, entry_count);
+				for(std::vector<plain_buffer::ptr>::const_iterator it = state.scratch_buffers.begin(); it != state.scratch_buffers.end(); ++it)
+					state_plain_config->first_touch(**it, entry_count);
+			};
 
 			unsigned int base_iteration_count = 0;
 			if (momentum.type == training_momentum::adam_momentum)
@@ -206,336 +461,1114 @@ namespace nnforge
 			unsigned int entry_processed_count = 0;
 			unsigned int chunk_index = 0;
 			unsigned int gradient_accumulated_entry_count = 0;
+			unsigned int gradient_accumulated_backward_entry_count = 0;
+			unsigned int backward_entry_processed_count = 0;
 			unsigned int gradient_applied_count = 0;
 			double total_idel_sec = 0.0;
 
-			while(true)
+			// All the keys are inserted upfront, so that concurrently running actions update different elements only
+			std::map<layer_name_with_action, double> action_seconds_accumulated;
+			if (profile->is_profile())
+			{
+				if (async_worker_count > 1)
+					profile->output_message("Action timings are not collected with asynchronous SGD");
+				else
+					for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+						action_seconds_accumulated.insert(std::make_pair(*it, 0.0));
+			}
+
+			plain_perf_counter_collector::ptr perf_counters;
+			std::map<layer_name_with_action, profile_util::hardware_counters> action_counters;
+			if (profile->is_profile() && plain_config->perf_counters)
 			{
-				const int current_max_entry_count_const = entry_read_count_list[chunk_index];
-				int entry_read_count = 0;
-				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
-				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count) reduction(+:entry_read_count)
+				if (action_stream_runner || (async_worker_count > 1))
+					profile->output_message("Hardware counters are not collected when running actions concurrently");
+				else
 				{
-					#pragma omp for schedule(dynamic)
-					for(int entry_id = 0; entry_id < current_max_entry_count_const; ++entry_id)
+					perf_counters = plain_perf_counter_collector::ptr(new plain_perf_counter_collector(plain_config->get_os_thread_id_list()));
+					if (perf_counters->is_available())
+					{
+						for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+							action_counters.insert(std::make_pair(*it, profile_util::hardware_counters()));
+					}
+					else
 					{
-						std::map<std::string, float *> data_map;
-						for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
-							data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float))));
-						if (reader.read(entry_processed_count + entry_id, data_map))
-							++entry_read_count;
+						profile->output_message("Hardware counters are not available");
+						perf_counters.reset();
 					}
 				}
-				std::chrono::duration<double> idle_sec = std::chrono::high_resolution_clock::now() - start;
-				total_idel_sec += idle_sec.count();
+			}
 
-				if (entry_read_count == 0)
-					break;
+			auto run_action = [&] (const layer_name_with_action& current_layer_name_with_action, bool initial_forward_pass, plain_running_configuration::const_ptr action_plain_config, unsigned int worker_id, chunk_state& state)
+			{
+				// The shard of the last chunk might be empty for some of the worker processes, they still take part in reducing gradients
+				if ((state.entry_read_count == 0) && (current_layer_name_with_action.get_action().get_action_type() != layer_action::update_weights))
+					return;
+
+				std::chrono::high_resolution_clock::time_point action_start;
+				if (!action_seconds_accumulated.empty())
+					action_start = std::chrono::high_resolution_clock::now();
+				profile_util::hardware_counters counters_start;
+				if (perf_counters)
+					counters_start = perf_counters->read();
+
+				std::string layer_name = current_layer_name_with_action.get_name();
+				layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+				layer::const_ptr l = schema->get_layer(layer_name);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+				layer_action action = current_layer_name_with_action.get_action();
+				layer::const_ptr current_layer = schema->find_layer(layer_name);
+				const std::set<layer_action>& actions = layer_name_to_action_set_map[layer_name];
+				unsigned int tiling_factor = cumulative_tiling_factor_map[layer_name];
+				bool use_scratch_buffers = initial_forward_pass && (recomputed_layer_names.find(layer_name) != recomputed_layer_names.end());
 
-				gradient_accumulated_entry_count += entry_read_count;
-				bool is_apply_gradient = false;
-				float gradient_normalizer;
-				if (gradient_accumulated_entry_count >= batch_size)
+				plain_buffer::ptr temporary_working_per_entry_buffer;
 				{
-					is_apply_gradient = true;
-					gradient_normalizer = 1.0F / static_cast<float>(gradient_accumulated_entry_count);
-					gradient_accumulated_entry_count = 0;
-					gradient_applied_count++;
+					const std::map<layer_name_with_action, unsigned int>& working_per_entry_action_to_set_map = use_scratch_buffers ? scratch_working_per_entry_data_action_to_set_map : temporary_working_per_entry_data_action_to_set_map;
+					std::map<layer_name_with_action, unsigned int>::const_iterator it = working_per_entry_action_to_set_map.find(current_layer_name_with_action);
+					if (it != working_per_entry_action_to_set_map.end())
+						temporary_working_per_entry_buffer = (use_scratch_buffers ? state.scratch_buffers : state.layer_buffers)[it->second];
 				}
 
-				for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it  != actions_in_execution_order.end(); ++action_it)
+				switch (action.get_action_type())
 				{
-					const layer_name_with_action& current_layer_name_with_action = *action_it;
-					std::string layer_name = current_layer_name_with_action.get_name();;
-					layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-					layer::const_ptr l = schema->get_layer(layer_name);
-					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
-						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
-					layer_action action = current_layer_name_with_action.get_action();
-					layer::const_ptr current_layer = schema->find_layer(layer_name);
-					const std::set<layer_action>& actions = layer_name_to_action_set_map[layer_name];
-					unsigned int tiling_factor = cumulative_tiling_factor_map[layer_name];
-
-					plain_buffer::ptr temporary_working_per_entry_buffer;
+				case layer_action::forward:
 					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_working_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
-						if (it != temporary_working_per_entry_data_action_to_set_map.end())
-							temporary_working_per_entry_buffer = layer_buffers[it->second];
-					}
+						plain_buffer::ptr output_buffer;
+						if (use_scratch_buffers)
+						{
+							output_buffer = state.scratch_buffers[scratch_buffer_action_to_set_map[current_layer_name_with_action]];
+						}
+						else
+						{
+							std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
+							if (it != layer_buffer_action_to_set_map.end())
+								output_buffer = state.layer_buffers[it->second];
+							else
+								output_buffer = state.dedicated_buffers.find(layer_name)->second;
+						}
 
-					switch (action.get_action_type())
-					{
-					case layer_action::forward:
+						std::vector<plain_buffer::const_ptr> input_buffers;
+						for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
 						{
-							plain_buffer::ptr output_buffer;
+							if (initial_forward_pass && (recomputed_layer_names.find(*input_layer_name_it) != recomputed_layer_names.end()))
 							{
-								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
+								input_buffers.push_back(state.scratch_buffers[scratch_buffer_action_to_set_map[layer_name_with_action(*input_layer_name_it, layer_action::forward)]]);
+							}
+							else
+							{
+								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
 								if (it != layer_buffer_action_to_set_map.end())
-									output_buffer = layer_buffers[it->second];
+									input_buffers.push_back(state.layer_buffers[it->second]);
 								else
-									output_buffer = dedicated_buffers.find(layer_name)->second;
+									input_buffers.push_back(state.dedicated_buffers.find(*input_layer_name_it)->second);
 							}
+						}
+
+						plain_buffer::ptr temporary_per_entry_buffer;
+						{
+							const std::map<layer_name_with_action, unsigned int>& temporary_per_entry_action_to_set_map = use_scratch_buffers ? scratch_temporary_per_entry_data_action_to_set_map : temporary_per_entry_data_action_to_set_map;
+							std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_action_to_set_map.find(current_layer_name_with_action);
+							if (it != temporary_per_entry_action_to_set_map.end())
+								temporary_per_entry_buffer = (use_scratch_buffers ? state.scratch_buffers : state.layer_buffers)[it->second];
+						}
 
-							std::vector<plain_buffer::const_ptr> input_buffers;
-							for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
+						updaters.find(layer_name)->second->run_forward_propagation(
+							output_buffer,
+							input_buffers,
+							state.temporary_working_fixed_buffers[worker_id],
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							action_plain_config,
+							current_layer,
+							data.data_list.find(layer_name),
+							data.data_custom_list.find(layer_name),
+							input_layer_configuration_specific_list,
+							output_layer_configuration_specific,
+							actions,
+							state.entry_read_count * tiling_factor);
+					}
+					break;
+				case layer_action::backward_data:
+					{
+						plain_buffer::ptr output_buffer = state.layer_buffers[layer_buffer_action_to_set_map[current_layer_name_with_action]];
+
+						std::vector<plain_buffer::const_ptr> input_neurons_buffers;
+						unsigned int data_input_index = 0;
+						for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it, ++data_input_index)
+						{
+							if (updaters[layer_name]->is_backward_data_dependent_on_input_buffer(action.get_backprop_index(), data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 							{
 								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
 								if (it != layer_buffer_action_to_set_map.end())
-									input_buffers.push_back(layer_buffers[it->second]);
+									input_neurons_buffers.push_back(state.layer_buffers[it->second]);
 								else
-									input_buffers.push_back(dedicated_buffers.find(*input_layer_name_it)->second);
+									input_neurons_buffers.push_back(state.dedicated_buffers[*input_layer_name_it]);
 							}
+							else
+								input_neurons_buffers.push_back(plain_buffer::const_ptr());
+						}
 
-							plain_buffer::ptr temporary_per_entry_buffer;
+						plain_buffer::ptr temporary_per_entry_buffer;
+						{
+							if (updaters[layer_name]->is_backward_data_dependent_on_temporary_per_entry_buffer(action.get_backprop_index(), actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 							{
-								std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
+								std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
 								if (it != temporary_per_entry_data_action_to_set_map.end())
-									temporary_per_entry_buffer = layer_buffers[it->second];
+									temporary_per_entry_buffer = state.layer_buffers[it->second];
 							}
+						}
 
-							updaters.find(layer_name)->second->run_forward_propagation(
-								output_buffer,
-								input_buffers,
-								temporary_working_fixed_buffer,
-								temporary_working_per_entry_buffer,
-								temporary_per_entry_buffer,
-								plain_config,
-								current_layer,
-								data.data_list.find(layer_name),
-								data.data_custom_list.find(layer_name),
-								input_layer_configuration_specific_list,
-								output_layer_configuration_specific,
-								actions,
-								entry_read_count * tiling_factor);
+						plain_buffer::const_ptr output_neurons_buffer;
+						{
+							if (updaters[layer_name]->is_backward_data_dependent_on_output_buffer(action.get_backprop_index(), actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+							{
+								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
+								if (it != layer_buffer_action_to_set_map.end())
+									output_neurons_buffer = state.layer_buffers[it->second];
+								else
+									output_neurons_buffer = state.dedicated_buffers[layer_name];
+							}
 						}
-						break;
-					case layer_action::backward_data:
+
+						plain_buffer::const_ptr output_errors_buffer;
 						{
-							plain_buffer::ptr output_buffer = layer_buffers[layer_buffer_action_to_set_map[current_layer_name_with_action]];
+							std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it = gradient_to_producing_actions_map.find(layer_name);
+							if (it != gradient_to_producing_actions_map.end())
+								output_errors_buffer = state.layer_buffers[layer_buffer_action_to_set_map[it->second.front()]];
+						}
 
-							std::vector<plain_buffer::const_ptr> input_neurons_buffers;
-							unsigned int data_input_index = 0;
-							for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it, ++data_input_index)
+						updaters.find(layer_name)->second->run_backward_data_propagation(
+							action.get_backprop_index(),
+							output_buffer,
+							output_errors_buffer,
+							input_neurons_buffers,
+							output_neurons_buffer,
+							state.temporary_working_fixed_buffers[worker_id],
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							action_plain_config,
+							current_layer,
+							data.data_list.find(layer_name),
+							data.data_custom_list.find(layer_name),
+							input_layer_configuration_specific_list,
+							output_layer_configuration_specific,
+							add_output_actions.find(current_layer_name_with_action) != add_output_actions.end(),
+							actions,
+							state.entry_read_count * tiling_factor);
+					}
+					break;
+				case layer_action::backward_weights:
+					{
+						std::vector<plain_buffer::const_ptr> input_neurons_buffers;
+						unsigned int data_input_index = 0;
+						for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it, ++data_input_index)
+						{
+							if (updaters[layer_name]->is_backward_weights_dependent_on_input_buffer(data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 							{
-								if (updaters[layer_name]->is_backward_data_dependent_on_input_buffer(action.get_backprop_index(), data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
-									if (it != layer_buffer_action_to_set_map.end())
-										input_neurons_buffers.push_back(layer_buffers[it->second]);
-									else
-										input_neurons_buffers.push_back(dedicated_buffers[*input_layer_name_it]);
-								}
+								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
+								if (it != layer_buffer_action_to_set_map.end())
+									input_neurons_buffers.push_back(state.layer_buffers[it->second]);
 								else
-									input_neurons_buffers.push_back(plain_buffer::const_ptr());
+									input_neurons_buffers.push_back(state.dedicated_buffers[*input_layer_name_it]);
 							}
+							else
+								input_neurons_buffers.push_back(plain_buffer::const_ptr());
+						}
 
-							plain_buffer::ptr temporary_per_entry_buffer;
+						plain_buffer::ptr temporary_per_entry_buffer;
+						{
+							if (updaters[layer_name]->is_backward_weights_dependent_on_temporary_per_entry_buffer(actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 							{
-								if (updaters[layer_name]->is_backward_data_dependent_on_temporary_per_entry_buffer(action.get_backprop_index(), actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
-									if (it != temporary_per_entry_data_action_to_set_map.end())
-										temporary_per_entry_buffer = layer_buffers[it->second];
-								}
+								std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
+								if (it != temporary_per_entry_data_action_to_set_map.end())
+									temporary_per_entry_buffer = state.layer_buffers[it->second];
 							}
+						}
+
+						plain_buffer::const_ptr output_errors_buffer;
+						{
+							std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it = gradient_to_producing_actions_map.find(layer_name);
+							if (it != gradient_to_producing_actions_map.end())
+								output_errors_buffer = state.layer_buffers[layer_buffer_action_to_set_map[it->second.front()]];
+						}
+
+						updaters.find(layer_name)->second->run_backward_weights_propagation(
+							input_neurons_buffers,
+							output_errors_buffer,
+							state.temporary_working_fixed_buffers[worker_id],
+							temporary_working_per_entry_buffer,
+							temporary_per_entry_buffer,
+							action_plain_config,
+							current_layer,
+							state.gradient->find(layer_name),
+							data.data_custom_list.find(layer_name),
+							input_layer_configuration_specific_list,
+							output_layer_configuration_specific,
+							actions,
+							state.entry_read_count * tiling_factor);
+					}
+					break;
+				case layer_action::update_weights:
+					{
+						// Worker processes apply gradients after reducing them, once all the actions are done
+						if (state.is_apply_gradient && reduce_queue)
+						{
+							layer_data::ptr layer_gradient = state.gradient->find(layer_name);
+							for(layer_data::iterator it = layer_gradient->begin(); it != layer_gradient->end(); ++it)
+								if (!it->empty())
+									reduce_queue->enqueue(&(*it->begin()), it->size());
+							enqueued_gradient_layer_names.insert(layer_name);
+						}
+						else if (state.is_apply_gradient && !communicator)
+						{
+							layer_data::ptr previous_upd;
+							if (momentum.is_momentum_data())
+								previous_upd = state.momentum_list->find(layer_name);
+							layer_data::ptr previous_upd2;
+							if (momentum.is_momentum_data2())
+								previous_upd2 = state.momentum2_list->find(layer_name);
+							apply_gradient(
+								layer_name,
+								data.data_list.find(layer_name),
+								state.gradient->find(layer_name),
+								previous_upd,
+								previous_upd2,
+								(*state.updates_accumulated)[layer_name],
+								learning_rates.find(layer_name)->second,
+								state.gradient_normalizer,
+								weight_decay,
+								momentum,
+								state.iteration_id);
+						}
+					}
+					break;
+				}
+
+				// Time of recomputing activations is attributed to the forward action of the layer
+				if (!action_seconds_accumulated.empty())
+				{
+					std::chrono::high_resolution_clock::time_point action_end = std::chrono::high_resolution_clock::now();
+					std::chrono::duration<double> action_sec = action_end - action_start;
+					action_seconds_accumulated.find(current_layer_name_with_action)->second += action_sec.count();
+					profile->add_trace_event(current_layer_name_with_action.get_action().str().c_str(), layer_name, action_start, action_end);
+				}
+				if (perf_counters)
+				{
+					profile_util::hardware_counters action_counters_delta = perf_counters->read();
+					action_counters_delta -= counters_start;
+					action_counters.find(current_layer_name_with_action)->second += action_counters_delta;
+				}
+			};
+
+			if (async_worker_count > 1)
+			{
+				// Hogwild: workers process their own chunks and apply gradients to the shared weights without any locking,
+				// each of them keeps its own momentums, these are averaged at the end of the epoch
+				// Each worker runs its kernels on its own pool threads of the task runtime
+				std::vector<plain_running_configuration::const_ptr> worker_plain_config_list = plain_config->get_thread_partition_config_list(async_worker_count);
+
+				std::vector<chunk_state> worker_states(async_worker_count);
+				std::vector<std::map<std::string, std::vector<double> > > worker_updates_accumulated(async_worker_count, updates_accumulated);
+				for(unsigned int worker_id = 0; worker_id < async_worker_count; ++worker_id)
+				{
+					chunk_state& state = worker_states[worker_id];
+					allocate_buffers(state, async_chunk_size, 1, worker_plain_config_list[worker_id]);
+					state.gradient = layer_data_list::ptr(new layer_data_list(layer_list, 0.0F));
+					if (momentum_data)
+					{
+						state.momentum_list = layer_data_list::ptr(new layer_data_list(layer_list, 0.0F));
+						for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
+							*state.momentum_list->get(*it) = *momentum_data->data_list.get(*it);
+					}
+					if (momentum_data2)
+					{
+						state.momentum2_list = layer_data_list::ptr(new layer_data_list(layer_list, 0.0F));
+						for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
+							*state.momentum2_list->get(*it) = *momentum_data2->data_list.get(*it);
+					}
+					state.updates_accumulated = &worker_updates_accumulated[worker_id];
+				}
 
-							plain_buffer::const_ptr output_neurons_buffer;
+				std::atomic<unsigned int> next_chunk_id(0);
+				std::atomic<unsigned int> async_entry_processed_count(0);
+				std::atomic<unsigned int> async_gradient_applied_count(0);
+				std::atomic<bool> last_chunk_read(false);
+				// Writers expect entries in order, so chunks are written in the order they are read
+				std::mutex writer_mutex;
+				std::condition_variable write_turn_condition;
+				unsigned int next_write_chunk_id = 0;
+				bool write_aborted = false;
+				std::vector<std::exception_ptr> worker_errors(async_worker_count);
+				std::vector<double> worker_idle_seconds(async_worker_count, 0.0);
+				std::vector<std::thread> workers;
+				for(unsigned int worker_id = 0; worker_id < async_worker_count; ++worker_id)
+				{
+					workers.push_back(std::thread([&, worker_id] ()
+					{
+						try
+						{
+							chunk_state& state = worker_states[worker_id];
+							plain_running_configuration::const_ptr worker_plain_config = worker_plain_config_list[worker_id];
+							unsigned int worker_gradient_accumulated_entry_count = 0;
+							unsigned int worker_gradient_accumulated_chunk_count = 0;
+							while (!last_chunk_read)
 							{
-								if (updaters[layer_name]->is_backward_data_dependent_on_output_buffer(action.get_backprop_index(), actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								unsigned int chunk_id = next_chunk_id++;
+								unsigned int chunk_entry_offset = chunk_id * async_chunk_size;
+								std::atomic<int> entry_read_count_accumulated(0);
+								std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+								worker_plain_config->parallel_for(async_chunk_size, [&] (int begin, int end)
+								{
+									int local_entry_read_count = 0;
+									for(int entry_id = begin; entry_id < end; ++entry_id)
+									{
+										std::map<std::string, float *> data_map;
+										for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+											data_map.insert(std::make_pair(*it, ((float *)(*state.dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float))));
+										if (reader.read(chunk_entry_offset + entry_id, data_map))
+											++local_entry_read_count;
+									}
+									entry_read_count_accumulated += local_entry_read_count;
+								});
+								int entry_read_count = entry_read_count_accumulated;
+								std::chrono::high_resolution_clock::time_point read_end = std::chrono::high_resolution_clock::now();
+								std::chrono::duration<double> idle_sec = read_end - start;
+								worker_idle_seconds[worker_id] += idle_sec.count();
+								profile->add_trace_event("reader", "read", start, read_end);
+
+								if (entry_read_count < static_cast<int>(async_chunk_size))
+									last_chunk_read = true;
+								if (entry_read_count == 0)
+									break;
+
+								state.entry_read_count = entry_read_count;
+								worker_gradient_accumulated_entry_count += entry_read_count;
+								++worker_gradient_accumulated_chunk_count;
+								state.is_apply_gradient = (worker_gradient_accumulated_chunk_count == async_chunk_count_per_batch);
+								if (state.is_apply_gradient)
+								{
+									state.gradient_normalizer = 1.0F / static_cast<float>(worker_gradient_accumulated_entry_count);
+									state.iteration_id = base_iteration_count + (++async_gradient_applied_count);
+									worker_gradient_accumulated_entry_count = 0;
+									worker_gradient_accumulated_chunk_count = 0;
+								}
+								for(std::vector<std::pair<layer_name_with_action, bool> >::const_iterator action_it = action_run_list.begin(); action_it != action_run_list.end(); ++action_it)
+									run_action(action_it->first, action_it->second, worker_plain_config, 0, state);
+
 								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
-									if (it != layer_buffer_action_to_set_map.end())
-										output_neurons_buffer = layer_buffers[it->second];
-									else
-										output_neurons_buffer = dedicated_buffers[layer_name];
+									std::unique_lock<std::mutex> lock(writer_mutex);
+									write_turn_condition.wait(lock, [&] () { return (next_write_chunk_id == chunk_id) || write_aborted; });
+									if (write_aborted)
+										break;
+									std::chrono::high_resolution_clock::time_point write_start = std::chrono::high_resolution_clock::now();
+									for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
+									{
+										std::map<std::string, const float *> data_map;
+										for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
+											data_map.insert(std::make_pair(*it, ((float *)(*state.dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float) / output_layers_tiling_factor)));
+										writer.write(chunk_entry_offset * output_layers_tiling_factor + entry_id, data_map);
+									}
+									profile->add_trace_event("writer", "write", write_start, std::chrono::high_resolution_clock::now());
+									++next_write_chunk_id;
+									write_turn_condition.notify_all();
 								}
+
+								async_entry_processed_count += entry_read_count;
 							}
 
-							plain_buffer::const_ptr output_errors_buffer;
+							// The gradient of the last incomplete batch of the worker
+							if (worker_gradient_accumulated_entry_count > 0)
 							{
-								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it = gradient_to_producing_actions_map.find(layer_name);
-								if (it != gradient_to_producing_actions_map.end())
-									output_errors_buffer = layer_buffers[layer_buffer_action_to_set_map[it->second.front()]];
+								state.is_apply_gradient = true;
+								state.gradient_normalizer = 1.0F / static_cast<float>(worker_gradient_accumulated_entry_count);
+								state.iteration_id = base_iteration_count + (++async_gradient_applied_count);
+								for(std::vector<std::pair<layer_name_with_action, bool> >::const_iterator action_it = action_run_list.begin(); action_it != action_run_list.end(); ++action_it)
+									if (action_it->first.get_action().get_action_type() == layer_action::update_weights)
+										run_action(action_it->first, action_it->second, worker_plain_config, 0, state);
 							}
-
-							updaters.find(layer_name)->second->run_backward_data_propagation(
-								action.get_backprop_index(),
-								output_buffer,
-								output_errors_buffer,
-								input_neurons_buffers,
-								output_neurons_buffer,
-								temporary_working_fixed_buffer,
-								temporary_working_per_entry_buffer,
-								temporary_per_entry_buffer,
-								plain_config,
-								current_layer,
-								data.data_list.find(layer_name),
-								data.data_custom_list.find(layer_name),
-								input_layer_configuration_specific_list,
-								output_layer_configuration_specific,
-								add_output_actions.find(current_layer_name_with_action) != add_output_actions.end(),
-								actions,
-								entry_read_count * tiling_factor);
 						}
-						break;
-					case layer_action::backward_weights:
+						catch (...)
 						{
-							std::vector<plain_buffer::const_ptr> input_neurons_buffers;
-							unsigned int data_input_index = 0;
-							for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it, ++data_input_index)
+							worker_errors[worker_id] = std::current_exception();
+							last_chunk_read = true;
+							std::lock_guard<std::mutex> lock(writer_mutex);
+							write_aborted = true;
+							write_turn_condition.notify_all();
+						}
+					}));
+				}
+				for(std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+					it->join();
+				for(std::vector<std::exception_ptr>::const_iterator it = worker_errors.begin(); it != worker_errors.end(); ++it)
+					if (*it)
+						std::rethrow_exception(*it);
+
+				entry_processed_count = async_entry_processed_count;
+				gradient_applied_count = async_gradient_applied_count;
+				for(std::vector<double>::const_iterator it = worker_idle_seconds.begin(); it != worker_idle_seconds.end(); ++it)
+					total_idel_sec += *it / static_cast<double>(async_worker_count);
+
+				for(std::map<std::string, std::vector<double> >::iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
+					for(std::vector<std::map<std::string, std::vector<double> > >::const_iterator it2 = worker_updates_accumulated.begin(); it2 != worker_updates_accumulated.end(); ++it2)
+					{
+						const std::vector<double>& src = it2->find(it->first)->second;
+						for(size_t i = 0; i < src.size(); ++i)
+							it->second[i] += src[i];
+					}
+
+				float momentum_mult = 1.0F / static_cast<float>(async_worker_count);
+				for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
+				{
+					for(int momentum_id = 0; momentum_id < 2; ++momentum_id)
+					{
+						network_data::ptr dst_momentum_data = (momentum_id == 0) ? momentum_data : momentum_data2;
+						if (!dst_momentum_data)
+							continue;
+						layer_data::ptr dst = dst_momentum_data->data_list.get(*it);
+						for(unsigned int part_id = 0; part_id < dst->size(); ++part_id)
+						{
+							std::vector<float>& dst_part = dst->at(part_id);
+							std::fill(dst_part.begin(), dst_part.end(), 0.0F);
+							for(std::vector<chunk_state>::const_iterator it2 = worker_states.begin(); it2 != worker_states.end(); ++it2)
 							{
-								if (updaters[layer_name]->is_backward_weights_dependent_on_input_buffer(data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
-									if (it != layer_buffer_action_to_set_map.end())
-										input_neurons_buffers.push_back(layer_buffers[it->second]);
-									else
-										input_neurons_buffers.push_back(dedicated_buffers[*input_layer_name_it]);
-								}
-								else
-									input_neurons_buffers.push_back(plain_buffer::const_ptr());
+								const std::vector<float>& src_part = ((momentum_id == 0) ? it2->momentum_list : it2->momentum2_list)->get(*it)->at(part_id);
+								for(size_t i = 0; i < dst_part.size(); ++i)
+									dst_part[i] += src_part[i] * momentum_mult;
 							}
+						}
+					}
+				}
+			}
+			else
+			{
+				chunk_state sync_state;
+				allocate_buffers(sync_state, current_max_chunk_size, action_stream_runner ? action_stream_runner->get_worker_count() : 1, plain_config);
+				sync_state.gradient = gradient;
+				if (momentum_data)
+					sync_state.momentum_list = layer_data_list::ptr(momentum_data, &momentum_data->data_list);
+				if (momentum_data2)
+					sync_state.momentum2_list = layer_data_list::ptr(momentum_data2, &momentum_data2->data_list);
+				sync_state.updates_accumulated = &updates_accumulated;
+
+				while(true)
+				{
+					const int current_global_entry_count_const = entry_read_count_list[chunk_index];
+					const int shard_start_entry_id = static_cast<int>(static_cast<long long>(current_global_entry_count_const) * worker_process_rank / worker_process_count);
+					const int current_max_entry_count_const = static_cast<int>(static_cast<long long>(current_global_entry_count_const) * (worker_process_rank + 1) / worker_process_count) - shard_start_entry_id;
+					std::atomic<int> entry_read_count_accumulated(0);
+					std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+					plain_config->parallel_for(current_max_entry_count_const, [&] (int begin, int end)
+					{
+						int local_entry_read_count = 0;
+						for(int entry_id = begin; entry_id < end; ++entry_id)
+						{
+							std::map<std::string, float *> data_map;
+							for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+								data_map.insert(std::make_pair(*it, ((float *)(*sync_state.dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float))));
+							if (reader.read(entry_processed_count + shard_start_entry_id + entry_id, data_map))
+								++local_entry_read_count;
+						}
+						entry_read_count_accumulated += local_entry_read_count;
+					});
+					int entry_read_count = entry_read_count_accumulated;
+					int global_entry_read_count = entry_read_count;
+					if (communicator)
+					{
+						float global_entry_read_count_float = static_cast<float>(entry_read_count);
+						communicator->reduce_all(&global_entry_read_count_float, 1);
+						global_entry_read_count = static_cast<int>(global_entry_read_count_float + 0.5F);
+					}
+					std::chrono::high_resolution_clock::time_point read_end = std::chrono::high_resolution_clock::now();
+					std::chrono::duration<double> idle_sec = read_end - start;
+					total_idel_sec += idle_sec.count();
+					profile->add_trace_event("reader", "read", start, read_end);
+
+					if (global_entry_read_count == 0)
+						break;
+
+					auto write_outputs = [&] ()
+					{
+						std::chrono::high_resolution_clock::time_point write_start = std::chrono::high_resolution_clock::now();
+						for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
+						{
+							std::map<std::string, const float *> data_map;
+							for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
+								data_map.insert(std::make_pair(*it, ((float *)(*sync_state.dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float) / output_layers_tiling_factor)));
+							writer.write(entry_processed_count + shard_start_entry_id * static_cast<int>(output_layers_tiling_factor) + entry_id, data_map);
+						}
+						profile->add_trace_event("writer", "write", write_start, std::chrono::high_resolution_clock::now());
+					};
 
-							plain_buffer::ptr temporary_per_entry_buffer;
+					sync_state.entry_read_count = entry_read_count;
+					int global_backward_entry_count = global_entry_read_count;
+					if (selective_backprop)
+					{
+						// Forward pass for all the entries ranks them by the error, activations of the hardest ones are moved to the beginning of the buffers,
+						// then backward pass is run for them only
+						for(std::vector<std::pair<layer_name_with_action, bool> >::const_iterator action_it = action_run_list.begin(); action_it != action_run_list.end(); ++action_it)
+							if ((action_it->first.get_action().get_action_type() == layer_action::forward) && (recomputed_layer_names.empty() || action_it->second))
+								run_action(action_it->first, action_it->second, plain_config, 0, sync_state);
+						write_outputs();
+
+						global_backward_entry_count = std::min(std::max(static_cast<int>(plain_config->selective_backprop_rate * static_cast<float>(entry_read_count) + 0.5F), 1), entry_read_count);
+						if (global_backward_entry_count < entry_read_count)
+						{
+							std::vector<std::pair<float, int> > entry_errors(entry_read_count);
+							for(int entry_id = 0; entry_id < entry_read_count; ++entry_id)
 							{
-								if (updaters[layer_name]->is_backward_weights_dependent_on_temporary_per_entry_buffer(actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								float error = 0.0F;
+								for(std::vector<std::string>::const_iterator it = error_source_layer_names.begin(); it != error_source_layer_names.end(); ++it)
 								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
-									if (it != temporary_per_entry_data_action_to_set_map.end())
-										temporary_per_entry_buffer = layer_buffers[it->second];
+									size_t per_entry_elem_count = dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float);
+									const float * src = ((const float *)(*sync_state.dedicated_buffers[*it])) + entry_id * per_entry_elem_count;
+									error = std::accumulate(src, src + per_entry_elem_count, error);
 								}
+								entry_errors[entry_id] = std::make_pair(error, entry_id);
 							}
-
-							plain_buffer::const_ptr output_errors_buffer;
+							std::nth_element(entry_errors.begin(), entry_errors.begin() + global_backward_entry_count, entry_errors.end(), [] (const std::pair<float, int>& x, const std::pair<float, int>& y) { return (x.first > y.first) || ((x.first == y.first) && (x.second < y.second)); } );
+							std::vector<int> selected_entry_ids;
+							for(int i = 0; i < global_backward_entry_count; ++i)
+								selected_entry_ids.push_back(entry_errors[i].second);
+							std::sort(selected_entry_ids.begin(), selected_entry_ids.end());
+							auto compact_entries = [&] (plain_buffer::ptr buffer, size_t per_entry_size)
 							{
-								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it = gradient_to_producing_actions_map.find(layer_name);
-								if (it != gradient_to_producing_actions_map.end())
-									output_errors_buffer = layer_buffers[layer_buffer_action_to_set_map[it->second.front()]];
-							}
+								unsigned char * buf = (unsigned char *)(*buffer);
+								for(int i = 0; i < global_backward_entry_count; ++i)
+									if (selected_entry_ids[i] != i)
+										memcpy(buf + i * per_entry_size, buf + selected_entry_ids[i] * per_entry_size, per_entry_size);
+							};
+							for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
+								compact_entries(sync_state.dedicated_buffers[it->first], it->second);
+							for(std::map<unsigned int, size_t>::const_iterator it = selective_layer_buffer_set_to_per_entry_size_map.begin(); it != selective_layer_buffer_set_to_per_entry_size_map.end(); ++it)
+								compact_entries(sync_state.layer_buffers[it->first], it->second);
+						}
+						sync_state.entry_read_count = global_backward_entry_count;
+					}
+					backward_entry_processed_count += global_backward_entry_count;
 
-							updaters.find(layer_name)->second->run_backward_weights_propagation(
-								input_neurons_buffers,
-								output_errors_buffer,
-								temporary_working_fixed_buffer,
-								temporary_working_per_entry_buffer,
-								temporary_per_entry_buffer,
-								plain_config,
-								current_layer,
+					gradient_accumulated_entry_count += global_entry_read_count;
+					gradient_accumulated_backward_entry_count += global_backward_entry_count;
+					bool is_apply_gradient = false;
+					float gradient_normalizer;
+					if (gradient_accumulated_entry_count >= batch_size)
+					{
+						is_apply_gradient = true;
+						gradient_normalizer = 1.0F / static_cast<float>(gradient_accumulated_backward_entry_count);
+						gradient_accumulated_entry_count = 0;
+						gradient_accumulated_backward_entry_count = 0;
+						gradient_applied_count++;
+					}
+					sync_state.is_apply_gradient = is_apply_gradient;
+					sync_state.gradient_normalizer = gradient_normalizer;
+					sync_state.iteration_id = base_iteration_count + gradient_applied_count;
+
+					// Forward actions already run for selective backprop are skipped, recomputed forward actions are still run
+					if (action_stream_runner)
+						action_stream_runner->run([&] (const layer_name_with_action& action, plain_running_configuration::const_ptr action_plain_config, unsigned int worker_id)
+							{
+								if (!selective_backprop || (action.get_action().get_action_type() != layer_action::forward))
+									run_action(action, false, action_plain_config, worker_id, sync_state);
+							});
+					else
+						for(std::vector<std::pair<layer_name_with_action, bool> >::const_iterator action_it = action_run_list.begin(); action_it != action_run_list.end(); ++action_it)
+							if (!selective_backprop || (action_it->first.get_action().get_action_type() != layer_action::forward) || !(recomputed_layer_names.empty() || action_it->second))
+								run_action(action_it->first, action_it->second, plain_config, 0, sync_state);
+
+					if (is_apply_gradient && communicator)
+					{
+						if (reduce_queue)
+						{
+							profile_trace_scope trace_scope(profile, "reduce_gradient", "wait");
+							reduce_queue->wait();
+						}
+						for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
+						{
+							const std::string& layer_name = it->first;
+							if (enqueued_gradient_layer_names.find(layer_name) == enqueued_gradient_layer_names.end())
+								reduce_gradient(*communicator, layer_name, gradient->find(layer_name));
+							layer_data::ptr previous_upd;
+							if (momentum.is_momentum_data())
+								previous_upd = momentum_data->data_list.find(layer_name);
+							layer_data::ptr previous_upd2;
+							if (momentum.is_momentum_data2())
+								previous_upd2 = momentum_data2->data_list.find(layer_name);
+							apply_gradient(
+								layer_name,
+								data.data_list.find(layer_name),
 								gradient->find(layer_name),
-								data.data_custom_list.find(layer_name),
-								input_layer_configuration_specific_list,
-								output_layer_configuration_specific,
-								actions,
-								entry_read_count * tiling_factor);
+								previous_upd,
+								previous_upd2,
+								updates_accumulated[layer_name],
+								learning_rates.find(layer_name)->second,
+								gradient_normalizer,
+								weight_decay,
+								momentum,
+								base_iteration_count + gradient_applied_count);
 						}
+						enqueued_gradient_layer_names.clear();
+					}
+
+					if (!selective_backprop)
+						write_outputs();
+
+					entry_processed_count += global_entry_read_count;
+					chunk_index = (chunk_index + 1) % entry_read_count_list.size();
+
+					if (global_entry_read_count < current_global_entry_count_const)
 						break;
-					case layer_action::update_weights:
+				}
+
+				if (gradient_accumulated_entry_count > 0)
+				{
+					float gradient_normalizer = 1.0F / static_cast<float>(batch_size);
+					if (selective_backprop)
+						gradient_normalizer *= static_cast<float>(gradient_accumulated_entry_count) / static_cast<float>(gradient_accumulated_backward_entry_count);
+					gradient_applied_count++;
+					for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
+					{
+						const std::string& layer_name = it->first;
+						if (communicator)
+							reduce_gradient(*communicator, layer_name, gradient->find(layer_name));
+						layer_data::ptr previous_upd;
+						if (momentum.is_momentum_data())
+							previous_upd = momentum_data->data_list.find(layer_name);
+						layer_data::ptr previous_upd2;
+						if (momentum.is_momentum_data2())
+							previous_upd2 = momentum_data2->data_list.find(layer_name);
+						apply_gradient(
+							layer_name,
+							data.data_list.find(layer_name),
+							gradient->find(layer_name),
+							previous_upd,
+							previous_upd2,
+							updates_accumulated[layer_name],
+							learning_rates.find(layer_name)->second,
+							gradient_normalizer,
+							weight_decay,
+							momentum,
+							base_iteration_count + gradient_applied_count);
+					}
+				}
+			}
+
+			if (selective_backprop && (entry_processed_count > 0))
+				backward_entry_ratio = static_cast<float>(backward_entry_processed_count) / static_cast<float>(entry_processed_count);
+
+			average_absolute_updates.clear();
+			{
+				float mult = 1.0F / static_cast<float>(gradient_applied_count);
+				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
+				{
+					std::vector<float>& f = average_absolute_updates.insert(std::make_pair(it->first, std::vector<float>())).first->second;
+					layer_data::const_iterator it_data = data.data_list.find(it->first)->begin();
+					for(std::vector<double>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2, ++it_data)
+						f.push_back(static_cast<float>(*it2) * mult / static_cast<float>(it_data->size()));
+				}
+			}
+			entries_processed = entry_processed_count;
+			action_seconds.clear();
+			for(std::map<layer_name_with_action, double>::const_iterator it = action_seconds_accumulated.begin(); it != action_seconds_accumulated.end(); ++it)
+				action_seconds.insert(std::make_pair(it->first, static_cast<float>(it->second)));
+
+			if (perf_counters)
+			{
+				std::map<std::string, std::string> layer_name_to_layer_type_map;
+				std::vector<layer::const_ptr> layer_list = schema->get_layers();
+				for(std::vector<layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+					layer_name_to_layer_type_map.insert(std::make_pair((*it)->instance_name, (*it)->get_type_name()));
+				profile_util::dump_layer_action_hardware_counters(
+					profile,
+					"backward_prop",
+					entry_processed_count,
+					action_flops_per_entry,
+					action_seconds,
+					action_counters,
+					layer_name_to_layer_type_map);
+			}
+			idle_seconds = static_cast<float>(total_idel_sec);
+		}
+
+
+		void backward_propagation_plain::layer_config_map_modified()
+		{
+			setup_dedicated_buffer_sizes();
+
+			setup_recompute_schedule();
+
+			setup_layer_buffer_sizes();
+
+			setup_recompute_scratch_buffer_sizes();
+
+			setup_temporary_working_fixed_buffer_sizes();
+
+			update_buffer_config();
+
+			update_cache_aware_entry_count();
+
+			// Buffers are sized again for the algorithms picked
+			if (setup_autotuned_updaters())
+			{
+				setup_dedicated_buffer_sizes();
+
+				setup_recompute_schedule();
+
+				setup_layer_buffer_sizes();
+
+				setup_recompute_scratch_buffer_sizes();
+
+				setup_temporary_working_fixed_buffer_sizes();
+
+				update_buffer_config();
+
+				update_cache_aware_entry_count();
+			}
+		}
+
+		bool backward_propagation_plain::setup_autotuned_updaters()
+		{
+			if (!plain_config->autotuner)
+				return false;
+
+			// Weights, gradients and the batch size are not known yet, so it is the largest chunk size actual_run might pick
+			unsigned int entry_count = plain_config->get_max_entry_count(buffer_config_without_data_and_momentum) / static_cast<unsigned int>(std::max(plain_config->async_sgd_worker_count, 1));
+			if (cache_aware_entry_count > 0)
+				entry_count = std::min(entry_count, cache_aware_entry_count);
+			entry_count = std::max(std::min(entry_count, plain_autotuner::max_entry_count), 1U);
+
+			bool updaters_replaced = false;
+			for(std::map<std::string, layer_updater_plain::const_ptr>::iterator it = updaters.begin(); it != updaters.end(); ++it)
+			{
+				layer::const_ptr l = schema->get_layer(it->first);
+				layer_updater_plain::const_ptr registered_updater = layer_updater_plain_factory::get_singleton().get_updater_plain_layer(l->get_type_name());
+				std::vector<layer_updater_plain::const_ptr> candidates = registered_updater->get_algorithm_alternatives();
+				if (candidates.empty())
+					continue;
+				candidates.insert(candidates.begin(), registered_updater);
+
+				const std::set<layer_action>& actions = layer_name_to_action_set_map[it->first];
+				layer_configuration_specific output_layer_configuration_specific = layer_config_map[it->first];
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+
+				std::string key = plain_config->autotuner->get_key("backward", plain_config->openmp_thread_count, entry_count, l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+				for(std::set<layer_action>::const_iterator action_it = actions.begin(); action_it != actions.end(); ++action_it)
+					key += "|" + action_it->str();
+				std::string algorithm_name;
+				if (!plain_config->autotuner->find(key, algorithm_name))
+				{
+					// All the buffers are allocated, whatever the dependencies of the actions are
+					std::vector<plain_buffer::const_ptr> input_neurons_buffers;
+					std::vector<plain_buffer::ptr> input_errors_buffers;
+					for(std::vector<layer_configuration_specific>::const_iterator it2 = input_layer_configuration_specific_list.begin(); it2 != input_layer_configuration_specific_list.end(); ++it2)
+					{
+						size_t elem_count = it2->get_neuron_count() * entry_count;
+						plain_buffer::ptr input_neurons_buffer(new plain_buffer(elem_count * sizeof(float)));
+						std::fill_n((float *)*input_neurons_buffer, elem_count, 0.01F);
+						input_neurons_buffers.push_back(input_neurons_buffer);
+						input_errors_buffers.push_back(plain_buffer::ptr(new plain_buffer(elem_count * sizeof(float))));
+					}
+					size_t output_elem_count = output_layer_configuration_specific.get_neuron_count() * entry_count;
+					plain_buffer::ptr output_neurons_buffer(new plain_buffer(output_elem_count * sizeof(float)));
+					plain_buffer::ptr output_errors_buffer(new plain_buffer(output_elem_count * sizeof(float)));
+					std::fill_n((float *)*output_errors_buffer, output_elem_count, 0.01F);
+					layer_data::ptr data = l->create_layer_data();
+					data->fill(0.01F);
+					layer_data::ptr gradient = l->create_layer_data();
+					layer_data_custom::ptr data_custom = l->create_layer_data_custom();
+
+					std::stringstream debug_str;
+					double best_seconds = 0.0;
+					for(std::vector<layer_updater_plain::const_ptr>::const_iterator candidate_it = candidates.begin(); candidate_it != candidates.end(); ++candidate_it)
+					{
+						layer_updater_plain::const_ptr candidate = *candidate_it;
+						size_t temporary_working_fixed_buffer_size = 0;
+						size_t temporary_working_per_entry_buffer_size = 0;
+						for(std::set<layer_action>::const_iterator action_it = actions.begin(); action_it != actions.end(); ++action_it)
 						{
-							if (is_apply_gradient)
+							temporary_working_fixed_buffer_size = std::max(temporary_working_fixed_buffer_size, candidate->get_temporary_working_fixed_buffer_size(*action_it, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific));
+							temporary_working_per_entry_buffer_size = std::max(temporary_working_per_entry_buffer_size, candidate->get_temporary_working_per_entry_buffer_size(*action_it, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific));
+						}
+						size_t temporary_per_entry_buffer_size = candidate->get_temporary_per_entry_buffer_size(actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+						plain_buffer::ptr temporary_working_fixed_buffer;
+						if (temporary_working_fixed_buffer_size > 0)
+							temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_buffer_size));
+						plain_buffer::ptr temporary_working_per_entry_buffer;
+						if (temporary_working_per_entry_buffer_size > 0)
+							temporary_working_per_entry_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_per_entry_buffer_size * entry_count));
+						plain_buffer::ptr temporary_per_entry_buffer;
+						if (temporary_per_entry_buffer_size > 0)
+							temporary_per_entry_buffer = plain_buffer::ptr(new plain_buffer(temporary_per_entry_buffer_size * entry_count));
+
+						double seconds = plain_config->autotuner->measure([&] () {
+							for(std::set<layer_action>::const_iterator action_it = actions.begin(); action_it != actions.end(); ++action_it)
 							{
-								layer_data::ptr previous_upd;
-								if (momentum.is_momentum_data())
-									previous_upd = momentum_data->data_list.find(layer_name);
-								layer_data::ptr previous_upd2;
-								if (momentum.is_momentum_data2())
-									previous_upd2 = momentum_data2->data_list.find(layer_name);
-								apply_gradient(
-									layer_name,
-									data.data_list.find(layer_name),
-									gradient->find(layer_name),
-									previous_upd,
-									previous_upd2,
-									updates_accumulated[layer_name],
-									learning_rates.find(layer_name)->second,
-									gradient_normalizer,
-									weight_decay,
-									momentum,
-									base_iteration_count + gradient_applied_count);
+								switch (action_it->get_action_type())
+								{
+								case layer_action::forward:
+									candidate->run_forward_propagation(
+										output_neurons_buffer,
+										input_neurons_buffers,
+										temporary_working_fixed_buffer,
+										temporary_working_per_entry_buffer,
+										temporary_per_entry_buffer,
+										plain_config,
+										l,
+										data,
+										data_custom,
+										input_layer_configuration_specific_list,
+										output_layer_configuration_specific,
+										actions,
+										entry_count);
+									break;
+								case layer_action::backward_data:
+									candidate->run_backward_data_propagation(
+										action_it->get_backprop_index(),
+										input_errors_buffers[action_it->get_backprop_index()],
+										output_errors_buffer,
+										input_neurons_buffers,
+										output_neurons_buffer,
+										temporary_working_fixed_buffer,
+										temporary_working_per_entry_buffer,
+										temporary_per_entry_buffer,
+										plain_config,
+										l,
+										data,
+										data_custom,
+										input_layer_configuration_specific_list,
+										output_layer_configuration_specific,
+										false,
+										actions,
+										entry_count);
+									break;
+								case layer_action::backward_weights:
+									candidate->run_backward_weights_propagation(
+										input_neurons_buffers,
+										output_errors_buffer,
+										temporary_working_fixed_buffer,
+										temporary_working_per_entry_buffer,
+										temporary_per_entry_buffer,
+										plain_config,
+										l,
+										gradient,
+										data_custom,
+										input_layer_configuration_specific_list,
+										output_layer_configuration_specific,
+										actions,
+										entry_count);
+									break;
+								default:
+									break;
+								}
 							}
+						});
+						debug_str << " " << candidate->get_algorithm_name() << "=" << (seconds * 1000.0) << "ms";
+						if ((candidate_it == candidates.begin()) || (seconds < best_seconds))
+						{
+							best_seconds = seconds;
+							algorithm_name = candidate->get_algorithm_name();
 						}
+					}
+					plain_config->autotuner->store(key, algorithm_name);
+
+					if (debug->is_debug())
+						debug->output_message((boost::format("backward prop plain autotuned %1%:%2%, picked %3%") % it->first % debug_str.str() % algorithm_name).str().c_str());
+				}
+
+				for(std::vector<layer_updater_plain::const_ptr>::const_iterator candidate_it = candidates.begin(); candidate_it != candidates.end(); ++candidate_it)
+				{
+					if ((*candidate_it)->get_algorithm_name() == algorithm_name)
+					{
+						updaters_replaced = updaters_replaced || (it->second != *candidate_it);
+						it->second = *candidate_it;
 						break;
 					}
 				}
+			}
 
-				for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
+			return updaters_replaced;
+		}
+
+		void backward_propagation_plain::update_cache_aware_entry_count()
+		{
+			cache_aware_entry_count = 0;
+			if (!plain_config->cache_aware_chunk_size)
+				return;
+
+			// Working set of the layer is its inputs and output, errors of them used in backward pass, and temporary buffers
+			size_t max_working_set_per_entry_size = 0;
+			std::string max_working_set_layer_name;
+			for(std::map<std::string, layer_updater_plain::const_ptr>::const_iterator it = updaters.begin(); it != updaters.end(); ++it)
+			{
+				const std::string& layer_name = it->first;
+				const std::set<layer_action>& actions = layer_name_to_action_set_map[layer_name];
+				bool backward_data = false;
+				bool backward_weights = false;
+				for(std::set<layer_action>::const_iterator action_it = actions.begin(); action_it != actions.end(); ++action_it)
+				{
+					backward_data = backward_data || (action_it->get_action_type() == layer_action::backward_data);
+					backward_weights = backward_weights || (action_it->get_action_type() == layer_action::backward_weights);
+				}
+
+				layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+				layer::const_ptr l = schema->get_layer(layer_name);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				size_t output_per_entry_size = output_layer_configuration_specific.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
+				size_t input_per_entry_size = 0;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+				{
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+					input_per_entry_size += layer_config_map[*it2].get_neuron_count() * cumulative_tiling_factor_map[*it2] * sizeof(float);
+				}
+
+				size_t working_set_per_entry_size = input_per_entry_size + output_per_entry_size;
+				if (backward_data || backward_weights)
+					working_set_per_entry_size += output_per_entry_size;
+				if (backward_data)
+					working_set_per_entry_size += input_per_entry_size;
+				size_t temporary_working_per_entry_size = 0;
+				for(std::set<layer_action>::const_iterator action_it = actions.begin(); action_it != actions.end(); ++action_it)
+					temporary_working_per_entry_size = std::max(temporary_working_per_entry_size, it->second->get_temporary_working_per_entry_buffer_size(
+						*action_it,
+						actions,
+						plain_config,
+						l,
+						input_layer_configuration_specific_list,
+						output_layer_configuration_specific));
+				working_set_per_entry_size += (temporary_working_per_entry_size + it->second->get_temporary_per_entry_buffer_size(
+					actions,
+					plain_config,
+					l,
+					input_layer_configuration_specific_list,
+					output_layer_configuration_specific)) * cumulative_tiling_factor_map[layer_name];
+
+				if (working_set_per_entry_size > max_working_set_per_entry_size)
+				{
+					max_working_set_per_entry_size = working_set_per_entry_size;
+					max_working_set_layer_name = layer_name;
+				}
+			}
+
+			cache_aware_entry_count = plain_config->get_cache_aware_entry_count(max_working_set_per_entry_size);
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain cache-aware packet size: " << cache_aware_entry_count
+					<< " (" << ((plain_config->cache_topology->get_capacity(plain_config->openmp_thread_count) + 1024 - 1) / 1024) << " KB of cache, "
+					<< ((max_working_set_per_entry_size + 1024 - 1) / 1024) << " KB per entry in " << max_working_set_layer_name << ")";
+				debug->output_message(debug_str.str().c_str());
+			}
+		}
+
+		void backward_propagation_plain::setup_dedicated_buffer_sizes()
+		{
+			dedicated_per_entry_data_name_to_size_map.clear();
+
+			std::set<std::string> separate_buffers_layer_names(output_layer_names.begin(), output_layer_names.end());
+			separate_buffers_layer_names.insert(data_layer_names.begin(), data_layer_names.end());
+			for(std::set<std::string>::const_iterator it = separate_buffers_layer_names.begin(); it != separate_buffers_layer_names.end(); ++it)
+				dedicated_per_entry_data_name_to_size_map.insert(std::make_pair(*it, layer_config_map.find(*it)->second.get_neuron_count() * cumulative_tiling_factor_map[*it] * sizeof(float)));
+		}
+
+		void backward_propagation_plain::setup_recompute_schedule()
+		{
+			action_run_list.clear();
+			scheduled_actions.clear();
+			recomputed_layer_names.clear();
+			action_stream_runner.reset();
+
+			// Forward actions of non-checkpoint layers are recomputed right before the backward actions which need their outputs
+			std::vector<layer_name_with_action> backward_pass_actions;
+			if (!non_checkpoint_layer_names.empty())
+			{
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
 				{
-					std::map<std::string, const float *> data_map;
-					for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
-						data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float) / output_layers_tiling_factor)));
-					writer.write(entry_processed_count + entry_id, data_map);
+					if (it->get_action().get_action_type() == layer_action::forward)
+						continue;
+
+					std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > current_dependencies = get_action_dependencies(*it);
+					for(std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > >::const_iterator it2 = current_dependencies.begin(); it2 != current_dependencies.end(); ++it2)
+						if ((it2->first.get_action().get_action_type() == layer_action::forward) && (non_checkpoint_layer_names.find(it2->first.get_name()) != non_checkpoint_layer_names.end()))
+							schedule_recompute(it2->first.get_name(), backward_pass_actions);
+
+					backward_pass_actions.push_back(*it);
 				}
+			}
 
-				entry_processed_count += entry_read_count;
-				chunk_index = (chunk_index + 1) % entry_read_count_list.size();
+			if (recomputed_layer_names.empty())
+			{
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					action_run_list.push_back(std::make_pair(*it, false));
+				scheduled_actions = actions_in_execution_order;
+				scheduled_action_schema = action_schema;
+				action_stream_runner = inter_op_action_stream_runner;
+				return;
+			}
 
-				if (entry_read_count < current_max_entry_count_const)
-					break;
+			// Non-checkpoint layers which outputs are not needed by backward pass are run once and treated as regular layers
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				if (it->get_action().get_action_type() != layer_action::forward)
+					continue;
+				action_run_list.push_back(std::make_pair(*it, true));
+				if (recomputed_layer_names.find(it->get_name()) == recomputed_layer_names.end())
+					scheduled_actions.push_back(*it);
+			}
+			for(std::vector<layer_name_with_action>::const_iterator it = backward_pass_actions.begin(); it != backward_pass_actions.end(); ++it)
+			{
+				action_run_list.push_back(std::make_pair(*it, false));
+				scheduled_actions.push_back(*it);
 			}
 
-			if (gradient_accumulated_entry_count > 0)
+			network_action_schema::ptr sequential_action_schema(new network_action_schema());
 			{
-				float gradient_normalizer = 1.0F / static_cast<float>(batch_size);
-				gradient_applied_count++;
-				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
+				std::vector<layer_name_with_action> dependencies;
+				for(std::vector<layer_name_with_action>::const_iterator it = scheduled_actions.begin(); it != scheduled_actions.end(); ++it)
 				{
-					const std::string& layer_name = it->first;
-					layer_data::ptr previous_upd;
-					if (momentum.is_momentum_data())
-						previous_upd = momentum_data->data_list.find(layer_name);
-					layer_data::ptr previous_upd2;
-					if (momentum.is_momentum_data2())
-						previous_upd2 = momentum_data2->data_list.find(layer_name);
-					apply_gradient(
-						layer_name,
-						data.data_list.find(layer_name),
-						gradient->find(layer_name),
-						previous_upd,
-						previous_upd2,
-						updates_accumulated[layer_name],
-						learning_rates.find(layer_name)->second,
-						gradient_normalizer,
-						weight_decay,
-						momentum,
-						base_iteration_count + gradient_applied_count);
+					sequential_action_schema->add_action(
+						schema->get_layer(it->get_name()),
+						it->get_action(),
+						dependencies);
+					dependencies.clear();
+					dependencies.push_back(*it);
 				}
 			}
+			scheduled_action_schema = sequential_action_schema;
 
-			average_absolute_updates.clear();
+			if (debug->is_debug())
 			{
-				float mult = 1.0F / static_cast<float>(gradient_applied_count);
-				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
+				std::stringstream debug_str;
+				debug_str << "backward prop plain activation checkpointing, " << recomputed_layer_names.size() << " layers recomputed: ";
+				for(std::set<std::string>::const_iterator it = recomputed_layer_names.begin(); it != recomputed_layer_names.end(); ++it)
 				{
-					std::vector<float>& f = average_absolute_updates.insert(std::make_pair(it->first, std::vector<float>())).first->second;
-					layer_data::const_iterator it_data = data.data_list.find(it->first)->begin();
-					for(std::vector<double>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2, ++it_data)
-						f.push_back(static_cast<float>(*it2) * mult / static_cast<float>(it_data->size()));
+					if (it != recomputed_layer_names.begin())
+						debug_str << ", ";
+					debug_str << *it;
 				}
+				debug->output_message(debug_str.str().c_str());
+				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_action_schema_recompute", "gv"), std::ios_base::out | std::ios_base::trunc);
+				scheduled_action_schema->write_gv(out);
 			}
-			entries_processed = entry_processed_count;
-			action_seconds.clear();
-			idle_seconds = static_cast<float>(total_idel_sec);
 		}
 
-		void backward_propagation_plain::layer_config_map_modified()
+		void backward_propagation_plain::schedule_recompute(
+			const std::string& layer_name,
+			std::vector<layer_name_with_action>& actions)
 		{
-			setup_dedicated_buffer_sizes();
-
-			setup_layer_buffer_sizes();
-
-			setup_temporary_working_fixed_buffer_sizes();
-
-			update_buffer_config();
-		}
+			if (!recomputed_layer_names.insert(layer_name).second)
+				return;
 
-		void backward_propagation_plain::setup_dedicated_buffer_sizes()
-		{
-			dedicated_per_entry_data_name_to_size_map.clear();
+			// Inputs are recomputed first, up to the nearest checkpoints
+			layer::const_ptr l = schema->get_layer(layer_name);
+			for(std::vector<std::string>::const_iterator it = l->input_layer_instance_names.begin(); it != l->input_layer_instance_names.end(); ++it)
+				if (non_checkpoint_layer_names.find(*it) != non_checkpoint_layer_names.end())
+					schedule_recompute(*it, actions);
 
-			std::set<std::string> separate_buffers_layer_names(output_layer_names.begin(), output_layer_names.end());
-			separate_buffers_layer_names.insert(data_layer_names.begin(), data_layer_names.end());
-			for(std::set<std::string>::const_iterator it = separate_buffers_layer_names.begin(); it != separate_buffers_layer_names.end(); ++it)
-				dedicated_per_entry_data_name_to_size_map.insert(std::make_pair(*it, layer_config_map.find(*it)->second.get_neuron_count() * cumulative_tiling_factor_map[*it] * sizeof(float)));
+			actions.push_back(layer_name_with_action(layer_name, layer_action::forward));
 		}
 
 		void backward_propagation_plain::setup_temporary_working_fixed_buffer_sizes()
@@ -573,136 +1606,22 @@ namespace nnforge
 			{
 				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > buffers;
 				std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > > dependencies;
-				std::set<std::string> dedicated_output_buffers(output_layer_names.begin(), output_layer_names.end());
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				for(std::vector<layer_name_with_action>::const_iterator it = scheduled_actions.begin(); it != scheduled_actions.end(); ++it)
 				{
-					std::string layer_name = it->get_name();
-					layer::const_ptr l = schema->get_layer(layer_name);
-					layer_updater_plain::const_ptr updater = updaters[layer_name];
-					layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
-						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
-
-					std::vector<std::pair<buffer_lifetime, float> > current_buffers;
-					{
-						switch (it->get_action().get_action_type())
-						{
-						case layer_action::forward:
-							{
-								size_t buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
-								if (dedicated_output_buffers.find(it->get_name()) == dedicated_output_buffers.end())
-										current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
-							}
-							{
-								size_t temporary_per_entry_buffer_size = updater->get_temporary_per_entry_buffer_size(
-									layer_name_to_action_set_map[layer_name],
-									plain_config,
-									l,
-									input_layer_configuration_specific_list,
-									output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
-								if (temporary_per_entry_buffer_size > 0)
-									current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), static_cast<float>(temporary_per_entry_buffer_size)));
-							}
-							break;
-						case layer_action::backward_data:
-							{
-								const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[it->get_action().get_backprop_index()];
-								size_t buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
-								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
-							}
-							break;
-						}
-
-						{
-							size_t temporary_working_per_entry_buffer_size = updater->get_temporary_working_per_entry_buffer_size(
-								it->get_action(),
-								layer_name_to_action_set_map[layer_name],
-								plain_config,
-								l,
-								input_layer_configuration_specific_list,
-								output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
-							if (temporary_working_per_entry_buffer_size > 0)
-								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::working_buffer), static_cast<float>(temporary_working_per_entry_buffer_size)));
-						}
-					}
-
+					std::vector<std::pair<buffer_lifetime, float> > current_buffers = get_action_buffers(*it);
 					if (!current_buffers.empty())
 						buffers.insert(std::make_pair(*it, current_buffers));
 
-					int input_index_layer_can_write;
-					{
-						layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-						layer::const_ptr l = schema->get_layer(layer_name);
-						std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
-							input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
-						input_index_layer_can_write = updaters[layer_name]->get_input_index_layer_can_write(
-							it->get_action(),
-							layer_name_to_action_set_map[layer_name],
-							plain_config,
-							l,
-							input_layer_configuration_specific_list,
-							output_layer_configuration_specific);
-					}
-
-					std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > current_dependencies;
+					std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > current_dependencies = get_action_dependencies(*it);
+					if ((it->get_action().get_action_type() == layer_action::forward) && (recomputed_layer_names.find(it->get_name()) == recomputed_layer_names.end()))
 					{
-						layer::const_ptr l = schema->get_layer(it->get_name());
-						switch (it->get_action().get_action_type())
+						// Inputs from recomputed layers are read from scratch buffers during initial forward pass
+						for(std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > >::iterator it2 = current_dependencies.begin(); it2 != current_dependencies.end();)
 						{
-						case layer_action::forward:
-							{
-								int input_index = 0;
-								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++input_index)
-								{
-									const std::string& previous_layer_name = *it2;
-									if (data_layer_names.find(previous_layer_name) == data_layer_names.end())
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(
-											std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == input_index)));
-								}
-							}
-							break;
-						case layer_action::backward_weights:
-							{
-								unsigned int data_input_index = 0;
-								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
-								{
-									const std::string& previous_layer_name = *it2;
-									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) &&
-										updater->is_backward_weights_dependent_on_input_buffer(data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									{
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-									}
-								}
-								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = gradient_to_producing_actions_map.find(l->instance_name);
-								if (input_to_all_output_it != gradient_to_producing_actions_map.end())
-									for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
-										current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-								if (updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
-							}
-							break;
-						case layer_action::backward_data:
-							{
-								unsigned int action_input_index = it->get_action().get_backprop_index();
-								unsigned int data_input_index = 0;
-								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
-								{
-									const std::string& previous_layer_name = *it2;
-									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) && updater->is_backward_data_dependent_on_input_buffer(action_input_index, data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-								}
-								if (updater->is_backward_data_dependent_on_output_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = gradient_to_producing_actions_map.find(l->instance_name);
-								if (input_to_all_output_it != gradient_to_producing_actions_map.end())
-									for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
-										current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == 0)));
-								if (updater->is_backward_data_dependent_on_temporary_per_entry_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
-							}
-							break;
+							if (recomputed_layer_names.find(it2->first.get_name()) != recomputed_layer_names.end())
+								current_dependencies.erase(it2++);
+							else
+								++it2;
 						}
 					}
 
@@ -720,19 +1639,275 @@ namespace nnforge
 						tt.push_back(std::make_pair(*it2, buffer_lifetime(buffer_lifetime::action_output_buffer)));
 				}
 
-				layer_buffer_set_list = action_schema->get_buffer_set(
+				layer_buffer_set_list = scheduled_action_schema->get_buffer_set(
+					buffers,
+					dependencies,
+					std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >());
+			}
+
+			fill_buffer_set_maps(
+				layer_buffer_set_list,
+				layer_buffer_set_per_entry_size_list,
+				layer_buffer_action_to_set_map,
+				temporary_working_per_entry_data_action_to_set_map,
+				temporary_per_entry_data_action_to_set_map);
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain per entry buffers: " << layer_buffer_set_per_entry_size_list.size();
+				size_t total_buffer_size = 0;
+				for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
+						total_buffer_size += *it;
+				debug_str << ", total size " << ((total_buffer_size + 1024 - 1) / 1024) << " KB";
+				debug->output_message(debug_str.str().c_str());
+				for(unsigned int set_id = 0; set_id < static_cast<unsigned int>(layer_buffer_set_per_entry_size_list.size()); ++set_id)
+				{
+					std::stringstream debug_str;
+					debug_str << " - " << ((layer_buffer_set_per_entry_size_list[set_id] + 1024 - 1) / 1024) << " KB: ";
+					const std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& action_list = layer_buffer_set_list[set_id];
+					for(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >::const_iterator it = action_list.begin(); it != action_list.end(); ++it)
+					{
+						if (it != action_list.begin())
+							debug_str << ", ";
+						debug_str << it->first.get_name() << " " << it->first.get_action().str();
+						if (it->second.get_buffer_lifetime_type() != buffer_lifetime::action_output_buffer)
+							debug_str << " " << it->second.str();
+					}
+					debug->output_message(debug_str.str().c_str());
+				}
+				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_per_entry_buffers", "gv"), std::ios_base::out | std::ios_base::trunc);
+				scheduled_action_schema->write_gv(out, layer_buffer_action_to_set_map, temporary_per_entry_data_action_to_set_map, temporary_working_per_entry_data_action_to_set_map);
+			}
+		}
+
+		void backward_propagation_plain::setup_recompute_scratch_buffer_sizes()
+		{
+			scratch_buffer_set_per_entry_size_list.clear();
+			scratch_buffer_action_to_set_map.clear();
+			scratch_working_per_entry_data_action_to_set_map.clear();
+			scratch_temporary_per_entry_data_action_to_set_map.clear();
+
+			if (recomputed_layer_names.empty())
+				return;
+
+			// Recomputed layers store their outputs in scratch buffers during initial forward pass, these are needed until the next checkpoint is computed only
+			std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > scratch_buffer_set_list;
+			network_action_schema::ptr initial_forward_action_schema(new network_action_schema());
+			{
+				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > buffers;
+				std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > > dependencies;
+				std::vector<layer_name_with_action> previous_actions;
+				for(std::vector<std::pair<layer_name_with_action, bool> >::const_iterator it = action_run_list.begin(); (it != action_run_list.end()) && it->second; ++it)
+				{
+					const layer_name_with_action& action = it->first;
+					initial_forward_action_schema->add_action(
+						schema->get_layer(action.get_name()),
+						action.get_action(),
+						previous_actions);
+					previous_actions.clear();
+					previous_actions.push_back(action);
+
+					bool is_recomputed = (recomputed_layer_names.find(action.get_name()) != recomputed_layer_names.end());
+
+					if (is_recomputed)
+					{
+						std::vector<std::pair<buffer_lifetime, float> > current_buffers = get_action_buffers(action);
+						if (!current_buffers.empty())
+							buffers.insert(std::make_pair(action, current_buffers));
+					}
+
+					std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > current_dependencies = get_action_dependencies(action);
+					for(std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > >::iterator it2 = current_dependencies.begin(); it2 != current_dependencies.end();)
+					{
+						if (recomputed_layer_names.find(it2->first.get_name()) == recomputed_layer_names.end())
+						{
+							current_dependencies.erase(it2++);
+							continue;
+						}
+						// Checkpoint layers write their output into layer buffers, not into scratch ones
+						if (!is_recomputed)
+							for(std::vector<std::pair<buffer_lifetime, bool> >::iterator it3 = it2->second.begin(); it3 != it2->second.end(); ++it3)
+								it3->second = false;
+						++it2;
+					}
+					if (!current_dependencies.empty())
+						dependencies.insert(std::make_pair(action, current_dependencies));
+				}
+
+				scratch_buffer_set_list = initial_forward_action_schema->get_buffer_set(
 					buffers,
 					dependencies,
 					std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >());
 			}
 
-			layer_buffer_set_per_entry_size_list.clear();
-			layer_buffer_action_to_set_map.clear();
-			temporary_working_per_entry_data_action_to_set_map.clear();
-			temporary_per_entry_data_action_to_set_map.clear();
-			for(unsigned int set_id = 0; set_id < layer_buffer_set_list.size(); ++set_id)
+			fill_buffer_set_maps(
+				scratch_buffer_set_list,
+				scratch_buffer_set_per_entry_size_list,
+				scratch_buffer_action_to_set_map,
+				scratch_working_per_entry_data_action_to_set_map,
+				scratch_temporary_per_entry_data_action_to_set_map);
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain per entry scratch buffers for recomputed layers: " << scratch_buffer_set_per_entry_size_list.size();
+				size_t total_buffer_size = 0;
+				for(std::vector<size_t>::const_iterator it = scratch_buffer_set_per_entry_size_list.begin(); it != scratch_buffer_set_per_entry_size_list.end(); ++it)
+						total_buffer_size += *it;
+				debug_str << ", total size " << ((total_buffer_size + 1024 - 1) / 1024) << " KB";
+				debug->output_message(debug_str.str().c_str());
+				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_per_entry_scratch_buffers", "gv"), std::ios_base::out | std::ios_base::trunc);
+				initial_forward_action_schema->write_gv(out, scratch_buffer_action_to_set_map, scratch_temporary_per_entry_data_action_to_set_map, scratch_working_per_entry_data_action_to_set_map);
+			}
+		}
+
+		std::vector<std::pair<buffer_lifetime, float> > backward_propagation_plain::get_action_buffers(const layer_name_with_action& action)
+		{
+			std::string layer_name = action.get_name();
+			layer::const_ptr l = schema->get_layer(layer_name);
+			layer_updater_plain::const_ptr updater = updaters[layer_name];
+			layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+			std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+			for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+				input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+
+			std::vector<std::pair<buffer_lifetime, float> > current_buffers;
+			switch (action.get_action().get_action_type())
+			{
+			case layer_action::forward:
+				{
+					size_t buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
+					if (std::find(output_layer_names.begin(), output_layer_names.end(), layer_name) == output_layer_names.end())
+							current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
+				}
+				{
+					size_t temporary_per_entry_buffer_size = updater->get_temporary_per_entry_buffer_size(
+						layer_name_to_action_set_map[layer_name],
+						plain_config,
+						l,
+						input_layer_configuration_specific_list,
+						output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
+					if (temporary_per_entry_buffer_size > 0)
+						current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), static_cast<float>(temporary_per_entry_buffer_size)));
+				}
+				break;
+			case layer_action::backward_data:
+				{
+					const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[action.get_action().get_backprop_index()];
+					size_t buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
+					current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
+				}
+				break;
+			}
+
+			{
+				size_t temporary_working_per_entry_buffer_size = updater->get_temporary_working_per_entry_buffer_size(
+					action.get_action(),
+					layer_name_to_action_set_map[layer_name],
+					plain_config,
+					l,
+					input_layer_configuration_specific_list,
+					output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
+				if (temporary_working_per_entry_buffer_size > 0)
+					current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::working_buffer), static_cast<float>(temporary_working_per_entry_buffer_size)));
+			}
+
+			return current_buffers;
+		}
+
+		std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > backward_propagation_plain::get_action_dependencies(const layer_name_with_action& action)
+		{
+			std::string layer_name = action.get_name();
+			layer::const_ptr l = schema->get_layer(layer_name);
+			layer_updater_plain::const_ptr updater = updaters[layer_name];
+			layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+			std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+			for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+				input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+
+			int input_index_layer_can_write = updater->get_input_index_layer_can_write(
+				action.get_action(),
+				layer_name_to_action_set_map[layer_name],
+				plain_config,
+				l,
+				input_layer_configuration_specific_list,
+				output_layer_configuration_specific);
+
+			std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > current_dependencies;
+			switch (action.get_action().get_action_type())
+			{
+			case layer_action::forward:
+				{
+					int input_index = 0;
+					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++input_index)
+					{
+						const std::string& previous_layer_name = *it2;
+						if (data_layer_names.find(previous_layer_name) == data_layer_names.end())
+							current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(
+								std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == input_index)));
+					}
+				}
+				break;
+			case layer_action::backward_weights:
+				{
+					unsigned int data_input_index = 0;
+					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
+					{
+						const std::string& previous_layer_name = *it2;
+						if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) &&
+							updater->is_backward_weights_dependent_on_input_buffer(data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+						{
+							current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+						}
+					}
+					std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = gradient_to_producing_actions_map.find(l->instance_name);
+					if (input_to_all_output_it != gradient_to_producing_actions_map.end())
+						for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
+							current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+					if (updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+						current_dependencies.insert(std::make_pair(layer_name_with_action(layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
+				}
+				break;
+			case layer_action::backward_data:
+				{
+					unsigned int action_input_index = action.get_action().get_backprop_index();
+					unsigned int data_input_index = 0;
+					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
+					{
+						const std::string& previous_layer_name = *it2;
+						if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) && updater->is_backward_data_dependent_on_input_buffer(action_input_index, data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+							current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+					}
+					if (updater->is_backward_data_dependent_on_output_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+						current_dependencies.insert(std::make_pair(layer_name_with_action(layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+					std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = gradient_to_producing_actions_map.find(l->instance_name);
+					if (input_to_all_output_it != gradient_to_producing_actions_map.end())
+						for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
+							current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == 0)));
+					if (updater->is_backward_data_dependent_on_temporary_per_entry_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+						current_dependencies.insert(std::make_pair(layer_name_with_action(layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
+				}
+				break;
+			}
+
+			return current_dependencies;
+		}
+
+		void backward_propagation_plain::fill_buffer_set_maps(
+			const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& buffer_set_list,
+			std::vector<size_t>& buffer_set_per_entry_size_list,
+			std::map<layer_name_with_action, unsigned int>& output_action_to_set_map,
+			std::map<layer_name_with_action, unsigned int>& working_per_entry_action_to_set_map,
+			std::map<layer_name_with_action, unsigned int>& temporary_per_entry_action_to_set_map)
+		{
+			buffer_set_per_entry_size_list.clear();
+			output_action_to_set_map.clear();
+			working_per_entry_action_to_set_map.clear();
+			temporary_per_entry_action_to_set_map.clear();
+			for(unsigned int set_id = 0; set_id < buffer_set_list.size(); ++set_id)
 			{
-				const std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& action_list = layer_buffer_set_list[set_id];
+				const std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& action_list = buffer_set_list[set_id];
 				size_t max_buffer_size_per_entry = 0;
 				for(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >::const_iterator it = action_list.begin(); it != action_list.end(); ++it)
 				{
@@ -748,7 +1923,7 @@ namespace nnforge
 					switch(it->second.get_buffer_lifetime_type())
 					{
 					case buffer_lifetime::action_output_buffer:
-						layer_buffer_action_to_set_map.insert(std::make_pair(it->first, set_id));
+						output_action_to_set_map.insert(std::make_pair(it->first, set_id));
 						switch (it->first.get_action().get_action_type())
 						{
 						case layer_action::forward:
@@ -765,11 +1940,11 @@ namespace nnforge
 						}
 						break;
 					case buffer_lifetime::working_buffer:
-						temporary_working_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
+						working_per_entry_action_to_set_map.insert(std::make_pair(it->first, set_id));
 						buffer_size_per_entry = updaters[layer_name]->get_temporary_working_per_entry_buffer_size(it->first.get_action(), layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
 						break;
 					case buffer_lifetime::temporary_buffer:
-						temporary_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
+						temporary_per_entry_action_to_set_map.insert(std::make_pair(it->first, set_id));
 						buffer_size_per_entry = updaters[layer_name]->get_temporary_per_entry_buffer_size(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
 						break;
 					default:
@@ -777,34 +1952,7 @@ namespace nnforge
 					}
 					max_buffer_size_per_entry = std::max(max_buffer_size_per_entry, buffer_size_per_entry);
 				}
-				layer_buffer_set_per_entry_size_list.push_back(max_buffer_size_per_entry);
-			}
-			if (debug->is_debug())
-			{
-				std::stringstream debug_str;
-				debug_str << "backward prop plain per entry buffers: " << layer_buffer_set_per_entry_size_list.size();
-				size_t total_buffer_size = 0;
-				for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
-						total_buffer_size += *it;
-				debug_str << ", total size " << ((total_buffer_size + 1024 - 1) / 1024) << " KB";
-				debug->output_message(debug_str.str().c_str());
-				for(unsigned int set_id = 0; set_id < static_cast<unsigned int>(layer_buffer_set_per_entry_size_list.size()); ++set_id)
-				{
-					std::stringstream debug_str;
-					debug_str << " - " << ((layer_buffer_set_per_entry_size_list[set_id] + 1024 - 1) / 1024) << " KB: ";
-					const std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& action_list = layer_buffer_set_list[set_id];
-					for(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >::const_iterator it = action_list.begin(); it != action_list.end(); ++it)
-					{
-						if (it != action_list.begin())
-							debug_str << ", ";
-						debug_str << it->first.get_name() << " " << it->first.get_action().str();
-						if (it->second.get_buffer_lifetime_type() != buffer_lifetime::action_output_buffer)
-							debug_str << " " << it->second.str();
-					}
-					debug->output_message(debug_str.str().c_str());
-				}
-				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_per_entry_buffers", "gv"), std::ios_base::out | std::ios_base::trunc);
-				action_schema->write_gv(out, layer_buffer_action_to_set_map, temporary_per_entry_data_action_to_set_map, temporary_working_per_entry_data_action_to_set_map);
+				buffer_set_per_entry_size_list.push_back(max_buffer_size_per_entry);
 			}
 		}
 
@@ -815,14 +1963,58 @@ namespace nnforge
 			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
 				buffer_configuration.add_per_entry_buffer(*it);
 
+			for(std::vector<size_t>::const_iterator it = scratch_buffer_set_per_entry_size_list.begin(); it != scratch_buffer_set_per_entry_size_list.end(); ++it)
+				buffer_configuration.add_per_entry_buffer(*it);
+
 			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
 				buffer_configuration.add_per_entry_buffer(it->second);
 
-			buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
+			unsigned int worker_count = action_stream_runner ? action_stream_runner->get_worker_count() : 1;
+			for(unsigned int worker_id = 0; worker_id < worker_count; ++worker_id)
+				buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
 
 			buffer_config_without_data_and_momentum = buffer_configuration;
 		}
 
+		void backward_propagation_plain::reduce_gradient(
+			plain_communicator& communicator,
+			const std::string& layer_name,
+			layer_data::ptr gradient) const
+		{
+			profile_trace_scope trace_scope(profile, "reduce_gradient", layer_name);
+
+			for(layer_data::iterator it = gradient->begin(); it != gradient->end(); ++it)
+				if (!it->empty())
+					communicator.reduce_all(&(*it->begin()), it->size());
+		}
+
+		void backward_propagation_plain::broadcast_data(
+			plain_communicator& communicator,
+			network_data& data,
+			network_data::ptr momentum_data,
+			network_data::ptr momentum_data2) const
+		{
+			std::vector<layer_data_list *> data_list_list;
+			data_list_list.push_back(&data.data_list);
+			if (momentum_data)
+				data_list_list.push_back(&momentum_data->data_list);
+			if (momentum_data2)
+				data_list_list.push_back(&momentum_data2->data_list);
+
+			for(std::vector<layer_data_list *>::const_iterator it = data_list_list.begin(); it != data_list_list.end(); ++it)
+			{
+				std::vector<std::string> layer_name_list = (*it)->get_data_layer_name_list();
+				std::sort(layer_name_list.begin(), layer_name_list.end());
+				for(std::vector<std::string>::const_iterator it2 = layer_name_list.begin(); it2 != layer_name_list.end(); ++it2)
+				{
+					layer_data::ptr d = (*it)->get(*it2);
+					for(layer_data::iterator it3 = d->begin(); it3 != d->end(); ++it3)
+						if (!it3->empty())
+							communicator.broadcast(&(*it3->begin()), it3->size());
+				}
+			}
+		}
+
 		void backward_propagation_plain::apply_gradient(
 			const std::string& layer_name,
 			layer_data::ptr data,
@@ -836,6 +2028,8 @@ namespace nnforge
 			training_momentum momentum,
 			unsigned int iteration_id) const
 		{
+			profile_trace_scope trace_scope(profile, "apply_gradient", layer_name);
+
 			switch (momentum.type)
 			{
 			case training_momentum::no_momentum:
@@ -974,5 +2168,10 @@ namespace nnforge
 				break;
 			}
 		}
+
+		float backward_propagation_plain::get_max_flops() const
+		{
+			return plain_config->get_flops();
+		}
 	}
 }
@@ -20,6 +20,8 @@
 
 #include "plain_running_configuration.h"
 #include "layer_updater_plain.h"
+#include "plain_action_stream_runner.h"
+#include "plain_perf_counter_collector.h"
 
 #include <map>
 
@@ -65,15 +67,57 @@ namespace nnforge
 			// The layer_config_map is guaranteed to be compatible with schema
 			virtual void layer_config_map_modified();
 
+			virtual float get_max_flops() const;
+
 		private:
+			void setup_non_checkpoint_layer_names();
+
+			// Picks the fastest algorithm for each layer having alternatives, when autotuning is on.
+			// Candidates are timed with the chunk size the buffers allow, the method returns true when it replaced any updater
+			bool setup_autotuned_updaters();
+
 			void setup_dedicated_buffer_sizes();
 
+			void setup_recompute_schedule();
+
+			void schedule_recompute(
+				const std::string& layer_name,
+				std::vector<layer_name_with_action>& actions);
+
 			void setup_layer_buffer_sizes();
 
+			void setup_recompute_scratch_buffer_sizes();
+
+			std::vector<std::pair<buffer_lifetime, float> > get_action_buffers(const layer_name_with_action& action);
+
+			std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > get_action_dependencies(const layer_name_with_action& action);
+
+			void fill_buffer_set_maps(
+				const std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >& buffer_set_list,
+				std::vector<size_t>& buffer_set_per_entry_size_list,
+				std::map<layer_name_with_action, unsigned int>& output_action_to_set_map,
+				std::map<layer_name_with_action, unsigned int>& working_per_entry_action_to_set_map,
+				std::map<layer_name_with_action, unsigned int>& temporary_per_entry_action_to_set_map);
+
 			void setup_temporary_working_fixed_buffer_sizes();
 
 			void update_buffer_config();
 
+			void update_cache_aware_entry_count();
+
+			// Sums gradient over the worker processes
+			void reduce_gradient(
+				plain_communicator& communicator,
+				const std::string& layer_name,
+				layer_data::ptr gradient) const;
+
+			// Makes all the worker processes start with the weights and momentums of the one with rank 0
+			void broadcast_data(
+				plain_communicator& communicator,
+				network_data& data,
+				network_data::ptr momentum_data,
+				network_data::ptr momentum_data2) const;
+
 			void apply_gradient(
 				const std::string& layer_name,
 				layer_data::ptr data,
@@ -92,16 +136,39 @@ namespace nnforge
 
 			std::vector<layer_name_with_action> actions_in_execution_order;
 			std::map<std::string, std::set<layer_action> > layer_name_to_action_set_map;
+			// Layers having update_weights action, layers excluded from training get neither gradients nor updates
+			std::set<std::string> updated_layer_names;
 
 			std::map<std::string, layer_updater_plain::const_ptr> updaters;
 
+			// Activation checkpointing: outputs of these layers are not kept after the initial forward pass
+			std::set<std::string> non_checkpoint_layer_names;
+			// Subset of non-checkpoint layers which outputs are used in backward pass, these are recomputed
+			std::set<std::string> recomputed_layer_names;
+			// The flag is set for the actions of the initial forward pass, recomputed layers use scratch buffers there
+			std::vector<std::pair<layer_name_with_action, bool> > action_run_list;
+			// Actions to plan layer buffers for, forward actions of recomputed layers are placed right before the backward actions using them
+			std::vector<layer_name_with_action> scheduled_actions;
+			network_action_schema::const_ptr scheduled_action_schema;
+
+			// Built when inter-op parallelism is on, it is used only when no layers are recomputed
+			plain_action_stream_runner::const_ptr inter_op_action_stream_runner;
+			plain_action_stream_runner::const_ptr action_stream_runner;
+
 			size_t temporary_working_fixed_size;
+			// Entry count keeping buffers used by each layer in cache, 0 when cache-aware chunk size is off
+			unsigned int cache_aware_entry_count;
 
 			std::vector<size_t> layer_buffer_set_per_entry_size_list;
 			std::map<layer_name_with_action, unsigned int> temporary_working_per_entry_data_action_to_set_map;
 			std::map<layer_name_with_action, unsigned int> layer_buffer_action_to_set_map;
 			std::map<layer_name_with_action, unsigned int> temporary_per_entry_data_action_to_set_map;
 
+			std::vector<size_t> scratch_buffer_set_per_entry_size_list;
+			std::map<layer_name_with_action, unsigned int> scratch_buffer_action_to_set_map;
+			std::map<layer_name_with_action, unsigned int> scratch_working_per_entry_data_action_to_set_map;
+			std::map<layer_name_with_action, unsigned int> scratch_temporary_per_entry_data_action_to_set_map;
+
 			std::map<std::string, size_t> dedicated_per_entry_data_name_to_size_map;
 
 			buffer_plain_size_configuration buffer_config_without_data_and_momentum;
@@ -44,5 +44,28 @@ namespace nnforge
 				profile,
 				plain_config));
 		}
+
+		std::vector<backward_propagation::ptr> backward_propagation_plain_factory::create_concurrent(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			const std::vector<std::string>& error_source_layer_names,
+			const std::vector<std::string>& exclude_data_update_layer_names,
+			unsigned int count,
+			debug_state::ptr debug,
+			profile_state::ptr profile) const
+		{
+			std::vector<plain_running_configuration::const_ptr> partition_config_list = plain_config->get_thread_partition_config_list(count);
+			std::vector<backward_propagation::ptr> res;
+			for(std::vector<plain_running_configuration::const_ptr>::const_iterator it = partition_config_list.begin(); it != partition_config_list.end(); ++it)
+				res.push_back(backward_propagation::ptr(new backward_propagation_plain(
+					schema,
+					output_layer_names,
+					error_source_layer_names,
+					exclude_data_update_layer_names,
+					debug,
+					profile,
+					*it)));
+			return res;
+		}
 	}
 }
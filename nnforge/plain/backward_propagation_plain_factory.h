@@ -38,6 +38,16 @@ namespace nnforge
 				debug_state::ptr debug,
 				profile_state::ptr profile) const;
 
+			// Threads are split between the backward propagations, each of them runs its kernels on its own pool threads
+			virtual std::vector<backward_propagation::ptr> create_concurrent(
+				const network_schema& schema,
+				const std::vector<std::string>& output_layer_names,
+				const std::vector<std::string>& error_source_layer_names,
+				const std::vector<std::string>& exclude_data_update_layer_names,
+				unsigned int count,
+				debug_state::ptr debug,
+				profile_state::ptr profile) const;
+
 		protected:
 			plain_running_configuration::const_ptr plain_config;
 		};
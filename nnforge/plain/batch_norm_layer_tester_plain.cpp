@@ -18,6 +18,9 @@
 
 #include "../batch_norm_layer.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace nnforge
 {
 	namespace plain
@@ -51,27 +54,70 @@ namespace nnforge
 			const std::vector<float>::const_iterator mean = (*data)[2].begin();
 			const std::vector<float>::const_iterator inverse_sigma = (*data)[3].begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			std::shared_ptr<const batch_norm_layer> layer_derived = std::dynamic_pointer_cast<const batch_norm_layer>(layer_schema);
+			if (layer_derived->use_batch_statistics)
 			{
-				int entry_id = workload_id / feature_map_count;
-				int feature_map_id = workload_id - entry_id * feature_map_count;
-
-				float mult = gamma[feature_map_id] * inverse_sigma[feature_map_id];
-				float add = beta[feature_map_id] - mult * mean[feature_map_id];
+				const float epsilon = layer_derived->epsilon;
+				const double mult_for_average = 1.0 / static_cast<double>(entry_count * neuron_count_per_feature_map);
+				plain_config->parallel_for(static_cast<int>(feature_map_count), [&] (int begin, int end)
+				{
+					for(int feature_map_id = begin; feature_map_id < end; ++feature_map_id)
+					{
+						double sum = 0.0;
+						double sum_squared = 0.0;
+						for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+						{
+							const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+							const float * current_in_it_end = current_in_it + neuron_count_per_feature_map;
+							for(; current_in_it != current_in_it_end; ++current_in_it)
+							{
+								double input_val = static_cast<double>(*current_in_it);
+								sum += input_val;
+								sum_squared += input_val * input_val;
+							}
+						}
+						double batch_mean = sum * mult_for_average;
+						double batch_variance = std::max(sum_squared * mult_for_average - batch_mean * batch_mean, 0.0);
 
-				const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-				const float * current_in_it_end = current_in_it + neuron_count_per_feature_map;
+						float mult = gamma[feature_map_id] / static_cast<float>(sqrt(batch_variance + static_cast<double>(epsilon)));
+						float add = beta[feature_map_id] - mult * static_cast<float>(batch_mean);
 
-				float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+						for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+						{
+							const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+							const float * current_in_it_end = current_in_it + neuron_count_per_feature_map;
+							float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+							for(; current_in_it != current_in_it_end; ++current_in_it, ++current_out_it)
+								*current_out_it = *current_in_it * mult + add;
+						}
+					}
+				});
+				return;
+			}
 
-				for(; current_in_it != current_in_it_end; ++current_in_it, ++current_out_it)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
+			{
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
-					float input_val = *current_in_it;
-					float output_val = input_val * mult + add;
-					*current_out_it = output_val;
+					int entry_id = workload_id / feature_map_count;
+					int feature_map_id = workload_id - entry_id * feature_map_count;
+
+					float mult = gamma[feature_map_id] * inverse_sigma[feature_map_id];
+					float add = beta[feature_map_id] - mult * mean[feature_map_id];
+
+					const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					const float * current_in_it_end = current_in_it + neuron_count_per_feature_map;
+
+					float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+
+					for(; current_in_it != current_in_it_end; ++current_in_it, ++current_out_it)
+					{
+						float input_val = *current_in_it;
+						float output_val = input_val * mult + add;
+						*current_out_it = output_val;
+					}
 				}
-			}
+			});
 		}
 
 		int batch_norm_layer_tester_plain::get_input_index_layer_can_write(
@@ -52,10 +52,9 @@ namespace nnforge
 			const bool is_min = layer_derived->is_min;
 			const int total_workload = entry_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id;
 
@@ -82,7 +81,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		void cdf_max_layer_updater_plain::run_backward_data_propagation(
@@ -114,10 +113,9 @@ namespace nnforge
 			const bool is_min = layer_derived->is_min;
 			const int total_workload = entry_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id;
 
@@ -183,7 +181,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		bool cdf_max_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
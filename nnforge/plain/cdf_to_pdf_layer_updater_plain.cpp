@@ -55,10 +55,9 @@ namespace nnforge
 			const float clamp_max = layer_derived->clamp_max;
 			const int total_workload = entry_count * feature_map_segment_count * neuron_count_per_feature_map;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / (feature_map_segment_count * neuron_count_per_feature_map);
 					int tt = workload_id - entry_id * feature_map_segment_count * neuron_count_per_feature_map;
@@ -75,7 +74,7 @@ namespace nnforge
 						previous_val = previous_val;
 					}
 				}
-			}
+			});
 		}
 
 		void cdf_to_pdf_layer_updater_plain::run_backward_data_propagation(
@@ -108,10 +107,9 @@ namespace nnforge
 			const float clamp_max = layer_derived->clamp_max;
 			const int total_workload = entry_count * feature_map_segment_count * neuron_count_per_feature_map;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / (feature_map_segment_count * neuron_count_per_feature_map);
 					int tt = workload_id - entry_id * feature_map_segment_count * neuron_count_per_feature_map;
@@ -128,7 +126,7 @@ namespace nnforge
 						previous_val = current_val;
 					}
 				}
-			}
+			});
 		}
 
 		int cdf_to_pdf_layer_updater_plain::get_input_index_layer_can_write(
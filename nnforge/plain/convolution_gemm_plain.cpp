@@ -0,0 +1,176 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_gemm_plain.h"
+
+#include "../convolution_layer.h"
+
+#include <array>
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const int convolution_gemm_plain::max_dimension_count = 4;
+		const unsigned int convolution_gemm_plain::output_position_block_size = 64;
+		const unsigned int convolution_gemm_plain::output_feature_map_block_size = 4;
+
+		void convolution_gemm_plain::run_forward_propagation(
+			float * output,
+			const float * input,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count)
+		{
+			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
+
+			const unsigned int dimension_count = static_cast<unsigned int>(layer_derived->window_sizes.size());
+			const unsigned int input_neuron_count = input_configuration_specific.get_neuron_count();
+			const unsigned int input_neuron_count_per_feature_map = input_configuration_specific.get_neuron_count_per_feature_map();
+			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
+			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const unsigned int input_feature_map_count = input_configuration_specific.feature_map_count;
+			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
+
+			std::vector<unsigned int> input_slices(dimension_count);
+			input_slices[0] = 1;
+			for(unsigned int i = 0; i < dimension_count - 1; ++i)
+				input_slices[i + 1] = input_slices[i] * input_configuration_specific.dimension_sizes[i];
+
+			unsigned int window_elem_count = 1;
+			for(unsigned int i = 0; i < dimension_count; ++i)
+				window_elem_count *= layer_derived->window_sizes[i];
+
+			// Dilated position of each window element relative to the window origin
+			std::vector<std::array<int, max_dimension_count> > window_elem_positions(window_elem_count);
+			{
+				std::array<int, max_dimension_count> current_local_position;
+				std::fill_n(current_local_position.begin(), max_dimension_count, 0);
+				for(unsigned int window_elem_id = 0; window_elem_id < window_elem_count; ++window_elem_id)
+				{
+					for(unsigned int i = 0; i < dimension_count; ++i)
+						window_elem_positions[window_elem_id][i] = current_local_position[i] * static_cast<int>(layer_derived->dilation[i]);
+					for(unsigned int i = 0; i < dimension_count; ++i)
+					{
+						if ((++current_local_position[i]) < static_cast<int>(layer_derived->window_sizes[i]))
+							break;
+						current_local_position[i] = 0;
+					}
+				}
+			}
+
+			const unsigned int reduction_size = input_feature_map_count * window_elem_count;
+			const bool bias = layer_derived->bias;
+			const float * const weights = &(*data)[0][0];
+			const float * const biases = bias ? &(*data)[1][0] : 0;
+			const unsigned int block_count = (output_neuron_count_per_feature_map + output_position_block_size - 1) / output_position_block_size;
+			const int total_workload = entry_count * block_count;
+
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
+			{
+				// Scratch buffers are per range, there are a few ranges per thread
+				std::vector<float> columns(reduction_size * output_position_block_size);
+				std::vector<float> accumulators(output_feature_map_block_size * output_position_block_size);
+
+				for(int workload_id = begin; workload_id < end; ++workload_id)
+				{
+					const unsigned int entry_id = workload_id / block_count;
+					const unsigned int block_id = workload_id - entry_id * block_count;
+					const unsigned int output_position_start = block_id * output_position_block_size;
+					const unsigned int block_size = std::min(output_position_block_size, output_neuron_count_per_feature_map - output_position_start);
+					const float * const in_it_base = input + entry_id * input_neuron_count;
+					float * const out_it_base = output + entry_id * output_neuron_count + output_position_start;
+
+					// im2col: columns[input_feature_map_id * window_elem_count + window_elem_id][position_in_block]
+					for(unsigned int position_in_block = 0; position_in_block < block_size; ++position_in_block)
+					{
+						std::array<int, max_dimension_count> window_origin;
+						unsigned int remainder = output_position_start + position_in_block;
+						for(unsigned int i = 0; i < dimension_count; ++i)
+						{
+							const unsigned int output_dimension_size = output_configuration_specific.dimension_sizes[i];
+							const unsigned int output_position = remainder % output_dimension_size;
+							remainder /= output_dimension_size;
+							window_origin[i] = static_cast<int>(output_position * layer_derived->strides[i]) - static_cast<int>(layer_derived->left_zero_padding[i]);
+						}
+
+						for(unsigned int window_elem_id = 0; window_elem_id < window_elem_count; ++window_elem_id)
+						{
+							bool fit = true;
+							int in_offset = 0;
+							for(unsigned int i = 0; i < dimension_count; ++i)
+							{
+								const int input_position = window_origin[i] + window_elem_positions[window_elem_id][i];
+								fit = fit && (static_cast<unsigned int>(input_position) < input_configuration_specific.dimension_sizes[i]);
+								in_offset += input_position * static_cast<int>(input_slices[i]);
+							}
+
+							float * col_it = &columns[window_elem_id * output_position_block_size + position_in_block];
+							if (fit)
+							{
+								const float * in_it = in_it_base + in_offset;
+								for(unsigned int input_feature_map_id = 0; input_feature_map_id < input_feature_map_count; ++input_feature_map_id)
+								{
+									*col_it = *in_it;
+									col_it += window_elem_count * output_position_block_size;
+									in_it += input_neuron_count_per_feature_map;
+								}
+							}
+							else
+							{
+								for(unsigned int input_feature_map_id = 0; input_feature_map_id < input_feature_map_count; ++input_feature_map_id)
+								{
+									*col_it = 0.0F;
+									col_it += window_elem_count * output_position_block_size;
+								}
+							}
+						}
+					}
+
+					// GEMM: output[output_feature_map_id][position] = weights[output_feature_map_id][k] * columns[k][position]
+					for(unsigned int output_feature_map_start = 0; output_feature_map_start < output_feature_map_count; output_feature_map_start += output_feature_map_block_size)
+					{
+						const unsigned int output_feature_map_block = std::min(output_feature_map_block_size, output_feature_map_count - output_feature_map_start);
+						for(unsigned int i = 0; i < output_feature_map_block; ++i)
+							std::fill_n(accumulators.begin() + i * output_position_block_size, block_size, bias ? biases[output_feature_map_start + i] : 0.0F);
+
+						for(unsigned int k = 0; k < reduction_size; ++k)
+						{
+							const float * const col_it = &columns[k * output_position_block_size];
+							for(unsigned int i = 0; i < output_feature_map_block; ++i)
+							{
+								const float w = weights[(output_feature_map_start + i) * reduction_size + k];
+								float * const acc_it = &accumulators[i * output_position_block_size];
+								for(unsigned int position_in_block = 0; position_in_block < block_size; ++position_in_block)
+									acc_it[position_in_block] += w * col_it[position_in_block];
+							}
+						}
+
+						for(unsigned int i = 0; i < output_feature_map_block; ++i)
+							std::copy(
+								accumulators.begin() + i * output_position_block_size,
+								accumulators.begin() + i * output_position_block_size + block_size,
+								out_it_base + (output_feature_map_start + i) * output_neuron_count_per_feature_map);
+					}
+				}
+			});
+		}
+	}
+}
@@ -0,0 +1,54 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+#include "plain_buffer.h"
+#include "../layer.h"
+#include "../layer_data.h"
+#include "../layer_configuration_specific.h"
+
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Forward convolution done as im2col followed by matrix multiplication,
+		// it is an alternative to the direct algorithm picked by autotuning
+		class convolution_gemm_plain
+		{
+		public:
+			static void run_forward_propagation(
+				float * output,
+				const float * input,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				layer_data::const_ptr data,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count);
+
+		private:
+			convolution_gemm_plain() = delete;
+
+			static const int max_dimension_count;
+			static const unsigned int output_position_block_size;
+			static const unsigned int output_feature_map_block_size;
+		};
+	}
+}
@@ -16,6 +16,8 @@
 
 #include "convolution_layer_tester_plain.h"
 
+#include "convolution_gemm_plain.h"
+
 #include "../convolution_layer.h"
 
 #include <array>
@@ -26,11 +28,29 @@ namespace nnforge
 	{
 		const int convolution_layer_tester_plain::max_dimension_count = 4;
 
+		convolution_layer_tester_plain::convolution_layer_tester_plain(bool gemm)
+			: gemm(gemm)
+		{
+		}
+
 		std::string convolution_layer_tester_plain::get_type_name() const
 		{
 			return convolution_layer::layer_type_name;
 		}
 
+		std::string convolution_layer_tester_plain::get_algorithm_name() const
+		{
+			return gemm ? "gemm" : "direct";
+		}
+
+		std::vector<layer_tester_plain::const_ptr> convolution_layer_tester_plain::get_algorithm_alternatives() const
+		{
+			std::vector<layer_tester_plain::const_ptr> res;
+			if (!gemm)
+				res.push_back(layer_tester_plain::const_ptr(new convolution_layer_tester_plain(true)));
+			return res;
+		}
+
 		void convolution_layer_tester_plain::run_forward_propagation(
 			plain_buffer::ptr output_buffer,
 			const std::vector<plain_buffer::const_ptr>& input_buffers,
@@ -44,6 +64,20 @@ namespace nnforge
 			const layer_configuration_specific& output_configuration_specific,
 			unsigned int entry_count) const
 		{
+			if (gemm)
+			{
+				convolution_gemm_plain::run_forward_propagation(
+					*output_buffer,
+					*input_buffers[0],
+					plain_config,
+					layer_schema,
+					data,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					entry_count);
+				return;
+			}
+
 			const float * const in_it_global = *input_buffers[0];
 			float * const out_it_global = *output_buffer;
 			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
@@ -117,13 +151,12 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const std::vector<unsigned int>::const_iterator dilation_it = dilation.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (entry_id * output_feature_map_count);
@@ -188,7 +221,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 	}
 }
@@ -16,6 +16,8 @@
 
 #include "convolution_layer_updater_plain.h"
 
+#include "convolution_gemm_plain.h"
+
 #include "../convolution_layer.h"
 
 #include <array>
@@ -26,11 +28,29 @@ namespace nnforge
 	{
 		const int convolution_layer_updater_plain::max_dimension_count = 4;
 
+		convolution_layer_updater_plain::convolution_layer_updater_plain(bool gemm)
+			: gemm(gemm)
+		{
+		}
+
 		std::string convolution_layer_updater_plain::get_type_name() const
 		{
 			return convolution_layer::layer_type_name;
 		}
 
+		std::string convolution_layer_updater_plain::get_algorithm_name() const
+		{
+			return gemm ? "gemm" : "direct";
+		}
+
+		std::vector<layer_updater_plain::const_ptr> convolution_layer_updater_plain::get_algorithm_alternatives() const
+		{
+			std::vector<layer_updater_plain::const_ptr> res;
+			if (!gemm)
+				res.push_back(layer_updater_plain::const_ptr(new convolution_layer_updater_plain(true)));
+			return res;
+		}
+
 		void convolution_layer_updater_plain::run_forward_propagation(
 			plain_buffer::ptr output_buffer,
 			const std::vector<plain_buffer::const_ptr>& input_buffers,
@@ -46,6 +66,20 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
+			if (gemm)
+			{
+				convolution_gemm_plain::run_forward_propagation(
+					*output_buffer,
+					*input_buffers[0],
+					plain_config,
+					layer_schema,
+					data,
+					input_configuration_specific_list[0],
+					output_configuration_specific,
+					entry_count);
+				return;
+			}
+
 			const unsigned int input_neuron_count = input_configuration_specific_list[0].get_neuron_count();
 			const unsigned int input_neuron_count_per_feature_map = input_configuration_specific_list[0].get_neuron_count_per_feature_map();
 			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
@@ -120,13 +154,12 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const std::vector<unsigned int>::const_iterator dilation_it = dilation.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (entry_id * output_feature_map_count);
@@ -190,7 +223,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		void convolution_layer_updater_plain::run_backward_data_propagation(
@@ -283,13 +316,12 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const std::vector<unsigned int>::const_iterator dilation_it = dilation.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / input_feature_map_count;
 					int input_feature_map_id = workload_id - (entry_id * input_feature_map_count);
@@ -359,7 +391,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		void convolution_layer_updater_plain::run_backward_weights_propagation(
@@ -452,14 +484,13 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator dilation_it = dilation.begin();
 			const int const_updater_count = entry_count;
 
-			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 				std::vector<float> weights_local(const_window_elem_count, 0.0F);
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int feature_map_pair_id = workload_id;
 					int output_feature_map_id = feature_map_pair_id / input_feature_map_count;
@@ -529,30 +560,32 @@ namespace nnforge
 					for(std::vector<float>::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
 						*it += *weights_local_it;
 				}
-			}
+			});
 
 			if (bias)
 			{
 				const std::vector<float>::iterator gradient_biases = (*gradient)[1].begin();
 				const int total_workload_bias = output_feature_map_count;
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_workload_bias; ++workload_id)
+				plain_config->parallel_for(total_workload_bias, [&] (int begin, int end)
 				{
-					int output_feature_map_id = workload_id;
-
-					float sum = 0.0F;
-					for(int entry_id = 0; entry_id < const_updater_count; ++entry_id)
+					for(int workload_id = begin; workload_id < end; ++workload_id)
 					{
-						float local_sum = 0.0F;
-						const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
-						for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
-							local_sum += *out_err_it;
+						int output_feature_map_id = workload_id;
 
-						sum += local_sum;
-					}
+						float sum = 0.0F;
+						for(int entry_id = 0; entry_id < const_updater_count; ++entry_id)
+						{
+							float local_sum = 0.0F;
+							const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
+							for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
+								local_sum += *out_err_it;
 
-					*(gradient_biases + output_feature_map_id) += sum;
-				}
+							sum += local_sum;
+						}
+
+						*(gradient_biases + output_feature_map_id) += sum;
+					}
+				});
 			}
 		}
 
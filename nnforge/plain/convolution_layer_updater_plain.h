@@ -25,12 +25,16 @@ namespace nnforge
 		class convolution_layer_updater_plain : public layer_updater_plain
 		{
 		public:
-			convolution_layer_updater_plain() = default;
+			convolution_layer_updater_plain(bool gemm = false);
 
 			virtual ~convolution_layer_updater_plain() = default;
 
 			virtual std::string get_type_name() const;
 
+			virtual std::string get_algorithm_name() const;
+
+			virtual std::vector<layer_updater_plain::const_ptr> get_algorithm_alternatives() const;
+
 			virtual void run_forward_propagation(
 				plain_buffer::ptr output_buffer,
 				const std::vector<plain_buffer::const_ptr>& input_buffers,
@@ -105,6 +109,9 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+		private:
+			bool gemm;
+
 		private:
 			static const int max_dimension_count;
 		};
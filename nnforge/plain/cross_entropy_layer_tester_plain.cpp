@@ -57,10 +57,9 @@ namespace nnforge
 			const float scale = layer_derived->scale;
 			const int total_workload = entry_count * output_neuron_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_neuron_count;
 					int output_neuron_id = workload_id - (entry_id * output_neuron_count);
@@ -95,7 +94,7 @@ namespace nnforge
 
 					*(out_it_global + output_offset) = err;
 				}
-			}
+			});
 		}
 	}
 }
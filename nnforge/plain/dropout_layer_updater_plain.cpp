@@ -61,37 +61,44 @@ namespace nnforge
 			std::uniform_real_distribution<float> dist(0.0F, 1.0F);
 
 			const int total_workload = (layer_derived->per_feature_map ? output_configuration_specific.feature_map_count : output_configuration_specific.get_neuron_count()) * entry_count;
-			for(int i = 0; i < total_workload; ++i)
-				keep_elem_ptr[i] = (dist(gen) <= keep_rate ? (unsigned char)1 : (unsigned char)0);
+			{
+				std::lock_guard<std::mutex> lock(gen_mutex);
+				for(int i = 0; i < total_workload; ++i)
+					keep_elem_ptr[i] = (dist(gen) <= keep_rate ? (unsigned char)1 : (unsigned char)0);
+			}
 
 			if (layer_derived->per_feature_map)
 			{
 				const int elem_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
-				#pragma omp parallel for default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr) schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				plain_config->parallel_for(total_workload, [&] (int begin, int end)
 				{
-					int base_elem_id = workload_id * elem_count_per_feature_map;
-					float * out_it = out_it_global + base_elem_id;
-					if (keep_elem_ptr[workload_id])
+					for(int workload_id = begin; workload_id < end; ++workload_id)
 					{
-						const float * in_it = in_it_global + base_elem_id;
-						for(int elem_id = 0; elem_id < elem_count_per_feature_map; ++elem_id)
-							*(out_it + elem_id) = *(in_it + elem_id) * mult;
-					}
-					else
-					{
-						std::fill_n(out_it, elem_count_per_feature_map, 0.0F);
+						int base_elem_id = workload_id * elem_count_per_feature_map;
+						float * out_it = out_it_global + base_elem_id;
+						if (keep_elem_ptr[workload_id])
+						{
+							const float * in_it = in_it_global + base_elem_id;
+							for(int elem_id = 0; elem_id < elem_count_per_feature_map; ++elem_id)
+								*(out_it + elem_id) = *(in_it + elem_id) * mult;
+						}
+						else
+						{
+							std::fill_n(out_it, elem_count_per_feature_map, 0.0F);
+						}
 					}
-				}
+				});
 			}
 			else
 			{
-				#pragma omp parallel for default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr) schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				plain_config->parallel_for(total_workload, [&] (int begin, int end)
 				{
-					int elem_id = workload_id;
-					*(out_it_global + elem_id) = *(in_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
-				}
+					for(int workload_id = begin; workload_id < end; ++workload_id)
+					{
+						int elem_id = workload_id;
+						*(out_it_global + elem_id) = *(in_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
+					}
+				});
 			}
 		}
 
@@ -130,27 +137,31 @@ namespace nnforge
 				if (layer_derived->per_feature_map)
 				{
 					const int elem_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
-					#pragma omp parallel for default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr) schedule(guided)
-					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					plain_config->parallel_for(total_workload, [&] (int begin, int end)
 					{
-						int base_elem_id = workload_id * elem_count_per_feature_map;
-						float * in_err_it = in_err_it_global + base_elem_id;
-						if (keep_elem_ptr[workload_id])
+						for(int workload_id = begin; workload_id < end; ++workload_id)
 						{
-							const float * out_err_it = out_err_it_global + base_elem_id;
-							for(int elem_id = 0; elem_id < elem_count_per_feature_map; ++elem_id)
-								*(in_err_it + elem_id) += *(out_err_it + elem_id) * mult;
+							int base_elem_id = workload_id * elem_count_per_feature_map;
+							float * in_err_it = in_err_it_global + base_elem_id;
+							if (keep_elem_ptr[workload_id])
+							{
+								const float * out_err_it = out_err_it_global + base_elem_id;
+								for(int elem_id = 0; elem_id < elem_count_per_feature_map; ++elem_id)
+									*(in_err_it + elem_id) += *(out_err_it + elem_id) * mult;
+							}
 						}
-					}
+					});
 				}
 				else
 				{
-					#pragma omp parallel for default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr) schedule(guided)
-					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					plain_config->parallel_for(total_workload, [&] (int begin, int end)
 					{
-						int elem_id = workload_id;
-						*(in_err_it_global + elem_id) += *(out_err_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
-					}
+						for(int workload_id = begin; workload_id < end; ++workload_id)
+						{
+							int elem_id = workload_id;
+							*(in_err_it_global + elem_id) += *(out_err_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
+						}
+					});
 				}
 			}
 			else
@@ -158,31 +169,35 @@ namespace nnforge
 				if (layer_derived->per_feature_map)
 				{
 					const int elem_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
-					#pragma omp parallel for default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr) schedule(guided)
-					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					plain_config->parallel_for(total_workload, [&] (int begin, int end)
 					{
-						int base_elem_id = workload_id * elem_count_per_feature_map;
-						float * in_err_it = in_err_it_global + base_elem_id;
-						if (keep_elem_ptr[workload_id])
-						{
-							const float * out_err_it = out_err_it_global + base_elem_id;
-							for(int elem_id = 0; elem_id < elem_count_per_feature_map; ++elem_id)
-								*(in_err_it + elem_id) = *(out_err_it + elem_id) * mult;
-						}
-						else
+						for(int workload_id = begin; workload_id < end; ++workload_id)
 						{
-							std::fill_n(in_err_it, elem_count_per_feature_map, 0.0F);
+							int base_elem_id = workload_id * elem_count_per_feature_map;
+							float * in_err_it = in_err_it_global + base_elem_id;
+							if (keep_elem_ptr[workload_id])
+							{
+								const float * out_err_it = out_err_it_global + base_elem_id;
+								for(int elem_id = 0; elem_id < elem_count_per_feature_map; ++elem_id)
+									*(in_err_it + elem_id) = *(out_err_it + elem_id) * mult;
+							}
+							else
+							{
+								std::fill_n(in_err_it, elem_count_per_feature_map, 0.0F);
+							}
 						}
-					}
+					});
 				}
 				else
 				{
-					#pragma omp parallel for default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr) schedule(guided)
-					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					plain_config->parallel_for(total_workload, [&] (int begin, int end)
 					{
-						int elem_id = workload_id;
-						*(in_err_it_global + elem_id) = *(out_err_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
-					}
+						for(int workload_id = begin; workload_id < end; ++workload_id)
+						{
+							int elem_id = workload_id;
+							*(in_err_it_global + elem_id) = *(out_err_it_global + elem_id) * (keep_elem_ptr[elem_id] ? mult : 0.0F);
+						}
+					});
 				}
 			}
 		}
@@ -231,5 +246,10 @@ namespace nnforge
 			std::shared_ptr<const dropout_layer> layer_derived = std::dynamic_pointer_cast<const dropout_layer>(layer_schema);
 			return (layer_derived->per_feature_map ? output_configuration_specific.feature_map_count : output_configuration_specific.get_neuron_count()) * sizeof(unsigned char);
 		}
+
+		bool dropout_layer_updater_plain::is_forward_deterministic() const
+		{
+			return false;
+		}
 	}
 }
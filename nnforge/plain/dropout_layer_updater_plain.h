@@ -19,6 +19,8 @@
 #include "layer_updater_plain.h"
 #include "../rnd.h"
 
+#include <mutex>
+
 namespace nnforge
 {
 	namespace plain
@@ -98,8 +100,12 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			virtual bool is_forward_deterministic() const;
+
 		private:
 			mutable random_generator gen;
+			// The same updater is used by all dropout layers, which might run concurrently with inter-op parallelism
+			mutable std::mutex gen_mutex;
 		};
 	}
 }
@@ -53,10 +53,9 @@ namespace nnforge
 			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
 			const int output_feature_map_count = output_configuration_specific.feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
 					int neuron_id = workload_id - entry_id * neuron_count_per_feature_map;
@@ -83,7 +82,7 @@ namespace nnforge
 						out_it_base[output_index * neuron_count_per_feature_map] = sum;
 					}
 				}
-			}
+			});
 		}
 	}
 }
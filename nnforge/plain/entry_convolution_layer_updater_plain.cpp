@@ -55,10 +55,9 @@ namespace nnforge
 			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
 			const int output_feature_map_count = output_configuration_specific.feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
 					int neuron_id = workload_id - entry_id * neuron_count_per_feature_map;
@@ -85,7 +84,7 @@ namespace nnforge
 						out_it_base[output_index * neuron_count_per_feature_map] = sum;
 					}
 				}
-			}
+			});
 		}
 
 		void entry_convolution_layer_updater_plain::run_backward_data_propagation(
@@ -119,10 +118,9 @@ namespace nnforge
 			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
 			const int output_feature_map_count = output_configuration_specific.feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
 					int neuron_id = workload_id - entry_id * neuron_count_per_feature_map;
@@ -159,7 +157,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		bool entry_convolution_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
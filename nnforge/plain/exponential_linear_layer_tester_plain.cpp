@@ -44,12 +44,14 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
 			{
-				float input_val = *(in_it + i);
-				*(out_it + i) = input_val >= 0.0F ? input_val : (expf(input_val) - 1.0F);
-			}
+				for(int i = begin; i < end; ++i)
+				{
+					float input_val = *(in_it + i);
+					*(out_it + i) = input_val >= 0.0F ? input_val : (expf(input_val) - 1.0F);
+				}
+			});
 		}
 
 		int exponential_linear_layer_tester_plain::get_input_index_layer_can_write(
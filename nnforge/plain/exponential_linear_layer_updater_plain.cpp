@@ -47,13 +47,15 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
 			{
-				float inp = *(in_it + i);
-				float res = inp >= 0.0F ? inp : (expf(inp) - 1.0F);
-				*(out_it + i) = res;
-			}
+				for(int i = begin; i < end; ++i)
+				{
+					float inp = *(in_it + i);
+					float res = inp >= 0.0F ? inp : (expf(inp) - 1.0F);
+					*(out_it + i) = res;
+				}
+			});
 		}
 
 		void exponential_linear_layer_updater_plain::run_backward_data_propagation(
@@ -82,23 +84,27 @@ namespace nnforge
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					float out_neuron = *(out_it + i);
-					float der1st = (out_neuron >= 0) ? 1.0F : (out_neuron + 1.0F);
-					*(in_err_it + i) += *(out_err_it + i) * der1st;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						float out_neuron = *(out_it + i);
+						float der1st = (out_neuron >= 0) ? 1.0F : (out_neuron + 1.0F);
+						*(in_err_it + i) += *(out_err_it + i) * der1st;
+					}
+				});
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					float out_neuron = *(out_it + i);
-					float der1st = (out_neuron >= 0) ? 1.0F : (out_neuron + 1.0F);
-					*(in_err_it + i) = *(out_err_it + i) * der1st;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						float out_neuron = *(out_it + i);
+						float der1st = (out_neuron >= 0) ? 1.0F : (out_neuron + 1.0F);
+						*(in_err_it + i) = *(out_err_it + i) * der1st;
+					}
+				});
 			}
 		}
 
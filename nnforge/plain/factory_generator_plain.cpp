@@ -18,8 +18,12 @@
 
 #include "forward_propagation_plain_factory.h"
 #include "backward_propagation_plain_factory.h"
+#include "plain_shared_memory_communicator.h"
+#include "plain_tcp_communicator.h"
+#include "../neural_network_exception.h"
 
 #include <iostream>
+#include <boost/format.hpp>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -31,17 +35,57 @@ namespace nnforge
 	{
 		factory_generator_plain::factory_generator_plain(
 			float plain_max_global_memory_usage,
-			int plain_openmp_thread_count)
+			int plain_openmp_thread_count,
+			bool plain_activation_checkpointing,
+			const std::vector<std::string>& plain_activation_checkpoint_layer_names,
+			bool plain_inter_op_parallelism,
+			bool plain_bind_threads,
+			bool plain_numa_aware,
+			bool plain_perf_counters,
+			bool plain_autotune,
+			const std::string& plain_autotune_cache_file,
+			bool plain_cache_aware_chunk_size,
+			const std::string& plain_communicator_type,
+			const std::vector<std::string>& plain_tcp_peer_addresses,
+			int plain_async_sgd_worker_count,
+			float plain_selective_backprop_rate)
 			: plain_max_global_memory_usage(plain_max_global_memory_usage)
 			, plain_openmp_thread_count(plain_openmp_thread_count)
+			, plain_activation_checkpointing(plain_activation_checkpointing)
+			, plain_activation_checkpoint_layer_names(plain_activation_checkpoint_layer_names)
+			, plain_inter_op_parallelism(plain_inter_op_parallelism)
+			, plain_bind_threads(plain_bind_threads)
+			, plain_numa_aware(plain_numa_aware)
+			, plain_perf_counters(plain_perf_counters)
+			, plain_autotune(plain_autotune)
+			, plain_autotune_cache_file(plain_autotune_cache_file)
+			, plain_cache_aware_chunk_size(plain_cache_aware_chunk_size)
+			, plain_communicator_type(plain_communicator_type)
+			, plain_tcp_peer_addresses(plain_tcp_peer_addresses)
+			, plain_async_sgd_worker_count(plain_async_sgd_worker_count)
+			, plain_selective_backprop_rate(plain_selective_backprop_rate)
 		{
 		}
 
 		void factory_generator_plain::initialize()
 		{
+			plain_running_configuration::options running_options;
+			running_options.activation_checkpointing = plain_activation_checkpointing;
+			running_options.activation_checkpoint_layer_names = plain_activation_checkpoint_layer_names;
+			running_options.inter_op_parallelism = plain_inter_op_parallelism;
+			running_options.bind_threads = plain_bind_threads;
+			running_options.numa_aware = plain_numa_aware;
+			running_options.perf_counters = plain_perf_counters;
+			running_options.autotune = plain_autotune;
+			running_options.autotune_cache_file_path = plain_autotune_cache_file;
+			running_options.cache_aware_chunk_size = plain_cache_aware_chunk_size;
+			running_options.communicator = communicator;
+			running_options.async_sgd_worker_count = plain_async_sgd_worker_count;
+			running_options.selective_backprop_rate = plain_selective_backprop_rate;
 			plain_config = plain_running_configuration::const_ptr(new plain_running_configuration(
 				plain_openmp_thread_count,
-				plain_max_global_memory_usage));
+				plain_max_global_memory_usage,
+				running_options));
 		}
 
 		forward_propagation_factory::ptr factory_generator_plain::create_forward_propagation_factory() const
@@ -54,11 +98,47 @@ namespace nnforge
 			return backward_propagation_factory::ptr(new backward_propagation_plain_factory(plain_config));
 		}
 
+		std::vector<string_option> factory_generator_plain::get_string_options()
+		{
+			std::vector<string_option> res;
+
+			res.push_back(string_option("plain_autotune_cache_file", &plain_autotune_cache_file, "", "File the autotuning results are kept in across runs, keyed by CPU model, layer configuration and chunk size. Empty value means tuning on each run"));
+			res.push_back(string_option("plain_communicator", &plain_communicator_type, "shared_memory", "How worker processes exchange gradients (shared_memory, tcp). shared_memory works for the processes on the same host only"));
+
+			return res;
+		}
+
+		std::vector<multi_string_option> factory_generator_plain::get_multi_string_options()
+		{
+			std::vector<multi_string_option> res;
+
+			res.push_back(multi_string_option("plain_activation_checkpoint_layer_name", &plain_activation_checkpoint_layer_names, "Names of the layers which outputs are kept when doing activation checkpointing, chosen automatically when empty"));
+			res.push_back(multi_string_option("plain_tcp_peer", &plain_tcp_peer_addresses, "Addresses of worker processes in the form host:port, one for each rank in the order of ranks, used by tcp communicator"));
+
+			return res;
+		}
+
+		std::vector<bool_option> factory_generator_plain::get_bool_options()
+		{
+			std::vector<bool_option> res;
+
+			res.push_back(bool_option("plain_activation_checkpointing", &plain_activation_checkpointing, false, "Keep only checkpoint layer outputs during training and recompute the rest of activations when running backward pass, trading compute for memory"));
+			res.push_back(bool_option("plain_inter_op_parallelism", &plain_inter_op_parallelism, false, "Run independent branches of the network concurrently, splitting OpenMP threads between them. Requires more memory as buffers of concurrent actions cannot be shared"));
+			res.push_back(bool_option("plain_bind_threads", &plain_bind_threads, false, "Bind threads of plain task runtime to CPU cores"));
+			res.push_back(bool_option("plain_numa_aware", &plain_numa_aware, false, "Spread threads over NUMA nodes, keep them there and place buffers on the nodes of the threads processing them"));
+			res.push_back(bool_option("plain_perf_counters", &plain_perf_counters, false, "Collect hardware performance counters per layer action in profile mode, threads running the layers are counted only (Linux only)"));
+			res.push_back(bool_option("plain_autotune", &plain_autotune, false, "Time alternative algorithms of layers for each configuration on first use and run the fastest one. Results might differ slightly from the default algorithms due to different order of summation"));
+			res.push_back(bool_option("plain_cache_aware_chunk_size", &plain_cache_aware_chunk_size, false, "Limit the number of entries processed at once so that inputs and outputs of each layer fit L2 and L3 caches, instead of filling plain_max_global_memory_usage"));
+
+			return res;
+		}
+
 		std::vector<float_option> factory_generator_plain::get_float_options()
 		{
 			std::vector<float_option> res;
 
 			res.push_back(float_option("plain_max_global_memory_usage,M", &plain_max_global_memory_usage, 0.5F, "memory to be used by single plain configuration, in GB."));
+			res.push_back(float_option("plain_selective_backprop_rate", &plain_selective_backprop_rate, 1.0F, "Run backward pass only for this fraction of entries of each chunk, the ones with the largest error, reusing activations of forward pass run for all of them. Layers with tiling are not supported. 1 means backward pass for all the entries"));
 
 			return res;
 		}
@@ -70,6 +150,7 @@ namespace nnforge
 			#ifdef _OPENMP
 			res.push_back(int_option("plain_openmp_thread_count", &plain_openmp_thread_count, omp_get_max_threads(), "count of threads to be used in OpenMP."));
 			#endif
+			res.push_back(int_option("plain_async_sgd_worker_count", &plain_async_sgd_worker_count, 0, "Train with this many workers asynchronously (Hogwild): each one applies its own gradient after at most batch_size entries to the shared weights without locking, keeping its own momentum. 0 means synchronous training"));
 
 			return res;
 		}
@@ -78,5 +159,42 @@ namespace nnforge
 		{
 			std::cout << *plain_config;
 		}
+
+		bool factory_generator_plain::set_thread_count(int thread_count)
+		{
+			plain_openmp_thread_count = thread_count;
+			initialize();
+			return true;
+		}
+
+		bool factory_generator_plain::set_worker_process(
+			unsigned int rank,
+			unsigned int worker_count,
+			const std::string& group_name)
+		{
+			communicator.reset();
+			if (worker_count > 1)
+			{
+				if (plain_communicator_type == "shared_memory")
+				{
+					communicator = plain_communicator::ptr(new plain_shared_memory_communicator(group_name, rank, worker_count));
+				}
+				else if (plain_communicator_type == "tcp")
+				{
+					if (plain_tcp_peer_addresses.size() != worker_count)
+						throw neural_network_exception((boost::format("%1% plain_tcp_peer addresses specified for %2% worker processes") % plain_tcp_peer_addresses.size() % worker_count).str());
+					communicator = plain_communicator::ptr(new plain_tcp_communicator(plain_tcp_peer_addresses, rank));
+				}
+				else
+					throw neural_network_exception((boost::format("Invalid plain_communicator: %1%") % plain_communicator_type).str());
+			}
+			initialize();
+			return true;
+		}
+
+		plain_running_configuration::const_ptr factory_generator_plain::get_plain_running_configuration() const
+		{
+			return plain_config;
+		}
 	}
 }
@@ -28,7 +28,20 @@ namespace nnforge
 		public:
 			factory_generator_plain(
 				float plain_max_global_memory_usage,
-				int plain_openmp_thread_count);
+				int plain_openmp_thread_count,
+				bool plain_activation_checkpointing,
+				const std::vector<std::string>& plain_activation_checkpoint_layer_names,
+				bool plain_inter_op_parallelism,
+				bool plain_bind_threads,
+				bool plain_numa_aware,
+				bool plain_perf_counters,
+				bool plain_autotune,
+				const std::string& plain_autotune_cache_file,
+				bool plain_cache_aware_chunk_size,
+				const std::string& plain_communicator_type,
+				const std::vector<std::string>& plain_tcp_peer_addresses,
+				int plain_async_sgd_worker_count,
+				float plain_selective_backprop_rate);
 
 			factory_generator_plain() = default;
 
@@ -42,6 +55,21 @@ namespace nnforge
 
 			virtual void info() const;
 
+			virtual bool set_thread_count(int thread_count);
+
+			virtual bool set_worker_process(
+				unsigned int rank,
+				unsigned int worker_count,
+				const std::string& group_name);
+
+			plain_running_configuration::const_ptr get_plain_running_configuration() const;
+
+			virtual std::vector<string_option> get_string_options();
+
+			virtual std::vector<multi_string_option> get_multi_string_options();
+
+			virtual std::vector<bool_option> get_bool_options();
+
 			virtual std::vector<float_option> get_float_options();
 
 			virtual std::vector<int_option> get_int_options();
@@ -49,6 +77,21 @@ namespace nnforge
 		protected:
 			float plain_max_global_memory_usage;
 			int plain_openmp_thread_count;
+			bool plain_activation_checkpointing;
+			std::vector<std::string> plain_activation_checkpoint_layer_names;
+			bool plain_inter_op_parallelism;
+			bool plain_bind_threads;
+			bool plain_numa_aware;
+			bool plain_perf_counters;
+			bool plain_autotune;
+			std::string plain_autotune_cache_file;
+			bool plain_cache_aware_chunk_size;
+			std::string plain_communicator_type;
+			std::vector<std::string> plain_tcp_peer_addresses;
+			int plain_async_sgd_worker_count;
+			float plain_selective_backprop_rate;
+
+			plain_communicator::ptr communicator;
 
 			plain_running_configuration::const_ptr plain_config;
 		};
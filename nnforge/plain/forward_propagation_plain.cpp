@@ -22,6 +22,7 @@
 #include <boost/format.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <chrono>
+#include <atomic>
 
 #include "../neural_network_exception.h"
 
@@ -40,30 +41,51 @@ namespace nnforge
 			: forward_propagation(schema, output_layer_names, debug, profile)
 			, plain_config(plain_config)
 			, max_entry_count(0)
+			, cache_aware_entry_count(0)
 			, temporary_working_fixed_size(0)
 		{
 			actions_in_execution_order = action_schema->get_actions_in_execution_order();
 
-			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
-			network_action_schema::ptr sequential_action_schema(new network_action_schema());
+			if (plain_config->inter_op_parallelism)
 			{
-				std::vector<layer_name_with_action> dependencies;
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				// Independent branches run concurrently, buffers are planned on the original action graph so that concurrent actions never share them
+				action_stream_runner = plain_action_stream_runner::const_ptr(new plain_action_stream_runner(*action_schema, plain_config));
+
+				if (debug->is_debug())
 				{
-					sequential_action_schema->add_action(
-						this->schema->get_layer(it->get_name()),
-						it->get_action(),
-						dependencies);
-					dependencies.clear();
-					dependencies.push_back(*it);
+					std::map<layer_name_with_action, unsigned int> action_to_worker_map;
+					const std::vector<std::vector<layer_name_with_action> >& worker_action_list = action_stream_runner->get_worker_action_list();
+					for(unsigned int worker_id = 0; worker_id < static_cast<unsigned int>(worker_action_list.size()); ++worker_id)
+						for(std::vector<layer_name_with_action>::const_iterator it = worker_action_list[worker_id].begin(); it != worker_action_list[worker_id].end(); ++it)
+							action_to_worker_map.insert(std::make_pair(*it, worker_id));
+					debug->output_message((boost::format("forward prop plain concurrent workers: %1%") % action_stream_runner->get_worker_count()).str().c_str());
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_workers", "gv"), std::ios_base::out | std::ios_base::trunc);
+					action_schema->write_gv(out, action_to_worker_map);
 				}
 			}
-			action_schema = sequential_action_schema;
-
-			if (debug->is_debug())
+			else
 			{
-				boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
-				action_schema->write_gv(out);
+				// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
+				network_action_schema::ptr sequential_action_schema(new network_action_schema());
+				{
+					std::vector<layer_name_with_action> dependencies;
+					for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					{
+						sequential_action_schema->add_action(
+							this->schema->get_layer(it->get_name()),
+							it->get_action(),
+							dependencies);
+						dependencies.clear();
+						dependencies.push_back(*it);
+					}
+				}
+				action_schema = sequential_action_schema;
+
+				if (debug->is_debug())
+				{
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
+					action_schema->write_gv(out);
+				}
 			}
 
 			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
@@ -95,49 +117,98 @@ namespace nnforge
 			if (reader_entry_count > 0)
 				current_max_entry_count = std::min(current_max_entry_count, static_cast<unsigned int>(reader_entry_count));
 			current_max_entry_count = std::min(current_max_entry_count, max_max_entry_count);
+			if (cache_aware_entry_count > 0)
+				current_max_entry_count = std::min(current_max_entry_count, cache_aware_entry_count);
 			const int current_max_entry_count_const = static_cast<int>(current_max_entry_count);
+			chunk_size = current_max_entry_count;
 
 			std::map<std::string, plain_buffer::ptr> dedicated_buffers;
 			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
 				dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * current_max_entry_count))));
 
-			plain_buffer::ptr temporary_working_fixed_buffer;
+			// Each of the concurrently running actions needs its own fixed working buffer
+			std::vector<plain_buffer::ptr> temporary_working_fixed_buffers(action_stream_runner ? action_stream_runner->get_worker_count() : 1);
 			if (temporary_working_fixed_size > 0)
-				temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
+				for(std::vector<plain_buffer::ptr>::iterator it = temporary_working_fixed_buffers.begin(); it != temporary_working_fixed_buffers.end(); ++it)
+					*it = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
 
 			std::vector<plain_buffer::ptr> layer_buffers;
 			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
 				layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * current_max_entry_count)));
 
+			// Per-entry buffers are processed in ranges of entries, each range is placed on the NUMA node of the thread it is dealt to
+			for(std::map<std::string, plain_buffer::ptr>::const_iterator it = dedicated_buffers.begin(); it != dedicated_buffers.end(); ++it)
+				plain_config->first_touch(*it->second, current_max_entry_count);
+			for(std::vector<plain_buffer::ptr>::const_iterator it = layer_buffers.begin(); it != layer_buffers.end(); ++it)
+				plain_config->first_touch(**it, current_max_entry_count);
+
 			unsigned int entry_processed_count = 0;
 			double total_idel_sec = 0.0;
 
+			// All the keys are inserted upfront, so that concurrently running actions update different elements only
+			std::map<layer_name_with_action, double> action_seconds_accumulated;
+			if (profile->is_profile())
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					action_seconds_accumulated.insert(std::make_pair(*it, 0.0));
+
+			plain_perf_counter_collector::ptr perf_counters;
+			std::map<layer_name_with_action, profile_util::hardware_counters> action_counters;
+			if (profile->is_profile() && plain_config->perf_counters)
+			{
+				if (action_stream_runner)
+					profile->output_message("Hardware counters are not collected when running actions concurrently");
+				else
+				{
+					perf_counters = plain_perf_counter_collector::ptr(new plain_perf_counter_collector(plain_config->get_os_thread_id_list()));
+					if (perf_counters->is_available())
+					{
+						for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+							action_counters.insert(std::make_pair(*it, profile_util::hardware_counters()));
+					}
+					else
+					{
+						profile->output_message("Hardware counters are not available");
+						perf_counters.reset();
+					}
+				}
+			}
+
 			while(true)
 			{
-				int entry_read_count = 0;
+				std::atomic<int> entry_read_count_accumulated(0);
 				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
-				#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count) reduction(+:entry_read_count)
+				plain_config->parallel_for(current_max_entry_count_const, [&] (int begin, int end)
 				{
-					#pragma omp for schedule(dynamic)
-					for(int entry_id = 0; entry_id < current_max_entry_count_const; ++entry_id)
+					int local_entry_read_count = 0;
+					for(int entry_id = begin; entry_id < end; ++entry_id)
 					{
 						std::map<std::string, float *> data_map;
 						for(std::set<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
 							data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float))));
 						if (reader.read(entry_processed_count + entry_id, data_map))
-							++entry_read_count;
+							++local_entry_read_count;
 					}
-				}
-				std::chrono::duration<double> idle_sec = std::chrono::high_resolution_clock::now() - start;
+					entry_read_count_accumulated += local_entry_read_count;
+				});
+				int entry_read_count = entry_read_count_accumulated;
+				std::chrono::high_resolution_clock::time_point read_end = std::chrono::high_resolution_clock::now();
+				std::chrono::duration<double> idle_sec = read_end - start;
 				total_idel_sec += idle_sec.count();
+				profile->add_trace_event("reader", "read", start, read_end);
 
 				if (entry_read_count == 0)
 					break;
 
-				for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it  != actions_in_execution_order.end(); ++action_it)
+				auto run_action = [&] (const layer_name_with_action& current_layer_name_with_action, plain_running_configuration::const_ptr action_plain_config, unsigned int worker_id)
 				{
-					const layer_name_with_action& current_layer_name_with_action = *action_it;
-					std::string layer_name = current_layer_name_with_action.get_name();;
+					std::chrono::high_resolution_clock::time_point action_start;
+					if (profile->is_profile())
+						action_start = std::chrono::high_resolution_clock::now();
+					profile_util::hardware_counters counters_start;
+					if (perf_counters)
+						counters_start = perf_counters->read();
+
+					std::string layer_name = current_layer_name_with_action.get_name();
 					layer_action action = current_layer_name_with_action.get_action();
 					layer::const_ptr current_layer = schema->find_layer(layer_name);
 
@@ -174,17 +245,38 @@ namespace nnforge
 					testers.find(layer_name)->second->run_forward_propagation(
 						output_buffer,
 						input_buffers,
-						temporary_working_fixed_buffer,
+						temporary_working_fixed_buffers[worker_id],
 						temporary_working_per_entry_buffer,
-						plain_config,
+						action_plain_config,
 						current_layer,
 						net_data->data_list.find(layer_name),
 						net_data->data_custom_list.find(layer_name),
 						input_layer_configuration_specific_list,
 						layer_config_map[layer_name],
 						entry_read_count * cumulative_tiling_factor_map[layer_name]);
-				}
 
+					if (profile->is_profile())
+					{
+						std::chrono::high_resolution_clock::time_point action_end = std::chrono::high_resolution_clock::now();
+						std::chrono::duration<double> action_sec = action_end - action_start;
+						action_seconds_accumulated.find(current_layer_name_with_action)->second += action_sec.count();
+						profile->add_trace_event(current_layer_name_with_action.get_action().str().c_str(), layer_name, action_start, action_end);
+					}
+					if (perf_counters)
+					{
+						profile_util::hardware_counters action_counters_delta = perf_counters->read();
+						action_counters_delta -= counters_start;
+						action_counters.find(current_layer_name_with_action)->second += action_counters_delta;
+					}
+				};
+
+				if (action_stream_runner)
+					action_stream_runner->run(run_action);
+				else
+					for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it != actions_in_execution_order.end(); ++action_it)
+						run_action(*action_it, plain_config, 0);
+
+				std::chrono::high_resolution_clock::time_point write_start = std::chrono::high_resolution_clock::now();
 				for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
 				{
 					std::map<std::string, const float *> data_map;
@@ -192,6 +284,7 @@ namespace nnforge
 						data_map.insert(std::make_pair(*it, ((float *)(*dedicated_buffers[*it])) + entry_id * (dedicated_per_entry_data_name_to_size_map[*it] / sizeof(float) / output_layers_tiling_factor)));
 					writer.write(entry_processed_count + entry_id, data_map);
 				}
+				profile->add_trace_event("writer", "write", write_start, std::chrono::high_resolution_clock::now());
 
 				entry_processed_count += entry_read_count;
 
@@ -201,6 +294,24 @@ namespace nnforge
 
 			entries_processed = entry_processed_count;
 			action_seconds.clear();
+			for(std::map<layer_name_with_action, double>::const_iterator it = action_seconds_accumulated.begin(); it != action_seconds_accumulated.end(); ++it)
+				action_seconds.insert(std::make_pair(it->first, static_cast<float>(it->second)));
+
+			if (perf_counters)
+			{
+				std::map<std::string, std::string> layer_name_to_layer_type_map;
+				std::vector<layer::const_ptr> layer_list = schema->get_layers();
+				for(std::vector<layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+					layer_name_to_layer_type_map.insert(std::make_pair((*it)->instance_name, (*it)->get_type_name()));
+				profile_util::dump_layer_action_hardware_counters(
+					profile,
+					"forward_prop",
+					entry_processed_count,
+					action_flops_per_entry,
+					action_seconds,
+					action_counters,
+					layer_name_to_layer_type_map);
+			}
 			idle_seconds = static_cast<float>(total_idel_sec);
 		}
 
@@ -213,6 +324,119 @@ namespace nnforge
 			setup_temporary_working_fixed_buffer_sizes();
 
 			update_max_entry_count();
+
+			update_cache_aware_entry_count();
+
+			// Buffers are sized again for the algorithms picked
+			if (setup_autotuned_testers())
+			{
+				setup_dedicated_buffer_sizes();
+
+				setup_layer_buffer_sizes();
+
+				setup_temporary_working_fixed_buffer_sizes();
+
+				update_max_entry_count();
+
+				update_cache_aware_entry_count();
+			}
+		}
+
+		bool forward_propagation_plain::setup_autotuned_testers()
+		{
+			if (!plain_config->autotuner)
+				return false;
+
+			unsigned int entry_count = std::min(std::min(max_entry_count, max_max_entry_count), plain_autotuner::max_entry_count);
+			if (cache_aware_entry_count > 0)
+				entry_count = std::min(entry_count, cache_aware_entry_count);
+			entry_count = std::max(entry_count, 1U);
+
+			bool testers_replaced = false;
+			for(std::map<std::string, layer_tester_plain::const_ptr>::iterator it = testers.begin(); it != testers.end(); ++it)
+			{
+				layer::const_ptr l = schema->get_layer(it->first);
+				layer_tester_plain::const_ptr registered_tester = layer_tester_plain_factory::get_singleton().get_tester_plain_layer(l->get_type_name());
+				std::vector<layer_tester_plain::const_ptr> candidates = registered_tester->get_algorithm_alternatives();
+				if (candidates.empty())
+					continue;
+				candidates.insert(candidates.begin(), registered_tester);
+
+				layer_configuration_specific output_layer_configuration_specific = layer_config_map[it->first];
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+
+				std::string key = plain_config->autotuner->get_key("forward", plain_config->openmp_thread_count, entry_count, l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+				std::string algorithm_name;
+				if (!plain_config->autotuner->find(key, algorithm_name))
+				{
+					std::vector<plain_buffer::const_ptr> input_buffers;
+					for(std::vector<layer_configuration_specific>::const_iterator it2 = input_layer_configuration_specific_list.begin(); it2 != input_layer_configuration_specific_list.end(); ++it2)
+					{
+						size_t elem_count = it2->get_neuron_count() * entry_count;
+						plain_buffer::ptr input_buffer(new plain_buffer(elem_count * sizeof(float)));
+						std::fill_n((float *)*input_buffer, elem_count, 0.01F);
+						input_buffers.push_back(input_buffer);
+					}
+					plain_buffer::ptr output_buffer(new plain_buffer(output_layer_configuration_specific.get_neuron_count() * entry_count * sizeof(float)));
+					layer_data::ptr data = l->create_layer_data();
+					data->fill(0.01F);
+					layer_data_custom::ptr data_custom = l->create_layer_data_custom();
+
+					std::stringstream debug_str;
+					double best_seconds = 0.0;
+					for(std::vector<layer_tester_plain::const_ptr>::const_iterator candidate_it = candidates.begin(); candidate_it != candidates.end(); ++candidate_it)
+					{
+						layer_tester_plain::const_ptr candidate = *candidate_it;
+						plain_buffer::ptr temporary_working_fixed_buffer;
+						size_t temporary_working_fixed_buffer_size = candidate->get_temporary_working_fixed_buffer_size(plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+						if (temporary_working_fixed_buffer_size > 0)
+							temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_buffer_size));
+						plain_buffer::ptr temporary_working_per_entry_buffer;
+						size_t temporary_working_per_entry_buffer_size = candidate->get_temporary_working_per_entry_buffer_size(plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific);
+						if (temporary_working_per_entry_buffer_size > 0)
+							temporary_working_per_entry_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_per_entry_buffer_size * entry_count));
+
+						double seconds = plain_config->autotuner->measure([&] () {
+							candidate->run_forward_propagation(
+								output_buffer,
+								input_buffers,
+								temporary_working_fixed_buffer,
+								temporary_working_per_entry_buffer,
+								plain_config,
+								l,
+								data,
+								data_custom,
+								input_layer_configuration_specific_list,
+								output_layer_configuration_specific,
+								entry_count);
+						});
+						debug_str << " " << candidate->get_algorithm_name() << "=" << (seconds * 1000.0) << "ms";
+						if ((candidate_it == candidates.begin()) || (seconds < best_seconds))
+						{
+							best_seconds = seconds;
+							algorithm_name = candidate->get_algorithm_name();
+						}
+					}
+					plain_config->autotuner->store(key, algorithm_name);
+
+					if (debug->is_debug())
+						debug->output_message((boost::format("forward prop plain autotuned %1%:%2%, picked %3%") % it->first % debug_str.str() % algorithm_name).str().c_str());
+				}
+
+				for(std::vector<layer_tester_plain::const_ptr>::const_iterator candidate_it = candidates.begin(); candidate_it != candidates.end(); ++candidate_it)
+				{
+					if ((*candidate_it)->get_algorithm_name() == algorithm_name)
+					{
+						testers_replaced = testers_replaced || (it->second != *candidate_it);
+						it->second = *candidate_it;
+						break;
+					}
+				}
+			}
+
+			return testers_replaced;
 		}
 
 		void forward_propagation_plain::setup_dedicated_buffer_sizes()
@@ -426,7 +650,9 @@ namespace nnforge
 			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
 				buffer_configuration.add_per_entry_buffer(it->second);
 
-			buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
+			unsigned int worker_count = action_stream_runner ? action_stream_runner->get_worker_count() : 1;
+			for(unsigned int worker_id = 0; worker_id < worker_count; ++worker_id)
+				buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
 
 			max_entry_count = plain_config->get_max_entry_count(buffer_configuration);
 
@@ -442,5 +668,56 @@ namespace nnforge
 				debug->output_message(debug_str.str().c_str());
 			}
 		}
+
+		void forward_propagation_plain::update_cache_aware_entry_count()
+		{
+			cache_aware_entry_count = 0;
+			if (!plain_config->cache_aware_chunk_size)
+				return;
+
+			// Working set of the action is its inputs, output, and working buffer
+			size_t max_working_set_per_entry_size = 0;
+			std::string max_working_set_layer_name;
+			for(std::map<std::string, layer_tester_plain::const_ptr>::const_iterator it = testers.begin(); it != testers.end(); ++it)
+			{
+				const std::string& layer_name = it->first;
+				layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+				layer::const_ptr l = schema->get_layer(layer_name);
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				size_t working_set_per_entry_size = output_layer_configuration_specific.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+				{
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+					working_set_per_entry_size += layer_config_map[*it2].get_neuron_count() * cumulative_tiling_factor_map[*it2] * sizeof(float);
+				}
+				working_set_per_entry_size += it->second->get_temporary_working_per_entry_buffer_size(
+					plain_config,
+					l,
+					input_layer_configuration_specific_list,
+					output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
+
+				if (working_set_per_entry_size > max_working_set_per_entry_size)
+				{
+					max_working_set_per_entry_size = working_set_per_entry_size;
+					max_working_set_layer_name = layer_name;
+				}
+			}
+
+			cache_aware_entry_count = plain_config->get_cache_aware_entry_count(max_working_set_per_entry_size);
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "forward prop plain cache-aware packet size: " << cache_aware_entry_count
+					<< " (" << ((plain_config->cache_topology->get_capacity(plain_config->openmp_thread_count) + 1024 - 1) / 1024) << " KB of cache, "
+					<< ((max_working_set_per_entry_size + 1024 - 1) / 1024) << " KB per entry in " << max_working_set_layer_name << ")";
+				debug->output_message(debug_str.str().c_str());
+			}
+		}
+
+		float forward_propagation_plain::get_max_flops() const
+		{
+			return plain_config->get_flops();
+		}
 	}
 }
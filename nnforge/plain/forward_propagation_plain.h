@@ -19,6 +19,8 @@
 #include "../forward_propagation.h"
 #include "plain_running_configuration.h"
 #include "layer_tester_plain.h"
+#include "plain_action_stream_runner.h"
+#include "plain_perf_counter_collector.h"
 
 #include <map>
 
@@ -56,7 +58,13 @@ namespace nnforge
 			// The layer_config_map is guaranteed to be compatible with schema
 			virtual void layer_config_map_modified();
 
+			virtual float get_max_flops() const;
+
 		private:
+			// Picks the fastest algorithm for each layer having alternatives, when autotuning is on.
+			// Candidates are timed with the chunk size the buffers allow, the method returns true when it replaced any tester
+			bool setup_autotuned_testers();
+
 			void setup_dedicated_buffer_sizes();
 
 			void setup_layer_buffer_sizes();
@@ -65,12 +73,16 @@ namespace nnforge
 
 			void update_max_entry_count();
 
+			void update_cache_aware_entry_count();
+
 		private:
 			plain_running_configuration::const_ptr plain_config;
 
 			std::vector<layer_name_with_action> actions_in_execution_order;
 
 			std::map<std::string, layer_tester_plain::const_ptr> testers;
+			// Set when running independent actions concurrently
+			plain_action_stream_runner::const_ptr action_stream_runner;
 			network_data::const_ptr net_data;
 
 			size_t temporary_working_fixed_size;
@@ -82,6 +94,8 @@ namespace nnforge
 			std::map<std::string, size_t> dedicated_per_entry_data_name_to_size_map;
 
 			unsigned int max_entry_count;
+			// Entry count keeping inputs and outputs of each layer in cache, 0 when cache-aware chunk size is off
+			unsigned int cache_aware_entry_count;
 
 		private:
 			static const unsigned int max_max_entry_count;
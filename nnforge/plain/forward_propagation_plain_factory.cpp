@@ -35,5 +35,17 @@ namespace nnforge
 		{
 			return forward_propagation::ptr(new forward_propagation_plain(schema, output_layer_names, debug, profile, plain_config));
 		}
+
+		forward_propagation::ptr forward_propagation_plain_factory::create_in_group(
+			const network_schema& schema,
+			const std::vector<std::string>& output_layer_names,
+			unsigned int group_id,
+			unsigned int group_count,
+			debug_state::ptr debug,
+			profile_state::ptr profile) const
+		{
+			plain_running_configuration::const_ptr group_plain_config = plain_config->get_thread_partition_config_list(group_count).at(group_id);
+			return forward_propagation::ptr(new forward_propagation_plain(schema, output_layer_names, debug, profile, group_plain_config));
+		}
 	}
 }
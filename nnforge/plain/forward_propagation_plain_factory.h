@@ -36,6 +36,15 @@ namespace nnforge
 				debug_state::ptr debug,
 				profile_state::ptr profile) const;
 
+			// Threads are split between the groups, each of them runs its kernels on its own pool threads
+			virtual forward_propagation::ptr create_in_group(
+				const network_schema& schema,
+				const std::vector<std::string>& output_layer_names,
+				unsigned int group_id,
+				unsigned int group_count,
+				debug_state::ptr debug,
+				profile_state::ptr profile) const;
+
 		protected:
 			plain_running_configuration::const_ptr plain_config;
 		};
@@ -80,19 +80,23 @@ namespace nnforge
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					*(in_err_it + i) += *(out_err_it + i) * scale;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						*(in_err_it + i) += *(out_err_it + i) * scale;
+					}
+				});
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					*(in_err_it + i) = *(out_err_it + i) * scale;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						*(in_err_it + i) = *(out_err_it + i) * scale;
+					}
+				});
 			}
 		}
 
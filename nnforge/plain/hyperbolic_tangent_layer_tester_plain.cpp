@@ -48,14 +48,16 @@ namespace nnforge
 			const float hyperbolic_tangent_steepness2 = layer_derived->steepness * 2.0F;
 			const float hyperbolic_tangent_major_multiplier = layer_derived->scale;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
 			{
-				float inp = *(in_it + i);
-				float inp2 = expf(inp * hyperbolic_tangent_steepness2);
-				float res = (inp2 - 1.0F) / (inp2 + 1.0F) * hyperbolic_tangent_major_multiplier;
-				*(out_it + i) = res;
-			}
+				for(int i = begin; i < end; ++i)
+				{
+					float inp = *(in_it + i);
+					float inp2 = expf(inp * hyperbolic_tangent_steepness2);
+					float res = (inp2 - 1.0F) / (inp2 + 1.0F) * hyperbolic_tangent_major_multiplier;
+					*(out_it + i) = res;
+				}
+			});
 		}
 
 		int hyperbolic_tangent_layer_tester_plain::get_input_index_layer_can_write(
@@ -50,14 +50,16 @@ namespace nnforge
 			const float hyperbolic_tangent_steepness2 = layer_derived->steepness * 2.0F;
 			const float hyperbolic_tangent_major_multiplier = layer_derived->scale;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
 			{
-				float inp = *(in_it + i);
-				float inp2 = expf(inp * hyperbolic_tangent_steepness2);
-				float res = (inp2 - 1.0F) / (inp2 + 1.0F) * hyperbolic_tangent_major_multiplier;
-				*(out_it + i) = res;
-			}
+				for(int i = begin; i < end; ++i)
+				{
+					float inp = *(in_it + i);
+					float inp2 = expf(inp * hyperbolic_tangent_steepness2);
+					float res = (inp2 - 1.0F) / (inp2 + 1.0F) * hyperbolic_tangent_major_multiplier;
+					*(out_it + i) = res;
+				}
+			});
 		}
 
 		void hyperbolic_tangent_layer_updater_plain::run_backward_data_propagation(
@@ -89,25 +91,29 @@ namespace nnforge
 			const float hyperbolic_tangent_steepness3 = layer_derived->steepness * layer_derived->scale;
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					float out_neuron = *(out_it + i);
-					float normalized_value = out_neuron * hyperbolic_tangent_major_multiplier_reverse;
-					float der1st = hyperbolic_tangent_steepness3 * (1.0F - (normalized_value * normalized_value));
-					*(in_err_it + i) += *(out_err_it + i) * der1st;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						float out_neuron = *(out_it + i);
+						float normalized_value = out_neuron * hyperbolic_tangent_major_multiplier_reverse;
+						float der1st = hyperbolic_tangent_steepness3 * (1.0F - (normalized_value * normalized_value));
+						*(in_err_it + i) += *(out_err_it + i) * der1st;
+					}
+				});
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					float out_neuron = *(out_it + i);
-					float normalized_value = out_neuron * hyperbolic_tangent_major_multiplier_reverse;
-					float der1st = hyperbolic_tangent_steepness3 * (1.0F - (normalized_value * normalized_value));
-					*(in_err_it + i) = *(out_err_it + i) * der1st;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						float out_neuron = *(out_it + i);
+						float normalized_value = out_neuron * hyperbolic_tangent_major_multiplier_reverse;
+						float der1st = hyperbolic_tangent_steepness3 * (1.0F - (normalized_value * normalized_value));
+						*(in_err_it + i) = *(out_err_it + i) * der1st;
+					}
+				});
 			}
 		}
 
@@ -46,5 +46,15 @@ namespace nnforge
 		{
 			return 0;
 		}
+
+		std::string layer_tester_plain::get_algorithm_name() const
+		{
+			return "default";
+		}
+
+		std::vector<layer_tester_plain::const_ptr> layer_tester_plain::get_algorithm_alternatives() const
+		{
+			return std::vector<layer_tester_plain::const_ptr>();
+		}
 	}
 }
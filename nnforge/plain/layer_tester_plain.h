@@ -70,6 +70,13 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			// Identifies the algorithm when autotuning, default impl returns "default"
+			virtual std::string get_algorithm_name() const;
+
+			// Testers for the same layer type implementing other algorithms, autotuning picks the fastest one for each layer configuration.
+			// Default impl returns empty list
+			virtual std::vector<layer_tester_plain::const_ptr> get_algorithm_alternatives() const;
+
 		protected:
 			layer_tester_plain() = default;
 
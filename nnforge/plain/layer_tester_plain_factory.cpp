@@ -44,6 +44,14 @@ namespace nnforge
 			return i->second;
 		}
 
+		std::vector<std::string> layer_tester_plain_factory::get_layer_type_name_list() const
+		{
+			std::vector<std::string> res;
+			for(sample_map::const_iterator it = sample_layer_tester_plain_map.begin(); it != sample_layer_tester_plain_map.end(); ++it)
+				res.push_back(it->first);
+			return res;
+		}
+
 		layer_tester_plain_factory& layer_tester_plain_factory::get_singleton()
 		{
 			static layer_tester_plain_factory instance;
@@ -20,6 +20,8 @@
 #include "layer_tester_plain.h"
 
 #include <map>
+#include <vector>
+#include <string>
 
 namespace nnforge
 {
@@ -34,6 +36,8 @@ namespace nnforge
 
 			layer_tester_plain::const_ptr get_tester_plain_layer(const std::string& layer_type_name) const;
 
+			std::vector<std::string> get_layer_type_name_list() const;
+
 			static layer_tester_plain_factory& get_singleton();
 
 		private:
@@ -186,5 +186,20 @@ namespace nnforge
 
 			return (get_temporary_per_entry_buffer_size(actions, plain_config, layer_schema, input_configuration_specific_list, output_configuration_specific) != 0);
 		}
+
+		bool layer_updater_plain::is_forward_deterministic() const
+		{
+			return true;
+		}
+
+		std::string layer_updater_plain::get_algorithm_name() const
+		{
+			return "default";
+		}
+
+		std::vector<layer_updater_plain::const_ptr> layer_updater_plain::get_algorithm_alternatives() const
+		{
+			return std::vector<layer_updater_plain::const_ptr>();
+		}
 	}
 }
@@ -166,6 +166,19 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			// Default impl returns true
+			// Layers which produce different output on each forward run for the same input (dropout) should return false,
+			// their outputs are never dropped and recomputed when doing activation checkpointing
+			virtual bool is_forward_deterministic() const;
+
+			// Identifies the algorithm when autotuning, default impl returns "default"
+			virtual std::string get_algorithm_name() const;
+
+			// Updaters for the same layer type implementing other algorithms, autotuning picks the fastest one for each layer configuration.
+			// They should have the same buffer dependencies and temporary per entry buffer size as this updater.
+			// Default impl returns empty list
+			virtual std::vector<layer_updater_plain::const_ptr> get_algorithm_alternatives() const;
+
 		protected:
 			layer_updater_plain() = default;
 
@@ -20,6 +20,8 @@
 #include "layer_updater_plain.h"
 
 #include <map>
+#include <vector>
+#include <string>
 
 namespace nnforge
 {
@@ -34,6 +36,8 @@ namespace nnforge
 
 			layer_updater_plain::const_ptr get_updater_plain_layer(const std::string& layer_type_name) const;
 
+			std::vector<std::string> get_layer_type_name_list() const;
+
 			static layer_updater_plain_factory& get_singleton();
 
 		private:
@@ -59,10 +59,9 @@ namespace nnforge
 			const float n_value = layer_derived->n;
 			const int total_workload = entry_count * output_neuron_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_neuron_count;
 					int output_neuron_id = workload_id - (entry_id * output_neuron_count);
@@ -107,7 +106,7 @@ namespace nnforge
 
 					*(out_it_global + output_offset) = err;
 				}
-			}
+			});
 		}
 	}
 }
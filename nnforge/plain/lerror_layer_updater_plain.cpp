@@ -61,10 +61,9 @@ namespace nnforge
 			const float n_value = layer_derived->n;
 			const int total_workload = entry_count * output_neuron_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_neuron_count;
 					int output_neuron_id = workload_id - (entry_id * output_neuron_count);
@@ -109,7 +108,7 @@ namespace nnforge
 
 					*(out_it_global + output_offset) = err;
 				}
-			}
+			});
 		}
 
 		void lerror_layer_updater_plain::run_backward_data_propagation(
@@ -151,48 +150,50 @@ namespace nnforge
 			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
 
 			const int total_workload = entry_count * neuron_count_per_feature_map;
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				int entry_id = workload_id / neuron_count_per_feature_map;
-				int neuron_id = workload_id - (entry_id * neuron_count_per_feature_map);
-				int output_offset = entry_id * neuron_count_per_feature_map + neuron_id;
-				float total_scale = scale2;
-				if (const_scale_mask_it)
-					total_scale *= *(const_scale_mask_it + output_offset);
-
-				for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
-					float gradient = 0.0F;
-					int input_offset = (entry_id * input_feature_map_count + feature_map_id) * neuron_count_per_feature_map + neuron_id;
-					if (total_scale != 0.0F)
-					{
-						float actual_val = *(target_input_neurons_it + input_offset);
-						float predicted_val = *(deriv_input_neurons_it + input_offset);
-						float diff = actual_val - predicted_val;
+					int entry_id = workload_id / neuron_count_per_feature_map;
+					int neuron_id = workload_id - (entry_id * neuron_count_per_feature_map);
+					int output_offset = entry_id * neuron_count_per_feature_map + neuron_id;
+					float total_scale = scale2;
+					if (const_scale_mask_it)
+						total_scale *= *(const_scale_mask_it + output_offset);
 
-						if (n_value == 1.0F)
-						{
-							gradient = (diff >= 0.0F ? 1.0F : -1.0F);
-						}
-						else if (n_value == 2.0F)
-						{
-							gradient = diff;
-						}
-						else
+					for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+					{
+						float gradient = 0.0F;
+						int input_offset = (entry_id * input_feature_map_count + feature_map_id) * neuron_count_per_feature_map + neuron_id;
+						if (total_scale != 0.0F)
 						{
-							gradient = (diff >= 0.0F ? 1.0F : -1.0F) * powf(fabsf(diff), n_value_m1);
+							float actual_val = *(target_input_neurons_it + input_offset);
+							float predicted_val = *(deriv_input_neurons_it + input_offset);
+							float diff = actual_val - predicted_val;
+
+							if (n_value == 1.0F)
+							{
+								gradient = (diff >= 0.0F ? 1.0F : -1.0F);
+							}
+							else if (n_value == 2.0F)
+							{
+								gradient = diff;
+							}
+							else
+							{
+								gradient = (diff >= 0.0F ? 1.0F : -1.0F) * powf(fabsf(diff), n_value_m1);
+							}
+
+							gradient *= total_scale;
 						}
 
-						gradient *= total_scale;
+						if (add_update_to_destination)
+							*(in_err_it + input_offset) += gradient;
+						else
+							*(in_err_it + input_offset) = gradient;
 					}
-
-					if (add_update_to_destination)
-						*(in_err_it + input_offset) += gradient;
-					else
-						*(in_err_it + input_offset) = gradient;
 				}
-			}
+			});
 		}
 
 		bool lerror_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
@@ -62,10 +62,9 @@ namespace nnforge
 
 			const int total_workload = entry_count * output_height * output_width;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / (output_height * output_width);
 					int yx = workload_id - (entry_id * (output_height * output_width));
@@ -114,7 +113,7 @@ namespace nnforge
 						current_output += output_elem_count_per_entry;
 					}
 				}
-			}
+			});
 		}
 
 		void linear_sampler_layer_updater_plain::run_backward_data_propagation(
@@ -157,10 +156,9 @@ namespace nnforge
 
 			const int total_workload = entry_count * output_height * output_width;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / (output_height * output_width);
 					int yx = workload_id - (entry_id * (output_height * output_width));
@@ -228,7 +226,7 @@ namespace nnforge
 						in_it_grid_errors[grid_y_offset] = input_err_y;
 					}
 				}
-			}
+			});
 		}
 
 		bool linear_sampler_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
@@ -16,10 +16,6 @@
 
 #include "local_contrast_subtractive_layer_updater_plain.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
 #include "../local_contrast_subtractive_layer.h"
 
 #include <cstring>
@@ -73,20 +69,15 @@ namespace nnforge
 			const int total_workload = entry_count * feature_maps_affected_count;
 			const int openmp_thread_count = plain_config->openmp_thread_count;
 			
-			#pragma omp parallel default(none) num_threads(openmp_thread_count)
+			plain_config->parallel_for_with_thread_id(total_workload, [&] (int begin, int end, unsigned int thread_id)
 			{
 				std::vector<float *> local_additional_buffers;
-				int thread_id = 0;
-				#ifdef _OPENMP
-				thread_id = omp_get_thread_num();
-				#endif
 
 				local_additional_buffers.push_back(working_buffer_it + thread_id * neuron_count_per_feature_map);
 				if (dimension_count > 1)
 					local_additional_buffers.push_back(working_buffer_it + (openmp_thread_count + thread_id) * neuron_count_per_feature_map);
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / feature_maps_affected_count;
 					int affected_feature_map_id = workload_id - (entry_id * feature_maps_affected_count);
@@ -147,7 +138,7 @@ namespace nnforge
 							*(out_it + i) = *(original_in_it + i) - *(in_it + i);
 					}
 				}
-			} // #pragma parallel
+			});
 
 			if ((feature_maps_unaffected_count > 0) && (input_buffer_it != output_buffer_it))
 			{
@@ -208,20 +199,15 @@ namespace nnforge
 			const int total_workload = entry_count * feature_maps_affected_count;
 			const int openmp_thread_count = plain_config->openmp_thread_count;
 			
-			#pragma omp parallel default(none) num_threads(openmp_thread_count)
+			plain_config->parallel_for_with_thread_id(total_workload, [&] (int begin, int end, unsigned int thread_id)
 			{
 				std::vector<float *> local_additional_buffers;
-				int thread_id = 0;
-				#ifdef _OPENMP
-				thread_id = omp_get_thread_num();
-				#endif
 
 				local_additional_buffers.push_back(working_buffer_it + thread_id * neuron_count_per_feature_map);
 				if (dimension_count > 1)
 					local_additional_buffers.push_back(working_buffer_it + (openmp_thread_count + thread_id) * neuron_count_per_feature_map);
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / feature_maps_affected_count;
 					int affected_feature_map_id = workload_id - (entry_id * feature_maps_affected_count);
@@ -289,7 +275,7 @@ namespace nnforge
 						}
 					}
 				}
-			} // #pragma parallel
+			});
 
 			if ((!add_update_to_destination) && (feature_maps_unaffected_count > 0) && (input_errors_it != output_errors_it))
 			{
@@ -120,12 +120,11 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (output_entry_id * output_feature_map_count);
@@ -167,7 +166,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		void max_subsampling_layer_updater_plain::run_backward_data_propagation(
@@ -199,34 +198,40 @@ namespace nnforge
 			if (!add_update_to_destination)
 			{
 				const int total_clean_workload = entry_count * entry_subsampling_size * input_configuration_specific_list[0].get_neuron_count();
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_clean_workload; ++workload_id)
+				plain_config->parallel_for(total_clean_workload, [&] (int begin, int end)
 				{
-					*(in_err_it_global + workload_id) = 0.0F;
-				}
+					for(int workload_id = begin; workload_id < end; ++workload_id)
+					{
+						*(in_err_it_global + workload_id) = 0.0F;
+					}
+				});
 			}
 
 			const int total_workload = entry_count * output_configuration_specific.get_neuron_count();
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				plain_config->parallel_for(total_workload, [&] (int begin, int end)
 				{
-					unsigned int max_index = *(max_indexes_it_global + workload_id);
-					float err = *(out_err_it_global + workload_id);
-					*(in_err_it_global + max_index) += err;
-				}
+					for(int workload_id = begin; workload_id < end; ++workload_id)
+					{
+						unsigned int max_index = *(max_indexes_it_global + workload_id);
+						float err = *(out_err_it_global + workload_id);
+						*(in_err_it_global + max_index) += err;
+					}
+				});
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				plain_config->parallel_for(total_workload, [&] (int begin, int end)
 				{
-					unsigned int max_index = *(max_indexes_it_global + workload_id);
-					float err = *(out_err_it_global + workload_id);
-					*(in_err_it_global + max_index) = err;
-				}
+					for(int workload_id = begin; workload_id < end; ++workload_id)
+					{
+						unsigned int max_index = *(max_indexes_it_global + workload_id);
+						float err = *(out_err_it_global + workload_id);
+						*(in_err_it_global + max_index) = err;
+					}
+				});
 			}
 		}
 
@@ -53,10 +53,9 @@ namespace nnforge
 			const int output_feature_map_count = output_configuration_specific.feature_map_count;
 			const int total_workload = entry_count * output_feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (entry_id * output_feature_map_count);
@@ -77,7 +76,7 @@ namespace nnforge
 						*out_it = current_max;
 					}
 				}
-			}
+			});
 		}
 	}
 }
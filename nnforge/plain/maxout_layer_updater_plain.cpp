@@ -57,10 +57,9 @@ namespace nnforge
 			const int output_feature_map_count = output_configuration_specific.feature_map_count;
 			const int total_workload = entry_count * output_feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (entry_id * output_feature_map_count);
@@ -89,7 +88,7 @@ namespace nnforge
 						*max_feature_map_positions_it = max_feature_map_pos;
 					}
 				}
-			}
+			});
 		}
 
 		void maxout_layer_updater_plain::run_backward_data_propagation(
@@ -124,10 +123,9 @@ namespace nnforge
 			const int output_feature_map_count = output_configuration_specific.feature_map_count;
 			const int total_workload = entry_count * output_feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (entry_id * output_feature_map_count);
@@ -160,7 +158,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		bool maxout_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
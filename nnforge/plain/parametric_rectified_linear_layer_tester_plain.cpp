@@ -48,26 +48,28 @@ namespace nnforge
 			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
 			const std::vector<float>::const_iterator weights = (*data)[0].begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				int entry_id = workload_id / feature_map_count;
-				int feature_map_id = workload_id - entry_id * feature_map_count;
+				for(int workload_id = begin; workload_id < end; ++workload_id)
+				{
+					int entry_id = workload_id / feature_map_count;
+					int feature_map_id = workload_id - entry_id * feature_map_count;
 
-				float a = weights[feature_map_id];
+					float a = weights[feature_map_id];
 
-				const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-				const float * current_in_it_end = current_in_it + neuron_count_per_feature_map;
+					const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					const float * current_in_it_end = current_in_it + neuron_count_per_feature_map;
 
-				float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
 
-				for(; current_in_it != current_in_it_end; ++current_in_it, ++current_out_it)
-				{
-					float input_val = *current_in_it;
-					float output_val = input_val * (input_val >= 0.0F ? 1.0F : a);
-					*current_out_it = output_val;
+					for(; current_in_it != current_in_it_end; ++current_in_it, ++current_out_it)
+					{
+						float input_val = *current_in_it;
+						float output_val = input_val * (input_val >= 0.0F ? 1.0F : a);
+						*current_out_it = output_val;
+					}
 				}
-			}
+			});
 		}
 
 		int parametric_rectified_linear_layer_tester_plain::get_input_index_layer_can_write(
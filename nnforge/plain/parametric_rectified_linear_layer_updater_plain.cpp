@@ -52,24 +52,26 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const std::vector<float>::const_iterator weights = (*data)[0].begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				int entry_id = workload_id / feature_map_count;
-				int feature_map_id = workload_id - entry_id * feature_map_count;
+				for(int workload_id = begin; workload_id < end; ++workload_id)
+				{
+					int entry_id = workload_id / feature_map_count;
+					int feature_map_id = workload_id - entry_id * feature_map_count;
 
-				float a = weights[feature_map_id];
+					float a = weights[feature_map_id];
 
-				const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-				float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					const float * current_in_it = in_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					float * current_out_it = out_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
 
-				for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
-				{
-					float input_val = *(current_in_it + i);
-					float output_val = input_val * (input_val >= 0.0F ? 1.0F : a);
-					*(current_out_it + i) = output_val;
+					for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+					{
+						float input_val = *(current_in_it + i);
+						float output_val = input_val * (input_val >= 0.0F ? 1.0F : a);
+						*(current_out_it + i) = output_val;
+					}
 				}
-			}
+			});
 		}
 
 		void parametric_rectified_linear_layer_updater_plain::run_backward_data_propagation(
@@ -101,39 +103,41 @@ namespace nnforge
 			float * const  in_errors_it = *input_errors_buffer;
 			const std::vector<float>::const_iterator weights = (*data)[0].begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				int entry_id = workload_id / feature_map_count;
-				int feature_map_id = workload_id - entry_id * feature_map_count;
+				for(int workload_id = begin; workload_id < end; ++workload_id)
+				{
+					int entry_id = workload_id / feature_map_count;
+					int feature_map_id = workload_id - entry_id * feature_map_count;
 
-				float a = weights[feature_map_id];
+					float a = weights[feature_map_id];
 
-				const float * current_in_neurons_it = in_neurons_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-				float * current_in_errors_it = in_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-				const float * current_out_errors_it = out_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					const float * current_in_neurons_it = in_neurons_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					float * current_in_errors_it = in_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					const float * current_out_errors_it = out_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
 
-				if (add_update_to_destination)
-				{
-					for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+					if (add_update_to_destination)
 					{
-						float output_err = *(current_out_errors_it+ i);
-						float input_val = *(current_in_neurons_it + i);
-						float input_err = output_err * (input_val >= 0.0F ? 1.0F : a);
-						*(current_in_errors_it + i) += input_err;
+						for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+						{
+							float output_err = *(current_out_errors_it+ i);
+							float input_val = *(current_in_neurons_it + i);
+							float input_err = output_err * (input_val >= 0.0F ? 1.0F : a);
+							*(current_in_errors_it + i) += input_err;
+						}
 					}
-				}
-				else
-				{
-					for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+					else
 					{
-						float output_err = *(current_out_errors_it+ i);
-						float input_val = *(current_in_neurons_it + i);
-						float input_err = output_err * (input_val >= 0.0F ? 1.0F : a);
-						*(current_in_errors_it + i) = input_err;
+						for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+						{
+							float output_err = *(current_out_errors_it+ i);
+							float input_val = *(current_in_neurons_it + i);
+							float input_err = output_err * (input_val >= 0.0F ? 1.0F : a);
+							*(current_in_errors_it + i) = input_err;
+						}
 					}
 				}
-			}
+			});
 		}
 
 		void parametric_rectified_linear_layer_updater_plain::run_backward_weights_propagation(
@@ -162,31 +166,33 @@ namespace nnforge
 			const int total_workload = feature_map_count;
 			const int const_updater_count = entry_count;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				int feature_map_id = workload_id;
-
-				float sum = 0.0F;
-				for(int entry_id = 0; entry_id < const_updater_count; ++entry_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
-					const float * current_in_neurons_it = in_neurons_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-					const float * current_err_it = err_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+					int feature_map_id = workload_id;
 
-					float local_sum = 0.0F;
-					for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+					float sum = 0.0F;
+					for(int entry_id = 0; entry_id < const_updater_count; ++entry_id)
 					{
-						float output_err = *(current_err_it + i);
-						float input_val = *(current_in_neurons_it + i);
-						float gr = output_err * (input_val >= 0.0F ? 0.0F : input_val);
-						local_sum += gr;
+						const float * current_in_neurons_it = in_neurons_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+						const float * current_err_it = err_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+
+						float local_sum = 0.0F;
+						for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+						{
+							float output_err = *(current_err_it + i);
+							float input_val = *(current_in_neurons_it + i);
+							float gr = output_err * (input_val >= 0.0F ? 0.0F : input_val);
+							local_sum += gr;
+						}
+
+						sum += local_sum;
 					}
 
-					sum += local_sum;
+					*(gradients + feature_map_id) += sum;
 				}
-
-				*(gradients + feature_map_id) += sum;
-			}
+			});
 		}
 
 		int parametric_rectified_linear_layer_updater_plain::get_input_index_layer_can_write(
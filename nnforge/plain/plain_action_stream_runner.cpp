@@ -0,0 +1,287 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_action_stream_runner.h"
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		struct plain_action_stream_runner::run_state
+		{
+			run_state(
+				size_t action_count,
+				unsigned int pool_worker_count)
+				: action_done(action_count, false)
+				, action_first_pool_worker_id(action_count, 0)
+				, action_pool_worker_count(action_count, 0)
+				, pool_worker_busy(pool_worker_count, false)
+				, running_action_count(0)
+				, error_encountered(false)
+			{
+			}
+
+			std::mutex m;
+			std::condition_variable action_done_condition;
+			std::vector<bool> action_done;
+			std::vector<unsigned int> action_first_pool_worker_id;
+			std::vector<unsigned int> action_pool_worker_count;
+			std::vector<bool> pool_worker_busy;
+			int running_action_count;
+			bool error_encountered;
+			std::exception_ptr error;
+		};
+
+		plain_action_stream_runner::plain_action_stream_runner(
+			const network_action_schema& action_schema,
+			plain_running_configuration::const_ptr plain_config)
+			: plain_config(plain_config)
+			, current_func(0)
+			, current_state(0)
+			, run_id(0)
+			, finished_worker_count(0)
+			, stopping(false)
+		{
+			actions = action_schema.get_actions_in_execution_order();
+			std::map<layer_name_with_action, unsigned int> action_to_id_map;
+			for(unsigned int action_id = 0; action_id < static_cast<unsigned int>(actions.size()); ++action_id)
+				action_to_id_map.insert(std::make_pair(actions[action_id], action_id));
+
+			for(std::vector<layer_name_with_action>::const_iterator it = actions.begin(); it != actions.end(); ++it)
+			{
+				action_dependency_list.push_back(std::vector<unsigned int>());
+				std::vector<layer_name_with_action> dependencies = action_schema.get_dependencies(*it);
+				for(std::vector<layer_name_with_action>::const_iterator it2 = dependencies.begin(); it2 != dependencies.end(); ++it2)
+					action_dependency_list.back().push_back(action_to_id_map[*it2]);
+			}
+
+			// Streams are distributed across workers, each worker runs its actions in the global execution order, so waiting for dependencies never deadlocks
+			std::vector<std::vector<layer_name_with_action> > stream_set = action_schema.get_action_stream_set();
+			unsigned int worker_count = std::max(std::min(static_cast<unsigned int>(stream_set.size()), static_cast<unsigned int>(plain_config->openmp_thread_count)), 1U);
+			worker_action_id_list.resize(worker_count);
+			for(unsigned int stream_id = 0; stream_id < static_cast<unsigned int>(stream_set.size()); ++stream_id)
+				for(std::vector<layer_name_with_action>::const_iterator it = stream_set[stream_id].begin(); it != stream_set[stream_id].end(); ++it)
+					worker_action_id_list[stream_id % worker_count].push_back(action_to_id_map[*it]);
+			for(std::vector<std::vector<unsigned int> >::iterator it = worker_action_id_list.begin(); it != worker_action_id_list.end(); ++it)
+			{
+				std::sort(it->begin(), it->end());
+				worker_action_list.push_back(std::vector<layer_name_with_action>());
+				for(std::vector<unsigned int>::const_iterator it2 = it->begin(); it2 != it->end(); ++it2)
+					worker_action_list.back().push_back(actions[*it2]);
+			}
+
+			for(unsigned int worker_id = 1; worker_id < get_worker_count(); ++worker_id)
+				worker_threads.push_back(std::thread(&plain_action_stream_runner::worker_thread_func, this, worker_id));
+		}
+
+		plain_action_stream_runner::~plain_action_stream_runner()
+		{
+			{
+				std::lock_guard<std::mutex> lock(worker_mutex);
+				stopping = true;
+			}
+			run_start_condition.notify_all();
+			for(std::vector<std::thread>::iterator it = worker_threads.begin(); it != worker_threads.end(); ++it)
+				it->join();
+		}
+
+		unsigned int plain_action_stream_runner::get_worker_count() const
+		{
+			return static_cast<unsigned int>(worker_action_id_list.size());
+		}
+
+		const std::vector<std::vector<layer_name_with_action> >& plain_action_stream_runner::get_worker_action_list() const
+		{
+			return worker_action_list;
+		}
+
+		void plain_action_stream_runner::run(const action_function& func) const
+		{
+			std::lock_guard<std::mutex> run_lock(run_mutex);
+
+			run_state state(actions.size(), static_cast<unsigned int>(std::max(plain_config->openmp_thread_count - 1, 0)));
+			{
+				std::lock_guard<std::mutex> lock(worker_mutex);
+				current_func = &func;
+				current_state = &state;
+				finished_worker_count = 0;
+				++run_id;
+			}
+			run_start_condition.notify_all();
+
+			run_worker(0, func, state);
+
+			{
+				std::unique_lock<std::mutex> lock(worker_mutex);
+				run_done_condition.wait(lock, [this] () { return finished_worker_count == static_cast<unsigned int>(worker_threads.size()); });
+				current_func = 0;
+				current_state = 0;
+			}
+
+			if (state.error_encountered)
+				std::rethrow_exception(state.error);
+		}
+
+		void plain_action_stream_runner::worker_thread_func(unsigned int worker_id)
+		{
+			unsigned int last_run_id = 0;
+			while (true)
+			{
+				const action_function * func;
+				run_state * state;
+				{
+					std::unique_lock<std::mutex> lock(worker_mutex);
+					run_start_condition.wait(lock, [this, last_run_id] () { return stopping || (run_id != last_run_id); });
+					if (stopping)
+						return;
+					last_run_id = run_id;
+					func = current_func;
+					state = current_state;
+				}
+
+				run_worker(worker_id, *func, *state);
+
+				{
+					std::lock_guard<std::mutex> lock(worker_mutex);
+					++finished_worker_count;
+				}
+				run_done_condition.notify_all();
+			}
+		}
+
+		void plain_action_stream_runner::run_worker(
+			unsigned int worker_id,
+			const action_function& func,
+			run_state& state) const
+		{
+			const std::vector<unsigned int>& action_id_list = worker_action_id_list[worker_id];
+			for(std::vector<unsigned int>::const_iterator it = action_id_list.begin(); it != action_id_list.end(); ++it)
+			{
+				unsigned int action_id = *it;
+				const std::vector<unsigned int>& dependencies = action_dependency_list[action_id];
+
+				plain_running_configuration::const_ptr action_plain_config;
+				{
+					std::unique_lock<std::mutex> lock(state.m);
+					while (true)
+					{
+						if (state.error_encountered)
+							return;
+						bool dependencies_done = true;
+						for(std::vector<unsigned int>::const_iterator it2 = dependencies.begin(); it2 != dependencies.end(); ++it2)
+						{
+							if (!state.action_done[*it2])
+							{
+								dependencies_done = false;
+								break;
+							}
+						}
+						if (dependencies_done)
+							break;
+						state.action_done_condition.wait(lock);
+					}
+					++state.running_action_count;
+					action_plain_config = acquire_action_config(state, action_id);
+				}
+
+				try
+				{
+					func(actions[action_id], action_plain_config, worker_id);
+				}
+				catch (...)
+				{
+					{
+						std::lock_guard<std::mutex> lock(state.m);
+						if (!state.error_encountered)
+						{
+							state.error_encountered = true;
+							state.error = std::current_exception();
+						}
+					}
+					state.action_done_condition.notify_all();
+					return;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(state.m);
+					--state.running_action_count;
+					release_action_config(state, action_id);
+					state.action_done[action_id] = true;
+				}
+				state.action_done_condition.notify_all();
+			}
+		}
+
+		plain_running_configuration::const_ptr plain_action_stream_runner::acquire_action_config(
+			run_state& state,
+			unsigned int action_id) const
+		{
+			// The action takes a contiguous range of free pool threads, the first one long enough or the longest one otherwise,
+			// so actions which started when fewer of them were running keep their threads
+			unsigned int wanted_pool_worker_count = static_cast<unsigned int>(std::max(plain_config->openmp_thread_count / state.running_action_count, 1) - 1);
+			unsigned int pool_worker_count = static_cast<unsigned int>(state.pool_worker_busy.size());
+			unsigned int best_first_pool_worker_id = 0;
+			unsigned int best_pool_worker_count = 0;
+			unsigned int first_pool_worker_id = 0;
+			while ((best_pool_worker_count < wanted_pool_worker_count) && (first_pool_worker_id < pool_worker_count))
+			{
+				if (state.pool_worker_busy[first_pool_worker_id])
+				{
+					++first_pool_worker_id;
+					continue;
+				}
+				unsigned int free_pool_worker_count = 0;
+				while ((first_pool_worker_id + free_pool_worker_count < pool_worker_count) && !state.pool_worker_busy[first_pool_worker_id + free_pool_worker_count])
+					++free_pool_worker_count;
+				if (free_pool_worker_count > best_pool_worker_count)
+				{
+					best_first_pool_worker_id = first_pool_worker_id;
+					best_pool_worker_count = std::min(free_pool_worker_count, wanted_pool_worker_count);
+				}
+				first_pool_worker_id += free_pool_worker_count;
+			}
+			if (best_pool_worker_count == 0)
+				best_first_pool_worker_id = 0;
+
+			for(unsigned int i = 0; i < best_pool_worker_count; ++i)
+				state.pool_worker_busy[best_first_pool_worker_id + i] = true;
+			state.action_first_pool_worker_id[action_id] = best_first_pool_worker_id;
+			state.action_pool_worker_count[action_id] = best_pool_worker_count;
+
+			std::pair<int, unsigned int> key(static_cast<int>(best_pool_worker_count) + 1, best_first_pool_worker_id);
+			std::map<std::pair<int, unsigned int>, plain_running_configuration::const_ptr>::const_iterator it = action_config_map.find(key);
+			if (it != action_config_map.end())
+				return it->second;
+			plain_running_configuration::const_ptr res = plain_config->get_thread_partition_config(key.first, key.second);
+			action_config_map.insert(std::make_pair(key, res));
+			return res;
+		}
+
+		void plain_action_stream_runner::release_action_config(
+			run_state& state,
+			unsigned int action_id) const
+		{
+			for(unsigned int i = 0; i < state.action_pool_worker_count[action_id]; ++i)
+				state.pool_worker_busy[state.action_first_pool_worker_id[action_id] + i] = false;
+		}
+	}
+}
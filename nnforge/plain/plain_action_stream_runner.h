@@ -0,0 +1,108 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../network_action_schema.h"
+#include "plain_running_configuration.h"
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Runs independent actions of the schema concurrently on persistent threads,
+		// OpenMP threads are split between the actions running at the same time, each of them gets its own pool threads of the task runtime
+		class plain_action_stream_runner
+		{
+		public:
+			typedef std::shared_ptr<plain_action_stream_runner> ptr;
+			typedef std::shared_ptr<const plain_action_stream_runner> const_ptr;
+
+			// action_plain_config has OpenMP thread count reduced according to the number of actions running concurrently,
+			// its pool threads don't overlap with the ones of the other actions running at the same time
+			// worker_id is less than get_worker_count(), actions running concurrently have different worker_id
+			typedef std::function<void(const layer_name_with_action& action, plain_running_configuration::const_ptr action_plain_config, unsigned int worker_id)> action_function;
+
+			plain_action_stream_runner(
+				const network_action_schema& action_schema,
+				plain_running_configuration::const_ptr plain_config);
+
+			~plain_action_stream_runner();
+
+			unsigned int get_worker_count() const;
+
+			const std::vector<std::vector<layer_name_with_action> >& get_worker_action_list() const;
+
+			// The function returns when all the actions are done, the first exception thrown by func is rethrown
+			// Concurrent calls are serialized
+			void run(const action_function& func) const;
+
+		private:
+			struct run_state;
+
+			void worker_thread_func(unsigned int worker_id);
+
+			void run_worker(
+				unsigned int worker_id,
+				const action_function& func,
+				run_state& state) const;
+
+			// Should be called with state.m locked
+			plain_running_configuration::const_ptr acquire_action_config(
+				run_state& state,
+				unsigned int action_id) const;
+
+			// Should be called with state.m locked
+			void release_action_config(
+				run_state& state,
+				unsigned int action_id) const;
+
+		private:
+			plain_running_configuration::const_ptr plain_config;
+			// Guarded by the run state mutex
+			mutable std::map<std::pair<int, unsigned int>, plain_running_configuration::const_ptr> action_config_map;
+
+			std::vector<layer_name_with_action> actions;
+			std::vector<std::vector<unsigned int> > action_dependency_list;
+			std::vector<std::vector<unsigned int> > worker_action_id_list;
+			std::vector<std::vector<layer_name_with_action> > worker_action_list;
+
+			// Threads for workers [1, get_worker_count()), worker 0 is run by the thread calling run
+			std::vector<std::thread> worker_threads;
+			mutable std::mutex run_mutex;
+			mutable std::mutex worker_mutex;
+			mutable std::condition_variable run_start_condition;
+			mutable std::condition_variable run_done_condition;
+			mutable const action_function * current_func;
+			mutable run_state * current_state;
+			mutable unsigned int run_id;
+			mutable unsigned int finished_worker_count;
+			bool stopping;
+
+		private:
+			plain_action_stream_runner(const plain_action_stream_runner&) = delete;
+			plain_action_stream_runner& operator =(const plain_action_stream_runner&) = delete;
+		};
+	}
+}
@@ -0,0 +1,196 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_autotuner.h"
+
+#include "../neural_network_exception.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+#include <chrono>
+#include <sstream>
+
+#ifdef _WIN32
+#include <intrin.h>
+#include <cstring>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const unsigned int plain_autotuner::max_entry_count = 1024;
+		const int plain_autotuner::measure_run_count = 3;
+
+		plain_autotuner::plain_autotuner(const std::string& cache_file_path)
+			: cache_file_path(cache_file_path)
+			, cpu_model(read_cpu_model())
+		{
+			load();
+		}
+
+		std::string plain_autotuner::get_key(
+			const std::string& kind,
+			int thread_count,
+			unsigned int entry_count,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			std::stringstream ss;
+			ss << cpu_model << "|" << thread_count << " threads|" << entry_count << " entries|" << kind << "|" << layer_schema->get_type_name();
+
+			std::vector<std::string> parameter_strings = layer_schema->get_parameter_strings();
+			for(std::vector<std::string>::const_iterator it = parameter_strings.begin(); it != parameter_strings.end(); ++it)
+				ss << "|" << *it;
+
+			for(std::vector<layer_configuration_specific>::const_iterator it = input_configuration_specific_list.begin(); it != input_configuration_specific_list.end(); ++it)
+			{
+				ss << "|in " << it->feature_map_count;
+				for(std::vector<unsigned int>::const_iterator it2 = it->dimension_sizes.begin(); it2 != it->dimension_sizes.end(); ++it2)
+					ss << "x" << *it2;
+			}
+
+			ss << "|out " << output_configuration_specific.feature_map_count;
+			for(std::vector<unsigned int>::const_iterator it = output_configuration_specific.dimension_sizes.begin(); it != output_configuration_specific.dimension_sizes.end(); ++it)
+				ss << "x" << *it;
+
+			// The key is stored in one line of the text file
+			std::string res = ss.str();
+			boost::replace_all(res, "\t", " ");
+			boost::replace_all(res, "\n", " ");
+			return res;
+		}
+
+		bool plain_autotuner::find(
+			const std::string& key,
+			std::string& algorithm_name) const
+		{
+			std::lock_guard<std::mutex> lock(key_to_algorithm_name_map_mutex);
+
+			std::map<std::string, std::string>::const_iterator it = key_to_algorithm_name_map.find(key);
+			if (it == key_to_algorithm_name_map.end())
+				return false;
+
+			algorithm_name = it->second;
+			return true;
+		}
+
+		void plain_autotuner::store(
+			const std::string& key,
+			const std::string& algorithm_name)
+		{
+			std::lock_guard<std::mutex> lock(key_to_algorithm_name_map_mutex);
+
+			key_to_algorithm_name_map[key] = algorithm_name;
+
+			if (!cache_file_path.empty())
+			{
+				// Appending keeps the file consistent if the process is killed, the last record for the key wins when loading
+				boost::filesystem::ofstream out(cache_file_path, std::ios_base::out | std::ios_base::app);
+				if (!out)
+					throw neural_network_exception((boost::format("Unable to write autotuning cache file %1%") % cache_file_path).str());
+				out << key << "\t" << algorithm_name << std::endl;
+			}
+		}
+
+		double plain_autotuner::measure(const std::function<void()>& func) const
+		{
+			func();
+
+			double best_seconds = 0.0;
+			for(int run_id = 0; run_id < measure_run_count; ++run_id)
+			{
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				func();
+				std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+				if ((run_id == 0) || (sec.count() < best_seconds))
+					best_seconds = sec.count();
+			}
+
+			return best_seconds;
+		}
+
+		const std::string& plain_autotuner::get_cpu_model() const
+		{
+			return cpu_model;
+		}
+
+		const std::string& plain_autotuner::get_cache_file_path() const
+		{
+			return cache_file_path;
+		}
+
+		void plain_autotuner::load()
+		{
+			if (cache_file_path.empty() || !boost::filesystem::exists(cache_file_path))
+				return;
+
+			boost::filesystem::ifstream in(cache_file_path, std::ios_base::in);
+			std::string line;
+			while (std::getline(in, line))
+			{
+				boost::trim_right_if(line, boost::is_any_of("\r"));
+				std::string::size_type pos = line.rfind('\t');
+				if ((pos == std::string::npos) || (pos == 0) || (pos == line.size() - 1))
+					continue;
+				key_to_algorithm_name_map[line.substr(0, pos)] = line.substr(pos + 1);
+			}
+		}
+
+		std::string plain_autotuner::read_cpu_model()
+		{
+			std::string res;
+
+		#ifdef _WIN32
+			int regs[4];
+			__cpuid(regs, 0x80000000);
+			if (static_cast<unsigned int>(regs[0]) >= 0x80000004)
+			{
+				char brand[49];
+				for(int i = 0; i < 3; ++i)
+				{
+					__cpuid(regs, 0x80000002 + i);
+					memcpy(brand + i * 16, regs, 16);
+				}
+				brand[48] = 0;
+				res = brand;
+			}
+		#else
+			boost::filesystem::ifstream in("/proc/cpuinfo", std::ios_base::in);
+			std::string line;
+			while (std::getline(in, line))
+			{
+				if (boost::starts_with(line, "model name"))
+				{
+					std::string::size_type pos = line.find(':');
+					if (pos != std::string::npos)
+						res = line.substr(pos + 1);
+					break;
+				}
+			}
+		#endif
+
+			boost::trim(res);
+			if (res.empty())
+				res = "unknown CPU";
+
+			return res;
+		}
+	}
+}
@@ -0,0 +1,89 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../layer.h"
+#include "../layer_configuration_specific.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Keeps the fastest algorithm found for each layer configuration on this machine, optionally persisted in a file
+		class plain_autotuner
+		{
+		public:
+			typedef std::shared_ptr<plain_autotuner> ptr;
+
+			// Empty cache_file_path means results are kept in memory only
+			plain_autotuner(const std::string& cache_file_path);
+
+			// entry_count is the number of entries the candidates are timed with
+			std::string get_key(
+				const std::string& kind,
+				int thread_count,
+				unsigned int entry_count,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
+			// The method returns false in case no algorithm is stored for the key
+			bool find(
+				const std::string& key,
+				std::string& algorithm_name) const;
+
+			void store(
+				const std::string& key,
+				const std::string& algorithm_name);
+
+			// Runs func once to warm up, then returns the best time of a few runs, in seconds
+			double measure(const std::function<void()>& func) const;
+
+			const std::string& get_cpu_model() const;
+
+			const std::string& get_cache_file_path() const;
+
+			// Candidates are timed with the chunk size the layers are run with, capped by this value
+			static const unsigned int max_entry_count;
+
+		private:
+			void load();
+
+			static std::string read_cpu_model();
+
+		private:
+			std::string cache_file_path;
+			std::string cpu_model;
+
+			mutable std::mutex key_to_algorithm_name_map_mutex;
+			std::map<std::string, std::string> key_to_algorithm_name_map;
+
+			static const int measure_run_count;
+
+		private:
+			plain_autotuner(const plain_autotuner&) = delete;
+			plain_autotuner& operator =(const plain_autotuner&) = delete;
+		};
+	}
+}
@@ -0,0 +1,195 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_cache_topology.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/format.hpp>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		plain_cache_topology::plain_cache_topology()
+		{
+			#ifdef __linux__
+			boost::filesystem::path cache_root_path("/sys/devices/system/cpu/cpu0/cache");
+			for(unsigned int index_id = 0; ; ++index_id)
+			{
+				boost::filesystem::path index_path = cache_root_path / (boost::format("index%1%") % index_id).str();
+				if (!boost::filesystem::exists(index_path))
+					break;
+
+				std::string type_str;
+				std::string level_str;
+				std::string size_str;
+				std::string shared_cpu_map_str;
+				{
+					boost::filesystem::ifstream in(index_path / "type", std::ios_base::in);
+					std::getline(in, type_str);
+				}
+				if (type_str == "Instruction")
+					continue;
+				{
+					boost::filesystem::ifstream in(index_path / "level", std::ios_base::in);
+					std::getline(in, level_str);
+				}
+				{
+					boost::filesystem::ifstream in(index_path / "size", std::ios_base::in);
+					std::getline(in, size_str);
+				}
+				{
+					boost::filesystem::ifstream in(index_path / "shared_cpu_map", std::ios_base::in);
+					std::getline(in, shared_cpu_map_str);
+				}
+
+				unsigned int level_id = static_cast<unsigned int>(atol(level_str.c_str()));
+				if (level_id == 0)
+					continue;
+				--level_id;
+
+				// The map is a comma separated list of 32-bit hex masks
+				unsigned int sharing_cpu_count = 0;
+				for(std::string::const_iterator it = shared_cpu_map_str.begin(); it != shared_cpu_map_str.end(); ++it)
+				{
+					if (*it == ',')
+						continue;
+					char digit_str[2] = { *it, 0 };
+					unsigned long digit = strtoul(digit_str, 0, 16);
+					for(; digit != 0; digit >>= 1)
+						sharing_cpu_count += static_cast<unsigned int>(digit & 1);
+				}
+
+				if (level_id >= level_size_list.size())
+				{
+					level_size_list.resize(level_id + 1, 0);
+					level_sharing_cpu_count_list.resize(level_id + 1, 1);
+				}
+				level_size_list[level_id] = parse_size(size_str);
+				level_sharing_cpu_count_list[level_id] = std::max(sharing_cpu_count, 1U);
+			}
+			#elif defined(_WIN32)
+			DWORD buffer_size = 0;
+			GetLogicalProcessorInformation(0, &buffer_size);
+			std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info_list(buffer_size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+			if (!info_list.empty() && GetLogicalProcessorInformation(&info_list[0], &buffer_size))
+			{
+				for(std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION>::const_iterator it = info_list.begin(); it != info_list.end(); ++it)
+				{
+					if ((it->Relationship != RelationCache) || (it->Cache.Type == CacheInstruction) || (it->Cache.Level == 0))
+						continue;
+					unsigned int level_id = it->Cache.Level - 1;
+					unsigned int sharing_cpu_count = 0;
+					for(ULONG_PTR mask = it->ProcessorMask; mask != 0; mask >>= 1)
+						sharing_cpu_count += static_cast<unsigned int>(mask & 1);
+					if (level_id >= level_size_list.size())
+					{
+						level_size_list.resize(level_id + 1, 0);
+						level_sharing_cpu_count_list.resize(level_id + 1, 1);
+					}
+					level_size_list[level_id] = it->Cache.Size;
+					level_sharing_cpu_count_list[level_id] = std::max(sharing_cpu_count, 1U);
+				}
+			}
+			#endif
+
+			if (std::find(level_size_list.begin(), level_size_list.end(), static_cast<size_t>(0)) != level_size_list.end())
+				level_size_list.clear();
+
+			// Virtual machines often report L3 as private, while it is shared by many cores in practice
+			for(unsigned int level_id = 2; level_id < level_size_list.size(); ++level_id)
+				if (level_sharing_cpu_count_list[level_id] == 1)
+					level_sharing_cpu_count_list[level_id] = std::max(std::thread::hardware_concurrency(), 1U);
+
+			if (level_size_list.empty())
+			{
+				// 32 KB L1 and 256 KB L2 per core, 2 MB of L3 per core
+				unsigned int core_count = std::max(std::thread::hardware_concurrency(), 1U);
+				level_size_list.push_back(32 * 1024);
+				level_sharing_cpu_count_list.push_back(1);
+				level_size_list.push_back(256 * 1024);
+				level_sharing_cpu_count_list.push_back(1);
+				level_size_list.push_back(static_cast<size_t>(core_count) * 2 * 1024 * 1024);
+				level_sharing_cpu_count_list.push_back(core_count);
+			}
+		}
+
+		unsigned int plain_cache_topology::get_level_count() const
+		{
+			return static_cast<unsigned int>(level_size_list.size());
+		}
+
+		size_t plain_cache_topology::get_size(unsigned int level_id) const
+		{
+			return level_size_list[level_id];
+		}
+
+		unsigned int plain_cache_topology::get_sharing_cpu_count(unsigned int level_id) const
+		{
+			return level_sharing_cpu_count_list[level_id];
+		}
+
+		size_t plain_cache_topology::get_capacity(unsigned int thread_count) const
+		{
+			// L1 is too small to hold layer inputs and outputs, it is left for weights and kernel locals.
+			// Threads beyond the CPU count don't bring more cache
+			thread_count = std::max(std::min(thread_count, std::thread::hardware_concurrency()), 1U);
+			size_t res = 0;
+			for(unsigned int level_id = 1; level_id < get_level_count(); ++level_id)
+			{
+				unsigned int sharing_cpu_count = get_sharing_cpu_count(level_id);
+				unsigned int instance_count = (thread_count + sharing_cpu_count - 1) / sharing_cpu_count;
+				res += std::min(get_size(level_id) * thread_count / sharing_cpu_count, get_size(level_id) * instance_count);
+			}
+			return res;
+		}
+
+		size_t plain_cache_topology::parse_size(const std::string& str)
+		{
+			// The format is "32K", "1024K", or "8M"
+			size_t res = static_cast<size_t>(atol(str.c_str()));
+			if (str.find('K') != std::string::npos)
+				res *= 1024;
+			else if (str.find('M') != std::string::npos)
+				res *= 1024 * 1024;
+			return res;
+		}
+
+		std::ostream& operator<< (std::ostream& out, const plain_cache_topology& topology)
+		{
+			out << "Caches = ";
+			for(unsigned int level_id = 0; level_id < topology.get_level_count(); ++level_id)
+			{
+				if (level_id > 0)
+					out << ", ";
+				out << "L" << (level_id + 1) << " " << (topology.get_size(level_id) / 1024) << " KB";
+				if (topology.get_sharing_cpu_count(level_id) > 1)
+					out << " per " << topology.get_sharing_cpu_count(level_id) << " CPUs";
+			}
+			out << std::endl;
+			return out;
+		}
+	}
+}
@@ -0,0 +1,61 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <ostream>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Data and unified cache levels of the CPU, typical sizes are assumed when the information is not available
+		class plain_cache_topology
+		{
+		public:
+			typedef std::shared_ptr<const plain_cache_topology> const_ptr;
+
+			plain_cache_topology();
+
+			unsigned int get_level_count() const;
+
+			// Size in bytes of the cache instance at level_id (0 for L1)
+			size_t get_size(unsigned int level_id) const;
+
+			// The number of CPUs sharing the same cache instance
+			unsigned int get_sharing_cpu_count(unsigned int level_id) const;
+
+			// Cache capacity available to thread_count threads, each of them getting its share of every level except L1
+			size_t get_capacity(unsigned int thread_count) const;
+
+		private:
+			static size_t parse_size(const std::string& str);
+
+		private:
+			std::vector<size_t> level_size_list;
+			std::vector<unsigned int> level_sharing_cpu_count_list;
+
+		private:
+			plain_cache_topology(const plain_cache_topology&) = delete;
+			plain_cache_topology& operator =(const plain_cache_topology&) = delete;
+		};
+
+		std::ostream& operator<< (std::ostream& out, const plain_cache_topology& topology);
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <string>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Exchanges data between the worker processes training the same network, each of them processing its own part of every chunk.
+		// All the workers should make the same calls in the same order
+		class plain_communicator
+		{
+		public:
+			typedef std::shared_ptr<plain_communicator> ptr;
+
+			virtual ~plain_communicator() = default;
+
+			// Sums data across all the workers, each of them gets the same result
+			virtual void reduce_all(
+				float * data,
+				size_t elem_count) = 0;
+
+			// Copies data of the worker with rank 0 to all the others
+			virtual void broadcast(
+				float * data,
+				size_t elem_count) = 0;
+
+			virtual unsigned int get_rank() const = 0;
+
+			virtual unsigned int get_worker_count() const = 0;
+
+			virtual std::string get_type_name() const = 0;
+
+		protected:
+			plain_communicator() = default;
+
+		private:
+			plain_communicator(const plain_communicator&) = delete;
+			plain_communicator& operator =(const plain_communicator&) = delete;
+		};
+	}
+}
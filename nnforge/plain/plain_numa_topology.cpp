@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_numa_topology.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/format.hpp>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		plain_numa_topology::plain_numa_topology()
+		{
+			#ifdef __linux__
+			boost::filesystem::path node_root_path("/sys/devices/system/node");
+			for(unsigned int node_id = 0; ; ++node_id)
+			{
+				boost::filesystem::path cpu_list_path = node_root_path / (boost::format("node%1%") % node_id).str() / "cpulist";
+				if (!boost::filesystem::exists(cpu_list_path))
+					break;
+
+				std::string cpu_list_str;
+				boost::filesystem::ifstream in(cpu_list_path, std::ios_base::in);
+				std::getline(in, cpu_list_str);
+				std::vector<unsigned int> cpu_list = parse_cpu_list(cpu_list_str);
+				// Memory-only nodes have no CPUs to run on
+				if (!cpu_list.empty())
+					node_cpu_list.push_back(cpu_list);
+			}
+			#endif
+
+			if (node_cpu_list.empty())
+			{
+				node_cpu_list.push_back(std::vector<unsigned int>());
+				unsigned int core_count = std::max(std::thread::hardware_concurrency(), 1U);
+				for(unsigned int cpu_id = 0; cpu_id < core_count; ++cpu_id)
+					node_cpu_list.back().push_back(cpu_id);
+			}
+		}
+
+		unsigned int plain_numa_topology::get_node_count() const
+		{
+			return static_cast<unsigned int>(node_cpu_list.size());
+		}
+
+		const std::vector<unsigned int>& plain_numa_topology::get_node_cpu_list(unsigned int node_id) const
+		{
+			return node_cpu_list[node_id];
+		}
+
+		std::vector<unsigned int> plain_numa_topology::parse_cpu_list(const std::string& str)
+		{
+			// The format is comma separated list of ranges, "0-7,16-23"
+			std::vector<unsigned int> res;
+			std::string::size_type pos = 0;
+			while (pos < str.size())
+			{
+				std::string::size_type end_pos = str.find(',', pos);
+				if (end_pos == std::string::npos)
+					end_pos = str.size();
+				std::string range_str = str.substr(pos, end_pos - pos);
+				std::string::size_type dash_pos = range_str.find('-');
+				if (!range_str.empty())
+				{
+					unsigned int first_cpu_id = static_cast<unsigned int>(atol(range_str.substr(0, dash_pos).c_str()));
+					unsigned int last_cpu_id = (dash_pos == std::string::npos) ? first_cpu_id : static_cast<unsigned int>(atol(range_str.substr(dash_pos + 1).c_str()));
+					for(unsigned int cpu_id = first_cpu_id; cpu_id <= last_cpu_id; ++cpu_id)
+						res.push_back(cpu_id);
+				}
+				pos = end_pos + 1;
+			}
+			return res;
+		}
+
+		std::ostream& operator<< (std::ostream& out, const plain_numa_topology& topology)
+		{
+			out << "NUMA nodes = " << topology.get_node_count();
+			for(unsigned int node_id = 0; node_id < topology.get_node_count(); ++node_id)
+				out << (node_id == 0 ? " (" : ", ") << topology.get_node_cpu_list(node_id).size() << " CPUs";
+			out << ")" << std::endl;
+			return out;
+		}
+	}
+}
@@ -0,0 +1,53 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <ostream>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// NUMA nodes and the CPUs they own, the whole system is a single node when the information is not available
+		class plain_numa_topology
+		{
+		public:
+			typedef std::shared_ptr<const plain_numa_topology> const_ptr;
+
+			plain_numa_topology();
+
+			unsigned int get_node_count() const;
+
+			const std::vector<unsigned int>& get_node_cpu_list(unsigned int node_id) const;
+
+		private:
+			static std::vector<unsigned int> parse_cpu_list(const std::string& str);
+
+		private:
+			std::vector<std::vector<unsigned int> > node_cpu_list;
+
+		private:
+			plain_numa_topology(const plain_numa_topology&) = delete;
+			plain_numa_topology& operator =(const plain_numa_topology&) = delete;
+		};
+
+		std::ostream& operator<< (std::ostream& out, const plain_numa_topology& topology);
+	}
+}
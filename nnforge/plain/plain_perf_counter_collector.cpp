@@ -0,0 +1,113 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_perf_counter_collector.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdint>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		plain_perf_counter_collector::plain_perf_counter_collector(const std::vector<long>& thread_id_list)
+		{
+			#ifdef __linux__
+			const unsigned long long counter_configs[counter_count] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+
+			for(std::vector<long>::const_iterator it = thread_id_list.begin(); it != thread_id_list.end(); ++it)
+			{
+				pid_t tid = static_cast<pid_t>(*it);
+				std::vector<int> fd_list(counter_count, -1);
+				for(int counter_id = 0; counter_id < counter_count; ++counter_id)
+				{
+					perf_event_attr attr;
+					memset(&attr, 0, sizeof(attr));
+					attr.size = sizeof(attr);
+					attr.type = PERF_TYPE_HARDWARE;
+					attr.config = counter_configs[counter_id];
+					attr.exclude_kernel = 1;
+					attr.exclude_hv = 1;
+					attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+					fd_list[counter_id] = static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, fd_list[cycles_counter], 0));
+					if (fd_list[cycles_counter] < 0)
+						break;
+				}
+				if (fd_list[cycles_counter] >= 0)
+					thread_counter_fd_list.push_back(fd_list);
+			}
+			#endif
+		}
+
+		plain_perf_counter_collector::~plain_perf_counter_collector()
+		{
+			#ifdef __linux__
+			for(std::vector<std::vector<int> >::const_iterator it = thread_counter_fd_list.begin(); it != thread_counter_fd_list.end(); ++it)
+				for(std::vector<int>::const_iterator it2 = it->begin(); it2 != it->end(); ++it2)
+					if (*it2 >= 0)
+						close(*it2);
+			#endif
+		}
+
+		bool plain_perf_counter_collector::is_available() const
+		{
+			return !thread_counter_fd_list.empty();
+		}
+
+		profile_util::hardware_counters plain_perf_counter_collector::read() const
+		{
+			profile_util::hardware_counters res;
+			if (thread_counter_fd_list.empty())
+			{
+				res.cycles = -1.0;
+				res.instructions = -1.0;
+				res.llc_misses = -1.0;
+				return res;
+			}
+
+			#ifdef __linux__
+			for(std::vector<std::vector<int> >::const_iterator it = thread_counter_fd_list.begin(); it != thread_counter_fd_list.end(); ++it)
+			{
+				// With PERF_FORMAT_GROUP | PERF_FORMAT_ID the leader returns the number of counters followed by (value, id) pairs
+				uint64_t data[1 + 2 * counter_count];
+				profile_util::hardware_counters current_counters;
+				if (::read(it->front(), data, sizeof(data)) <= 0)
+					continue;
+				unsigned int value_id = 0;
+				double * values[counter_count] = { &current_counters.cycles, &current_counters.instructions, &current_counters.llc_misses };
+				for(int counter_id = 0; counter_id < counter_count; ++counter_id)
+				{
+					if ((*it)[counter_id] >= 0)
+					{
+						*values[counter_id] = (value_id < data[0]) ? static_cast<double>(data[1 + value_id * 2]) : -1.0;
+						++value_id;
+					}
+					else
+						*values[counter_id] = -1.0;
+				}
+				res += current_counters;
+			}
+			#endif
+
+			return res;
+		}
+	}
+}
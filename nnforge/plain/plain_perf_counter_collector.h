@@ -0,0 +1,62 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../profile_util.h"
+
+#include <vector>
+#include <memory>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Hardware performance counters summed over the threads specified, Linux only
+		class plain_perf_counter_collector
+		{
+		public:
+			typedef std::shared_ptr<plain_perf_counter_collector> ptr;
+
+			// thread_id_list holds OS thread ids, see plain_running_configuration::get_os_thread_id_list
+			plain_perf_counter_collector(const std::vector<long>& thread_id_list);
+
+			~plain_perf_counter_collector();
+
+			// False when counters could not be opened: unsupported OS, restrictive perf_event_paranoid, no PMU in VM
+			bool is_available() const;
+
+			// Values accumulated since construction
+			profile_util::hardware_counters read() const;
+
+		private:
+			enum counter_id
+			{
+				cycles_counter = 0,
+				instructions_counter = 1,
+				llc_misses_counter = 2,
+				counter_count = 3
+			};
+
+			// File descriptors per thread, the first one is the group leader, -1 for counters not available
+			std::vector<std::vector<int> > thread_counter_fd_list;
+
+		private:
+			plain_perf_counter_collector(const plain_perf_counter_collector&) = delete;
+			plain_perf_counter_collector& operator =(const plain_perf_counter_collector&) = delete;
+		};
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_reduce_all_queue.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		plain_reduce_all_queue::plain_reduce_all_queue(plain_communicator::ptr communicator)
+			: communicator(communicator)
+			, running(false)
+			, stop(false)
+		{
+			worker = std::thread([this] () { run(); });
+		}
+
+		plain_reduce_all_queue::~plain_reduce_all_queue()
+		{
+			{
+				std::lock_guard<std::mutex> lock(queue_mutex);
+				stop = true;
+			}
+			queue_condition.notify_all();
+			worker.join();
+		}
+
+		void plain_reduce_all_queue::enqueue(
+			float * data,
+			size_t elem_count)
+		{
+			{
+				std::lock_guard<std::mutex> lock(queue_mutex);
+				pending.push_back(std::make_pair(data, elem_count));
+			}
+			queue_condition.notify_all();
+		}
+
+		void plain_reduce_all_queue::wait()
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			queue_condition.wait(lock, [this] () { return (pending.empty() && !running) || error; });
+			if (error)
+			{
+				std::exception_ptr e = error;
+				error = std::exception_ptr();
+				pending.clear();
+				std::rethrow_exception(e);
+			}
+		}
+
+		void plain_reduce_all_queue::run()
+		{
+			while (true)
+			{
+				std::pair<float *, size_t> current;
+				{
+					std::unique_lock<std::mutex> lock(queue_mutex);
+					queue_condition.wait(lock, [this] () { return stop || (!pending.empty() && !error); });
+					if (stop)
+						return;
+					current = pending.front();
+					pending.pop_front();
+					running = true;
+				}
+
+				try
+				{
+					communicator->reduce_all(current.first, current.second);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(queue_mutex);
+					error = std::current_exception();
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(queue_mutex);
+					running = false;
+				}
+				queue_condition.notify_all();
+			}
+		}
+	}
+}
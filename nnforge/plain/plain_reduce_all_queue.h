@@ -0,0 +1,72 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_communicator.h"
+
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Reduces data across worker processes on a background thread in the order it is enqueued,
+		// so that gradients of the layers already done are exchanged while backward pass goes on with the rest
+		class plain_reduce_all_queue
+		{
+		public:
+			typedef std::shared_ptr<plain_reduce_all_queue> ptr;
+
+			plain_reduce_all_queue(plain_communicator::ptr communicator);
+
+			// Drops the reductions not started yet
+			~plain_reduce_all_queue();
+
+			// data should not be accessed until wait returns
+			void enqueue(
+				float * data,
+				size_t elem_count);
+
+			// Returns when all the enqueued reductions are done, the first exception thrown by the communicator is rethrown
+			void wait();
+
+		private:
+			void run();
+
+		private:
+			plain_communicator::ptr communicator;
+
+			std::mutex queue_mutex;
+			std::condition_variable queue_condition;
+			std::deque<std::pair<float *, size_t> > pending;
+			bool running;
+			bool stop;
+			std::exception_ptr error;
+
+			std::thread worker;
+
+		private:
+			plain_reduce_all_queue(const plain_reduce_all_queue&) = delete;
+			plain_reduce_all_queue& operator =(const plain_reduce_all_queue&) = delete;
+		};
+	}
+}
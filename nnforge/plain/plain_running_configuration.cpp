@@ -16,6 +16,12 @@
 
 #include "plain_running_configuration.h"
 
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <limits>
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -24,15 +30,74 @@ namespace nnforge
 {
 	namespace plain
 	{
+		plain_running_configuration::options::options()
+			: activation_checkpointing(false)
+			, inter_op_parallelism(false)
+			, bind_threads(false)
+			, numa_aware(false)
+			, perf_counters(false)
+			, autotune(false)
+			, cache_aware_chunk_size(false)
+			, async_sgd_worker_count(0)
+			, selective_backprop_rate(1.0F)
+		{
+		}
+
 		plain_running_configuration::plain_running_configuration(
 			int openmp_thread_count,
-			float max_memory_usage_gigabytes)
+			float max_memory_usage_gigabytes,
+			const options& running_options)
 			: openmp_thread_count(openmp_thread_count)
 			, max_memory_usage_gigabytes(max_memory_usage_gigabytes)
+			, activation_checkpointing(running_options.activation_checkpointing)
+			, activation_checkpoint_layer_names(running_options.activation_checkpoint_layer_names)
+			, inter_op_parallelism(running_options.inter_op_parallelism)
+			, bind_threads(running_options.bind_threads)
+			, numa_aware(running_options.numa_aware)
+			, perf_counters(running_options.perf_counters)
+			, first_pool_worker_id(0)
+			, cache_aware_chunk_size(running_options.cache_aware_chunk_size)
+			, communicator(running_options.communicator)
+			, async_sgd_worker_count(running_options.async_sgd_worker_count)
+			, selective_backprop_rate(running_options.selective_backprop_rate)
+			, flops_measured(false)
+			, measured_flops(0.0F)
 		{
 			#ifndef _OPENMP
 			this->openmp_thread_count = 1;
 			#endif
+
+			numa_topology = plain_numa_topology::const_ptr(new plain_numa_topology());
+			cache_topology = plain_cache_topology::const_ptr(new plain_cache_topology());
+			task_runtime = plain_task_runtime::ptr(new plain_task_runtime(static_cast<unsigned int>(std::max(this->openmp_thread_count, 1)), bind_threads, numa_aware, numa_topology));
+			if (running_options.autotune)
+				autotuner = plain_autotuner::ptr(new plain_autotuner(running_options.autotune_cache_file_path));
+		}
+
+		plain_running_configuration::plain_running_configuration(
+			const plain_running_configuration& parent,
+			int openmp_thread_count,
+			unsigned int first_pool_worker_id)
+			: openmp_thread_count(openmp_thread_count)
+			, max_memory_usage_gigabytes(parent.max_memory_usage_gigabytes)
+			, activation_checkpointing(parent.activation_checkpointing)
+			, activation_checkpoint_layer_names(parent.activation_checkpoint_layer_names)
+			, inter_op_parallelism(parent.inter_op_parallelism)
+			, bind_threads(parent.bind_threads)
+			, numa_aware(parent.numa_aware)
+			, numa_topology(parent.numa_topology)
+			, perf_counters(parent.perf_counters)
+			, task_runtime(parent.task_runtime)
+			, first_pool_worker_id(first_pool_worker_id)
+			, autotuner(parent.autotuner)
+			, cache_aware_chunk_size(parent.cache_aware_chunk_size)
+			, cache_topology(parent.cache_topology)
+			, communicator(parent.communicator)
+			, async_sgd_worker_count(parent.async_sgd_worker_count)
+			, selective_backprop_rate(parent.selective_backprop_rate)
+			, flops_measured(false)
+			, measured_flops(0.0F)
+		{
 		}
 
 		unsigned int plain_running_configuration::get_max_entry_count(
@@ -48,6 +113,156 @@ namespace nnforge
 			return static_cast<unsigned int>(entry_count_limited_by_global);
 		}
 
+		unsigned int plain_running_configuration::get_cache_aware_entry_count(size_t working_set_per_entry_size) const
+		{
+			unsigned int thread_count = static_cast<unsigned int>(std::max(openmp_thread_count, 1));
+			size_t entry_count = cache_topology->get_capacity(thread_count) / std::max(working_set_per_entry_size, static_cast<size_t>(1));
+			// Each thread gets the same number of entries when kernels parallelize over entries
+			entry_count = std::max(entry_count / thread_count, static_cast<size_t>(1)) * thread_count;
+			return static_cast<unsigned int>(std::min(entry_count, static_cast<size_t>(std::numeric_limits<unsigned int>::max())));
+		}
+
+		std::vector<plain_running_configuration::const_ptr> plain_running_configuration::get_thread_group_config_list() const
+		{
+			std::vector<const_ptr> res;
+			for(int thread_count = 1; thread_count <= openmp_thread_count; ++thread_count)
+				res.push_back(const_ptr(new plain_running_configuration(*this, thread_count, first_pool_worker_id)));
+			return res;
+		}
+
+		plain_running_configuration::const_ptr plain_running_configuration::get_thread_partition_config(
+			int thread_count,
+			unsigned int first_pool_worker_id) const
+		{
+			return const_ptr(new plain_running_configuration(*this, std::max(thread_count, 1), this->first_pool_worker_id + first_pool_worker_id));
+		}
+
+		std::vector<plain_running_configuration::const_ptr> plain_running_configuration::get_thread_partition_config_list(unsigned int group_count) const
+		{
+			// Each group has its own calling thread, so it takes one pool thread less than its thread count
+			int thread_count = std::max(openmp_thread_count / static_cast<int>(std::max(group_count, 1U)), 1);
+			std::vector<const_ptr> res;
+			for(unsigned int group_id = 0; group_id < group_count; ++group_id)
+				res.push_back(get_thread_partition_config(thread_count, group_id * static_cast<unsigned int>(thread_count - 1)));
+			return res;
+		}
+
+		void plain_running_configuration::parallel_for(
+			int count,
+			const plain_task_runtime::range_function& func,
+			int grain_size) const
+		{
+			task_runtime->parallel_for(count, func, static_cast<unsigned int>(std::max(openmp_thread_count, 1)), grain_size, first_pool_worker_id);
+		}
+
+		void plain_running_configuration::parallel_for_with_thread_id(
+			int count,
+			const plain_task_runtime::thread_range_function& func,
+			int grain_size) const
+		{
+			task_runtime->parallel_for_with_thread_id(count, func, static_cast<unsigned int>(std::max(openmp_thread_count, 1)), grain_size, first_pool_worker_id);
+		}
+
+		std::vector<long> plain_running_configuration::get_os_thread_id_list() const
+		{
+			std::vector<long> res;
+			long current_thread_id = plain_task_runtime::get_current_os_thread_id();
+			if (current_thread_id < 0)
+				return res;
+			res.push_back(current_thread_id);
+
+			unsigned int worker_count = std::min(static_cast<unsigned int>(std::max(openmp_thread_count, 1)), task_runtime->get_thread_count()) - 1;
+			for(unsigned int worker_id = first_pool_worker_id; worker_id < first_pool_worker_id + worker_count; ++worker_id)
+			{
+				long worker_thread_id = task_runtime->get_worker_os_thread_id(worker_id);
+				if (worker_thread_id >= 0)
+					res.push_back(worker_thread_id);
+			}
+
+			return res;
+		}
+
+		void plain_running_configuration::first_touch(
+			plain_buffer& buffer,
+			unsigned int entry_count) const
+		{
+			if (!numa_aware || (numa_topology->get_node_count() <= 1) || (entry_count == 0))
+				return;
+
+			// The task runtime deals the same ranges of entries to the same threads and doesn't move them to other nodes
+			unsigned char * buf = buffer;
+			size_t size = buffer.get_size();
+			size_t per_entry_size = size / entry_count;
+			parallel_for(static_cast<int>(entry_count), [&] (int begin, int end)
+			{
+				size_t offset = static_cast<size_t>(begin) * per_entry_size;
+				size_t end_offset = (end == static_cast<int>(entry_count)) ? size : static_cast<size_t>(end) * per_entry_size;
+				memset(buf + offset, 0, end_offset - offset);
+			});
+		}
+
+		float plain_running_configuration::get_flops() const
+		{
+			std::lock_guard<std::mutex> lock(flops_mutex);
+			if (!flops_measured)
+			{
+				measured_flops = measure_flops();
+				flops_measured = true;
+			}
+			return measured_flops;
+		}
+
+		bool plain_running_configuration::get_measured_flops(float& flops) const
+		{
+			std::lock_guard<std::mutex> lock(flops_mutex);
+			if (!flops_measured)
+				return false;
+			flops = measured_flops;
+			return true;
+		}
+
+		float plain_running_configuration::measure_flops() const
+		{
+			// Independent accumulators let the compiler vectorize and pipeline multiply-adds, as it does in real kernels
+			const int accumulator_count = 64;
+			const int iteration_count = 1 << 20;
+			const int run_count = 3;
+			int thread_count = std::max(openmp_thread_count, 1);
+
+			double best_seconds = 0.0;
+			std::atomic<int> sink(0);
+			for(int run_id = 0; run_id < run_count; ++run_id)
+			{
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				parallel_for(thread_count, [&] (int begin, int end)
+				{
+					for(int thread_id = begin; thread_id < end; ++thread_id)
+					{
+						float acc[accumulator_count];
+						for(int i = 0; i < accumulator_count; ++i)
+							acc[i] = static_cast<float>(i + thread_id);
+						const float mult = 0.999999F;
+						const float add = 1.0e-7F;
+						for(int iteration_id = 0; iteration_id < iteration_count; ++iteration_id)
+							for(int i = 0; i < accumulator_count; ++i)
+								acc[i] = acc[i] * mult + add;
+						float sum = 0.0F;
+						for(int i = 0; i < accumulator_count; ++i)
+							sum += acc[i];
+						// Keep the result alive
+						if (sum == 0.0F)
+							++sink;
+					}
+				});
+				std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+				if ((run_id == 0) || (sec.count() < best_seconds))
+					best_seconds = sec.count();
+			}
+
+			double flops = 2.0 * static_cast<double>(accumulator_count) * static_cast<double>(iteration_count) * static_cast<double>(thread_count);
+			return static_cast<float>(flops / best_seconds);
+		}
+
 		std::ostream& operator<< (std::ostream& out, const plain_running_configuration& running_configuration)
 		{
 			out << "--- Configuration ---" << std::endl;
@@ -57,10 +272,69 @@ namespace nnforge
 			out << "Built without OpenMP support" << std::endl;
 			#endif
 
+			out << *running_configuration.numa_topology;
+			out << *running_configuration.cache_topology;
+			// The microbenchmark is not run just to print the configuration
+			float measured_flops;
+			if (running_configuration.get_measured_flops(measured_flops))
+				out << "Measured GFLOPS = " << static_cast<int>(measured_flops / 1.0e+9F) << std::endl;
+
 			out << "--- Settings ---" << std::endl;
 
 			out << "Max memory usage = " << running_configuration.max_memory_usage_gigabytes << " GB" << std::endl;
 			out << "OpenMP thread count = " << running_configuration.openmp_thread_count << std::endl;
+			out << "Activation checkpointing = " << (running_configuration.activation_checkpointing ? "on" : "off");
+			if (running_configuration.activation_checkpointing)
+			{
+				if (running_configuration.activation_checkpoint_layer_names.empty())
+					out << " (auto)";
+				else
+				{
+					out << " (";
+					for(std::vector<std::string>::const_iterator it = running_configuration.activation_checkpoint_layer_names.begin(); it != running_configuration.activation_checkpoint_layer_names.end(); ++it)
+					{
+						if (it != running_configuration.activation_checkpoint_layer_names.begin())
+							out << ", ";
+						out << *it;
+					}
+					out << ")";
+				}
+			}
+			out << std::endl;
+			out << "Inter-op parallelism = " << (running_configuration.inter_op_parallelism ? "on" : "off") << std::endl;
+			out << "Bind threads = " << (running_configuration.bind_threads ? "on" : "off") << std::endl;
+			out << "NUMA aware = " << (running_configuration.numa_aware ? "on" : "off") << std::endl;
+			out << "Hardware counters = " << (running_configuration.perf_counters ? "on" : "off") << std::endl;
+			out << "Cache-aware chunk size = " << (running_configuration.cache_aware_chunk_size ? "on" : "off") << std::endl;
+			out << "Communicator = ";
+			if (running_configuration.communicator)
+				out << running_configuration.communicator->get_type_name() << " (rank " << running_configuration.communicator->get_rank() << " of " << running_configuration.communicator->get_worker_count() << ")";
+			else
+				out << "none";
+			out << std::endl;
+			out << "Asynchronous SGD = ";
+			if (running_configuration.async_sgd_worker_count > 1)
+				out << running_configuration.async_sgd_worker_count << " workers";
+			else
+				out << "off";
+			out << std::endl;
+			out << "Selective backprop = ";
+			if (running_configuration.selective_backprop_rate < 1.0F)
+				out << (running_configuration.selective_backprop_rate * 100.0F) << "% of entries";
+			else
+				out << "off";
+			out << std::endl;
+			out << "Autotuning = ";
+			if (running_configuration.autotuner)
+			{
+				out << "on (" << running_configuration.autotuner->get_cpu_model();
+				if (!running_configuration.autotuner->get_cache_file_path().empty())
+					out << ", cache " << running_configuration.autotuner->get_cache_file_path();
+				out << ")";
+			}
+			else
+				out << "off";
+			out << std::endl;
 
 			return out;
 		}
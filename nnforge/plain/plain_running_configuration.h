@@ -19,8 +19,17 @@
 #include <ostream>
 
 #include "buffer_plain_size_configuration.h"
+#include "plain_task_runtime.h"
+#include "plain_numa_topology.h"
+#include "plain_cache_topology.h"
+#include "plain_buffer.h"
+#include "plain_autotuner.h"
+#include "plain_communicator.h"
 
 #include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
 
 namespace nnforge
 {
@@ -31,18 +40,124 @@ namespace nnforge
 		public:
 			typedef std::shared_ptr<const plain_running_configuration> const_ptr;
 
+			// Optional settings, they are copied to the members of the same name, autotune and autotune_cache_file_path set up autotuner.
+			// Defaults turn all of them off
+			struct options
+			{
+				options();
+
+				bool activation_checkpointing;
+				std::vector<std::string> activation_checkpoint_layer_names;
+				bool inter_op_parallelism;
+				bool bind_threads;
+				bool numa_aware;
+				bool perf_counters;
+				bool autotune;
+				std::string autotune_cache_file_path;
+				bool cache_aware_chunk_size;
+				plain_communicator::ptr communicator;
+				int async_sgd_worker_count;
+				float selective_backprop_rate;
+			};
+
 			plain_running_configuration(
 				int openmp_thread_count,
-				float max_memory_usage_gigabytes);
+				float max_memory_usage_gigabytes,
+				const options& running_options = options());
 
 			unsigned int get_max_entry_count(
 				const buffer_plain_size_configuration& buffers_config,
 				float ratio = 1.0F) const;
 
+			// The largest entry count keeping working_set_per_entry_size bytes per entry in the caches available to openmp_thread_count threads,
+			// it is a multiple of the thread count and is at least the thread count
+			unsigned int get_cache_aware_entry_count(size_t working_set_per_entry_size) const;
+
+			// Returns configurations with the same settings, i-th one has OpenMP thread count equal to i + 1
+			std::vector<const_ptr> get_thread_group_config_list() const;
+
+			// Returns configuration with the same settings and thread_count threads, its ranges are run by the calling thread and
+			// pool threads [first_pool_worker_id, first_pool_worker_id + thread_count - 1) of this configuration only
+			const_ptr get_thread_partition_config(
+				int thread_count,
+				unsigned int first_pool_worker_id) const;
+
+			// Splits threads of this configuration between group_count configurations with non-overlapping pool threads,
+			// each of them is to be used from its own thread
+			std::vector<const_ptr> get_thread_partition_config_list(unsigned int group_count) const;
+
+			// Runs func on consecutive ranges of [0, count) using up to openmp_thread_count threads of the task runtime
+			void parallel_for(
+				int count,
+				const plain_task_runtime::range_function& func,
+				int grain_size = 1) const;
+
+			// The same as parallel_for, func gets thread_id less than openmp_thread_count, unique among the ranges running at the same time
+			void parallel_for_with_thread_id(
+				int count,
+				const plain_task_runtime::thread_range_function& func,
+				int grain_size = 1) const;
+
+			// Touches memory pages of the newly allocated buffer holding entry_count entries from the threads which are going to process them,
+			// entries are split the same way as by parallel_for(entry_count, ...) in kernels, so that the pages are placed on the NUMA nodes of these threads.
+			// Does nothing when not NUMA aware
+			void first_touch(
+				plain_buffer& buffer,
+				unsigned int entry_count) const;
+
+			// OS ids of the calling thread and of the pool threads parallel_for of this configuration runs ranges on, Linux only, empty elsewhere
+			std::vector<long> get_os_thread_id_list() const;
+
+			// Peak FLOPS achievable with openmp_thread_count threads, measured with a short FMA microbenchmark on the first call.
+			// Propagators call it when profiling only
+			float get_flops() const;
+
+			// The method returns false in case get_flops has not been called yet
+			bool get_measured_flops(float& flops) const;
+
 			float max_memory_usage_gigabytes;
 			int openmp_thread_count;
+			bool activation_checkpointing;
+			// Empty list means checkpoint layers are selected automatically
+			std::vector<std::string> activation_checkpoint_layer_names;
+			bool inter_op_parallelism;
+			bool bind_threads;
+			bool numa_aware;
+			plain_numa_topology::const_ptr numa_topology;
+			// Collect hardware counters per action in profile mode
+			bool perf_counters;
+			// Shared by all the configurations returned by get_thread_group_config_list
+			plain_task_runtime::ptr task_runtime;
+			// Pool threads of task_runtime this configuration starts from
+			unsigned int first_pool_worker_id;
+			// Picks the fastest algorithm for layers having alternative implementations, empty when autotuning is off
+			plain_autotuner::ptr autotuner;
+			// Limit chunk size so that inputs and outputs of each layer stay in cache
+			bool cache_aware_chunk_size;
+			plain_cache_topology::const_ptr cache_topology;
+			// Reduces gradients across worker processes when training in multiple processes, empty otherwise
+			plain_communicator::ptr communicator;
+			// Number of threads training asynchronously without locks (Hogwild), each running its own chunks with its share of OpenMP threads,
+			// 0 or 1 means synchronous training
+			int async_sgd_worker_count;
+			// Fraction of entries of each chunk backward pass is run for, these are the ones with the largest error, 1 means all the entries
+			float selective_backprop_rate;
 
 		private:
+			float measure_flops() const;
+
+		private:
+			mutable std::mutex flops_mutex;
+			mutable bool flops_measured;
+			mutable float measured_flops;
+
+		private:
+			// Copies settings and shares task runtime with parent
+			plain_running_configuration(
+				const plain_running_configuration& parent,
+				int openmp_thread_count,
+				unsigned int first_pool_worker_id);
+
 			plain_running_configuration() = delete;
 			plain_running_configuration(const plain_running_configuration&) = delete;
 			plain_running_configuration& operator =(const plain_running_configuration&) = delete;
@@ -0,0 +1,220 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_shared_memory_communicator.h"
+
+#include "../neural_network_exception.h"
+
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/interprocess_condition.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		struct plain_shared_memory_communicator::segment_header
+		{
+			boost::interprocess::interprocess_mutex mutex;
+			boost::interprocess::interprocess_condition condition;
+			unsigned int worker_count;
+			unsigned int arrived_count;
+			unsigned int generation;
+			// Written last by the creator, the others don't touch the segment until it is set
+			volatile unsigned int magic;
+		};
+
+		const size_t plain_shared_memory_communicator::bucket_elem_count = 1 << 20;
+		const unsigned int plain_shared_memory_communicator::magic = 0x6E6E6673;
+		const int plain_shared_memory_communicator::attach_timeout_seconds = 60;
+		const int plain_shared_memory_communicator::barrier_timeout_seconds = 600;
+
+		plain_shared_memory_communicator::plain_shared_memory_communicator(
+			const std::string& segment_name,
+			unsigned int rank,
+			unsigned int worker_count)
+			: segment_name(segment_name)
+			, rank(rank)
+			, worker_count(worker_count)
+			, header(0)
+		{
+			if (rank >= worker_count)
+				throw neural_network_exception((boost::format("Invalid rank %1% for %2% workers") % rank % worker_count).str());
+
+			// A slot per worker for its bucket and one for the result
+			size_t segment_size = sizeof(segment_header) + sizeof(float) * bucket_elem_count * (worker_count + 1);
+
+			if (rank == 0)
+			{
+				boost::interprocess::shared_memory_object::remove(segment_name.c_str());
+				segment = std::make_shared<boost::interprocess::shared_memory_object>(boost::interprocess::create_only, segment_name.c_str(), boost::interprocess::read_write);
+				segment->truncate(static_cast<boost::interprocess::offset_t>(segment_size));
+				region = std::make_shared<boost::interprocess::mapped_region>(*segment, boost::interprocess::read_write);
+				header = new (region->get_address()) segment_header();
+				header->worker_count = worker_count;
+				header->arrived_count = 0;
+				header->generation = 0;
+				header->magic = magic;
+			}
+			else
+			{
+				std::chrono::steady_clock::time_point attach_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(attach_timeout_seconds);
+				while (true)
+				{
+					try
+					{
+						segment = std::make_shared<boost::interprocess::shared_memory_object>(boost::interprocess::open_only, segment_name.c_str(), boost::interprocess::read_write);
+						boost::interprocess::offset_t size;
+						if (segment->get_size(size) && (size >= static_cast<boost::interprocess::offset_t>(segment_size)))
+						{
+							region = std::make_shared<boost::interprocess::mapped_region>(*segment, boost::interprocess::read_write);
+							header = static_cast<segment_header *>(region->get_address());
+							if (header->magic == magic)
+								break;
+						}
+					}
+					catch (const boost::interprocess::interprocess_exception&)
+					{
+					}
+					region.reset();
+					segment.reset();
+					header = 0;
+
+					if (std::chrono::steady_clock::now() > attach_deadline)
+						throw neural_network_exception((boost::format("Worker %1% could not attach to shared memory segment %2% in %3% seconds") % rank % segment_name % attach_timeout_seconds).str());
+					std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				}
+
+				if (header->worker_count != worker_count)
+					throw neural_network_exception((boost::format("Shared memory segment %1% is created for %2% workers while %3% are specified") % segment_name % header->worker_count % worker_count).str());
+			}
+		}
+
+		plain_shared_memory_communicator::~plain_shared_memory_communicator()
+		{
+			region.reset();
+			segment.reset();
+			if (rank == 0)
+				boost::interprocess::shared_memory_object::remove(segment_name.c_str());
+		}
+
+		float * plain_shared_memory_communicator::get_slot(unsigned int slot_id) const
+		{
+			return reinterpret_cast<float *>(static_cast<char *>(region->get_address()) + sizeof(segment_header)) + bucket_elem_count * slot_id;
+		}
+
+		void plain_shared_memory_communicator::barrier()
+		{
+			boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(header->mutex);
+
+			unsigned int generation = header->generation;
+			if ((++header->arrived_count) == worker_count)
+			{
+				header->arrived_count = 0;
+				++header->generation;
+				header->condition.notify_all();
+				return;
+			}
+
+			boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::seconds(barrier_timeout_seconds);
+			while (header->generation == generation)
+			{
+				if ((!header->condition.timed_wait(lock, deadline)) && (header->generation == generation))
+					throw neural_network_exception((boost::format("Worker %1% timed out waiting for the others in %2%") % rank % segment_name).str());
+			}
+		}
+
+		void plain_shared_memory_communicator::reduce_all(
+			float * data,
+			size_t elem_count)
+		{
+			if (worker_count == 1)
+				return;
+
+			float * own_slot = get_slot(rank);
+			float * result_slot = get_slot(worker_count);
+			for(size_t offset = 0; offset < elem_count; offset += bucket_elem_count)
+			{
+				size_t current_elem_count = std::min(bucket_elem_count, elem_count - offset);
+				memcpy(own_slot, data + offset, current_elem_count * sizeof(float));
+
+				barrier();
+
+				// Summing in the same order for all the elements keeps results identical to the ones of a fixed reduction tree
+				size_t share_start = current_elem_count * rank / worker_count;
+				size_t share_end = current_elem_count * (rank + 1) / worker_count;
+				std::copy(get_slot(0) + share_start, get_slot(0) + share_end, result_slot + share_start);
+				for(unsigned int slot_id = 1; slot_id < worker_count; ++slot_id)
+				{
+					const float * src = get_slot(slot_id);
+					for(size_t i = share_start; i < share_end; ++i)
+						result_slot[i] += src[i];
+				}
+
+				barrier();
+
+				memcpy(data + offset, result_slot, current_elem_count * sizeof(float));
+
+				// Slots are reused by the next bucket
+				barrier();
+			}
+		}
+
+		void plain_shared_memory_communicator::broadcast(
+			float * data,
+			size_t elem_count)
+		{
+			if (worker_count == 1)
+				return;
+
+			float * result_slot = get_slot(worker_count);
+			for(size_t offset = 0; offset < elem_count; offset += bucket_elem_count)
+			{
+				size_t current_elem_count = std::min(bucket_elem_count, elem_count - offset);
+				if (rank == 0)
+					memcpy(result_slot, data + offset, current_elem_count * sizeof(float));
+
+				barrier();
+
+				if (rank != 0)
+					memcpy(data + offset, result_slot, current_elem_count * sizeof(float));
+
+				barrier();
+			}
+		}
+
+		unsigned int plain_shared_memory_communicator::get_rank() const
+		{
+			return rank;
+		}
+
+		unsigned int plain_shared_memory_communicator::get_worker_count() const
+		{
+			return worker_count;
+		}
+
+		std::string plain_shared_memory_communicator::get_type_name() const
+		{
+			return "shared_memory";
+		}
+	}
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_communicator.h"
+
+#include <string>
+#include <memory>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Worker processes on the same host exchange data through a shared memory segment.
+		// Data is processed in buckets: each worker puts its bucket into its own slot, then sums its share of elements across all the slots,
+		// then all the workers copy the whole result back (reduce-scatter followed by all-gather).
+		// The worker with rank 0 creates the segment and should be constructed before the others, which wait for it.
+		// segment_name should be unique for each run: the others might attach to a segment a crashed run left before rank 0 removes it
+		class plain_shared_memory_communicator : public plain_communicator
+		{
+		public:
+			plain_shared_memory_communicator(
+				const std::string& segment_name,
+				unsigned int rank,
+				unsigned int worker_count);
+
+			virtual ~plain_shared_memory_communicator();
+
+			virtual void reduce_all(
+				float * data,
+				size_t elem_count);
+
+			virtual void broadcast(
+				float * data,
+				size_t elem_count);
+
+			virtual unsigned int get_rank() const;
+
+			virtual unsigned int get_worker_count() const;
+
+			virtual std::string get_type_name() const;
+
+		private:
+			struct segment_header;
+
+			// Waits for all the workers to reach the barrier, throws exception if some of them don't come in time
+			void barrier();
+
+			float * get_slot(unsigned int slot_id) const;
+
+		private:
+			std::string segment_name;
+			unsigned int rank;
+			unsigned int worker_count;
+
+			std::shared_ptr<boost::interprocess::shared_memory_object> segment;
+			std::shared_ptr<boost::interprocess::mapped_region> region;
+			segment_header * header;
+
+			static const size_t bucket_elem_count;
+			static const unsigned int magic;
+			static const int attach_timeout_seconds;
+			static const int barrier_timeout_seconds;
+		};
+	}
+}
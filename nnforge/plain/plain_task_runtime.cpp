@@ -0,0 +1,431 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_task_runtime.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// NUMA node the thread calling parallel_for was last moved to, -1 if it was not
+		static thread_local int calling_thread_node_id = -1;
+		// Pool threads waiting for nested calls run ranges of any node, so that they never wait for each other
+		static thread_local bool is_pool_thread = false;
+
+		struct plain_task_runtime::job
+		{
+			job(
+				const thread_range_function& func,
+				int task_count,
+				unsigned int first_worker_id,
+				unsigned int worker_count,
+				unsigned int node_count)
+				: func(func)
+				, first_worker_id(first_worker_id)
+				, worker_count(worker_count)
+				, queued_task_count_list(node_count)
+				, remaining_task_count(task_count)
+				, error_encountered(false)
+			{
+				for(std::vector<std::atomic<int> >::iterator it = queued_task_count_list.begin(); it != queued_task_count_list.end(); ++it)
+					*it = 0;
+			}
+
+			bool is_worker_allowed(unsigned int worker_id) const
+			{
+				return (worker_id >= first_worker_id) && (worker_id < first_worker_id + worker_count);
+			}
+
+			const thread_range_function& func;
+			// Pool threads [first_worker_id, first_worker_id + worker_count) run the tasks besides the calling thread
+			unsigned int first_worker_id;
+			unsigned int worker_count;
+			// Tasks still in the deques, per node of the deque
+			std::vector<std::atomic<int> > queued_task_count_list;
+			std::atomic<int> remaining_task_count;
+			std::mutex m;
+			std::condition_variable done_condition;
+			bool error_encountered;
+			std::exception_ptr error;
+		};
+
+		plain_task_runtime::plain_task_runtime(
+			unsigned int thread_count,
+			bool bind_threads,
+			bool numa_aware,
+			plain_numa_topology::const_ptr numa_topology)
+			: thread_count(std::max(thread_count, 1U))
+			, numa_aware(numa_aware && (numa_topology->get_node_count() > 1))
+			, numa_topology(numa_topology)
+			, node_count(this->numa_aware ? numa_topology->get_node_count() : 1)
+			, stopping(false)
+		{
+			std::vector<unsigned int> all_cpu_list;
+			for(unsigned int node_id = 0; node_id < numa_topology->get_node_count(); ++node_id)
+				all_cpu_list.insert(all_cpu_list.end(), numa_topology->get_node_cpu_list(node_id).begin(), numa_topology->get_node_cpu_list(node_id).end());
+
+			// Thread i (the calling thread is 0) belongs to node i * node_count / thread_count, so threads of each node are consecutive
+			std::vector<unsigned int> node_first_thread_id_list(node_count, this->thread_count);
+			for(unsigned int thread_id = this->thread_count; thread_id > 0; --thread_id)
+				node_first_thread_id_list[(thread_id - 1) * node_count / this->thread_count] = thread_id - 1;
+
+			for(unsigned int worker_id = 0; worker_id < this->thread_count - 1; ++worker_id)
+			{
+				task_deques.push_back(std::unique_ptr<task_deque>(new task_deque()));
+				worker_node_id_list.push_back((worker_id + 1) * node_count / this->thread_count);
+			}
+			worker_os_thread_id_list.resize(this->thread_count - 1, -1);
+
+			for(unsigned int worker_id = 0; worker_id < this->thread_count - 1; ++worker_id)
+			{
+				threads.push_back(std::thread(&plain_task_runtime::run_worker, this, worker_id));
+
+				unsigned int thread_id = worker_id + 1;
+				if (numa_aware)
+				{
+					unsigned int node_id = worker_node_id_list[worker_id];
+					const std::vector<unsigned int>& node_cpu_list = numa_topology->get_node_cpu_list(node_id);
+					if (bind_threads)
+						set_thread_affinity(threads.back(), std::vector<unsigned int>(1, node_cpu_list[(thread_id - node_first_thread_id_list[node_id]) % node_cpu_list.size()]));
+					else
+						set_thread_affinity(threads.back(), node_cpu_list);
+				}
+				else if (bind_threads)
+				{
+					// The calling thread is left to the OS, pool threads take the cores after the first one
+					set_thread_affinity(threads.back(), std::vector<unsigned int>(1, all_cpu_list[thread_id % all_cpu_list.size()]));
+				}
+			}
+
+			#ifdef __linux__
+			// Workers register their ids as soon as they start
+			std::unique_lock<std::mutex> lock(park_mutex);
+			park_condition.wait(lock, [this] () { return std::find(worker_os_thread_id_list.begin(), worker_os_thread_id_list.end(), -1L) == worker_os_thread_id_list.end(); });
+			#endif
+		}
+
+		plain_task_runtime::~plain_task_runtime()
+		{
+			{
+				std::lock_guard<std::mutex> lock(park_mutex);
+				stopping = true;
+			}
+			park_condition.notify_all();
+			for(std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+				it->join();
+		}
+
+		unsigned int plain_task_runtime::get_thread_count() const
+		{
+			return thread_count;
+		}
+
+		long plain_task_runtime::get_worker_os_thread_id(unsigned int worker_id) const
+		{
+			std::lock_guard<std::mutex> lock(park_mutex);
+			return (worker_id < worker_os_thread_id_list.size()) ? worker_os_thread_id_list[worker_id] : -1L;
+		}
+
+		long plain_task_runtime::get_current_os_thread_id()
+		{
+			#ifdef __linux__
+			return static_cast<long>(::syscall(SYS_gettid));
+			#else
+			return -1L;
+			#endif
+		}
+
+		void plain_task_runtime::parallel_for(
+			int count,
+			const range_function& func,
+			unsigned int thread_count,
+			int grain_size,
+			unsigned int first_worker_id) const
+		{
+			parallel_for_with_thread_id(
+				count,
+				[&func] (int begin, int end, unsigned int thread_id) { func(begin, end); },
+				thread_count,
+				grain_size,
+				first_worker_id);
+		}
+
+		void plain_task_runtime::parallel_for_with_thread_id(
+			int count,
+			const thread_range_function& func,
+			unsigned int thread_count,
+			int grain_size,
+			unsigned int first_worker_id) const
+		{
+			if (count <= 0)
+				return;
+
+			int max_task_count = static_cast<int>(std::min(thread_count, this->thread_count)) * 4;
+			int task_count = std::min((count + std::max(grain_size, 1) - 1) / std::max(grain_size, 1), max_task_count);
+			unsigned int deque_count = static_cast<unsigned int>(task_deques.size());
+			unsigned int worker_count = (first_worker_id < deque_count) ? std::min(std::min(thread_count, this->thread_count) - 1, deque_count - first_worker_id) : 0;
+			int node_id = bind_calling_thread(first_worker_id);
+			if ((task_count <= 1) || (worker_count == 0))
+			{
+				func(0, count, 0);
+				return;
+			}
+
+			job current_job(func, task_count, first_worker_id, worker_count, node_count);
+			{
+				// Ranges are dealt to the deques of the workers of the job, they steal them from each other
+				for(int task_id = 0; task_id < task_count; ++task_id)
+				{
+					task t;
+					t.parent_job = &current_job;
+					t.begin = static_cast<int>(static_cast<long long>(count) * task_id / task_count);
+					t.end = static_cast<int>(static_cast<long long>(count) * (task_id + 1) / task_count);
+					unsigned int worker_id = first_worker_id + task_id * worker_count / task_count;
+					task_deque& d = *task_deques[worker_id];
+					std::lock_guard<std::mutex> lock(d.m);
+					d.tasks.push_back(t);
+					++current_job.queued_task_count_list[worker_node_id_list[worker_id]];
+				}
+				{
+					std::lock_guard<std::mutex> lock(park_mutex);
+					active_jobs.push_back(&current_job);
+				}
+				park_condition.notify_all();
+			}
+
+			// The calling thread helps until all the ranges are taken, then waits for the ones still running
+			task t;
+			while (current_job.remaining_task_count > 0)
+			{
+				if (take_job_task(current_job, node_id, t))
+					run_task(t, 0);
+				else
+				{
+					std::unique_lock<std::mutex> lock(current_job.m);
+					current_job.done_condition.wait(lock, [&current_job] () { return current_job.remaining_task_count == 0; });
+				}
+			}
+			{
+				// Make sure the last task has released the job
+				std::lock_guard<std::mutex> lock(current_job.m);
+			}
+			{
+				std::lock_guard<std::mutex> lock(park_mutex);
+				active_jobs.erase(std::find(active_jobs.begin(), active_jobs.end(), &current_job));
+			}
+
+			if (current_job.error_encountered)
+				std::rethrow_exception(current_job.error);
+		}
+
+		void plain_task_runtime::run_worker(unsigned int worker_id)
+		{
+			is_pool_thread = true;
+			#ifdef __linux__
+			{
+				std::lock_guard<std::mutex> lock(park_mutex);
+				worker_os_thread_id_list[worker_id] = get_current_os_thread_id();
+			}
+			park_condition.notify_all();
+			#endif
+
+			task t;
+			while (true)
+			{
+				if (pop_task(worker_id, t) || steal_task(worker_id, t))
+				{
+					run_task(t, worker_id - t.parent_job->first_worker_id + 1);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(park_mutex);
+				park_condition.wait(lock, [this, worker_id] () { return stopping || has_queued_task_for_worker(worker_id); });
+				if (stopping)
+					return;
+			}
+		}
+
+		bool plain_task_runtime::pop_task(
+			unsigned int worker_id,
+			task& t) const
+		{
+			// Tasks are dealt only to the workers allowed to run them
+			task_deque& d = *task_deques[worker_id];
+			std::lock_guard<std::mutex> lock(d.m);
+			if (d.tasks.empty())
+				return false;
+			t = d.tasks.front();
+			d.tasks.pop_front();
+			--t.parent_job->queued_task_count_list[worker_node_id_list[worker_id]];
+			return true;
+		}
+
+		bool plain_task_runtime::steal_task(
+			unsigned int worker_id,
+			task& t) const
+		{
+			unsigned int deque_count = static_cast<unsigned int>(task_deques.size());
+			unsigned int node_id = worker_node_id_list[worker_id];
+			// Threads of the same node are tried first, and only then the remote ones
+			for(int pass = 0; pass < (numa_aware ? 1 : 2); ++pass)
+			{
+				for(unsigned int i = 1; i < deque_count; ++i)
+				{
+					unsigned int victim_id = (worker_id + i) % deque_count;
+					if ((worker_node_id_list[victim_id] == node_id) != (pass == 0))
+						continue;
+					task_deque& d = *task_deques[victim_id];
+					std::lock_guard<std::mutex> lock(d.m);
+					for(std::deque<task>::reverse_iterator it = d.tasks.rbegin(); it != d.tasks.rend(); ++it)
+					{
+						if (!it->parent_job->is_worker_allowed(worker_id))
+							continue;
+						t = *it;
+						d.tasks.erase(std::next(it).base());
+						--t.parent_job->queued_task_count_list[worker_node_id_list[victim_id]];
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		bool plain_task_runtime::take_job_task(
+			const job& j,
+			int node_id,
+			task& t) const
+		{
+			for(unsigned int worker_id = j.first_worker_id; worker_id < j.first_worker_id + j.worker_count; ++worker_id)
+			{
+				// The tasks left on the other nodes are run by their own pool threads
+				if ((node_id >= 0) && (worker_node_id_list[worker_id] != static_cast<unsigned int>(node_id)))
+					continue;
+				task_deque& d = *task_deques[worker_id];
+				std::lock_guard<std::mutex> lock(d.m);
+				for(std::deque<task>::reverse_iterator it = d.tasks.rbegin(); it != d.tasks.rend(); ++it)
+				{
+					if (it->parent_job != &j)
+						continue;
+					t = *it;
+					d.tasks.erase(std::next(it).base());
+					--t.parent_job->queued_task_count_list[worker_node_id_list[worker_id]];
+					return true;
+				}
+			}
+			return false;
+		}
+
+		int plain_task_runtime::bind_calling_thread(unsigned int first_worker_id) const
+		{
+			// Pool threads are kept on their nodes already
+			if (!numa_aware || is_pool_thread || worker_node_id_list.empty())
+				return -1;
+
+			int node_id = static_cast<int>(worker_node_id_list[std::min(first_worker_id, static_cast<unsigned int>(worker_node_id_list.size()) - 1)]);
+			if (node_id != calling_thread_node_id)
+			{
+				set_current_thread_affinity(numa_topology->get_node_cpu_list(node_id));
+				calling_thread_node_id = node_id;
+			}
+			return node_id;
+		}
+
+		bool plain_task_runtime::has_queued_task_for_worker(unsigned int worker_id) const
+		{
+			// Only the tasks steal_task can reach count, otherwise the worker would spin while the ones of the other nodes run
+			unsigned int node_id = worker_node_id_list[worker_id];
+			for(std::vector<job *>::const_iterator it = active_jobs.begin(); it != active_jobs.end(); ++it)
+				if ((*it)->is_worker_allowed(worker_id) && ((*it)->queued_task_count_list[node_id] > 0))
+					return true;
+			return false;
+		}
+
+		void plain_task_runtime::set_thread_affinity(
+			std::thread& t,
+			const std::vector<unsigned int>& cpu_list)
+		{
+			#ifdef _WIN32
+			DWORD_PTR mask = 0;
+			for(std::vector<unsigned int>::const_iterator it = cpu_list.begin(); it != cpu_list.end(); ++it)
+				if (*it < sizeof(DWORD_PTR) * 8)
+					mask |= static_cast<DWORD_PTR>(1) << *it;
+			if (mask != 0)
+				::SetThreadAffinityMask(t.native_handle(), mask);
+			#elif defined(__linux__)
+			cpu_set_t cpuset;
+			CPU_ZERO(&cpuset);
+			for(std::vector<unsigned int>::const_iterator it = cpu_list.begin(); it != cpu_list.end(); ++it)
+				CPU_SET(*it, &cpuset);
+			::pthread_setaffinity_np(t.native_handle(), sizeof(cpu_set_t), &cpuset);
+			#endif
+		}
+
+		void plain_task_runtime::set_current_thread_affinity(const std::vector<unsigned int>& cpu_list)
+		{
+			#ifdef _WIN32
+			DWORD_PTR mask = 0;
+			for(std::vector<unsigned int>::const_iterator it = cpu_list.begin(); it != cpu_list.end(); ++it)
+				if (*it < sizeof(DWORD_PTR) * 8)
+					mask |= static_cast<DWORD_PTR>(1) << *it;
+			if (mask != 0)
+				::SetThreadAffinityMask(::GetCurrentThread(), mask);
+			#elif defined(__linux__)
+			cpu_set_t cpuset;
+			CPU_ZERO(&cpuset);
+			for(std::vector<unsigned int>::const_iterator it = cpu_list.begin(); it != cpu_list.end(); ++it)
+				CPU_SET(*it, &cpuset);
+			::pthread_setaffinity_np(::pthread_self(), sizeof(cpu_set_t), &cpuset);
+			#endif
+		}
+
+		void plain_task_runtime::run_task(
+			const task& t,
+			unsigned int thread_id) const
+		{
+			job& j = *t.parent_job;
+			std::exception_ptr error;
+			try
+			{
+				j.func(t.begin, t.end, thread_id);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			// The job might be destroyed as soon as the lock is released after the last task
+			std::lock_guard<std::mutex> lock(j.m);
+			if (error && !j.error_encountered)
+			{
+				j.error_encountered = true;
+				j.error = error;
+			}
+			if (--j.remaining_task_count == 0)
+				j.done_condition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,161 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+#include "plain_numa_topology.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Persistent pool of threads with per-thread task deques, idle threads steal work from others and park when there is nothing to do
+		class plain_task_runtime
+		{
+		public:
+			typedef std::shared_ptr<plain_task_runtime> ptr;
+
+			// Processes elements [begin, end)
+			typedef std::function<void(int begin, int end)> range_function;
+
+			// Processes elements [begin, end), thread_id is less than the thread count of the call and differs for ranges running at the same time
+			typedef std::function<void(int begin, int end, unsigned int thread_id)> thread_range_function;
+
+			// The pool has thread_count - 1 threads, the thread calling parallel_for is the last one
+			// Threads are bound to cores when bind_threads is set
+			// When numa_aware is set threads are spread over NUMA nodes and kept on them, the thread calling parallel_for is moved to the node
+			// of the pool threads of the call, and ranges are never run on other nodes, so each node processes its own consecutive part of [0, count)
+			plain_task_runtime(
+				unsigned int thread_count,
+				bool bind_threads,
+				bool numa_aware,
+				plain_numa_topology::const_ptr numa_topology);
+
+			~plain_task_runtime();
+
+			unsigned int get_thread_count() const;
+
+			// OS id of pool thread worker_id, Linux only, -1 elsewhere
+			long get_worker_os_thread_id(unsigned int worker_id) const;
+
+			// OS id of the calling thread, Linux only, -1 elsewhere
+			static long get_current_os_thread_id();
+
+			// Splits [0, count) into up to 4 * thread_count ranges of at least grain_size elements and runs func on them
+			// Consecutive ranges are dealt to the same threads for the same count, so that threads keep processing the same parts of buffers
+			// The ranges are run by the calling thread and pool threads [first_worker_id, first_worker_id + thread_count - 1) only,
+			// so the call never takes more threads than asked for, and calls with non-overlapping pool threads don't compete for them
+			// Exception thrown by func is rethrown in the calling thread
+			void parallel_for(
+				int count,
+				const range_function& func,
+				unsigned int thread_count,
+				int grain_size,
+				unsigned int first_worker_id = 0) const;
+
+			// The same as parallel_for, the calling thread has thread_id 0, so func might index per-thread scratch buffers with it
+			void parallel_for_with_thread_id(
+				int count,
+				const thread_range_function& func,
+				unsigned int thread_count,
+				int grain_size,
+				unsigned int first_worker_id = 0) const;
+
+		private:
+			struct job;
+
+			struct task
+			{
+				job * parent_job;
+				int begin;
+				int end;
+			};
+
+			struct task_deque
+			{
+				std::mutex m;
+				std::deque<task> tasks;
+			};
+
+			void run_worker(unsigned int worker_id);
+
+			bool pop_task(
+				unsigned int worker_id,
+				task& t) const;
+
+			// Takes a task of the job the worker is allowed to run, tasks of the same node are tried first, the other nodes are tried when not NUMA aware only
+			bool steal_task(
+				unsigned int worker_id,
+				task& t) const;
+
+			// Takes a task of the job for the thread which called parallel_for, the ones of node_id only when node_id is not -1
+			bool take_job_task(
+				const job& j,
+				int node_id,
+				task& t) const;
+
+			// Moves the calling thread to the node of the pool threads of the call,
+			// returns the node or -1 when not NUMA aware or when called from a pool thread
+			int bind_calling_thread(unsigned int first_worker_id) const;
+
+			// Should be called with park_mutex locked
+			bool has_queued_task_for_worker(unsigned int worker_id) const;
+
+			void run_task(
+				const task& t,
+				unsigned int thread_id) const;
+
+			static void set_thread_affinity(
+				std::thread& t,
+				const std::vector<unsigned int>& cpu_list);
+
+			static void set_current_thread_affinity(const std::vector<unsigned int>& cpu_list);
+
+		private:
+			unsigned int thread_count;
+			bool numa_aware;
+			plain_numa_topology::const_ptr numa_topology;
+			// 1 when not NUMA aware, all the workers are on node 0 then
+			unsigned int node_count;
+			std::vector<std::unique_ptr<task_deque> > task_deques;
+			// The calling thread is considered to belong to node 0
+			std::vector<unsigned int> worker_node_id_list;
+			std::vector<std::thread> threads;
+			// Guarded by park_mutex, filled by the workers when they start
+			std::vector<long> worker_os_thread_id_list;
+
+			// Jobs having tasks queued or running, guarded by park_mutex
+			mutable std::vector<job *> active_jobs;
+			mutable std::mutex park_mutex;
+			mutable std::condition_variable park_condition;
+			bool stopping;
+
+		private:
+			plain_task_runtime() = delete;
+			plain_task_runtime(const plain_task_runtime&) = delete;
+			plain_task_runtime& operator =(const plain_task_runtime&) = delete;
+		};
+	}
+}
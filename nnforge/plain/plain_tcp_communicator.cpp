@@ -0,0 +1,190 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_tcp_communicator.h"
+
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const size_t plain_tcp_communicator::bucket_elem_count = 1 << 20;
+		const int plain_tcp_communicator::connect_timeout_seconds = 60;
+
+		plain_tcp_communicator::plain_tcp_communicator(
+			const std::vector<std::string>& peer_address_list,
+			unsigned int rank)
+			: rank(rank)
+			, worker_count(static_cast<unsigned int>(peer_address_list.size()))
+		{
+			if (rank >= worker_count)
+				throw neural_network_exception((boost::format("Invalid rank %1% for %2% peer addresses") % rank % worker_count).str());
+
+			if (worker_count == 1)
+				return;
+
+			std::pair<std::string, unsigned short> own_address = parse_address(peer_address_list[rank]);
+			boost::asio::ip::tcp::acceptor acceptor(io_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), own_address.second));
+
+			// The connection to the next worker is established by the kernel once it listens, so connecting before accepting doesn't deadlock
+			unsigned int next_rank = (rank + 1) % worker_count;
+			std::pair<std::string, unsigned short> next_address = parse_address(peer_address_list[next_rank]);
+			boost::asio::ip::tcp::resolver resolver(io_context);
+			std::chrono::steady_clock::time_point connect_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(connect_timeout_seconds);
+			while (true)
+			{
+				next_socket = std::make_shared<boost::asio::ip::tcp::socket>(io_context);
+				boost::system::error_code ec;
+				boost::asio::connect(*next_socket, resolver.resolve(next_address.first, boost::lexical_cast<std::string>(next_address.second)), ec);
+				if (!ec)
+					break;
+				if (std::chrono::steady_clock::now() > connect_deadline)
+					throw neural_network_exception((boost::format("Worker %1% could not connect to %2% in %3% seconds: %4%") % rank % peer_address_list[next_rank] % connect_timeout_seconds % ec.message()).str());
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			}
+			next_socket->set_option(boost::asio::ip::tcp::no_delay(true));
+			unsigned int handshake = rank;
+			boost::asio::write(*next_socket, boost::asio::buffer(&handshake, sizeof(handshake)));
+
+			unsigned int prev_rank = (rank + worker_count - 1) % worker_count;
+			prev_socket = std::make_shared<boost::asio::ip::tcp::socket>(io_context);
+			acceptor.accept(*prev_socket);
+			prev_socket->set_option(boost::asio::ip::tcp::no_delay(true));
+			boost::asio::read(*prev_socket, boost::asio::buffer(&handshake, sizeof(handshake)));
+			if (handshake != prev_rank)
+				throw neural_network_exception((boost::format("Worker %1% expected connection from worker %2%, got it from worker %3%") % rank % prev_rank % handshake).str());
+
+			recv_buffer.resize((bucket_elem_count + worker_count - 1) / worker_count);
+		}
+
+		std::pair<std::string, unsigned short> plain_tcp_communicator::parse_address(const std::string& address)
+		{
+			size_t pos = address.rfind(':');
+			if ((pos == std::string::npos) || (pos == 0) || (pos + 1 == address.size()))
+				throw neural_network_exception((boost::format("Invalid peer address %1%, host:port expected") % address).str());
+
+			return std::make_pair(address.substr(0, pos), boost::lexical_cast<unsigned short>(address.substr(pos + 1)));
+		}
+
+		void plain_tcp_communicator::exchange(
+			const float * send_data,
+			size_t send_elem_count,
+			float * recv_data,
+			size_t recv_elem_count)
+		{
+			// Both directions are served at once, otherwise all the workers could block sending to each other
+			boost::system::error_code send_error;
+			boost::system::error_code recv_error;
+			if (send_elem_count > 0)
+				boost::asio::async_write(*next_socket, boost::asio::buffer(send_data, send_elem_count * sizeof(float)), [&send_error] (const boost::system::error_code& ec, size_t) { send_error = ec; });
+			if (recv_elem_count > 0)
+				boost::asio::async_read(*prev_socket, boost::asio::buffer(recv_data, recv_elem_count * sizeof(float)), [&recv_error] (const boost::system::error_code& ec, size_t) { recv_error = ec; });
+			io_context.restart();
+			io_context.run();
+
+			if (send_error)
+				throw neural_network_exception((boost::format("Worker %1% failed sending data: %2%") % rank % send_error.message()).str());
+			if (recv_error)
+				throw neural_network_exception((boost::format("Worker %1% failed receiving data: %2%") % rank % recv_error.message()).str());
+		}
+
+		void plain_tcp_communicator::reduce_all(
+			float * data,
+			size_t elem_count)
+		{
+			if (worker_count == 1)
+				return;
+
+			for(size_t offset = 0; offset < elem_count; offset += bucket_elem_count)
+			{
+				size_t current_elem_count = std::min(bucket_elem_count, elem_count - offset);
+				float * bucket = data + offset;
+
+				// Segment i covers [start(i), start(i + 1))
+				auto segment_start = [&] (unsigned int segment_id) { return current_elem_count * segment_id / worker_count; };
+
+				// Reduce-scatter: after worker_count - 1 steps the worker has the sum of segment (rank + 1) % worker_count
+				for(unsigned int step = 0; step < worker_count - 1; ++step)
+				{
+					unsigned int send_segment_id = (rank + worker_count - step) % worker_count;
+					unsigned int recv_segment_id = (rank + worker_count - step - 1) % worker_count;
+					size_t recv_start = segment_start(recv_segment_id);
+					size_t recv_elem_count = segment_start(recv_segment_id + 1) - recv_start;
+					exchange(
+						bucket + segment_start(send_segment_id),
+						segment_start(send_segment_id + 1) - segment_start(send_segment_id),
+						&recv_buffer[0],
+						recv_elem_count);
+					float * dst = bucket + recv_start;
+					for(size_t i = 0; i < recv_elem_count; ++i)
+						dst[i] += recv_buffer[i];
+				}
+
+				// All-gather: reduced segments travel around the ring
+				for(unsigned int step = 0; step < worker_count - 1; ++step)
+				{
+					unsigned int send_segment_id = (rank + 1 + worker_count - step) % worker_count;
+					unsigned int recv_segment_id = (rank + worker_count - step) % worker_count;
+					exchange(
+						bucket + segment_start(send_segment_id),
+						segment_start(send_segment_id + 1) - segment_start(send_segment_id),
+						bucket + segment_start(recv_segment_id),
+						segment_start(recv_segment_id + 1) - segment_start(recv_segment_id));
+				}
+			}
+		}
+
+		void plain_tcp_communicator::broadcast(
+			float * data,
+			size_t elem_count)
+		{
+			if (worker_count == 1)
+				return;
+
+			// Data is passed along the ring from the worker with rank 0 to the one preceding it
+			for(size_t offset = 0; offset < elem_count; offset += bucket_elem_count)
+			{
+				size_t current_elem_count = std::min(bucket_elem_count, elem_count - offset);
+				if (rank != 0)
+					exchange(0, 0, data + offset, current_elem_count);
+				if (rank != worker_count - 1)
+					exchange(data + offset, current_elem_count, 0, 0);
+			}
+		}
+
+		unsigned int plain_tcp_communicator::get_rank() const
+		{
+			return rank;
+		}
+
+		unsigned int plain_tcp_communicator::get_worker_count() const
+		{
+			return worker_count;
+		}
+
+		std::string plain_tcp_communicator::get_type_name() const
+		{
+			return "tcp";
+		}
+	}
+}
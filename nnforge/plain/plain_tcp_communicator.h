@@ -0,0 +1,81 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_communicator.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <boost/asio.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Worker processes, possibly running on different hosts, form a ring of TCP connections: each one sends to the next rank and receives from the previous one.
+		// Data is reduced in buckets with ring allreduce: reduce-scatter followed by all-gather, each worker sends 2 * (worker_count - 1) / worker_count of the data.
+		// All the workers should use the same byte order and floating point format
+		class plain_tcp_communicator : public plain_communicator
+		{
+		public:
+			// peer_address_list has host:port of each worker ordered by rank, the worker listens on the port of its own entry
+			plain_tcp_communicator(
+				const std::vector<std::string>& peer_address_list,
+				unsigned int rank);
+
+			virtual ~plain_tcp_communicator() = default;
+
+			virtual void reduce_all(
+				float * data,
+				size_t elem_count);
+
+			virtual void broadcast(
+				float * data,
+				size_t elem_count);
+
+			virtual unsigned int get_rank() const;
+
+			virtual unsigned int get_worker_count() const;
+
+			virtual std::string get_type_name() const;
+
+		private:
+			static std::pair<std::string, unsigned short> parse_address(const std::string& address);
+
+			// Sends send_elem_count elements to the next worker while receiving recv_elem_count elements from the previous one
+			void exchange(
+				const float * send_data,
+				size_t send_elem_count,
+				float * recv_data,
+				size_t recv_elem_count);
+
+		private:
+			unsigned int rank;
+			unsigned int worker_count;
+
+			boost::asio::io_context io_context;
+			std::shared_ptr<boost::asio::ip::tcp::socket> next_socket;
+			std::shared_ptr<boost::asio::ip::tcp::socket> prev_socket;
+
+			std::vector<float> recv_buffer;
+
+			static const size_t bucket_elem_count;
+			static const int connect_timeout_seconds;
+		};
+	}
+}
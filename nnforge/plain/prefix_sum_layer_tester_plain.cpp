@@ -53,10 +53,9 @@ namespace nnforge
 			const float clamp_max = layer_derived->clamp_max;
 			const int total_workload = entry_count * feature_map_segment_count * neuron_count_per_feature_map;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / (feature_map_segment_count * neuron_count_per_feature_map);
 					int tt = workload_id - entry_id * feature_map_segment_count * neuron_count_per_feature_map;
@@ -72,7 +71,7 @@ namespace nnforge
 						out_it_global[offset] = std::min(std::max(running_sum, clamp_min), clamp_max);
 					}
 				}
-			}
+			});
 		}
 
 		int prefix_sum_layer_tester_plain::get_input_index_layer_can_write(
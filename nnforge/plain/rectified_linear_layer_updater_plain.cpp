@@ -49,12 +49,14 @@ namespace nnforge
 			const float * const in_it = *input_buffers[0];
 			const float negative_slope = layer_derived->negative_slope;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
 			{
-				float input_val = *(in_it + i);
-				*(out_it + i) = input_val >= 0.0F ? input_val : input_val * negative_slope;
-			}
+				for(int i = begin; i < end; ++i)
+				{
+					float input_val = *(in_it + i);
+					*(out_it + i) = input_val >= 0.0F ? input_val : input_val * negative_slope;
+				}
+			});
 		}
 
 		void rectified_linear_layer_updater_plain::run_backward_data_propagation(
@@ -86,23 +88,27 @@ namespace nnforge
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					float in_val = *(in_it + i);
-					float out_err = *(out_err_it+ i);
-					*(in_err_it + i) += (in_val >= 0.0F) ? out_err : out_err * negative_slope;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						float in_val = *(in_it + i);
+						float out_err = *(out_err_it+ i);
+						*(in_err_it + i) += (in_val >= 0.0F) ? out_err : out_err * negative_slope;
+					}
+				});
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int i = 0; i < elem_count; ++i)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					float in_val = *(in_it + i);
-					float out_err = *(out_err_it+ i);
-					*(in_err_it + i) = (in_val >= 0.0F) ? out_err : out_err * negative_slope;
-				}
+					for(int i = begin; i < end; ++i)
+					{
+						float in_val = *(in_it + i);
+						float out_err = *(out_err_it+ i);
+						*(in_err_it + i) = (in_val >= 0.0F) ? out_err : out_err * negative_slope;
+					}
+				});
 			}
 		}
 
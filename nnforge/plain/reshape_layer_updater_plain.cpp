@@ -74,15 +74,14 @@ namespace nnforge
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+				plain_config->parallel_for(elem_count, [&] (int begin, int end)
 				{
-					#pragma omp for schedule(guided)
-					for(int workload_id = 0; workload_id < elem_count; ++workload_id)
+					for(int workload_id = begin; workload_id < end; ++workload_id)
 					{
 						int elem_id = workload_id;
 						*(dst + elem_id) += *(src + elem_id);
 					}
-				}
+				});
 			}
 			else
 			{
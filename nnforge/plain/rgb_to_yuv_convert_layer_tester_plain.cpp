@@ -66,36 +66,38 @@ namespace nnforge
 			const unsigned int input_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			const std::vector<color_feature_map_config>::const_iterator cfm_it = layer_derived->color_feature_map_config_list.begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				int entry_id = workload_id / color_feature_map_config_count;
-				int color_feature_map_config_id = workload_id - entry_id * color_feature_map_config_count;
-				const color_feature_map_config& cfm = *(cfm_it + color_feature_map_config_id);
-
-				const float * in_it_red_and_y = in_it + (entry_id * input_neuron_count) + (cfm.red_and_y_feature_map_id * input_neuron_count_per_feature_map);
-				const float * in_it_green_and_u = in_it + (entry_id * input_neuron_count) + (cfm.green_and_u_feature_map_id * input_neuron_count_per_feature_map);
-				const float * in_it_blue_and_v = in_it + (entry_id * input_neuron_count) + (cfm.blue_and_v_feature_map_id * input_neuron_count_per_feature_map);
-
-				float * out_it_red_and_y = out_it + (entry_id * input_neuron_count) + (cfm.red_and_y_feature_map_id * input_neuron_count_per_feature_map);
-				float * out_it_green_and_u = out_it + (entry_id * input_neuron_count) + (cfm.green_and_u_feature_map_id * input_neuron_count_per_feature_map);
-				float * out_it_blue_and_v = out_it + (entry_id * input_neuron_count) + (cfm.blue_and_v_feature_map_id * input_neuron_count_per_feature_map);
-
-				for(unsigned int i = 0; i < input_neuron_count_per_feature_map; ++i)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
-					float red = in_it_red_and_y[i];
-					float green = in_it_green_and_u[i];
-					float blue = in_it_blue_and_v[i];
-
-					float y = w_r * red + w_g * green + w_b * blue;
-					float u = u_mult * (blue - y);
-					float v = v_mult * (red - y);
-
-					out_it_red_and_y[i] = y;
-					out_it_green_and_u[i] = u;
-					out_it_blue_and_v[i] = v;
+					int entry_id = workload_id / color_feature_map_config_count;
+					int color_feature_map_config_id = workload_id - entry_id * color_feature_map_config_count;
+					const color_feature_map_config& cfm = *(cfm_it + color_feature_map_config_id);
+
+					const float * in_it_red_and_y = in_it + (entry_id * input_neuron_count) + (cfm.red_and_y_feature_map_id * input_neuron_count_per_feature_map);
+					const float * in_it_green_and_u = in_it + (entry_id * input_neuron_count) + (cfm.green_and_u_feature_map_id * input_neuron_count_per_feature_map);
+					const float * in_it_blue_and_v = in_it + (entry_id * input_neuron_count) + (cfm.blue_and_v_feature_map_id * input_neuron_count_per_feature_map);
+
+					float * out_it_red_and_y = out_it + (entry_id * input_neuron_count) + (cfm.red_and_y_feature_map_id * input_neuron_count_per_feature_map);
+					float * out_it_green_and_u = out_it + (entry_id * input_neuron_count) + (cfm.green_and_u_feature_map_id * input_neuron_count_per_feature_map);
+					float * out_it_blue_and_v = out_it + (entry_id * input_neuron_count) + (cfm.blue_and_v_feature_map_id * input_neuron_count_per_feature_map);
+
+					for(unsigned int i = 0; i < input_neuron_count_per_feature_map; ++i)
+					{
+						float red = in_it_red_and_y[i];
+						float green = in_it_green_and_u[i];
+						float blue = in_it_blue_and_v[i];
+
+						float y = w_r * red + w_g * green + w_b * blue;
+						float u = u_mult * (blue - y);
+						float v = v_mult * (red - y);
+
+						out_it_red_and_y[i] = y;
+						out_it_green_and_u[i] = u;
+						out_it_blue_and_v[i] = v;
+					}
 				}
-			}
+			});
 		}
 
 		int rgb_to_yuv_convert_layer_tester_plain::get_input_index_layer_can_write(
@@ -44,13 +44,15 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-			for(int i = 0; i < elem_count; ++i)
+			plain_config->parallel_for(elem_count, [&] (int begin, int end)
 			{
-				float inp = *(in_it + i);
-				float res = 1.0F / (expf(-inp) + 1.0F);
-				*(out_it + i) = res;
-			}
+				for(int i = begin; i < end; ++i)
+				{
+					float inp = *(in_it + i);
+					float res = 1.0F / (expf(-inp) + 1.0F);
+					*(out_it + i) = res;
+				}
+			});
 		}
 
 		int sigmoid_layer_tester_plain::get_input_index_layer_can_write(
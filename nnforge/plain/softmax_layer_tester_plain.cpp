@@ -16,10 +16,6 @@
 
 #include "softmax_layer_tester_plain.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
 #include "../softmax_layer.h"
 
 namespace nnforge
@@ -52,17 +48,10 @@ namespace nnforge
 			const float * const input_buffer_it = *input_buffers[0];
 
 			const int total_workload = entry_count * neuron_count_per_feature_map;
-			const int openmp_thread_count = plain_config->openmp_thread_count;
 			
-			#pragma omp parallel default(none) num_threads(openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				int thread_id = 0;
-				#ifdef _OPENMP
-				thread_id = omp_get_thread_num();
-				#endif
-
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
 					int neuron_id = workload_id - (entry_id * neuron_count_per_feature_map);
@@ -87,7 +76,7 @@ namespace nnforge
 					for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
 						*(out_it + (feature_map_id * neuron_count_per_feature_map)) *= mult;
 				} // for(int workload_id
-			} // #pragma parallel
+			});
 		}
 
 		int softmax_layer_tester_plain::get_input_index_layer_can_write(
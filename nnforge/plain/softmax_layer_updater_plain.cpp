@@ -16,10 +16,6 @@
 
 #include "softmax_layer_updater_plain.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
 #include "../softmax_layer.h"
 
 namespace nnforge
@@ -55,19 +51,12 @@ namespace nnforge
 			float * const working_buffer_it = *temporary_working_fixed_buffer;
 
 			const int total_workload = entry_count * neuron_count_per_feature_map;
-			const int openmp_thread_count = plain_config->openmp_thread_count;
 			
-			#pragma omp parallel default(none) num_threads(openmp_thread_count)
+			plain_config->parallel_for_with_thread_id(total_workload, [&] (int begin, int end, unsigned int thread_id)
 			{
-				int thread_id = 0;
-				#ifdef _OPENMP
-				thread_id = omp_get_thread_num();
-				#endif
-
 				float * local_additional_buffer = working_buffer_it + thread_id * feature_map_count;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
 					int neuron_id = workload_id - (entry_id * neuron_count_per_feature_map);
@@ -93,7 +82,7 @@ namespace nnforge
 					for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
 						*(out_it + (feature_map_id * neuron_count_per_feature_map)) = local_additional_buffer[feature_map_id] * mult;
 				} // for(int workload_id
-			} // #pragma parallel
+			});
 		}
 
 		void softmax_layer_updater_plain::run_backward_data_propagation(
@@ -124,12 +113,10 @@ namespace nnforge
 			const float * const output_neurons_it = *output_neurons_buffer;
 
 			const int total_workload = entry_count * neuron_count_per_feature_map;
-			const int openmp_thread_count = plain_config->openmp_thread_count;
 			
-			#pragma omp parallel default(none) num_threads(openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
 					int neuron_id = workload_id - (entry_id * neuron_count_per_feature_map);
@@ -162,7 +149,7 @@ namespace nnforge
 						}
 					}
 				} // for(int workload_id
-			} // #pragma parallel
+			});
 		}
 
 		int softmax_layer_updater_plain::get_input_index_layer_can_write(
@@ -116,13 +116,12 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (entry_id * output_feature_map_count);
@@ -188,7 +187,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 	}
 }
@@ -118,13 +118,12 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
 					int output_feature_map_id = workload_id - (entry_id * output_feature_map_count);
@@ -190,7 +189,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		void sparse_convolution_layer_updater_plain::run_backward_data_propagation(
@@ -294,13 +293,12 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const std::vector<std::vector<std::pair<int, int> > >::const_iterator in_fm_out_fm_weight_pos_it = in_fm_out_fm_weight_pos_list_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int entry_id = workload_id / input_feature_map_count;
 					int input_feature_map_id = workload_id - (entry_id * input_feature_map_count);
@@ -368,7 +366,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		void sparse_convolution_layer_updater_plain::run_backward_weights_propagation(
@@ -476,14 +474,13 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator strides_it = strides.begin();
 			const std::vector<std::pair<int, int> >::const_iterator out_fm_in_fm_it = out_fm_in_fm_list.begin();
 
-			#pragma omp parallel default(shared) num_threads(plain_config->openmp_thread_count) shared(window_sizes,left_zero_padding,right_zero_padding,input_dimension_sizes)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 				std::vector<float> weights_local(const_window_elem_count, 0.0F);
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int weight_block_id = workload_id;
 					int output_feature_map_id = out_fm_in_fm_it[weight_block_id].first;
@@ -549,30 +546,32 @@ namespace nnforge
 					for(std::vector<float>::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
 						*it += *weights_local_it;
 				}
-			}
+			});
 
 			if (bias)
 			{
 				const std::vector<float>::iterator gradient_biases = (*gradient)[1].begin();
 				const int total_workload_bias = output_feature_map_count;
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_workload_bias; ++workload_id)
+				plain_config->parallel_for(total_workload_bias, [&] (int begin, int end)
 				{
-					int output_feature_map_id = workload_id;
-
-					float sum = 0.0F;
-					for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
+					for(int workload_id = begin; workload_id < end; ++workload_id)
 					{
-						float local_sum = 0.0F;
-						const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
-						for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
-							local_sum += *out_err_it;
+						int output_feature_map_id = workload_id;
 
-						sum += local_sum;
-					}
+						float sum = 0.0F;
+						for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
+						{
+							float local_sum = 0.0F;
+							const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
+							for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
+								local_sum += *out_err_it;
 
-					*(gradient_biases + output_feature_map_id) += sum;
-				}
+							sum += local_sum;
+						}
+
+						*(gradient_biases + output_feature_map_id) += sum;
+					}
+				});
 			}
 		}
 
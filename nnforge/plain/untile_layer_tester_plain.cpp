@@ -144,10 +144,9 @@ namespace nnforge
 			const std::vector<int>::const_iterator position_list_it = position_list.begin();
 			const std::vector<int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					unsigned int output_entry_id = workload_id / feature_map_count;
 					int feature_map_id = workload_id - (output_entry_id * feature_map_count);
@@ -166,7 +165,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 	}
 }
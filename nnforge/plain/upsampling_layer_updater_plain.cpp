@@ -105,12 +105,11 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator output_slices_it = output_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int input_entry_id = workload_id / input_feature_map_count;
 					int input_feature_map_id = workload_id - (input_entry_id * input_feature_map_count);
@@ -140,7 +139,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		void upsampling_layer_updater_plain::run_backward_data_propagation(
@@ -221,12 +220,11 @@ namespace nnforge
 			const std::vector<unsigned int>::const_iterator output_slices_it = output_slices.begin();
 			const std::vector<unsigned int>::const_iterator offset_list_it = offset_list.begin();
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			plain_config->parallel_for(total_workload, [&] (int begin, int end)
 			{
 				std::array<unsigned int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				for(int workload_id = begin; workload_id < end; ++workload_id)
 				{
 					int input_entry_id = workload_id / input_feature_map_count;
 					int input_feature_map_id = workload_id - (input_entry_id * input_feature_map_count);
@@ -260,7 +258,7 @@ namespace nnforge
 						}
 					}
 				}
-			}
+			});
 		}
 
 		bool upsampling_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
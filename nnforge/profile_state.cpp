@@ -17,15 +17,20 @@
 #include "profile_state.h"
 
 #include <boost/format.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <iostream>
 
 namespace nnforge
 {
+	const size_t profile_state::max_pending_trace_event_count = 16384;
+
 	profile_state::profile_state(
 		bool profile_mode,
 		const boost::filesystem::path& profile_folder)
 		: profile_mode(profile_mode)
 		, index(0)
+		, trace_start(std::chrono::high_resolution_clock::now())
+		, trace_event_written(false)
 	{
 		if (profile_mode)
 		{
@@ -42,6 +47,26 @@ namespace nnforge
 			boost::filesystem::create_directories(this->profile_folder);
 
 			output_message((boost::format("Profile files will be saved into %1%") % this->profile_folder.string()).str().c_str());
+
+			trace_file_path = get_path_to_unique_file("trace", "json");
+			trace_stream.open(trace_file_path, std::ios_base::out | std::ios_base::trunc);
+			trace_stream << "{\"traceEvents\":[";
+			trace_end_pos = trace_stream.tellp();
+			trace_stream << std::endl << "]}" << std::endl;
+		}
+	}
+
+	profile_state::~profile_state()
+	{
+		if (profile_mode)
+		{
+			try
+			{
+				write_trace();
+			}
+			catch (...)
+			{
+			}
 		}
 	}
 
@@ -68,4 +93,92 @@ namespace nnforge
 		if (profile_mode)
 			std::cout << "PROFILE: " << msg << std::endl;
 	}
+
+	void profile_state::add_trace_event(
+		const char * category,
+		const std::string& name,
+		std::chrono::high_resolution_clock::time_point start,
+		std::chrono::high_resolution_clock::time_point end)
+	{
+		if (!profile_mode)
+			return;
+
+		trace_event e;
+		e.category = category;
+		e.name = name;
+		e.start_us = std::chrono::duration_cast<std::chrono::microseconds>(start - trace_start).count();
+		e.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+		std::lock_guard<std::mutex> lock(trace_mutex);
+		e.thread_id = trace_thread_id_map.insert(std::make_pair(std::this_thread::get_id(), static_cast<unsigned int>(trace_thread_id_map.size()))).first->second;
+		trace_events.push_back(e);
+		if (trace_events.size() >= max_pending_trace_event_count)
+			flush_trace_events();
+	}
+
+	void profile_state::write_trace()
+	{
+		if (!profile_mode)
+			return;
+
+		std::lock_guard<std::mutex> lock(trace_mutex);
+		flush_trace_events();
+	}
+
+	void profile_state::flush_trace_events()
+	{
+		if (trace_events.empty())
+			return;
+
+		trace_stream.seekp(trace_end_pos);
+		for(std::vector<trace_event>::const_iterator it = trace_events.begin(); it != trace_events.end(); ++it)
+		{
+			if (trace_event_written)
+				trace_stream << ",";
+			trace_stream << std::endl << "{\"name\":\"" << escape_json(it->name) << "\",\"cat\":\"" << escape_json(it->category) << "\",\"ph\":\"X\",\"ts\":" << it->start_us << ",\"dur\":" << it->duration_us << ",\"pid\":0,\"tid\":" << it->thread_id << "}";
+			trace_event_written = true;
+		}
+		trace_events.clear();
+		trace_end_pos = trace_stream.tellp();
+		trace_stream << std::endl << "]}" << std::endl;
+	}
+
+	std::string profile_state::escape_json(const std::string& str)
+	{
+		std::string res;
+		for(std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+		{
+			unsigned char c = static_cast<unsigned char>(*it);
+			if ((c == '"') || (c == '\\'))
+			{
+				res.push_back('\\');
+				res.push_back(*it);
+			}
+			else if (c < 0x20)
+				res += (boost::format("\\u%|1$04x|") % static_cast<unsigned int>(c)).str();
+			else
+				res.push_back(*it);
+		}
+		return res;
+	}
+
+	profile_trace_scope::profile_trace_scope(
+		profile_state::ptr profile,
+		const char * category,
+		const std::string& name)
+		: profile(profile)
+		, category(category)
+	{
+		if (profile->is_profile())
+		{
+			this->name = name;
+			start = std::chrono::high_resolution_clock::now();
+		}
+	}
+
+	profile_trace_scope::~profile_trace_scope()
+	{
+		if (profile->is_profile())
+			profile->add_trace_event(category, name, start, std::chrono::high_resolution_clock::now());
+	}
 }
@@ -17,8 +17,14 @@
 #pragma once
 
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <mutex>
 #include <memory>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <map>
 
 namespace nnforge
 {
@@ -31,7 +37,7 @@ namespace nnforge
 			bool profile_mode,
 			const boost::filesystem::path& profile_folder);
 
-		~profile_state() = default;
+		~profile_state();
 
 		bool is_profile() const;
 
@@ -41,17 +47,79 @@ namespace nnforge
 
 		void output_message(const char * msg);
 
+		// Adds complete event of the calling thread to the timeline, does nothing when not in profile mode.
+		// Events are appended to the trace file once max_pending_trace_event_count of them are collected, so that memory doesn't grow with the run
+		void add_trace_event(
+			const char * category,
+			const std::string& name,
+			std::chrono::high_resolution_clock::time_point start,
+			std::chrono::high_resolution_clock::time_point end);
+
+		// Appends the events collected so far to the trace file in Chrome trace event format, it is also called on destruction.
+		// The file is a complete JSON document after each call
+		void write_trace();
+
 	protected:
 		bool profile_mode;
 		boost::filesystem::path profile_folder;
 
+	private:
+		struct trace_event
+		{
+			std::string category;
+			std::string name;
+			long long start_us;
+			long long duration_us;
+			unsigned int thread_id;
+		};
+
+		// Should be called with trace_mutex locked
+		void flush_trace_events();
+
+		static std::string escape_json(const std::string& str);
+
 	private:
 		std::mutex index_mutex;
 		unsigned int index;
 
+		std::mutex trace_mutex;
+		std::chrono::high_resolution_clock::time_point trace_start;
+		boost::filesystem::path trace_file_path;
+		boost::filesystem::ofstream trace_stream;
+		// Position of the closing brackets, which are overwritten by the events appended next
+		std::streampos trace_end_pos;
+		bool trace_event_written;
+		std::vector<trace_event> trace_events;
+		std::map<std::thread::id, unsigned int> trace_thread_id_map;
+
+		static const size_t max_pending_trace_event_count;
+
 	private:
 		profile_state() = delete;
 		profile_state(const profile_state&) = delete;
 		profile_state& operator =(const profile_state&) = delete;
 	};
+
+	// Records the lifetime of the object as a trace event
+	class profile_trace_scope
+	{
+	public:
+		profile_trace_scope(
+			profile_state::ptr profile,
+			const char * category,
+			const std::string& name);
+
+		~profile_trace_scope();
+
+	private:
+		profile_state::ptr profile;
+		const char * category;
+		std::string name;
+		std::chrono::high_resolution_clock::time_point start;
+
+	private:
+		profile_trace_scope() = delete;
+		profile_trace_scope(const profile_trace_scope&) = delete;
+		profile_trace_scope& operator =(const profile_trace_scope&) = delete;
+	};
 }
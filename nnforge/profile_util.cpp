@@ -103,4 +103,88 @@ namespace nnforge
 			}
 		}
 	}
+
+	profile_util::hardware_counters::hardware_counters()
+		: cycles(0.0)
+		, instructions(0.0)
+		, llc_misses(0.0)
+	{
+	}
+
+	profile_util::hardware_counters& profile_util::hardware_counters::operator +=(const hardware_counters& other)
+	{
+		cycles = ((cycles < 0.0) || (other.cycles < 0.0)) ? -1.0 : cycles + other.cycles;
+		instructions = ((instructions < 0.0) || (other.instructions < 0.0)) ? -1.0 : instructions + other.instructions;
+		llc_misses = ((llc_misses < 0.0) || (other.llc_misses < 0.0)) ? -1.0 : llc_misses + other.llc_misses;
+		return *this;
+	}
+
+	profile_util::hardware_counters& profile_util::hardware_counters::operator -=(const hardware_counters& other)
+	{
+		cycles = ((cycles < 0.0) || (other.cycles < 0.0)) ? -1.0 : cycles - other.cycles;
+		instructions = ((instructions < 0.0) || (other.instructions < 0.0)) ? -1.0 : instructions - other.instructions;
+		llc_misses = ((llc_misses < 0.0) || (other.llc_misses < 0.0)) ? -1.0 : llc_misses - other.llc_misses;
+		return *this;
+	}
+
+	void profile_util::dump_layer_action_hardware_counters(
+		profile_state::ptr profile,
+		const char * action_prefix,
+		unsigned int entry_count,
+		const std::map<layer_name_with_action, float>& action_flops_per_entry,
+		const std::map<layer_name_with_action, float>& action_seconds,
+		const std::map<layer_name_with_action, hardware_counters>& action_counters,
+		const std::map<std::string, std::string>& layer_name_to_layer_type_map)
+	{
+		const double cache_line_size = 64.0;
+
+		boost::filesystem::path profile_path = profile->get_path_to_unique_file((boost::format("%1%_hw_counters_per_layer_action") % action_prefix).str().c_str(), "csv");
+		boost::filesystem::ofstream out(profile_path, std::ios_base::out | std::ios_base::trunc);
+		out << "Layer\tLayer type\tAction\tAbsolute time, seconds\tCycles\tInstructions\tIPC\tLLC misses\tEstimated memory traffic, MB\tEstimated bandwidth, GB/s\tArithmetic intensity, FLOP/byte\tAbsolute perf, GFLOPS" << std::endl;
+		for(std::map<layer_name_with_action, hardware_counters>::const_iterator it = action_counters.begin(); it != action_counters.end(); ++it)
+		{
+			double seconds = static_cast<double>(action_seconds.find(it->first)->second);
+			double flops = static_cast<double>(action_flops_per_entry.find(it->first)->second) * static_cast<double>(entry_count);
+			const hardware_counters& counters = it->second;
+			bool has_flops = (it->first.get_action().get_action_type() != layer_action::update_weights);
+
+			out << it->first.get_name();
+			out << "\t" << layer_name_to_layer_type_map.find(it->first.get_name())->second;
+			out << "\t" << it->first.get_action().str();
+			out << "\t" << seconds;
+			if (counters.cycles >= 0.0)
+				out << "\t" << counters.cycles;
+			else
+				out << "\tNA";
+			if (counters.instructions >= 0.0)
+				out << "\t" << counters.instructions;
+			else
+				out << "\tNA";
+			if ((counters.cycles > 0.0) && (counters.instructions >= 0.0))
+				out << "\t" << (counters.instructions / counters.cycles);
+			else
+				out << "\tNA";
+			if (counters.llc_misses >= 0.0)
+			{
+				double bytes = counters.llc_misses * cache_line_size;
+				out << "\t" << counters.llc_misses;
+				out << "\t" << (bytes * 1.0e-6);
+				if (seconds > 0.0)
+					out << "\t" << (bytes / seconds * 1.0e-9);
+				else
+					out << "\tNA";
+				if (has_flops && (bytes > 0.0))
+					out << "\t" << (flops / bytes);
+				else
+					out << "\tNA";
+			}
+			else
+				out << "\tNA\tNA\tNA\tNA";
+			if (has_flops && (seconds > 0.0))
+				out << "\t" << (flops / seconds * 1.0e-9);
+			else
+				out << "\tNA";
+			out << std::endl;
+		}
+	}
 }
@@ -26,6 +26,20 @@ namespace nnforge
 	class profile_util
 	{
 	public:
+		// Values summed over all the threads, negative value means the counter is not available
+		struct hardware_counters
+		{
+			hardware_counters();
+
+			hardware_counters& operator +=(const hardware_counters& other);
+
+			hardware_counters& operator -=(const hardware_counters& other);
+
+			double cycles;
+			double instructions;
+			double llc_misses;
+		};
+
 		static void dump_layer_action_performance(
 			profile_state::ptr profile,
 			float max_flops,
@@ -36,6 +50,16 @@ namespace nnforge
 			const std::map<std::string, std::string>& layer_name_to_layer_type_map,
 			float total_seconds);
 
+		// Memory traffic is estimated as LLC misses times cache line size
+		static void dump_layer_action_hardware_counters(
+			profile_state::ptr profile,
+			const char * action_prefix,
+			unsigned int entry_count,
+			const std::map<layer_name_with_action, float>& action_flops_per_entry,
+			const std::map<layer_name_with_action, float>& action_seconds,
+			const std::map<layer_name_with_action, hardware_counters>& action_counters,
+			const std::map<std::string, std::string>& layer_name_to_layer_type_map);
+
 	private:
 		struct entry
 		{
@@ -104,4 +104,9 @@ namespace nnforge
 			src_begin += original_config.get_neuron_count_per_feature_map();
 		}
 	}
+
+	bool rotate_band_data_transformer::is_deterministic() const
+	{
+		return false;
+	}
 }
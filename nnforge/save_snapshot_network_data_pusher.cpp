@@ -17,14 +17,22 @@
 #include "save_snapshot_network_data_pusher.h"
 
 #include "neural_network_exception.h"
+#include "network_data_checkpoint.h"
 
 #include <boost/filesystem/fstream.hpp>
 #include <boost/format.hpp>
 
 namespace nnforge
 {
-	save_snapshot_network_data_pusher::save_snapshot_network_data_pusher(const boost::filesystem::path& folder_path)
+	save_snapshot_network_data_pusher::save_snapshot_network_data_pusher(
+		const boost::filesystem::path& folder_path,
+		bool background,
+		bool sync_to_disk,
+		unsigned int keep_frequency)
 		: folder_path(folder_path)
+		, background(background)
+		, keep_frequency(keep_frequency)
+		, writer(sync_to_disk)
 	{
 	}
 
@@ -34,39 +42,31 @@ namespace nnforge
 	{
 		unsigned int index = task_state.index_peeked;
 
-		std::string data_folder_name = (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % index % task_state.get_current_epoch()).str();
-		save_data_to_file(task_state.data, data_folder_name);
+		// Empty momentum data removes the folder of the momentum
+		std::vector<std::pair<network_data::const_ptr, boost::filesystem::path> > data_folder_list;
+		data_folder_list.push_back(std::make_pair(task_state.data, folder_path / (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % index % task_state.get_current_epoch()).str()));
+		data_folder_list.push_back(std::make_pair(task_state.momentum_data, folder_path / (boost::format("momentum_%|1$03d|") % index).str()));
+		data_folder_list.push_back(std::make_pair(task_state.momentum_data2, folder_path / (boost::format("momentum2_%|1$03d|") % index).str()));
 
+		// Removed by the same write, once the new snapshot is complete, so that there is always a complete snapshot on the disk
+		if ((keep_frequency > 1) && (task_state.get_current_epoch() > 0))
 		{
-			std::string momentum_data_folder_name = (boost::format("momentum_%|1$03d|") % index).str();
-			if (task_state.momentum_data)
-				save_data_to_file(task_state.momentum_data, momentum_data_folder_name);
-			else
-				boost::filesystem::remove_all(folder_path / momentum_data_folder_name);
+			unsigned int previous_epoch = task_state.get_current_epoch() - 1;
+			if (previous_epoch % keep_frequency != 0)
+			{
+				std::string previous_folder_name = (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % index % previous_epoch).str();
+				data_folder_list.push_back(std::make_pair(network_data::const_ptr(), folder_path / previous_folder_name));
+				data_folder_list.push_back(std::make_pair(network_data::const_ptr(), folder_path / (previous_folder_name + network_data_checkpoint::file_extension)));
+			}
 		}
 
-		{
-			std::string momentum2_data_folder_name = (boost::format("momentum2_%|1$03d|") % index).str();
-			if (task_state.momentum_data2)
-				save_data_to_file(task_state.momentum_data2, momentum2_data_folder_name);
-			else
-				boost::filesystem::remove_all(folder_path / momentum2_data_folder_name);
-		}
+		writer.write(data_folder_list);
+		if (!background)
+			writer.wait();
 	}
 
-	void save_snapshot_network_data_pusher::save_data_to_file(
-		network_data::const_ptr data,
-		std::string folder_name) const
+	void save_snapshot_network_data_pusher::flush()
 	{
-		std::string temp_folder_name = folder_name + ".temp";
-
-		boost::filesystem::path temp_full_folder_path = folder_path / temp_folder_name;
-		data->write(temp_full_folder_path);
-
-		boost::filesystem::path full_folder_path = folder_path / folder_name;
-		if (boost::filesystem::exists(full_folder_path))
-			boost::filesystem::remove_all(full_folder_path);
-
-		boost::filesystem::rename(temp_full_folder_path, full_folder_path);
+		writer.wait();
 	}
 }
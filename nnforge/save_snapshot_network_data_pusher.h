@@ -17,6 +17,7 @@
 #pragma once
 
 #include "network_data_pusher.h"
+#include "background_network_data_writer.h"
 
 #include <boost/filesystem.hpp>
 
@@ -25,7 +26,14 @@ namespace nnforge
 	class save_snapshot_network_data_pusher : public network_data_pusher
 	{
 	public:
-		save_snapshot_network_data_pusher(const boost::filesystem::path& folder_path);
+		// Snapshots are written on a background thread when background is set,
+		// push blocks then only when the previous snapshot is still being written.
+		// The snapshot of the previous epoch is removed after the new one is written, unless the epoch is a multiple of keep_frequency
+		save_snapshot_network_data_pusher(
+			const boost::filesystem::path& folder_path,
+			bool background = false,
+			bool sync_to_disk = false,
+			unsigned int keep_frequency = 1);
 
 		virtual ~save_snapshot_network_data_pusher() = default;
 
@@ -33,12 +41,12 @@ namespace nnforge
 			const training_task_state& task_state,
 			const network_schema& schema);
 
-	private:
-		void save_data_to_file(
-			network_data::const_ptr data,
-			std::string folder_name) const;
+		virtual void flush();
 
 	private:
 		boost::filesystem::path folder_path;
+		bool background;
+		unsigned int keep_frequency;
+		background_network_data_writer writer;
 	};
 }
@@ -0,0 +1,131 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_bunch_mapped_average_writer.h"
+
+#include "neural_network_exception.h"
+#include "structured_data_stream_schema.h"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+
+namespace nnforge
+{
+	structured_data_bunch_mapped_average_writer::structured_data_bunch_mapped_average_writer(
+		const std::map<std::string, boost::filesystem::path>& layer_name_to_file_path_map,
+		float new_weight,
+		unsigned int compact_sample_count)
+		: layer_name_to_file_path_map(layer_name_to_file_path_map)
+		, new_weight(new_weight)
+		, compact_sample_count(std::max(compact_sample_count, 1U))
+	{
+	}
+
+	structured_data_bunch_mapped_average_writer::~structured_data_bunch_mapped_average_writer()
+	{
+		unmap();
+	}
+
+	void structured_data_bunch_mapped_average_writer::unmap()
+	{
+		for(std::map<std::string, mapped_file>::const_iterator it = layer_name_to_mapped_file_map.begin(); it != layer_name_to_mapped_file_map.end(); ++it)
+			it->second.region->flush();
+		layer_name_to_mapped_file_map.clear();
+	}
+
+	void structured_data_bunch_mapped_average_writer::set_config_map(const std::map<std::string, layer_configuration_specific> config_map)
+	{
+		std::lock_guard<std::mutex> lock(write_mutex);
+
+		unmap();
+
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+		{
+			std::map<std::string, boost::filesystem::path>::const_iterator path_it = layer_name_to_file_path_map.find(it->first);
+			if (path_it == layer_name_to_file_path_map.end())
+				throw neural_network_exception((boost::format("No file specified for layer %1% in structured_data_bunch_mapped_average_writer") % it->first).str());
+
+			// Header is parsed the same way structured_data_stream_reader does, the data follows it
+			std::istream::pos_type data_pos;
+			mapped_file file;
+			{
+				boost::filesystem::ifstream in(path_it->second, std::ios_base::in | std::ios_base::binary);
+				if (!in)
+					throw neural_network_exception((boost::format("Cannot open %1% for averaging") % path_it->second.string()).str());
+				in.exceptions(std::istream::eofbit | std::istream::failbit | std::istream::badbit);
+
+				boost::uuids::uuid guid_read;
+				in.read(reinterpret_cast<char*>(guid_read.data), sizeof(guid_read.data));
+				if (guid_read != structured_data_stream_schema::structured_data_stream_guid)
+					throw neural_network_exception((boost::format("Unknown structured data GUID encountered in %1%: %2%") % path_it->second.string() % guid_read).str());
+
+				layer_configuration_specific config;
+				config.read(in);
+				if (config != it->second)
+					throw neural_network_exception((boost::format("Configuration stored in %1% doesn't match the one of layer %2%") % path_it->second.string() % it->first).str());
+
+				in.read(reinterpret_cast<char*>(&file.entry_count), sizeof(file.entry_count));
+				data_pos = in.tellg();
+			}
+			file.neuron_count = it->second.get_neuron_count();
+
+			size_t data_size = sizeof(float) * static_cast<size_t>(file.neuron_count) * static_cast<size_t>(file.entry_count);
+			if (static_cast<size_t>(boost::filesystem::file_size(path_it->second)) < static_cast<size_t>(data_pos) + data_size)
+				throw neural_network_exception((boost::format("File %1% is truncated") % path_it->second.string()).str());
+
+			file.mapping = std::make_shared<boost::interprocess::file_mapping>(path_it->second.string().c_str(), boost::interprocess::read_write);
+			file.region = std::make_shared<boost::interprocess::mapped_region>(*file.mapping, boost::interprocess::read_write, static_cast<boost::interprocess::offset_t>(data_pos), data_size);
+			file.data = static_cast<float *>(file.region->get_address());
+			file.entry_scaled_list.resize(file.entry_count, false);
+
+			layer_name_to_mapped_file_map.insert(std::make_pair(it->first, file));
+		}
+	}
+
+	void structured_data_bunch_mapped_average_writer::write(
+		unsigned int entry_id,
+		const std::map<std::string, const float *>& data_map)
+	{
+		unsigned int compacted_entry_id = entry_id / compact_sample_count;
+		float mult = new_weight / static_cast<float>(compact_sample_count);
+		float old_weight = 1.0F - new_weight;
+
+		std::lock_guard<std::mutex> lock(write_mutex);
+
+		for(std::map<std::string, const float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+		{
+			std::map<std::string, mapped_file>::iterator file_it = layer_name_to_mapped_file_map.find(it->first);
+			if (file_it == layer_name_to_mapped_file_map.end())
+				continue;
+
+			mapped_file& file = file_it->second;
+			if (compacted_entry_id >= file.entry_count)
+				throw neural_network_exception((boost::format("Entry %1% is out of %2% entries stored for layer %3%") % compacted_entry_id % file.entry_count % it->first).str());
+
+			float * dst = file.data + static_cast<size_t>(compacted_entry_id) * file.neuron_count;
+			if (!file.entry_scaled_list[compacted_entry_id])
+			{
+				std::transform(dst, dst + file.neuron_count, dst, [old_weight] (float x) { return x * old_weight; });
+				file.entry_scaled_list[compacted_entry_id] = true;
+			}
+			const float * src = it->second;
+			for(unsigned int i = 0; i < file.neuron_count; ++i)
+				dst[i] += src[i] * mult;
+		}
+	}
+}
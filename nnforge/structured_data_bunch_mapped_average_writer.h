@@ -0,0 +1,80 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_bunch_writer.h"
+
+#include <map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace nnforge
+{
+	// Blends entries into the structured data stream files written before, the files are memory mapped instead of being loaded into memory.
+	// Existing values of the compacted entry entry_id / compact_sample_count are scaled by (1 - new_weight) when the first of its entries is written,
+	// then each entry written adds new_weight / compact_sample_count of its values to it, so the entries may come in any order.
+	// Entries which are not written keep their values, so an interrupted run leaves them intact
+	class structured_data_bunch_mapped_average_writer : public structured_data_bunch_writer
+	{
+	public:
+		typedef std::shared_ptr<structured_data_bunch_mapped_average_writer> ptr;
+
+		structured_data_bunch_mapped_average_writer(
+			const std::map<std::string, boost::filesystem::path>& layer_name_to_file_path_map,
+			float new_weight,
+			unsigned int compact_sample_count = 1);
+
+		virtual ~structured_data_bunch_mapped_average_writer();
+
+		// Maps the files for the layers in config_map, configurations and entry counts stored are validated
+		virtual void set_config_map(const std::map<std::string, layer_configuration_specific> config_map);
+
+		virtual void write(
+			unsigned int entry_id,
+			const std::map<std::string, const float *>& data_map);
+
+	private:
+		struct mapped_file
+		{
+			std::shared_ptr<boost::interprocess::file_mapping> mapping;
+			std::shared_ptr<boost::interprocess::mapped_region> region;
+			float * data;
+			unsigned int neuron_count;
+			unsigned int entry_count;
+			// Compacted entries scaled by (1 - new_weight) already
+			std::vector<bool> entry_scaled_list;
+		};
+
+		void unmap();
+
+	private:
+		std::map<std::string, boost::filesystem::path> layer_name_to_file_path_map;
+		float new_weight;
+		unsigned int compact_sample_count;
+
+		std::map<std::string, mapped_file> layer_name_to_mapped_file_map;
+		std::mutex write_mutex;
+
+	private:
+		structured_data_bunch_mapped_average_writer(const structured_data_bunch_mapped_average_writer&) = delete;
+		structured_data_bunch_mapped_average_writer& operator =(const structured_data_bunch_mapped_average_writer&) = delete;
+	};
+}
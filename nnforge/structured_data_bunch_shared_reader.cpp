@@ -0,0 +1,213 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_bunch_shared_reader.h"
+
+#include "neural_network_exception.h"
+
+#include <algorithm>
+#include <cstring>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	structured_data_bunch_shared_reader::structured_data_bunch_shared_reader(
+		structured_data_bunch_reader& original_reader,
+		unsigned int consumer_count,
+		unsigned int max_kept_entry_count)
+		: original_reader(original_reader)
+		, max_kept_entry_count(max_kept_entry_count)
+		, consumer_active_flags(consumer_count, true)
+	{
+		std::map<std::string, layer_configuration_specific> config_map = original_reader.get_config_map();
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+			layer_name_to_neuron_count_map.insert(std::make_pair(it->first, it->second.get_neuron_count()));
+	}
+
+	structured_data_bunch_reader::ptr structured_data_bunch_shared_reader::get_consumer_reader(unsigned int consumer_id)
+	{
+		if (consumer_id >= consumer_active_flags.size())
+			throw neural_network_exception((boost::format("Invalid consumer id %1% for shared reader with %2% consumers") % consumer_id % consumer_active_flags.size()).str());
+
+		return structured_data_bunch_reader::ptr(new consumer_reader(*this, consumer_id));
+	}
+
+	void structured_data_bunch_shared_reader::finish(unsigned int consumer_id)
+	{
+		std::lock_guard<std::mutex> lock(entries_mutex);
+		consumer_active_flags[consumer_id] = false;
+	}
+
+	void structured_data_bunch_shared_reader::set_epoch(unsigned int epoch_id)
+	{
+		std::lock_guard<std::mutex> lock(entries_mutex);
+		entries.clear();
+		entry_id_order.clear();
+		std::fill(consumer_active_flags.begin(), consumer_active_flags.end(), true);
+		original_reader.set_epoch(epoch_id);
+	}
+
+	void structured_data_bunch_shared_reader::drop_oldest_entries()
+	{
+		while (!entry_id_order.empty())
+		{
+			std::map<unsigned int, shared_entry>::iterator it = entries.find(entry_id_order.front());
+			if (it != entries.end())
+			{
+				if ((entries.size() <= max_kept_entry_count) || (!it->second.ready) || (it->second.copying_consumer_count > 0))
+					break;
+				entries.erase(it);
+			}
+			entry_id_order.pop_front();
+		}
+	}
+
+	bool structured_data_bunch_shared_reader::read(
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		std::unique_lock<std::mutex> lock(entries_mutex);
+
+		while (true)
+		{
+			std::map<unsigned int, shared_entry>::iterator it = entries.find(entry_id);
+			if (it == entries.end())
+				break;
+
+			// The entry is being read from the original reader by another consumer, it doesn't depend on the progress of this one
+			if (!it->second.ready)
+			{
+				entries_condition.wait(lock);
+				continue;
+			}
+
+			shared_entry& current_entry = it->second;
+			bool res = current_entry.read_successfully;
+			++current_entry.copying_consumer_count;
+			lock.unlock();
+
+			bool copied = true;
+			if (res)
+			{
+				for(std::map<std::string, float *>::const_iterator it2 = data_map.begin(); it2 != data_map.end(); ++it2)
+				{
+					std::map<std::string, std::vector<float> >::const_iterator data_it = current_entry.data.find(it2->first);
+					if (data_it == current_entry.data.end())
+					{
+						copied = false;
+						break;
+					}
+					memcpy(it2->second, &data_it->second[0], data_it->second.size() * sizeof(float));
+				}
+			}
+
+			lock.lock();
+			--current_entry.copying_consumer_count;
+			if (current_entry.remaining_consumer_count > 0)
+				--current_entry.remaining_consumer_count;
+			if ((current_entry.remaining_consumer_count == 0) && (current_entry.copying_consumer_count == 0))
+				entries.erase(entry_id);
+
+			if (!copied)
+				throw neural_network_exception((boost::format("Entry %1% is kept by the shared reader without some of the layers requested") % entry_id).str());
+
+			return res;
+		}
+
+		// The first consumer reading the entry reads it from the original reader into its own buffers
+		unsigned int remaining_consumer_count = static_cast<unsigned int>(std::count(consumer_active_flags.begin(), consumer_active_flags.end(), true)) - 1;
+		{
+			shared_entry& new_entry = entries[entry_id];
+			new_entry.ready = false;
+			new_entry.read_successfully = false;
+			new_entry.remaining_consumer_count = remaining_consumer_count;
+			new_entry.copying_consumer_count = 0;
+			entry_id_order.push_back(entry_id);
+			drop_oldest_entries();
+		}
+		lock.unlock();
+
+		bool res;
+		std::map<std::string, std::vector<float> > data;
+		try
+		{
+			res = original_reader.read(entry_id, data_map);
+			if (res && (remaining_consumer_count > 0))
+			{
+				for(std::map<std::string, float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+				{
+					std::map<std::string, size_t>::const_iterator neuron_count_it = layer_name_to_neuron_count_map.find(it->first);
+					if (neuron_count_it == layer_name_to_neuron_count_map.end())
+						throw neural_network_exception((boost::format("Shared reader has no layer %1%") % it->first).str());
+					data[it->first].assign(it->second, it->second + neuron_count_it->second);
+				}
+			}
+		}
+		catch (...)
+		{
+			// Consumers waiting for the entry will try reading it themselves
+			lock.lock();
+			entries.erase(entry_id);
+			lock.unlock();
+			entries_condition.notify_all();
+			throw;
+		}
+
+		lock.lock();
+		std::map<unsigned int, shared_entry>::iterator it = entries.find(entry_id);
+		if (it->second.remaining_consumer_count > 0)
+		{
+			it->second.data.swap(data);
+			it->second.read_successfully = res;
+			it->second.ready = true;
+		}
+		else
+			entries.erase(it);
+		lock.unlock();
+		entries_condition.notify_all();
+
+		return res;
+	}
+
+	structured_data_bunch_shared_reader::consumer_reader::consumer_reader(
+		structured_data_bunch_shared_reader& shared_reader,
+		unsigned int consumer_id)
+		: shared_reader(shared_reader)
+		, consumer_id(consumer_id)
+	{
+	}
+
+	std::map<std::string, layer_configuration_specific> structured_data_bunch_shared_reader::consumer_reader::get_config_map() const
+	{
+		return shared_reader.original_reader.get_config_map();
+	}
+
+	bool structured_data_bunch_shared_reader::consumer_reader::read(
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		return shared_reader.read(entry_id, data_map);
+	}
+
+	void structured_data_bunch_shared_reader::consumer_reader::set_epoch(unsigned int epoch_id)
+	{
+	}
+
+	int structured_data_bunch_shared_reader::consumer_reader::get_entry_count() const
+	{
+		return shared_reader.original_reader.get_entry_count();
+	}
+}
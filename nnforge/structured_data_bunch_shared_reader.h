@@ -0,0 +1,115 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_bunch_reader.h"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace nnforge
+{
+	// Lets several consumers read the same entries of the original reader, the entry is read from the original reader once
+	// and kept in memory until all the active consumers read it.
+	// At most max_kept_entry_count entries are kept, the oldest ones are dropped and read again by the consumers lagging behind.
+	// Consumers never wait for each other's progress, as they might be running their reads on the same thread pool
+	class structured_data_bunch_shared_reader
+	{
+	public:
+		typedef std::shared_ptr<structured_data_bunch_shared_reader> ptr;
+
+		structured_data_bunch_shared_reader(
+			structured_data_bunch_reader& original_reader,
+			unsigned int consumer_count,
+			unsigned int max_kept_entry_count);
+
+		~structured_data_bunch_shared_reader() = default;
+
+		// The reader returned should not be used after this object is destroyed
+		structured_data_bunch_reader::ptr get_consumer_reader(unsigned int consumer_id);
+
+		// The consumer doesn't read anymore in this epoch, entries read afterwards are not kept for it
+		void finish(unsigned int consumer_id);
+
+		// Drops the entries kept, sets the epoch of the original reader and makes all the consumers active.
+		// None of the consumers should be reading at the moment
+		void set_epoch(unsigned int epoch_id);
+
+	private:
+		class consumer_reader : public structured_data_bunch_reader
+		{
+		public:
+			consumer_reader(
+				structured_data_bunch_shared_reader& shared_reader,
+				unsigned int consumer_id);
+
+			virtual ~consumer_reader() = default;
+
+			virtual std::map<std::string, layer_configuration_specific> get_config_map() const;
+
+			virtual bool read(
+				unsigned int entry_id,
+				const std::map<std::string, float *>& data_map);
+
+			// The epoch is set for all the consumers at once by the shared reader
+			virtual void set_epoch(unsigned int epoch_id);
+
+			virtual int get_entry_count() const;
+
+		private:
+			structured_data_bunch_shared_reader& shared_reader;
+			unsigned int consumer_id;
+		};
+
+		struct shared_entry
+		{
+			bool ready;
+			bool read_successfully;
+			unsigned int remaining_consumer_count;
+			// The entry is not dropped while consumers are copying it
+			unsigned int copying_consumer_count;
+			std::map<std::string, std::vector<float> > data;
+		};
+
+		bool read(
+			unsigned int entry_id,
+			const std::map<std::string, float *>& data_map);
+
+		// Should be called with entries_mutex locked
+		void drop_oldest_entries();
+
+	private:
+		structured_data_bunch_reader& original_reader;
+		unsigned int max_kept_entry_count;
+		std::map<std::string, size_t> layer_name_to_neuron_count_map;
+
+		std::vector<bool> consumer_active_flags;
+		std::map<unsigned int, shared_entry> entries;
+		// Entry ids in the order they were added, some of them might be removed from entries already
+		std::deque<unsigned int> entry_id_order;
+		std::mutex entries_mutex;
+		std::condition_variable entries_condition;
+
+	private:
+		structured_data_bunch_shared_reader(const structured_data_bunch_shared_reader&) = delete;
+		structured_data_bunch_shared_reader& operator =(const structured_data_bunch_shared_reader&) = delete;
+	};
+}
@@ -0,0 +1,138 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_bunch_stream_writer.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+
+namespace nnforge
+{
+	structured_data_bunch_stream_writer::structured_data_bunch_stream_writer(
+		const std::map<std::string, boost::filesystem::path>& layer_name_to_file_path_map,
+		unsigned int compact_sample_count,
+		unsigned int max_reorder_entry_count)
+		: layer_name_to_file_path_map(layer_name_to_file_path_map)
+		, compact_sample_count(std::max(compact_sample_count, 1U))
+		, max_reorder_entry_count(max_reorder_entry_count)
+		, compact_accumulated_count(0)
+		, next_entry_id(0)
+	{
+	}
+
+	void structured_data_bunch_stream_writer::set_config_map(const std::map<std::string, layer_configuration_specific> config_map)
+	{
+		std::lock_guard<std::mutex> lock(write_mutex);
+
+		this->config_map = config_map;
+		layer_name_to_writer_map.clear();
+		layer_name_to_compact_sum_map.clear();
+		reorder_buffer.clear();
+		compact_accumulated_count = 0;
+		next_entry_id = 0;
+
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+		{
+			std::map<std::string, boost::filesystem::path>::const_iterator path_it = layer_name_to_file_path_map.find(it->first);
+			if (path_it == layer_name_to_file_path_map.end())
+				throw neural_network_exception((boost::format("No file specified for layer %1% in structured_data_bunch_stream_writer") % it->first).str());
+
+			std::shared_ptr<std::ostream> out(new boost::filesystem::ofstream(path_it->second, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary));
+			layer_name_to_writer_map.insert(std::make_pair(it->first, structured_data_stream_writer::ptr(new structured_data_stream_writer(out, it->second))));
+			layer_name_to_compact_sum_map.insert(std::make_pair(it->first, std::vector<float>(it->second.get_neuron_count(), 0.0F)));
+		}
+	}
+
+	void structured_data_bunch_stream_writer::write(
+		unsigned int entry_id,
+		const std::map<std::string, const float *>& data_map)
+	{
+		std::lock_guard<std::mutex> lock(write_mutex);
+
+		if (entry_id < next_entry_id)
+			throw neural_network_exception((boost::format("structured_data_bunch_stream_writer cannot write entry %1% when %2% entries written already") % entry_id % next_entry_id).str());
+
+		if (entry_id > next_entry_id)
+		{
+			if (reorder_buffer.size() >= max_reorder_entry_count)
+				throw neural_network_exception((boost::format("structured_data_bunch_stream_writer reorder buffer is full with %1% entries when waiting for entry %2%") % reorder_buffer.size() % next_entry_id).str());
+
+			std::map<std::string, std::vector<float> >& entry = reorder_buffer[entry_id];
+			for(std::map<std::string, const float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+				entry.insert(std::make_pair(it->first, std::vector<float>(it->second, it->second + config_map[it->first].get_neuron_count())));
+			return;
+		}
+
+		write_in_order(data_map);
+		++next_entry_id;
+
+		// Flush the entries which were waiting for this one
+		for(std::map<unsigned int, std::map<std::string, std::vector<float> > >::iterator it = reorder_buffer.begin(); (it != reorder_buffer.end()) && (it->first == next_entry_id); it = reorder_buffer.erase(it))
+		{
+			std::map<std::string, const float *> buffered_data_map;
+			for(std::map<std::string, std::vector<float> >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+				buffered_data_map.insert(std::make_pair(it2->first, &it2->second[0]));
+			write_in_order(buffered_data_map);
+			++next_entry_id;
+		}
+	}
+
+	void structured_data_bunch_stream_writer::write_in_order(const std::map<std::string, const float *>& data_map)
+	{
+		if (compact_sample_count == 1)
+		{
+			for(std::map<std::string, const float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+				layer_name_to_writer_map[it->first]->write(it->second);
+			return;
+		}
+
+		for(std::map<std::string, const float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+		{
+			std::vector<float>& sum = layer_name_to_compact_sum_map[it->first];
+			const float * src = it->second;
+			for(std::vector<float>::iterator dst_it = sum.begin(); dst_it != sum.end(); ++dst_it, ++src)
+				*dst_it += *src;
+		}
+
+		if ((++compact_accumulated_count) < compact_sample_count)
+			return;
+
+		float mult = 1.0F / static_cast<float>(compact_sample_count);
+		for(std::map<std::string, std::vector<float> >::iterator it = layer_name_to_compact_sum_map.begin(); it != layer_name_to_compact_sum_map.end(); ++it)
+		{
+			std::transform(it->second.begin(), it->second.end(), it->second.begin(), [mult] (float x) { return x * mult; });
+			layer_name_to_writer_map[it->first]->write(&it->second[0]);
+			std::fill(it->second.begin(), it->second.end(), 0.0F);
+		}
+		compact_accumulated_count = 0;
+	}
+
+	void structured_data_bunch_stream_writer::close()
+	{
+		std::lock_guard<std::mutex> lock(write_mutex);
+
+		if (!reorder_buffer.empty())
+			throw neural_network_exception((boost::format("structured_data_bunch_stream_writer is closed when entry %1% is missing") % next_entry_id).str());
+		if (compact_accumulated_count != 0)
+			throw neural_network_exception((boost::format("structured_data_bunch_stream_writer cannot compact %1% entries not evenly divisible by sample count %2%") % next_entry_id % compact_sample_count).str());
+
+		// Writers put entry count into the files when destroyed
+		layer_name_to_writer_map.clear();
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_bunch_writer.h"
+#include "structured_data_stream_writer.h"
+
+#include <map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <boost/filesystem.hpp>
+
+namespace nnforge
+{
+	// Writes entries of each layer to its own file in structured data stream format as they come, instead of keeping them in memory.
+	// Entries coming out of order are held in the reorder buffer until all the preceding ones are written.
+	// Each compact_sample_count consecutive entries are averaged into a single one
+	class structured_data_bunch_stream_writer : public structured_data_bunch_writer
+	{
+	public:
+		typedef std::shared_ptr<structured_data_bunch_stream_writer> ptr;
+
+		structured_data_bunch_stream_writer(
+			const std::map<std::string, boost::filesystem::path>& layer_name_to_file_path_map,
+			unsigned int compact_sample_count = 1,
+			unsigned int max_reorder_entry_count = 1024);
+
+		virtual ~structured_data_bunch_stream_writer() = default;
+
+		// Creates the files for the layers in config_map
+		virtual void set_config_map(const std::map<std::string, layer_configuration_specific> config_map);
+
+		virtual void write(
+			unsigned int entry_id,
+			const std::map<std::string, const float *>& data_map);
+
+		// Finishes the files, the method throws exception in case some entries are missing or the last group of entries is incomplete
+		void close();
+
+	private:
+		void write_in_order(const std::map<std::string, const float *>& data_map);
+
+	private:
+		std::map<std::string, boost::filesystem::path> layer_name_to_file_path_map;
+		unsigned int compact_sample_count;
+		unsigned int max_reorder_entry_count;
+
+		std::map<std::string, layer_configuration_specific> config_map;
+		std::map<std::string, structured_data_stream_writer::ptr> layer_name_to_writer_map;
+		std::map<std::string, std::vector<float> > layer_name_to_compact_sum_map;
+		unsigned int compact_accumulated_count;
+		std::map<unsigned int, std::map<std::string, std::vector<float> > > reorder_buffer;
+		unsigned int next_entry_id;
+		std::mutex write_mutex;
+
+	private:
+		structured_data_bunch_stream_writer(const structured_data_bunch_stream_writer&) = delete;
+		structured_data_bunch_stream_writer& operator =(const structured_data_bunch_stream_writer&) = delete;
+	};
+}
@@ -0,0 +1,62 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_bunch_subset_reader.h"
+
+namespace nnforge
+{
+	structured_data_bunch_subset_reader::structured_data_bunch_subset_reader(
+		structured_data_bunch_reader::ptr original_reader,
+		const std::vector<unsigned int>& entry_subset)
+		: original_reader(original_reader)
+		, entry_subset(entry_subset)
+	{
+	}
+
+	std::map<std::string, layer_configuration_specific> structured_data_bunch_subset_reader::get_config_map() const
+	{
+		return original_reader->get_config_map();
+	}
+
+	bool structured_data_bunch_subset_reader::read(
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		if (entry_id >= entry_subset.size())
+			return false;
+
+		return original_reader->read(entry_subset[entry_id], data_map);
+	}
+
+	void structured_data_bunch_subset_reader::set_epoch(unsigned int epoch_id)
+	{
+		original_reader->set_epoch(epoch_id);
+	}
+
+	int structured_data_bunch_subset_reader::get_entry_count() const
+	{
+		return static_cast<int>(entry_subset.size());
+	}
+
+	structured_data_bunch_reader::ptr structured_data_bunch_subset_reader::get_narrow_reader(const std::set<std::string>& layer_names) const
+	{
+		structured_data_bunch_reader::ptr narrow_original_reader = original_reader->get_narrow_reader(layer_names);
+		if (!narrow_original_reader)
+			return structured_data_bunch_reader::ptr();
+
+		return structured_data_bunch_reader::ptr(new structured_data_bunch_subset_reader(narrow_original_reader, entry_subset));
+	}
+}
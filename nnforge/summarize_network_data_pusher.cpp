@@ -23,8 +23,13 @@
 
 namespace nnforge
 {
-	summarize_network_data_pusher::summarize_network_data_pusher(const boost::filesystem::path& folder_path)
+	summarize_network_data_pusher::summarize_network_data_pusher(
+		const boost::filesystem::path& folder_path,
+		bool background,
+		bool sync_to_disk)
 		: folder_path(folder_path)
+		, background(background)
+		, writer(sync_to_disk)
 	{
 	}
 
@@ -33,9 +38,17 @@ namespace nnforge
 		const network_schema& schema)
 	{
 		unsigned int index = task_state.index_peeked;
-		network_data::const_ptr data = task_state.data;
 
-		std::string data_folder_name = (boost::format("ann_trained_%|1$03d|") % index).str();
-		data->write(folder_path / data_folder_name);
+		std::vector<std::pair<network_data::const_ptr, boost::filesystem::path> > data_folder_list;
+		data_folder_list.push_back(std::make_pair(task_state.data, folder_path / (boost::format("ann_trained_%|1$03d|") % index).str()));
+
+		writer.write(data_folder_list);
+		if (!background)
+			writer.wait();
+	}
+
+	void summarize_network_data_pusher::flush()
+	{
+		writer.wait();
 	}
 }
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "network_data_pusher.h"
+#include "background_network_data_writer.h"
 
 #include <boost/filesystem.hpp>
 
@@ -25,7 +26,11 @@ namespace nnforge
 	class summarize_network_data_pusher : public network_data_pusher
 	{
 	public:
-		summarize_network_data_pusher(const boost::filesystem::path& folder_path);
+		// Trained data is written on a background thread when background is set, so that training the next network doesn't wait for it
+		summarize_network_data_pusher(
+			const boost::filesystem::path& folder_path,
+			bool background = false,
+			bool sync_to_disk = false);
 
 		virtual ~summarize_network_data_pusher() = default;
 
@@ -33,7 +38,11 @@ namespace nnforge
 			const training_task_state& task_state,
 			const network_schema& schema);
 
+		virtual void flush();
+
 	private:
 		boost::filesystem::path folder_path;
+		bool background;
+		background_network_data_writer writer;
 	};
 }
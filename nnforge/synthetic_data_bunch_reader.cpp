@@ -0,0 +1,94 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "synthetic_data_bunch_reader.h"
+
+#include "rnd.h"
+#include "neural_network_exception.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	const unsigned int synthetic_data_bunch_reader::max_pool_entry_count = 16;
+
+	synthetic_data_bunch_reader::synthetic_data_bunch_reader(
+		const std::map<std::string, layer_configuration_specific>& config_map,
+		unsigned int entry_count,
+		unsigned int seed)
+		: config_map(config_map)
+		, entry_count(entry_count)
+		, seed(seed)
+		, pool_entry_count(std::max(std::min(entry_count, max_pool_entry_count), 1U))
+	{
+		random_generator gen = rnd::get_random_generator(seed);
+		std::uniform_real_distribution<float> dist(0.0F, 1.0F);
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+		{
+			std::vector<float>& pool = layer_name_to_pool_map.insert(std::make_pair(it->first, std::vector<float>(static_cast<size_t>(it->second.get_neuron_count()) * pool_entry_count))).first->second;
+			for(std::vector<float>::iterator it2 = pool.begin(); it2 != pool.end(); ++it2)
+				*it2 = dist(gen);
+		}
+	}
+
+	std::map<std::string, layer_configuration_specific> synthetic_data_bunch_reader::get_config_map() const
+	{
+		return config_map;
+	}
+
+	bool synthetic_data_bunch_reader::read(
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		if (entry_id >= entry_count)
+			return false;
+
+		unsigned int pool_entry_id = entry_id % pool_entry_count;
+		for(std::map<std::string, float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+		{
+			std::map<std::string, layer_configuration_specific>::const_iterator config_it = config_map.find(it->first);
+			if (config_it == config_map.end())
+				throw neural_network_exception((boost::format("synthetic_data_bunch_reader has no data for layer %1%") % it->first).str());
+			size_t neuron_count = config_it->second.get_neuron_count();
+			memcpy(it->second, &layer_name_to_pool_map[it->first][neuron_count * pool_entry_id], neuron_count * sizeof(float));
+		}
+
+		return true;
+	}
+
+	void synthetic_data_bunch_reader::set_epoch(unsigned int epoch_id)
+	{
+	}
+
+	int synthetic_data_bunch_reader::get_entry_count() const
+	{
+		return static_cast<int>(entry_count);
+	}
+
+	structured_data_bunch_reader::ptr synthetic_data_bunch_reader::get_narrow_reader(const std::set<std::string>& layer_names) const
+	{
+		std::map<std::string, layer_configuration_specific> narrow_config_map;
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = config_map.begin(); it != config_map.end(); ++it)
+		{
+			if (layer_names.find(it->first) != layer_names.end())
+				narrow_config_map.insert(*it);
+		}
+		return synthetic_data_bunch_reader::ptr(new synthetic_data_bunch_reader(narrow_config_map, entry_count, seed));
+	}
+}
@@ -0,0 +1,67 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "layer_configuration_specific.h"
+#include "structured_data_bunch_reader.h"
+
+#include <map>
+#include <vector>
+#include <memory>
+
+namespace nnforge
+{
+	// Serves random data of the configuration specified from memory, used to benchmark compute without any I/O involved
+	class synthetic_data_bunch_reader : public structured_data_bunch_reader
+	{
+	public:
+		typedef std::shared_ptr<synthetic_data_bunch_reader> ptr;
+
+		synthetic_data_bunch_reader(
+			const std::map<std::string, layer_configuration_specific>& config_map,
+			unsigned int entry_count,
+			unsigned int seed = 0);
+
+		virtual ~synthetic_data_bunch_reader() = default;
+
+		virtual std::map<std::string, layer_configuration_specific> get_config_map() const;
+
+		// The method returns false in case the entry cannot be read
+		virtual bool read(
+			unsigned int entry_id,
+			const std::map<std::string, float *>& data_map);
+
+		virtual void set_epoch(unsigned int epoch_id);
+
+		// Return -1 in case there is no info on entry count
+		virtual int get_entry_count() const;
+
+		// Empty return value (default) indicates original reader should be used
+		virtual structured_data_bunch_reader::ptr get_narrow_reader(const std::set<std::string>& layer_names) const;
+
+	private:
+		std::map<std::string, layer_configuration_specific> config_map;
+		unsigned int entry_count;
+		unsigned int seed;
+
+		// Entry i is served from the pool entry i % pool_entry_count
+		unsigned int pool_entry_count;
+		std::map<std::string, std::vector<float> > layer_name_to_pool_map;
+
+		static const unsigned int max_pool_entry_count;
+	};
+}
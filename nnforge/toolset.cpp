@@ -28,14 +28,23 @@
 #include "layer_factory.h"
 #include "neural_network_exception.h"
 #include "neuron_value_set_data_bunch_writer.h"
+#include "average_data_bunch_writer.h"
+#include "composite_data_bunch_writer.h"
+#include "structured_data_bunch_stream_writer.h"
+#include "structured_data_bunch_mapped_average_writer.h"
+#include "forward_propagation_ensemble.h"
+#include "structured_data_bunch_subset_reader.h"
 #include "network_trainer_sgd.h"
 #include "network_data_peeker_random.h"
+#include "network_data_checkpoint.h"
 #include "complex_network_data_pusher.h"
 #include "save_snapshot_network_data_pusher.h"
+#include "background_network_data_writer.h"
 #include "clean_snapshots_network_data_pusher.h"
 #include "report_progress_network_data_pusher.h"
 #include "summarize_network_data_pusher.h"
 #include "validate_progress_network_data_pusher.h"
+#include "traced_network_data_pusher.h"
 #include "structured_data_stream_writer.h"
 #include "structured_data_bunch_stream_reader.h"
 #include "data_visualizer.h"
@@ -48,6 +57,22 @@
 #include "batch_norm_layer.h"
 #include "stat_data_bunch_writer.h"
 #include "training_data_util.h"
+#include "synthetic_data_bunch_reader.h"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/process.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
 
 namespace nnforge
 {
@@ -56,8 +81,9 @@ namespace nnforge
 	const char * toolset::debug_subfolder_name = "debug";
 	const char * toolset::profile_subfolder_name = "profile";
 	const char * toolset::dump_data_subfolder_name = "dump_data";
-	const char * toolset::trained_ann_index_extractor_pattern = "^ann_trained_(\\d+)$";
-	const char * toolset::snapshot_ann_index_extractor_pattern = "^ann_trained_(\\d+)_epoch_(\\d+)$";
+	const char * toolset::frozen_prefix_cache_subfolder_name = "frozen_prefix_cache";
+	const char * toolset::trained_ann_index_extractor_pattern = "^ann_trained_(\\d+)(\\.nnc)?$";
+	const char * toolset::snapshot_ann_index_extractor_pattern = "^ann_trained_(\\d+)_epoch_(\\d+)(\\.nnc)?$";
 	const char * toolset::ann_snapshot_subfolder_name = "snapshots";
 	const char * toolset::dataset_extractor_pattern = "^%1%_(.+)\\.dt$";
 	const char * toolset::dataset_value_data_layer_name = "dataset_value";
@@ -117,6 +143,18 @@ namespace nnforge
 		{
 			update_bn_weights();
 		}
+		else if (!action.compare("benchmark"))
+		{
+			benchmark();
+		}
+		else if (!action.compare("convert_to_checkpoint"))
+		{
+			convert_to_checkpoint();
+		}
+		else if (!action.compare("convert_from_checkpoint"))
+		{
+			convert_from_checkpoint();
+		}
 		else
 		{
 			do_custom_action();
@@ -127,6 +165,7 @@ namespace nnforge
 	{
 		default_config_path = argv[0];
 		default_config_path += ".cfg";
+		command_line_args.assign(argv, argv + argc);
 
 		// Declare a group of options that will be 
 		// allowed only on command line
@@ -266,7 +305,15 @@ namespace nnforge
 			return false;
 		}
 
-		boost::filesystem::path logfile_path = get_working_data_folder() / logfile_name;
+		if ((worker_process_count < 1) || (worker_process_rank < 0) || (worker_process_rank >= worker_process_count))
+			throw neural_network_exception((boost::format("Invalid worker_process_rank %1% for worker_process_count %2%") % worker_process_rank % worker_process_count).str());
+
+		if (concurrent_network_count < 1)
+			throw neural_network_exception((boost::format("Invalid concurrent_network_count %1%") % concurrent_network_count).str());
+		if ((concurrent_network_count > 1) && (worker_process_count > 1))
+			throw neural_network_exception("concurrent_network_count cannot be used together with worker_process_count");
+
+		boost::filesystem::path logfile_path = get_working_data_folder() / ((worker_process_rank > 0) ? (boost::format("log_worker_%1%.txt") % worker_process_rank).str() : std::string(logfile_name));
 		if (log_mode == "redirect")
 		{
 			out_to_log_redirector = std::shared_ptr<stream_redirector>(new stream_redirector(logfile_path));
@@ -295,6 +342,10 @@ namespace nnforge
 
 		master_factory->initialize();
 
+		// The random part keeps the name unique when the process id is reused after a crashed run left its shared memory segment behind
+		if ((worker_process_count > 1) && worker_process_group.empty())
+			worker_process_group = (boost::format("nnforge_%1%_%|2$08x|") % boost::this_process::get_id() % std::random_device()()).str();
+
 		forward_prop_factory = master_factory->create_forward_propagation_factory();
 		backward_prop_factory = master_factory->create_backward_propagation_factory();
 
@@ -326,7 +377,7 @@ namespace nnforge
 	{
 		std::vector<string_option> res;
 
-		res.push_back(string_option("action", &action, get_default_action().c_str(), "run action (info, prepare_training_data, prepare_testing_data, shuffle_data, dump_data, dump_schema, create_normalizer, inference, train, save_random_weights, update_bn_weights)"));
+		res.push_back(string_option("action", &action, get_default_action().c_str(), "run action (info, prepare_training_data, prepare_testing_data, shuffle_data, dump_data, dump_schema, create_normalizer, inference, train, save_random_weights, update_bn_weights, benchmark, convert_to_checkpoint, convert_from_checkpoint)"));
 		res.push_back(string_option("schema", &schema_filename, "schema.txt", "Name of the file with schema of the network, in protobuf format"));
 		res.push_back(string_option("inference_dataset_name", &inference_dataset_name, "validating", "Name of the dataset to be used for inference"));
 		res.push_back(string_option("training_dataset_name", &training_dataset_name, "training", "Name of the dataset to be used for training"));
@@ -346,6 +397,9 @@ namespace nnforge
 		res.push_back(string_option("check_gradient_weights", &check_gradient_weights, "::", "The set of weights to check for gradient, in the form Layer:WeightSet:WeightID"));
 		res.push_back(string_option("learning_rate_policy", &learning_rate_policy, "exponential", "Learning rate decay policy (exponential, step)"));
 		res.push_back(string_option("step_learning_rate_epochs_and_rates", &step_learning_rate_epochs_and_rates, "", "List of start epoch and decay for step learining rate policy, for example 30:0.1:60:0.01"));
+		res.push_back(string_option("benchmark_batch_sizes", &benchmark_batch_sizes, "", "Comma separated list of mini-batch sizes to benchmark training with, empty value means using batch_size"));
+		res.push_back(string_option("benchmark_thread_counts", &benchmark_thread_counts, "", "Comma separated list of backend thread counts to benchmark with, empty value means no sweep"));
+		res.push_back(string_option("worker_process_group", &worker_process_group, "", "Name the worker processes use to find each other, unique for each run, set by the launching process"));
 
 		return res;
 	}
@@ -359,6 +413,7 @@ namespace nnforge
 		res.push_back(multi_string_option("training_output_layer_name", &training_output_layer_names, "Names of the output layers when doing training"));
 		res.push_back(multi_string_option("training_error_source_layer_name", &training_error_source_layer_names, "Names of the error sources for training"));
 		res.push_back(multi_string_option("training_exclude_data_update_layer_name", &training_exclude_data_update_layer_names, "Names of layers which shouldn't be trained"));
+		res.push_back(multi_string_option("benchmark_input_layer_config", &benchmark_input_layer_configs, "Configuration of the input layer for synthetic benchmark data, in the form Layer,FeatureMapCount,Dim0,Dim1..., configuration of the training dataset is used if none specified"));
 
 		return res;
 	}
@@ -383,6 +438,14 @@ namespace nnforge
 		res.push_back(bool_option("resume_from_snapshot,R", &resume_from_snapshot, false, "Continue neural network training starting from saved snapshot"));
 		res.push_back(bool_option("dump_snapshot", &dump_snapshot, true, "Dump neural network data after each epoch"));
 		res.push_back(bool_option("dump_data_rgb", &dump_data_rgb, true, "Treat 3 feature map data layer as RGB"));
+		res.push_back(bool_option("update_bn_weights_single_pass", &update_bn_weights_single_pass, false, "Collect statistics for all Batch Normalization layers in a single pass, the layers normalize with statistics of the entries processed at once"));
+		res.push_back(bool_option("inference_ensemble", &inference_ensemble, false, "Run all the networks on each chunk of the inference dataset read once instead of reading the dataset for each network"));
+		res.push_back(bool_option("background_validation", &background_validation, false, "Validate a copy of the weights in a background thread while training goes on, at most one validation per network waits for the running one"));
+		res.push_back(bool_option("background_snapshot_saving", &background_snapshot_saving, false, "Write snapshots and trained data on a background thread from a copy, training waits only for the previous write to complete"));
+		res.push_back(bool_option("sync_snapshots_to_disk", &sync_snapshots_to_disk, false, "Flush all the files of each snapshot to the disk before renaming its temporary folder or checkpoint file"));
+		res.push_back(bool_option("cache_frozen_prefix", &cache_frozen_prefix, false, "Run the layers frozen by training_exclude_data_update_layer_name once and train the rest of the network on their cached outputs. Training data transformers should be deterministic, random augmentations are rejected"));
+		res.push_back(bool_option("remove_converted_sources", &remove_converted_sources, false, "Delete the folders and files convert_to_checkpoint and convert_from_checkpoint converted, after all of them are converted"));
+		res.push_back(bool_option("worker_process_launch", &worker_process_launch, true, "The worker process with rank 0 launches the rest of worker_process_count on this host. Turn it off when they are started separately, on other hosts for example"));
 
 		return res;
 	}
@@ -425,6 +488,17 @@ namespace nnforge
 		res.push_back(int_option("check_gradient_max_weights_per_set", &check_gradient_max_weights_per_set, 20, "The maximum amount of weights to check in the set"));
 		res.push_back(int_option("keep_snapshots_frequency", &keep_snapshots_frequency, 10, "Keep every Nth snapshot"));
 		res.push_back(int_option("step_learning_rate_warmup_epochs", &step_learning_rate_warmup_epochs, 0, "How many epochs from the beginning LR goes up to target one"));
+		res.push_back(int_option("update_bn_weights_entry_count", &update_bn_weights_entry_count, 0, "Number of training entries randomly sampled to update Batch Normalization weights, 0 indicates the whole dataset"));
+		res.push_back(int_option("inference_ensemble_chunk_size", &inference_ensemble_chunk_size, 4096, "Number of entries read at once for inference_ensemble"));
+		res.push_back(int_option("inference_ensemble_thread_group_count", &inference_ensemble_thread_group_count, 1, "Number of thread groups running networks concurrently for inference_ensemble, backend threads are split between the groups"));
+		res.push_back(int_option("inference_ensemble_reader_thread_count", &inference_ensemble_reader_thread_count, 1, "Number of threads reading the next chunk for inference_ensemble while the networks run on the current one"));
+		res.push_back(int_option("benchmark_warmup_iteration_count", &benchmark_warmup_iteration_count, 2, "Number of untimed iterations before measuring"));
+		res.push_back(int_option("benchmark_iteration_count", &benchmark_iteration_count, 20, "Number of measured iterations"));
+		res.push_back(int_option("benchmark_entry_count", &benchmark_entry_count, 1024, "Number of synthetic entries processed in each iteration"));
+		res.push_back(int_option("worker_process_count", &worker_process_count, 1, "Number of processes training the network on this host, each of them processing its own part of every chunk. The first one launches the rest"));
+		res.push_back(int_option("worker_process_rank", &worker_process_rank, 0, "Rank of the worker process, set by the launching process"));
+		res.push_back(int_option("concurrent_network_count", &concurrent_network_count, 1, "Number of networks trained at the same time, those at the same epoch read and decode the training data once"));
+		res.push_back(int_option("concurrent_network_kept_entry_count", &concurrent_network_kept_entry_count, 8192, "Maximum number of entries kept in memory for the networks trained concurrently, the networks lagging behind more read the data again"));
 
 		return res;
 	}
@@ -559,7 +633,19 @@ namespace nnforge
 		std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
 		std::cout << "Running inference for " << ann_data_name_and_folderpath_list.size() << " networks..." << std::endl;
 
-		std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > average_layer_name_to_config_and_value_set_map;
+		std::map<std::string, boost::filesystem::path> dump_file_path_map;
+		if (inference_mode == "dump_average_across_nets")
+		{
+			dump_file_path_map = get_inference_dump_file_path_map();
+			for(std::map<std::string, boost::filesystem::path>::const_iterator it = dump_file_path_map.begin(); it != dump_file_path_map.end(); ++it)
+				std::cout << "Writing " << it->second.string() << std::endl;
+		}
+		else if (inference_mode != "report_average_per_entry")
+			throw neural_network_exception((boost::format("Unknown inference_mode specified: %1%") % inference_mode).str());
+
+		if (inference_ensemble && forward_prop->is_schema_with_weights() && (ann_data_name_and_folderpath_list.size() > 1))
+			return run_inference_ensemble(*schema, *reader, ann_data_name_and_folderpath_list, dump_file_path_map);
+
 		unsigned int accumulated_count = 0;
 
 		if (forward_prop->is_schema_with_weights())
@@ -570,37 +656,52 @@ namespace nnforge
 				data.read(it->second);
 				forward_prop->set_data(data);
 
-				neuron_value_set_data_bunch_writer writer;
-				forward_propagation::stat st = forward_prop->run(*reader, writer);
-				std::cout << "NN # " << it->first << " - " << st << std::endl;
-
-				std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > res_layer_map;
-
-				for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::iterator it2 = writer.layer_name_to_config_and_value_set_map.begin(); it2 != writer.layer_name_to_config_and_value_set_map.end(); ++it2)
+				std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > average_map;
+				if (inference_mode == "report_average_per_entry")
 				{
-					std::shared_ptr<std::vector<double> > average_list = it2->second.second->get_average();
-					res_layer_map.insert(std::make_pair(it2->first, std::make_pair(it2->second.first, *average_list)));
-
-					if (inference_mode == "report_average_per_entry")
-						std::cout << schema->get_layer(it2->first)->get_string_for_average_data(it2->second.first, *average_list) << std::endl;
-					else if (inference_mode == "dump_average_across_nets")
+					// Only averages are needed, entries are not kept
+					average_data_bunch_writer writer;
+					forward_propagation::stat st = forward_prop->run(*reader, writer);
+					std::cout << "NN # " << it->first << " - " << st << std::endl;
+
+					average_map = writer.get_average();
+					for(std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > >::const_iterator it2 = average_map.begin(); it2 != average_map.end(); ++it2)
+						std::cout << schema->get_layer(it2->first)->get_string_for_average_data(it2->second.first, *it2->second.second) << std::endl;
+				}
+				else if (inference_mode == "dump_average_across_nets")
+				{
+					// Outputs of the first network are streamed to the files, outputs of the rest are blended into the files memory mapped
+					average_data_bunch_writer::ptr average_writer(new average_data_bunch_writer());
+					structured_data_bunch_stream_writer::ptr stream_writer;
+					structured_data_bunch_writer::ptr dump_writer;
+					if (accumulated_count == 0)
 					{
-						it2->second.second->compact(dump_compact_samples);
-
-						if (it == ann_data_name_and_folderpath_list.begin())
-							average_layer_name_to_config_and_value_set_map.insert(*it2);
-						else
-						{
-							float alpha = 1.0F / static_cast<float>(accumulated_count + 1);
-							float beta = 1.0F - alpha;
-							average_layer_name_to_config_and_value_set_map[it2->first].second->add(*it2->second.second, alpha, beta);
-						}
+						stream_writer = structured_data_bunch_stream_writer::ptr(new structured_data_bunch_stream_writer(dump_file_path_map, dump_compact_samples));
+						dump_writer = stream_writer;
 					}
 					else
-						throw neural_network_exception((boost::format("Unknown inference_mode specified: %1%") % inference_mode).str());
+						dump_writer = structured_data_bunch_writer::ptr(new structured_data_bunch_mapped_average_writer(dump_file_path_map, 1.0F / static_cast<float>(accumulated_count + 1), dump_compact_samples));
 
-					res.insert(std::make_pair(it->first, res_layer_map));
+					{
+						std::vector<structured_data_bunch_writer::ptr> writers;
+						writers.push_back(average_writer);
+						writers.push_back(dump_writer);
+						composite_data_bunch_writer writer(writers);
+						forward_propagation::stat st = forward_prop->run(*reader, writer);
+						std::cout << "NN # " << it->first << " - " << st << std::endl;
+					}
+
+					if (stream_writer)
+						stream_writer->close();
+					average_map = average_writer->get_average();
 				}
+				else
+					throw neural_network_exception((boost::format("Unknown inference_mode specified: %1%") % inference_mode).str());
+
+				std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > res_layer_map;
+				for(std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > >::const_iterator it2 = average_map.begin(); it2 != average_map.end(); ++it2)
+					res_layer_map.insert(std::make_pair(it2->first, std::make_pair(it2->second.first, *it2->second.second)));
+				res.insert(std::make_pair(it->first, res_layer_map));
 
 				++accumulated_count;
 			}
@@ -610,45 +711,103 @@ namespace nnforge
 			network_data data;
 			forward_prop->set_data(data);
 
-			neuron_value_set_data_bunch_writer writer;
-			forward_propagation::stat st = forward_prop->run(*reader, writer);
-			std::cout << "NN <no weights uniform> - " << st << std::endl;
+			if (inference_mode == "report_average_per_entry")
+			{
+				average_data_bunch_writer writer;
+				forward_propagation::stat st = forward_prop->run(*reader, writer);
+				std::cout << "NN <no weights uniform> - " << st << std::endl;
 
-			for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it2 = writer.layer_name_to_config_and_value_set_map.begin(); it2 != writer.layer_name_to_config_and_value_set_map.end(); ++it2)
+				std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > average_map = writer.get_average();
+				for(std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > >::const_iterator it2 = average_map.begin(); it2 != average_map.end(); ++it2)
+					std::cout << schema->get_layer(it2->first)->get_string_for_average_data(it2->second.first, *it2->second.second) << std::endl;
+			}
+			else if (inference_mode == "dump_average_across_nets")
 			{
-				if (inference_mode == "report_average_per_entry")
-					std::cout << schema->get_layer(it2->first)->get_string_for_average_data(it2->second.first, *it2->second.second->get_average()) << std::endl;
-				else if (inference_mode == "dump_average_across_nets")
-				{
-					average_layer_name_to_config_and_value_set_map.insert(*it2);
-				}
-				else
-					throw neural_network_exception((boost::format("Unknown inference_mode specified: %1%") % inference_mode).str());
+				structured_data_bunch_stream_writer writer(dump_file_path_map);
+				forward_propagation::stat st = forward_prop->run(*reader, writer);
+				std::cout << "NN <no weights uniform> - " << st << std::endl;
+
+				writer.close();
 			}
+			else
+				throw neural_network_exception((boost::format("Unknown inference_mode specified: %1%") % inference_mode).str());
 
 			++accumulated_count;
 		}
 
+		return res;
+	}
+
+	std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > toolset::run_inference_ensemble(
+		const network_schema& schema,
+		structured_data_bunch_reader& reader,
+		const std::vector<std::pair<unsigned int, boost::filesystem::path> >& ann_data_name_and_folderpath_list,
+		const std::map<std::string, boost::filesystem::path>& dump_file_path_map)
+	{
+		if (inference_ensemble_chunk_size <= 0)
+			throw neural_network_exception((boost::format("Invalid inference_ensemble_chunk_size: %1%") % inference_ensemble_chunk_size).str());
+		if (inference_ensemble_thread_group_count <= 0)
+			throw neural_network_exception((boost::format("Invalid inference_ensemble_thread_group_count: %1%") % inference_ensemble_thread_group_count).str());
+		if (inference_ensemble_reader_thread_count <= 0)
+			throw neural_network_exception((boost::format("Invalid inference_ensemble_reader_thread_count: %1%") % inference_ensemble_reader_thread_count).str());
+
+		// Network i runs in group i % group_count, each group has its own share of the backend threads
+		unsigned int group_count = std::max(std::min(static_cast<unsigned int>(inference_ensemble_thread_group_count), static_cast<unsigned int>(ann_data_name_and_folderpath_list.size())), 1U);
+		std::vector<forward_propagation::ptr> forward_props;
+		std::vector<average_data_bunch_writer::ptr> average_writers;
+		for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
+		{
+			unsigned int group_id = static_cast<unsigned int>(forward_props.size()) % group_count;
+			forward_propagation::ptr forward_prop = forward_prop_factory->create_in_group(schema, inference_output_layer_names, group_id, group_count, debug, profile);
+			network_data data;
+			data.read(it->second);
+			forward_prop->set_data(data);
+			forward_props.push_back(forward_prop);
+			average_writers.push_back(average_data_bunch_writer::ptr(new average_data_bunch_writer()));
+		}
+
+		structured_data_bunch_stream_writer::ptr stream_writer;
 		if (inference_mode == "dump_average_across_nets")
+			stream_writer = structured_data_bunch_stream_writer::ptr(new structured_data_bunch_stream_writer(dump_file_path_map, dump_compact_samples));
+
+		forward_propagation_ensemble ensemble(forward_props, inference_ensemble_chunk_size, group_count, inference_ensemble_reader_thread_count);
+		forward_propagation_ensemble::stat st = ensemble.run(
+			reader,
+			stream_writer,
+			std::vector<structured_data_bunch_writer::ptr>(average_writers.begin(), average_writers.end()));
+		std::cout << "Ensemble of " << forward_props.size() << " networks - " << st << std::endl;
+
+		if (stream_writer)
+			stream_writer->close();
+
+		std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > res;
+		for(unsigned int i = 0; i < static_cast<unsigned int>(ann_data_name_and_folderpath_list.size()); ++i)
 		{
-			for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = average_layer_name_to_config_and_value_set_map.begin(); it != average_layer_name_to_config_and_value_set_map.end(); ++it)
+			std::cout << "NN # " << ann_data_name_and_folderpath_list[i].first << " - " << st.network_stats[i] << std::endl;
+
+			std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > average_map = average_writers[i]->get_average();
+			std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > res_layer_map;
+			for(std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > >::const_iterator it = average_map.begin(); it != average_map.end(); ++it)
 			{
-				std::string dataset_name = inference_output_dataset_name.empty() ? inference_dataset_name : inference_output_dataset_name;
-				std::string file_name = (boost::format("%1%_%2%.dt") % dataset_name % it->first).str();
-				boost::filesystem::path file_path = get_working_data_folder() / file_name;
-				std::cout << "Writing " << file_path.string() << std::endl;
-				std::shared_ptr<std::ostream> out(new boost::filesystem::ofstream(file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary));
-				{
-					structured_data_stream_writer dw(out, it->second.first);
-					const std::vector<std::shared_ptr<std::vector<float> > >& data = it->second.second->neuron_value_list;
-					unsigned int entry_id = 0;
-					for(std::vector<std::shared_ptr<std::vector<float> > >::const_iterator data_it = data.begin(); data_it != data.end(); ++data_it, ++entry_id)
-					{
-						const std::vector<float>& dd = **data_it;
-						dw.write(entry_id, &dd[0]);
-					}
-				}
+				if (inference_mode == "report_average_per_entry")
+					std::cout << schema.get_layer(it->first)->get_string_for_average_data(it->second.first, *it->second.second) << std::endl;
+				res_layer_map.insert(std::make_pair(it->first, std::make_pair(it->second.first, *it->second.second)));
 			}
+			res.insert(std::make_pair(ann_data_name_and_folderpath_list[i].first, res_layer_map));
+		}
+
+		return res;
+	}
+
+	std::map<std::string, boost::filesystem::path> toolset::get_inference_dump_file_path_map() const
+	{
+		std::map<std::string, boost::filesystem::path> res;
+
+		std::string dataset_name = inference_output_dataset_name.empty() ? inference_dataset_name : inference_output_dataset_name;
+		for(std::vector<std::string>::const_iterator it = inference_output_layer_names.begin(); it != inference_output_layer_names.end(); ++it)
+		{
+			std::string file_name = (boost::format("%1%_%2%.dt") % dataset_name % *it).str();
+			res.insert(std::make_pair(*it, get_working_data_folder() / file_name));
 		}
 
 		return res;
@@ -659,6 +818,14 @@ namespace nnforge
 		dataset_usage usage,
 		unsigned int multiple_epoch_count,
 		unsigned int shuffle_block_size) const
+	{
+		structured_data_bunch_reader::ptr res(new structured_data_bunch_stream_reader(get_structured_data_reader_map(dataset_name, usage), multiple_epoch_count, shuffle_block_size));
+		return res;
+	}
+
+	std::map<std::string, structured_data_reader::ptr> toolset::get_structured_data_reader_map(
+		const std::string& dataset_name,
+		dataset_usage usage) const
 	{
 		std::map<std::string, boost::filesystem::path> data_filenames = get_data_filenames(dataset_name);
 
@@ -674,8 +841,7 @@ namespace nnforge
 			std::string(dataset_value_data_layer_name),
 			structured_data_reader::ptr(new structured_data_constant_reader(get_dataset_value_data_value(dataset_name, usage), layer_configuration_specific(1)))));
 
-		structured_data_bunch_reader::ptr res(new structured_data_bunch_stream_reader(data_reader_map, multiple_epoch_count, shuffle_block_size));
-		return res;
+		return data_reader_map;
 	}
 
 	float toolset::get_dataset_value_data_value(
@@ -694,10 +860,10 @@ namespace nnforge
 
 	std::vector<std::pair<unsigned int, boost::filesystem::path> > toolset::get_ann_data_index_and_folderpath_list() const
 	{
-		std::vector<std::pair<unsigned int, boost::filesystem::path> > res;
-
 		boost::filesystem::path trained_data_folder = get_working_data_folder() / get_ann_subfolder_name();
 
+		// Single-file checkpoint is preferred to the folder with the same index as it loads faster
+		std::map<unsigned int, boost::filesystem::path> ann_data_index_to_path_map;
 		std::regex expression(trained_ann_index_extractor_pattern);
 		std::cmatch what;
 		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(trained_data_folder); it != boost::filesystem::directory_iterator(); ++it)
@@ -711,11 +877,14 @@ namespace nnforge
 				if ((inference_ann_data_index != -1) && (inference_ann_data_index != ann_data_index))
 					continue;
 
-				res.push_back(std::make_pair(ann_data_index, folder_path));
+				if (what[2].matched)
+					ann_data_index_to_path_map[ann_data_index] = folder_path;
+				else
+					ann_data_index_to_path_map.insert(std::make_pair(ann_data_index, folder_path));
 			}
 		}
 
-		return res;
+		return std::vector<std::pair<unsigned int, boost::filesystem::path> >(ann_data_index_to_path_map.begin(), ann_data_index_to_path_map.end());
 	}
 
 	void toolset::dump_schema_gv()
@@ -732,6 +901,30 @@ namespace nnforge
 
 	void toolset::train()
 	{
+		// Running worker processes are terminated when their handles are destroyed, so that they don't wait for this one if it fails
+		std::vector<std::shared_ptr<boost::process::child> > worker_processes;
+		for(int rank = 1; (worker_process_rank == 0) && worker_process_launch && (rank < worker_process_count); ++rank)
+		{
+			std::vector<std::string> args;
+			for(std::vector<std::string>::const_iterator it = command_line_args.begin() + 1; it != command_line_args.end(); ++it)
+				if ((it->find("--worker_process_rank") != 0) && (it->find("--worker_process_group") != 0))
+					args.push_back(*it);
+			args.push_back((boost::format("--worker_process_rank=%1%") % rank).str());
+			args.push_back((boost::format("--worker_process_group=%1%") % worker_process_group).str());
+			worker_processes.push_back(std::shared_ptr<boost::process::child>(new boost::process::child(command_line_args.front(), boost::process::args(args), boost::process::std_out > boost::process::null)));
+		}
+		if (!worker_processes.empty())
+			std::cout << worker_processes.size() << " worker processes launched, their output is logged to log_worker_<rank>.txt" << std::endl;
+
+		// The rest of worker processes are launched first, as the communicator might wait for all of them to connect
+		if (worker_process_count > 1)
+		{
+			if (!master_factory->set_worker_process(worker_process_rank, worker_process_count, worker_process_group))
+				throw neural_network_exception("worker_process_count is not supported by the backend");
+			forward_prop_factory = master_factory->create_forward_propagation_factory();
+			backward_prop_factory = master_factory->create_backward_propagation_factory();
+		}
+
 		network_trainer::ptr trainer = get_network_trainer();
 
 		boost::filesystem::path batch_folder = get_working_data_folder() / get_ann_subfolder_name();
@@ -751,39 +944,64 @@ namespace nnforge
 
 		complex_network_data_pusher progress;
 
-		progress.push_back(network_data_pusher::ptr(new report_progress_network_data_pusher()));
+		// Pushers are traced so that validation and snapshot saving show up on the profile timeline
+		progress.push_back(network_data_pusher::ptr(new traced_network_data_pusher(network_data_pusher::ptr(new report_progress_network_data_pusher()), profile, "report_progress")));
 
-		std::vector<network_data_pusher::ptr> train_modifiers_before_snapshot = get_train_modifiers_before_snapshot(get_schema(schema_usage_train));
-		progress.insert(progress.end(), train_modifiers_before_snapshot.begin(), train_modifiers_before_snapshot.end());
+		structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(training_dataset_name, dataset_usage_train, epoch_count_in_training_dataset, shuffle_block_size);
 
-		if (dump_snapshot)
+		if (training_mix_validating_ratio > 0.0F)
 		{
-			progress.push_back(network_data_pusher::ptr(new save_snapshot_network_data_pusher(batch_snapshot_folder)));
+			structured_data_bunch_reader::ptr validating_reader = get_structured_data_bunch_reader(inference_dataset_name, dataset_usage_train, 1, 0);
+			reader = structured_data_bunch_reader::ptr(new structured_data_bunch_mix_reader(reader, validating_reader, training_mix_validating_ratio));
 		}
 
-		if (keep_snapshots_frequency > 1)
+		// Weights are kept in sync by the backend, so the rest of worker processes just train and leave saving and validation to the first one
+		if (worker_process_rank > 0)
 		{
-			progress.push_back(network_data_pusher::ptr(new clean_snapshots_network_data_pusher(batch_snapshot_folder, keep_snapshots_frequency)));
+			complex_network_data_pusher res;
+			trainer->train(
+				*reader,
+				*peeker,
+				progress,
+				res);
+
+			profile->write_trace();
+			return;
 		}
 
-		std::vector<network_data_pusher::ptr> validators_for_training = get_validators_for_training(get_schema(schema_usage_validate_when_train));
-		progress.insert(progress.end(), validators_for_training.begin(), validators_for_training.end());
-
-		summarize_network_data_pusher res(batch_folder);
-
-		structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(training_dataset_name, dataset_usage_train, epoch_count_in_training_dataset, shuffle_block_size);
+		std::vector<network_data_pusher::ptr> train_modifiers_before_snapshot = get_train_modifiers_before_snapshot(get_schema(schema_usage_train));
+		for(std::vector<network_data_pusher::ptr>::const_iterator it = train_modifiers_before_snapshot.begin(); it != train_modifiers_before_snapshot.end(); ++it)
+			progress.push_back(network_data_pusher::ptr(new traced_network_data_pusher(*it, profile, "train_modifier")));
 
-		if (training_mix_validating_ratio > 0.0F)
+		if (dump_snapshot)
 		{
-			structured_data_bunch_reader::ptr validating_reader = get_structured_data_bunch_reader(inference_dataset_name, dataset_usage_train, 1, 0);
-			reader = structured_data_bunch_reader::ptr(new structured_data_bunch_mix_reader(reader, validating_reader, training_mix_validating_ratio));
+			progress.push_back(network_data_pusher::ptr(new traced_network_data_pusher(network_data_pusher::ptr(new save_snapshot_network_data_pusher(batch_snapshot_folder, background_snapshot_saving, sync_snapshots_to_disk, keep_snapshots_frequency)), profile, "save_snapshot")));
 		}
+		else if (keep_snapshots_frequency > 1)
+		{
+			progress.push_back(network_data_pusher::ptr(new traced_network_data_pusher(network_data_pusher::ptr(new clean_snapshots_network_data_pusher(batch_snapshot_folder, keep_snapshots_frequency)), profile, "clean_snapshots")));
+		}
+
+		std::vector<network_data_pusher::ptr> validators_for_training = get_validators_for_training(get_schema(schema_usage_validate_when_train));
+		for(std::vector<network_data_pusher::ptr>::const_iterator it = validators_for_training.begin(); it != validators_for_training.end(); ++it)
+			progress.push_back(network_data_pusher::ptr(new traced_network_data_pusher(*it, profile, "validate")));
+
+		summarize_network_data_pusher res(batch_folder, background_snapshot_saving, sync_snapshots_to_disk);
 
 		trainer->train(
 			*reader,
 			*peeker,
 			progress,
 			res);
+
+		for(std::vector<std::shared_ptr<boost::process::child> >::const_iterator it = worker_processes.begin(); it != worker_processes.end(); ++it)
+		{
+			(*it)->wait();
+			if ((*it)->exit_code() != 0)
+				throw neural_network_exception((boost::format("Worker process %1% exited with code %2%") % (it - worker_processes.begin() + 1) % (*it)->exit_code()).str());
+		}
+
+		profile->write_trace();
 	}
 
 	std::vector<network_data_pusher::ptr> toolset::get_validators_for_training(network_schema::const_ptr schema)
@@ -794,7 +1012,9 @@ namespace nnforge
 		{
 			res.push_back(network_data_pusher::ptr(new validate_progress_network_data_pusher(
 				forward_prop_factory->create(*schema, inference_output_layer_names, debug, profile),
-				get_structured_data_bunch_reader(inference_dataset_name, dataset_usage_validate_when_train, epoch_count_in_validating_dataset, 0))));
+				get_structured_data_bunch_reader(inference_dataset_name, dataset_usage_validate_when_train, epoch_count_in_validating_dataset, 0),
+				1,
+				background_validation)));
 		}
 
 		return res;
@@ -840,6 +1060,9 @@ namespace nnforge
 		boost::filesystem::create_directories(batch_folder);
 		boost::filesystem::path snapshot_ann_folder_path = batch_folder / ann_snapshot_subfolder_name;
 		boost::filesystem::create_directories(snapshot_ann_folder_path);
+		// The rest of worker processes get the data from the first one
+		if (worker_process_rank == 0)
+			background_network_data_writer::recover_folders(snapshot_ann_folder_path);
 
 		std::set<unsigned int> trained_ann_list = get_trained_ann_list();
 
@@ -851,8 +1074,20 @@ namespace nnforge
 			new_item.index = it->first;
 			new_item.start_epoch = it->second;
 			
+			std::string folder_name = (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % new_item.index % new_item.start_epoch).str();
+			boost::filesystem::path checkpoint_file_path = snapshot_ann_folder_path / (folder_name + network_data_checkpoint::file_extension);
+			if (network_data_checkpoint::is_checkpoint_file(checkpoint_file_path))
+			{
+				network_data_checkpoint checkpoint;
+				checkpoint.read(checkpoint_file_path);
+				new_item.data = checkpoint.data;
+				new_item.momentum_data = checkpoint.momentum_data;
+				new_item.momentum_data2 = checkpoint.momentum_data2;
+				res.push_back(new_item);
+				continue;
+			}
+
 			{
-				std::string folder_name = (boost::format("ann_trained_%|1$03d|_epoch_%|2$05d|") % new_item.index % new_item.start_epoch).str();
 				boost::filesystem::path folder_path = snapshot_ann_folder_path / folder_name;
 				new_item.data = network_data::ptr(new network_data());
 				new_item.data->read(folder_path);
@@ -904,7 +1139,7 @@ namespace nnforge
 
 		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(snapshot_ann_folder_path); it != boost::filesystem::directory_iterator(); ++it)
 		{
-			if (it->status().type() == boost::filesystem::directory_file)
+			if ((it->status().type() == boost::filesystem::directory_file) || network_data_checkpoint::is_checkpoint_file(it->path()))
 			{
 				boost::filesystem::path folder_path = it->path();
 				std::string folder_name = folder_path.filename().string();
@@ -932,6 +1167,8 @@ namespace nnforge
 	{
 		boost::filesystem::path trained_ann_folder_path = get_working_data_folder() / get_ann_subfolder_name();
 		boost::filesystem::create_directories(trained_ann_folder_path);
+		if (worker_process_rank == 0)
+			background_network_data_writer::recover_folders(trained_ann_folder_path);
 
 		std::set<unsigned int> res;
 		std::regex expression(trained_ann_index_extractor_pattern);
@@ -939,7 +1176,7 @@ namespace nnforge
 
 		for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(trained_ann_folder_path); it != boost::filesystem::directory_iterator(); ++it)
 		{
-			if (it->status().type() == boost::filesystem::directory_file)
+			if ((it->status().type() == boost::filesystem::directory_file) || network_data_checkpoint::is_checkpoint_file(it->path()))
 			{
 				boost::filesystem::path folder_path = it->path();
 				std::string folder_name = folder_path.filename().string();
@@ -961,11 +1198,61 @@ namespace nnforge
 
 		network_schema::ptr schema = get_schema(schema_usage_train);
 
-		backward_propagation::ptr backprop = backward_prop_factory->create(
-			*schema,
+		// Backward propagation runs for the trainable suffix only when outputs of the frozen prefix are cached
+		frozen_prefix_feature_cache::ptr prefix_cache;
+		network_schema::ptr backprop_schema = schema;
+		std::vector<std::string> backprop_exclude_data_update_layer_names = training_exclude_data_update_layer_names;
+		if (cache_frozen_prefix)
+		{
+			if ((concurrent_network_count > 1) || (worker_process_count > 1) || (training_mix_validating_ratio > 0.0F))
+				throw neural_network_exception("cache_frozen_prefix cannot be used together with concurrent_network_count, worker_process_count, or training_mix_validating_ratio");
+
+			std::map<std::string, boost::filesystem::path> data_filenames = get_data_filenames(training_dataset_name);
+			std::vector<boost::filesystem::path> data_file_paths;
+			std::map<std::string, std::vector<data_transformer::ptr> > data_transformer_map;
+			for(std::map<std::string, boost::filesystem::path>::const_iterator it = data_filenames.begin(); it != data_filenames.end(); ++it)
+			{
+				data_file_paths.push_back(it->second);
+				data_transformer_map.insert(std::make_pair(it->first, get_data_transformer_list(training_dataset_name, it->first, dataset_usage_train)));
+			}
+
+			prefix_cache = frozen_prefix_feature_cache::ptr(new frozen_prefix_feature_cache(
+				schema,
+				training_output_layer_names,
+				training_error_source_layer_names,
+				training_exclude_data_update_layer_names,
+				get_structured_data_reader_map(training_dataset_name, dataset_usage_train),
+				data_transformer_map,
+				data_file_paths,
+				epoch_count_in_training_dataset,
+				shuffle_block_size,
+				get_working_data_folder() / frozen_prefix_cache_subfolder_name,
+				forward_prop_factory,
+				debug,
+				profile));
+
+			if (prefix_cache->is_applicable())
+			{
+				backprop_schema = prefix_cache->get_suffix_schema();
+				backprop_exclude_data_update_layer_names.clear();
+				for(std::vector<std::string>::const_iterator it = training_exclude_data_update_layer_names.begin(); it != training_exclude_data_update_layer_names.end(); ++it)
+					if (backprop_schema->find_layer(*it))
+						backprop_exclude_data_update_layer_names.push_back(*it);
+			}
+			else
+			{
+				std::cout << "Warning: No frozen layers found to cache outputs of, training the whole network" << std::endl;
+				prefix_cache.reset();
+			}
+		}
+
+		// Networks trained concurrently split the backend threads between them, each of them has its own buffers
+		std::vector<backward_propagation::ptr> backprops = backward_prop_factory->create_concurrent(
+			*backprop_schema,
 			training_output_layer_names,
 			training_error_source_layer_names,
-			training_exclude_data_update_layer_names,
+			backprop_exclude_data_update_layer_names,
+			static_cast<unsigned int>(std::max(concurrent_network_count, 1)),
 			debug,
 			profile);
 
@@ -977,7 +1264,7 @@ namespace nnforge
 					training_output_layer_names,
 					training_error_source_layer_names,
 					training_exclude_data_update_layer_names,
-					backprop));
+					backprops));
 
 			res = typed_res;
 		}
@@ -991,6 +1278,8 @@ namespace nnforge
 		res->batch_size = batch_size;
 		res->max_chunk_size = max_chunk_size;
 		res->momentum = training_momentum(momentum_type_str, momentum_val, momentum_val2);
+		res->concurrent_max_kept_entry_count = concurrent_network_kept_entry_count;
+		res->prefix_cache = prefix_cache;
 
 		return res;
 	}
@@ -1413,7 +1702,7 @@ namespace nnforge
 				double original_error = 0.0;
 				std::vector<float> gradient_backprops(weight_id_list.size());
 				{
-					neuron_value_set_data_bunch_writer writer;
+					average_data_bunch_writer writer;
 					backprop->run(
 						*reader,
 						writer,
@@ -1428,7 +1717,7 @@ namespace nnforge
 						0);
 					for(std::vector<std::string>::const_iterator it = training_error_source_layer_names.begin(); it != training_error_source_layer_names.end(); ++it)
 					{
-						std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+						std::shared_ptr<std::vector<double> > averages = writer.get_average().find(*it)->second.second;
 						original_error += std::accumulate(averages->begin(), averages->end(), 0.0);
 					}
 					for(int weight_index = 0; weight_index < static_cast<int>(weight_id_list.size()); ++weight_index)
@@ -1444,7 +1733,7 @@ namespace nnforge
 					double minus_error = 0.0;
 					{
 						weight_list[weight_id] -= check_gradient_base_step;
-						neuron_value_set_data_bunch_writer writer;
+						average_data_bunch_writer writer;
 						backprop->run(
 							*reader,
 							writer,
@@ -1459,7 +1748,7 @@ namespace nnforge
 							0);
 						for(std::vector<std::string>::const_iterator it = training_error_source_layer_names.begin(); it != training_error_source_layer_names.end(); ++it)
 						{
-							std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+							std::shared_ptr<std::vector<double> > averages = writer.get_average().find(*it)->second.second;
 							minus_error += std::accumulate(averages->begin(), averages->end(), 0.0);
 						}
 					}
@@ -1468,7 +1757,7 @@ namespace nnforge
 					double plus_error = 0.0;
 					{
 						weight_list[weight_id] += check_gradient_base_step;
-						neuron_value_set_data_bunch_writer writer;
+						average_data_bunch_writer writer;
 						backprop->run(
 							*reader,
 							writer,
@@ -1483,7 +1772,7 @@ namespace nnforge
 							0);
 						for(std::vector<std::string>::const_iterator it = training_error_source_layer_names.begin(); it != training_error_source_layer_names.end(); ++it)
 						{
-							std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+							std::shared_ptr<std::vector<double> > averages = writer.get_average().find(*it)->second.second;
 							plus_error += std::accumulate(averages->begin(), averages->end(), 0.0);
 						}
 					}
@@ -1559,12 +1848,213 @@ namespace nnforge
 		data->write(weights_folder);
 	}
 
+	void toolset::convert_to_checkpoint()
+	{
+		boost::filesystem::path batch_folder = get_working_data_folder() / get_ann_subfolder_name();
+		// Sources are deleted only when all the conversions succeed
+		std::vector<boost::filesystem::path> converted_path_list;
+
+		std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
+		for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
+		{
+			if (!boost::filesystem::is_directory(it->second))
+				continue;
+
+			boost::filesystem::path file_path = it->second;
+			file_path += network_data_checkpoint::file_extension;
+			if (boost::filesystem::exists(file_path))
+			{
+				std::cout << "Skipped " << it->second.string() << ", " << file_path.string() << " already exists" << std::endl;
+				continue;
+			}
+
+			network_data_checkpoint checkpoint;
+			checkpoint.data = network_data::ptr(new network_data());
+			checkpoint.data->read(it->second);
+			checkpoint.write(file_path, sync_snapshots_to_disk);
+			converted_path_list.push_back(it->second);
+			std::cout << "Converted " << it->second.string() << " to " << file_path.string() << std::endl;
+		}
+
+		// Momentums are kept for the latest snapshot of each network only, they are stored in its checkpoint
+		boost::filesystem::path snapshot_ann_folder_path = batch_folder / ann_snapshot_subfolder_name;
+		std::map<unsigned int, unsigned int> latest_snapshot_ann_list = get_snapshot_ann_list(std::set<unsigned int>());
+		std::regex expression(snapshot_ann_index_extractor_pattern);
+		std::cmatch what;
+		std::vector<boost::filesystem::path> snapshot_folder_path_list;
+		if (boost::filesystem::is_directory(snapshot_ann_folder_path))
+			for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(snapshot_ann_folder_path); it != boost::filesystem::directory_iterator(); ++it)
+				if (boost::filesystem::is_directory(it->path()))
+					snapshot_folder_path_list.push_back(it->path());
+		for(std::vector<boost::filesystem::path>::const_iterator it = snapshot_folder_path_list.begin(); it != snapshot_folder_path_list.end(); ++it)
+		{
+			const boost::filesystem::path& folder_path = *it;
+			std::string folder_name = folder_path.filename().string();
+			if (!std::regex_search(folder_name.c_str(), what, expression))
+				continue;
+
+			unsigned int index = static_cast<unsigned int>(atol(std::string(what[1].first, what[1].second).c_str()));
+			unsigned int epoch = static_cast<unsigned int>(atol(std::string(what[2].first, what[2].second).c_str()));
+
+			boost::filesystem::path file_path = folder_path;
+			file_path += network_data_checkpoint::file_extension;
+			if (boost::filesystem::exists(file_path))
+			{
+				std::cout << "Skipped " << folder_path.string() << ", " << file_path.string() << " already exists" << std::endl;
+				continue;
+			}
+
+			std::vector<boost::filesystem::path> converted_folder_path_list(1, folder_path);
+			network_data_checkpoint checkpoint;
+			checkpoint.data = network_data::ptr(new network_data());
+			checkpoint.data->read(folder_path);
+			if (latest_snapshot_ann_list[index] == epoch)
+			{
+				boost::filesystem::path momentum_folder_path = snapshot_ann_folder_path / (boost::format("momentum_%|1$03d|") % index).str();
+				if (boost::filesystem::exists(momentum_folder_path))
+				{
+					checkpoint.momentum_data = network_data::ptr(new network_data());
+					checkpoint.momentum_data->read(momentum_folder_path);
+					converted_folder_path_list.push_back(momentum_folder_path);
+				}
+				boost::filesystem::path momentum2_folder_path = snapshot_ann_folder_path / (boost::format("momentum2_%|1$03d|") % index).str();
+				if (boost::filesystem::exists(momentum2_folder_path))
+				{
+					checkpoint.momentum_data2 = network_data::ptr(new network_data());
+					checkpoint.momentum_data2->read(momentum2_folder_path);
+					converted_folder_path_list.push_back(momentum2_folder_path);
+				}
+			}
+
+			checkpoint.write(file_path, sync_snapshots_to_disk);
+			converted_path_list.insert(converted_path_list.end(), converted_folder_path_list.begin(), converted_folder_path_list.end());
+			std::cout << "Converted " << folder_path.string() << " to " << file_path.string() << std::endl;
+		}
+
+		if (remove_converted_sources)
+			remove_converted_paths(converted_path_list);
+	}
+
+	void toolset::convert_from_checkpoint()
+	{
+		boost::filesystem::path batch_folder = get_working_data_folder() / get_ann_subfolder_name();
+		// Sources are deleted only when all the conversions succeed
+		std::vector<boost::filesystem::path> converted_path_list;
+
+		std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
+		for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
+		{
+			if (!network_data_checkpoint::is_checkpoint_file(it->second))
+				continue;
+
+			boost::filesystem::path folder_path = it->second;
+			folder_path.replace_extension();
+			if (boost::filesystem::exists(folder_path))
+			{
+				std::cout << "Skipped " << it->second.string() << ", " << folder_path.string() << " already exists" << std::endl;
+				continue;
+			}
+
+			network_data data;
+			data.read(it->second);
+			data.write(folder_path);
+			converted_path_list.push_back(it->second);
+			std::cout << "Converted " << it->second.string() << " to " << folder_path.string() << std::endl;
+		}
+
+		boost::filesystem::path snapshot_ann_folder_path = batch_folder / ann_snapshot_subfolder_name;
+		std::map<unsigned int, unsigned int> latest_snapshot_ann_list = get_snapshot_ann_list(std::set<unsigned int>());
+		std::regex expression(snapshot_ann_index_extractor_pattern);
+		std::cmatch what;
+		std::vector<boost::filesystem::path> snapshot_file_path_list;
+		if (boost::filesystem::is_directory(snapshot_ann_folder_path))
+			for(boost::filesystem::directory_iterator it = boost::filesystem::directory_iterator(snapshot_ann_folder_path); it != boost::filesystem::directory_iterator(); ++it)
+				if (network_data_checkpoint::is_checkpoint_file(it->path()))
+					snapshot_file_path_list.push_back(it->path());
+		for(std::vector<boost::filesystem::path>::const_iterator it = snapshot_file_path_list.begin(); it != snapshot_file_path_list.end(); ++it)
+		{
+			const boost::filesystem::path& file_path = *it;
+			std::string file_name = file_path.filename().string();
+			if (!std::regex_search(file_name.c_str(), what, expression))
+				continue;
+
+			unsigned int index = static_cast<unsigned int>(atol(std::string(what[1].first, what[1].second).c_str()));
+			unsigned int epoch = static_cast<unsigned int>(atol(std::string(what[2].first, what[2].second).c_str()));
+
+			boost::filesystem::path folder_path = file_path;
+			folder_path.replace_extension();
+			if (boost::filesystem::exists(folder_path))
+			{
+				std::cout << "Skipped " << file_path.string() << ", " << folder_path.string() << " already exists" << std::endl;
+				continue;
+			}
+
+			network_data_checkpoint checkpoint;
+			checkpoint.read(file_path);
+			checkpoint.data->write(folder_path);
+			// Momentum folders belong to the latest snapshot, existing ones are kept
+			if (latest_snapshot_ann_list[index] == epoch)
+			{
+				if (checkpoint.momentum_data)
+				{
+					boost::filesystem::path momentum_folder_path = snapshot_ann_folder_path / (boost::format("momentum_%|1$03d|") % index).str();
+					if (boost::filesystem::exists(momentum_folder_path))
+						std::cout << "Skipped momentums of " << file_path.string() << ", " << momentum_folder_path.string() << " already exists" << std::endl;
+					else
+						checkpoint.momentum_data->write(momentum_folder_path);
+				}
+				if (checkpoint.momentum_data2)
+				{
+					boost::filesystem::path momentum2_folder_path = snapshot_ann_folder_path / (boost::format("momentum2_%|1$03d|") % index).str();
+					if (boost::filesystem::exists(momentum2_folder_path))
+						std::cout << "Skipped 2nd momentums of " << file_path.string() << ", " << momentum2_folder_path.string() << " already exists" << std::endl;
+					else
+						checkpoint.momentum_data2->write(momentum2_folder_path);
+				}
+			}
+			converted_path_list.push_back(file_path);
+			std::cout << "Converted " << file_path.string() << " to " << folder_path.string() << std::endl;
+		}
+
+		if (remove_converted_sources)
+			remove_converted_paths(converted_path_list);
+	}
+
+	void toolset::remove_converted_paths(const std::vector<boost::filesystem::path>& path_list)
+	{
+		for(std::vector<boost::filesystem::path>::const_iterator it = path_list.begin(); it != path_list.end(); ++it)
+		{
+			boost::filesystem::remove_all(*it);
+			std::cout << "Removed " << it->string() << std::endl;
+		}
+	}
+
 	void toolset::update_bn_weights()
 	{
 		network_schema::ptr schema = get_schema(schema_usage_inference);
 		structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(training_dataset_name, dataset_usage_update_bn_weights, epoch_count_in_training_dataset, 0);
 		std::vector<layer::const_ptr> layers = schema->get_layers_in_forward_propagation_order();
 
+		if (update_bn_weights_entry_count > 0)
+		{
+			int entry_count = reader->get_entry_count();
+			if (entry_count < 0)
+				throw neural_network_exception("update_bn_weights_entry_count is specified while the number of entries in the training dataset is unknown");
+			if (update_bn_weights_entry_count < entry_count)
+			{
+				std::vector<unsigned int> entry_subset(entry_count);
+				for(unsigned int i = 0; i < static_cast<unsigned int>(entry_count); ++i)
+					entry_subset[i] = i;
+				random_generator gen = rnd::get_random_generator();
+				std::shuffle(entry_subset.begin(), entry_subset.end(), gen);
+				entry_subset.resize(update_bn_weights_entry_count);
+				// Keep the entries sampled in order for sequential reads
+				std::sort(entry_subset.begin(), entry_subset.end());
+				reader = structured_data_bunch_reader::ptr(new structured_data_bunch_subset_reader(reader, entry_subset));
+				std::cout << "Using " << update_bn_weights_entry_count << " entries sampled out of " << entry_count << std::endl;
+			}
+		}
+
 		std::vector<std::string> bn_layes;
 		std::cout << "Updating Batch Normalization weights for these layers: ";
 		for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
@@ -1581,6 +2071,13 @@ namespace nnforge
 
 		std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
 		std::cout << "Updating Batch Normalization weights for " << ann_data_name_and_folderpath_list.size() << " networks..." << std::endl;
+
+		if (update_bn_weights_single_pass)
+		{
+			update_bn_weights_single_pass_run(*schema, *reader, bn_layes, ann_data_name_and_folderpath_list);
+			return;
+		}
+
 		for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
 		{
 			network_data data;
@@ -1628,4 +2125,301 @@ namespace nnforge
 			data.write(it->second);
 		}
 	}
+
+	void toolset::update_bn_weights_single_pass_run(
+		const network_schema& schema,
+		structured_data_bunch_reader& reader,
+		const std::vector<std::string>& bn_layer_names,
+		const std::vector<std::pair<unsigned int, boost::filesystem::path> >& ann_data_name_and_folderpath_list)
+	{
+		// Batch Normalization layers normalize with statistics of the entries processed at once,
+		// so each of them gets the input as if the preceding ones were updated already
+		std::vector<layer::const_ptr> recalibration_layers;
+		std::vector<std::string> bn_input_layer_names;
+		std::vector<layer::const_ptr> layers = schema.get_layers();
+		for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+		{
+			if ((*it)->get_type_name() == batch_norm_layer::layer_type_name)
+			{
+				std::shared_ptr<batch_norm_layer> bn_layer = std::dynamic_pointer_cast<batch_norm_layer>((*it)->clone());
+				bn_layer->use_batch_statistics = true;
+				recalibration_layers.push_back(bn_layer);
+				if (std::find(bn_input_layer_names.begin(), bn_input_layer_names.end(), bn_layer->input_layer_instance_names[0]) == bn_input_layer_names.end())
+					bn_input_layer_names.push_back(bn_layer->input_layer_instance_names[0]);
+			}
+			else
+				recalibration_layers.push_back(*it);
+		}
+		network_schema recalibration_schema(recalibration_layers);
+		forward_propagation::ptr forward_prop = forward_prop_factory->create(recalibration_schema, bn_input_layer_names, debug, profile);
+
+		for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
+		{
+			network_data data;
+			data.read(it->second);
+
+			std::cout << "Working on network # " << it->first << std::endl;
+
+			forward_prop->set_data(data);
+
+			stat_data_bunch_writer writer;
+			forward_propagation::stat st = forward_prop->run(reader, writer);
+			std::cout << st << std::endl;
+
+			std::map<std::string, std::vector<feature_map_data_stat> > stat_map = writer.get_stat();
+			for(std::vector<std::string>::const_iterator it2 = bn_layer_names.begin(); it2 != bn_layer_names.end(); ++it2)
+			{
+				const std::string& layer_name = *it2;
+				std::cout << layer_name << std::endl;
+
+				const std::vector<feature_map_data_stat>& stat = stat_map.find(schema.get_layer(layer_name)->input_layer_instance_names[0])->second;
+				layer_data::ptr dt = data.data_list.get(layer_name);
+				for(unsigned int feature_map_id = 0; feature_map_id < static_cast<unsigned int>(stat.size()); ++feature_map_id)
+				{
+					std::cout << feature_map_id << ": " << stat[feature_map_id] << std::endl;
+
+					dt->at(2)[feature_map_id] = stat[feature_map_id].average;
+					dt->at(3)[feature_map_id] = 1.0F / stat[feature_map_id].std_dev;
+				}
+			}
+
+			data.write(it->second);
+		}
+	}
+
+	void toolset::benchmark()
+	{
+		if (benchmark_iteration_count <= 0)
+			throw neural_network_exception((boost::format("Invalid benchmark_iteration_count: %1%") % benchmark_iteration_count).str());
+		if (benchmark_entry_count <= 0)
+			throw neural_network_exception((boost::format("Invalid benchmark_entry_count: %1%") % benchmark_entry_count).str());
+
+		std::vector<int> batch_size_list = parse_benchmark_list(benchmark_batch_sizes, "benchmark_batch_sizes");
+		if (batch_size_list.empty())
+			batch_size_list.push_back(batch_size);
+		std::vector<int> thread_count_list = parse_benchmark_list(benchmark_thread_counts, "benchmark_thread_counts");
+
+		std::map<std::string, layer_configuration_specific> input_config_map = get_benchmark_input_config_map();
+		synthetic_data_bunch_reader reader(input_config_map, static_cast<unsigned int>(benchmark_entry_count));
+
+		network_schema::ptr inference_schema = get_schema(schema_usage_inference);
+		network_schema::ptr training_schema = get_schema(schema_usage_train);
+
+		random_generator gen = rnd::get_random_generator(48576);
+		network_data::ptr inference_data(new network_data(inference_schema->get_layers()));
+		inference_data->randomize(inference_schema->get_layers(), gen);
+		network_data_initializer().initialize(inference_data->data_list, *inference_schema);
+
+		std::cout << "Benchmarking with " << benchmark_entry_count << " synthetic entries per iteration, "
+			<< benchmark_warmup_iteration_count << " warmup and " << benchmark_iteration_count << " measured iterations" << std::endl;
+
+		// -1 stands for the thread count the backend is configured with
+		if (thread_count_list.empty())
+			thread_count_list.push_back(-1);
+		for(std::vector<int>::const_iterator thread_it = thread_count_list.begin(); thread_it != thread_count_list.end(); ++thread_it)
+		{
+			std::string thread_prefix;
+			if (*thread_it != -1)
+			{
+				if (!master_factory->set_thread_count(*thread_it))
+					throw neural_network_exception("benchmark_thread_counts is not supported by the backend");
+				forward_prop_factory = master_factory->create_forward_propagation_factory();
+				backward_prop_factory = master_factory->create_backward_propagation_factory();
+				thread_prefix = (boost::format("threads %1%, ") % *thread_it).str();
+			}
+
+			if (!inference_output_layer_names.empty())
+			{
+				size_t initial_memory_usage = get_current_memory_usage();
+				size_t max_memory_usage = initial_memory_usage;
+				forward_propagation::ptr forward_prop = forward_prop_factory->create(*inference_schema, inference_output_layer_names, debug, profile);
+				if (forward_prop->is_schema_with_weights())
+					forward_prop->set_data(*inference_data);
+
+				std::vector<float> seconds_list;
+				float flops_per_entry = 0.0F;
+				unsigned int chunk_size = 0;
+				for(int iteration_id = 0; iteration_id < benchmark_warmup_iteration_count + benchmark_iteration_count; ++iteration_id)
+				{
+					stat_data_bunch_writer writer;
+					forward_propagation::stat st = forward_prop->run(reader, writer);
+					if (iteration_id >= benchmark_warmup_iteration_count)
+						seconds_list.push_back(st.total_seconds);
+					flops_per_entry = st.flops_per_entry;
+					chunk_size = st.chunk_size;
+					max_memory_usage = std::max(max_memory_usage, get_current_memory_usage());
+				}
+
+				report_benchmark(thread_prefix + "forward" + (chunk_size > 0 ? (boost::format(", chunk %1%") % chunk_size).str() : std::string()), seconds_list, flops_per_entry, max_memory_usage - initial_memory_usage);
+			}
+
+			for(std::vector<int>::const_iterator batch_it = batch_size_list.begin(); batch_it != batch_size_list.end(); ++batch_it)
+			{
+				size_t initial_memory_usage = get_current_memory_usage();
+				size_t max_memory_usage = initial_memory_usage;
+				backward_propagation::ptr backprop = backward_prop_factory->create(
+					*training_schema,
+					training_output_layer_names,
+					training_error_source_layer_names,
+					training_exclude_data_update_layer_names,
+					debug,
+					profile);
+
+				network_data data(training_schema->get_layers());
+				data.randomize(training_schema->get_layers(), gen);
+				network_data_initializer().initialize(data.data_list, *training_schema);
+
+				training_momentum momentum(momentum_type_str, momentum_val, momentum_val2);
+				network_data::ptr momentum_data;
+				if (momentum.is_momentum_data())
+					momentum_data = network_data::ptr(new network_data(training_schema->get_layers()));
+				network_data::ptr momentum_data2;
+				if (momentum.is_momentum_data2())
+					momentum_data2 = network_data::ptr(new network_data(training_schema->get_layers()));
+
+				// Zero learning rates keep weights intact from iteration to iteration, the amount of work is the same
+				std::map<std::string, std::vector<float> > learning_rates;
+				std::vector<std::string> data_layer_name_list = data.data_list.get_data_layer_name_list();
+				for(std::vector<std::string>::const_iterator it = data_layer_name_list.begin(); it != data_layer_name_list.end(); ++it)
+					learning_rates.insert(std::make_pair(*it, std::vector<float>(data.data_list.get(*it)->size(), 0.0F)));
+
+				std::vector<float> seconds_list;
+				float flops_per_entry = 0.0F;
+				unsigned int chunk_size = 0;
+				for(int iteration_id = 0; iteration_id < benchmark_warmup_iteration_count + benchmark_iteration_count; ++iteration_id)
+				{
+					stat_data_bunch_writer writer;
+					backward_propagation::stat st = backprop->run(
+						reader,
+						writer,
+						data,
+						momentum_data,
+						momentum_data2,
+						learning_rates,
+						*batch_it,
+						static_cast<unsigned int>(benchmark_entry_count),
+						weight_decay,
+						momentum,
+						0);
+					if (iteration_id >= benchmark_warmup_iteration_count)
+						seconds_list.push_back(st.total_seconds);
+					flops_per_entry = st.flops_per_entry;
+					chunk_size = st.chunk_size;
+					max_memory_usage = std::max(max_memory_usage, get_current_memory_usage());
+				}
+
+				report_benchmark((boost::format("%1%batch %2%, forward+backward") % thread_prefix % *batch_it).str() + (chunk_size > 0 ? (boost::format(", chunk %1%") % chunk_size).str() : std::string()), seconds_list, flops_per_entry, max_memory_usage - initial_memory_usage);
+			}
+		}
+	}
+
+	std::map<std::string, layer_configuration_specific> toolset::get_benchmark_input_config_map() const
+	{
+		if (benchmark_input_layer_configs.empty())
+			return get_structured_data_bunch_reader(training_dataset_name, dataset_usage_train, 1, 0)->get_config_map();
+
+		std::map<std::string, layer_configuration_specific> res;
+		for(std::vector<std::string>::const_iterator it = benchmark_input_layer_configs.begin(); it != benchmark_input_layer_configs.end(); ++it)
+		{
+			std::vector<std::string> strs;
+			boost::split(strs, *it, boost::is_any_of(","));
+			if (strs.size() < 2)
+				throw neural_network_exception((boost::format("Invalid benchmark_input_layer_config %1%, expected Layer,FeatureMapCount[,Dim0[,Dim1...]]") % *it).str());
+
+			layer_configuration_specific config;
+			try
+			{
+				config.feature_map_count = boost::lexical_cast<unsigned int>(boost::trim_copy(strs[1]));
+				for(std::vector<std::string>::const_iterator it2 = strs.begin() + 2; it2 != strs.end(); ++it2)
+					config.dimension_sizes.push_back(boost::lexical_cast<unsigned int>(boost::trim_copy(*it2)));
+			}
+			catch (const boost::bad_lexical_cast&)
+			{
+				throw neural_network_exception((boost::format("Invalid benchmark_input_layer_config %1%, expected Layer,FeatureMapCount[,Dim0[,Dim1...]]") % *it).str());
+			}
+			res[boost::trim_copy(strs[0])] = config;
+		}
+
+		return res;
+	}
+
+	std::vector<int> toolset::parse_benchmark_list(
+		const std::string& str,
+		const char * option_name)
+	{
+		std::vector<int> res;
+		std::vector<std::string> strs;
+		boost::split(strs, str, boost::is_any_of(","));
+		for(std::vector<std::string>::iterator it = strs.begin(); it != strs.end(); ++it)
+		{
+			boost::trim(*it);
+			if (it->empty())
+				continue;
+
+			int val = 0;
+			try
+			{
+				val = boost::lexical_cast<int>(*it);
+			}
+			catch (const boost::bad_lexical_cast&)
+			{
+			}
+			if (val <= 0)
+				throw neural_network_exception((boost::format("Invalid value %1% in %2%") % *it % option_name).str());
+			res.push_back(val);
+		}
+
+		return res;
+	}
+
+	void toolset::report_benchmark(
+		const std::string& name,
+		std::vector<float> seconds_list,
+		float flops_per_entry,
+		size_t memory_usage_increase)
+	{
+		std::sort(seconds_list.begin(), seconds_list.end());
+		float total_seconds = std::accumulate(seconds_list.begin(), seconds_list.end(), 0.0F);
+		float entries_per_second = static_cast<float>(benchmark_entry_count) * static_cast<float>(seconds_list.size()) / total_seconds;
+
+		// Nearest-rank percentiles of the time of the whole iteration over benchmark_entry_count entries
+		const int percentile_count = 3;
+		const float percentiles[percentile_count] = {0.5F, 0.95F, 0.99F};
+		float iteration_seconds[percentile_count];
+		for(int i = 0; i < percentile_count; ++i)
+		{
+			int rank = static_cast<int>(ceilf(percentiles[i] * static_cast<float>(seconds_list.size())));
+			iteration_seconds[i] = seconds_list[std::max(std::min(rank, static_cast<int>(seconds_list.size())), 1) - 1];
+		}
+
+		std::cout << name << ": "
+			<< (boost::format("%|1$.1f| entries/s, %|2$.1f| GFLOPS, iteration time p50 %|3$.2f| ms, p95 %|4$.2f| ms, p99 %|5$.2f| ms, memory increase %|6$.1f| MB")
+				% entries_per_second
+				% (entries_per_second * flops_per_entry * 1.0e-9F)
+				% (iteration_seconds[0] * 1000.0F)
+				% (iteration_seconds[1] * 1000.0F)
+				% (iteration_seconds[2] * 1000.0F)
+				% (static_cast<double>(memory_usage_increase) / (1024.0 * 1024.0))).str()
+			<< std::endl;
+	}
+
+	size_t toolset::get_current_memory_usage()
+	{
+	#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.WorkingSetSize;
+		return 0;
+	#elif defined(__linux__)
+		// The second field is the resident set size in pages
+		boost::filesystem::ifstream in(boost::filesystem::path("/proc/self/statm"), std::ios_base::in);
+		size_t total_page_count = 0;
+		size_t resident_page_count = 0;
+		if (!(in >> total_page_count >> resident_page_count))
+			return 0;
+		return resident_page_count * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	#else
+		return 0;
+	#endif
+	}
 }
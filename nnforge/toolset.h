@@ -91,6 +91,13 @@ namespace nnforge
 
 		virtual std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > run_inference();
 
+		// Runs all the networks reading each chunk of the dataset once
+		virtual std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > run_inference_ensemble(
+			const network_schema& schema,
+			structured_data_bunch_reader& reader,
+			const std::vector<std::pair<unsigned int, boost::filesystem::path> >& ann_data_name_and_folderpath_list,
+			const std::map<std::string, boost::filesystem::path>& dump_file_path_map);
+
 		virtual void dump_schema_gv();
 
 		virtual void train();
@@ -125,6 +132,31 @@ namespace nnforge
 
 		virtual void update_bn_weights();
 
+		// Converts trained networks and snapshots to single-file checkpoints, the latest snapshot keeps its momentums in the same file.
+		// Existing targets are skipped, sources are kept unless remove_converted_sources is set
+		virtual void convert_to_checkpoint();
+
+		// Converts single-file checkpoints back to folders, with the same rules for targets and sources as convert_to_checkpoint
+		virtual void convert_from_checkpoint();
+
+		void remove_converted_paths(const std::vector<boost::filesystem::path>& path_list);
+
+		// Collects statistics for all Batch Normalization layers in a single forward pass per network
+		virtual void update_bn_weights_single_pass_run(
+			const network_schema& schema,
+			structured_data_bunch_reader& reader,
+			const std::vector<std::string>& bn_layer_names,
+			const std::vector<std::pair<unsigned int, boost::filesystem::path> >& ann_data_name_and_folderpath_list);
+
+		// Runs forward and forward+backward passes on synthetic in-memory data
+		virtual void benchmark();
+
+		// Input layer configurations for the synthetic data in benchmark
+		virtual std::map<std::string, layer_configuration_specific> get_benchmark_input_config_map() const;
+
+		// Files inference outputs are dumped to, one per output layer
+		virtual std::map<std::string, boost::filesystem::path> get_inference_dump_file_path_map() const;
+
 		virtual structured_data_bunch_reader::ptr get_structured_data_bunch_reader(
 			const std::string& dataset_name,
 			dataset_usage usage,
@@ -160,6 +192,11 @@ namespace nnforge
 			structured_data_reader::ptr original_reader,
 			const std::vector<data_transformer::ptr>& data_transformer_list) const;
 
+		// Readers for each layer of the dataset, transformers applied
+		std::map<std::string, structured_data_reader::ptr> get_structured_data_reader_map(
+			const std::string& dataset_name,
+			dataset_usage usage) const;
+
 		// Returns empty smart pointer if no normalize_data_transformer exists for the layer specified
 		normalize_data_transformer::ptr get_normalize_data_transformer(const std::string& layer_name) const;
 
@@ -178,6 +215,19 @@ namespace nnforge
 
 		static bool compare_entry(network_data_peek_entry i, network_data_peek_entry j);
 
+		static std::vector<int> parse_benchmark_list(
+			const std::string& str,
+			const char * option_name);
+
+		void report_benchmark(
+			const std::string& name,
+			std::vector<float> seconds_list,
+			float flops_per_entry,
+			size_t memory_usage_increase);
+
+		// Resident memory of the process in bytes, 0 if unknown
+		static size_t get_current_memory_usage();
+
 		std::map<std::string, boost::filesystem::path> get_data_filenames(const std::string& dataset_name) const;
 
 	protected:
@@ -235,6 +285,12 @@ namespace nnforge
 		std::string dump_extension_image;
 		std::string dump_extension_video;
 		bool dump_data_rgb;
+		bool inference_ensemble;
+		bool update_bn_weights_single_pass;
+		int inference_ensemble_chunk_size;
+		int inference_ensemble_thread_group_count;
+		int inference_ensemble_reader_thread_count;
+		int update_bn_weights_entry_count;
 		int dump_data_scale;
 		int dump_data_video_fps;
 		int epoch_count_in_training_dataset;
@@ -249,6 +305,23 @@ namespace nnforge
 		float check_gradient_base_step;
 		float check_gradient_relative_threshold_warning;
 		float check_gradient_relative_threshold_error;
+		std::vector<std::string> benchmark_input_layer_configs;
+		std::string benchmark_batch_sizes;
+		std::string benchmark_thread_counts;
+		int benchmark_warmup_iteration_count;
+		int benchmark_iteration_count;
+		int benchmark_entry_count;
+		int worker_process_count;
+		int worker_process_rank;
+		int concurrent_network_count;
+		int concurrent_network_kept_entry_count;
+		bool cache_frozen_prefix;
+		bool remove_converted_sources;
+		bool worker_process_launch;
+		bool background_validation;
+		bool background_snapshot_saving;
+		bool sync_snapshots_to_disk;
+		std::string worker_process_group;
 
 		debug_state::ptr debug;
 		profile_state::ptr profile;
@@ -264,9 +337,12 @@ namespace nnforge
 		static const char * ann_snapshot_subfolder_name;
 		static const char * dataset_extractor_pattern;
 		static const char * dump_data_subfolder_name;
+		static const char * frozen_prefix_cache_subfolder_name;
 		static const char * dataset_value_data_layer_name;
 
 		std::string default_config_path;
+		// Worker processes are launched with the same arguments
+		std::vector<std::string> command_line_args;
 
 	private:
 		toolset();
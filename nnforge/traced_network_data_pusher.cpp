@@ -0,0 +1,44 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "traced_network_data_pusher.h"
+
+namespace nnforge
+{
+	traced_network_data_pusher::traced_network_data_pusher(
+		network_data_pusher::ptr pusher,
+		profile_state::ptr profile,
+		const std::string& name)
+		: pusher(pusher)
+		, profile(profile)
+		, name(name)
+	{
+	}
+
+	void traced_network_data_pusher::push(
+		const training_task_state& task_state,
+		const network_schema& schema)
+	{
+		profile_trace_scope trace_scope(profile, "pusher", name);
+		pusher->push(task_state, schema);
+	}
+
+	void traced_network_data_pusher::flush()
+	{
+		profile_trace_scope trace_scope(profile, "pusher", name);
+		pusher->flush();
+	}
+}
@@ -0,0 +1,48 @@
+/*
+ *  Copyright 2011-2017 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "network_data_pusher.h"
+#include "profile_state.h"
+
+#include <string>
+
+namespace nnforge
+{
+	// Runs the pusher recording its time on the profile timeline
+	class traced_network_data_pusher : public network_data_pusher
+	{
+	public:
+		traced_network_data_pusher(
+			network_data_pusher::ptr pusher,
+			profile_state::ptr profile,
+			const std::string& name);
+
+		virtual ~traced_network_data_pusher() = default;
+
+		virtual void push(
+			const training_task_state& task_state,
+			const network_schema& schema);
+
+		virtual void flush();
+
+	private:
+		network_data_pusher::ptr pusher;
+		profile_state::ptr profile;
+		std::string name;
+	};
+}
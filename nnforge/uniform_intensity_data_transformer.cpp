@@ -70,4 +70,9 @@ namespace nnforge
 				dest_data[i] = src_data[i] + shift;
 		}
 	}
+
+	bool uniform_intensity_data_transformer::is_deterministic() const
+	{
+		return false;
+	}
 }
@@ -16,22 +16,43 @@
 
 #include "validate_progress_network_data_pusher.h"
 
-#include "neuron_value_set_data_bunch_writer.h"
+#include "average_data_bunch_writer.h"
+#include "neural_network_exception.h"
 
 #include <stdio.h>
 #include <boost/format.hpp>
 #include <iostream>
+#include <sstream>
 
 namespace nnforge
 {
 	validate_progress_network_data_pusher::validate_progress_network_data_pusher(
 		forward_propagation::ptr forward_prop,
 		structured_data_bunch_reader::ptr reader,
-		unsigned int report_frequency)
+		unsigned int report_frequency,
+		bool background)
 		: forward_prop(forward_prop)
 		, reader(reader)
 		, report_frequency(report_frequency)
+		, background(background)
+		, job_running(false)
+		, stop_requested(false)
 	{
+		if (background)
+			validation_thread = std::thread([this] () { run_background_validation(); });
+	}
+
+	validate_progress_network_data_pusher::~validate_progress_network_data_pusher()
+	{
+		if (validation_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(pending_job_mutex);
+				stop_requested = true;
+			}
+			pending_job_condition.notify_all();
+			validation_thread.join();
+		}
 	}
 
 	void validate_progress_network_data_pusher::push(
@@ -40,20 +61,127 @@ namespace nnforge
 	{
 		if ((task_state.get_current_epoch() % report_frequency) == 0)
 		{
-			forward_prop->set_data(*task_state.data);
+			std::shared_ptr<validation_job> job(new validation_job());
+			job->index = task_state.index_peeked;
+			job->epoch = task_state.get_current_epoch();
+			std::vector<layer::const_ptr> layer_list = schema.get_layers();
+			for(std::vector<layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+				job->layer_name_to_layer_map.insert(std::make_pair((*it)->instance_name, *it));
+
+			if (!background)
+			{
+				job->data = task_state.data;
+				validate(*job);
+				return;
+			}
 
-			neuron_value_set_data_bunch_writer writer;
-			forward_propagation::stat st = forward_prop->run(*reader, writer);
+			// Training goes on updating the weights in place, so the validation gets its own copy
+			job->data = task_state.data->clone();
+			unsigned int skipped_epoch = 0;
+			{
+				std::lock_guard<std::mutex> lock(pending_job_mutex);
+				if (validation_error)
+					std::rethrow_exception(validation_error);
+				std::map<unsigned int, std::shared_ptr<validation_job> >::iterator it = pending_job_map.find(job->index);
+				if (it != pending_job_map.end())
+				{
+					skipped_epoch = it->second->epoch;
+					it->second = job;
+				}
+				else
+				{
+					pending_job_map.insert(std::make_pair(job->index, job));
+					pending_index_queue.push_back(job->index);
+				}
+			}
+			pending_job_condition.notify_all();
 
-			forward_prop->clear_data();
+			if (skipped_epoch > 0)
+				std::cout << (boost::format("Validation of NN # %1%, epoch %2% is skipped, the previous one is still running") % job->index % skipped_epoch).str() << std::endl;
+		}
+	}
+
+	void validate_progress_network_data_pusher::flush()
+	{
+		if (!background)
+			return;
+
+		std::unique_lock<std::mutex> lock(pending_job_mutex);
+		pending_job_condition.wait(lock, [this] () { return (pending_job_map.empty() && !job_running) || validation_error; });
+		if (validation_error)
+			std::rethrow_exception(validation_error);
+	}
+
+	void validate_progress_network_data_pusher::validate(const validation_job& job)
+	{
+		forward_prop->set_data(*job.data);
+
+		average_data_bunch_writer writer;
+		forward_propagation::stat st = forward_prop->run(*reader, writer);
+
+		forward_prop->clear_data();
+
+		// The report is printed at once, so that it doesn't interleave with training output when validating in background
+		std::stringstream out;
+		if (background)
+			out << "----- Validating NN # " << job.index << ", epoch " << job.epoch << " -----" << std::endl;
+		else
+			out << "----- Validating -----" << std::endl;
+		out << st << std::endl;
+
+		std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > > average_map = writer.get_average();
+		for(std::map<std::string, std::pair<layer_configuration_specific, std::shared_ptr<std::vector<double> > > >::const_iterator it = average_map.begin(); it != average_map.end(); ++it)
+			out << job.layer_name_to_layer_map.find(it->first)->second->get_string_for_average_data(it->second.first, *it->second.second) << std::endl;
+
+		std::cout << out.str() << std::flush;
+	}
+
+	void validate_progress_network_data_pusher::run_background_validation()
+	{
+		while (true)
+		{
+			std::shared_ptr<validation_job> job;
+			{
+				std::unique_lock<std::mutex> lock(pending_job_mutex);
+				pending_job_condition.wait(lock, [this] () { return !pending_index_queue.empty() || stop_requested; });
+				if (pending_index_queue.empty())
+					return;
+				std::map<unsigned int, std::shared_ptr<validation_job> >::iterator it = pending_job_map.find(pending_index_queue.front());
+				job = it->second;
+				pending_job_map.erase(it);
+				pending_index_queue.pop_front();
+				job_running = true;
+			}
 
-			unsigned int last_index = static_cast<unsigned int>(task_state.history.size()) - 1;
+			// The error is rethrown by the next push or flush
+			std::exception_ptr error;
+			try
+			{
+				validate(*job);
+			}
+			catch (const std::exception& e)
+			{
+				error = std::make_exception_ptr(neural_network_exception((boost::format("Validation of NN # %1%, epoch %2% failed: %3%") % job->index % job->epoch % e.what()).str()));
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
 
-			std::cout << "----- Validating -----" << std::endl;
-			std::cout << st << std::endl;
+			{
+				std::lock_guard<std::mutex> lock(pending_job_mutex);
+				job_running = false;
+				if (error)
+				{
+					validation_error = error;
+					pending_job_map.clear();
+					pending_index_queue.clear();
+				}
+			}
+			pending_job_condition.notify_all();
 
-			for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = writer.layer_name_to_config_and_value_set_map.begin(); it != writer.layer_name_to_config_and_value_set_map.end(); ++it)
-				std::cout << schema.get_layer(it->first)->get_string_for_average_data(it->second.first, *it->second.second->get_average()) << std::endl;
+			if (error)
+				return;
 		}
 	}
 }
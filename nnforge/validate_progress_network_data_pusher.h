@@ -20,6 +20,13 @@
 #include "forward_propagation.h"
 #include "structured_data_bunch_reader.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <deque>
+
 namespace nnforge
 {
 	class validate_progress_network_data_pusher : public network_data_pusher
@@ -28,17 +35,48 @@ namespace nnforge
 		validate_progress_network_data_pusher(
 			forward_propagation::ptr forward_prop,
 			structured_data_bunch_reader::ptr reader,
-			unsigned int report_frequency = 1);
+			unsigned int report_frequency = 1,
+			bool background = false);
 
-		virtual ~validate_progress_network_data_pusher() = default;
+		// Waits for the running and pending validations to complete
+		virtual ~validate_progress_network_data_pusher();
 
+		// In background mode the method copies the weights and returns right away,
+		// a newer snapshot of the network replaces its one still waiting for validation, snapshots of different networks are validated in the order pushed
 		virtual void push(
 			const training_task_state& task_state,
 			const network_schema& schema);
 
+		// Waits for the running and pending validations to complete, rethrows the exception the validation failed with
+		virtual void flush();
+
+	protected:
+		struct validation_job
+		{
+			unsigned int index;
+			unsigned int epoch;
+			network_data::ptr data;
+			std::map<std::string, layer::const_ptr> layer_name_to_layer_map;
+		};
+
+		void validate(const validation_job& job);
+
+		void run_background_validation();
+
 	protected:
 		forward_propagation::ptr forward_prop;
 		structured_data_bunch_reader::ptr reader;
 		unsigned int report_frequency;
+		bool background;
+
+		std::thread validation_thread;
+		std::mutex pending_job_mutex;
+		std::condition_variable pending_job_condition;
+		// Network index to the job waiting for validation
+		std::map<unsigned int, std::shared_ptr<validation_job> > pending_job_map;
+		std::deque<unsigned int> pending_index_queue;
+		bool job_running;
+		bool stop_requested;
+		std::exception_ptr validation_error;
 	};
 }